@@ -9,6 +9,7 @@
 #include <task.h>
 
 #include <tkjhat/sdk.h>
+#include <tkjhat/sensor_hub.h>
 #include <pico/binary_info.h>
 
 #if CFG_TUSB_OS != OPT_OS_FREERTOS
@@ -33,9 +34,7 @@ void sw2_task(void *pvParameters);
 void led_task(void *pvParameters);
 void rgb_task(void *pvParameters);
 void buzzer_task(void *pvParameters);
-void light_sensor_task(void *pvParameters);
-void ths_task(void *pvParameters);
-void imu_task(void *pvParameters);
+void sensors_print_task(void *pvParameters);
 
 
 // void display_task(void *pvParameters);
@@ -85,45 +84,30 @@ void buzzer_task(void *pvParameters) {
     }
 }
 
-void light_sensor_task(void *pvParameters) {
+// The sensor hub samples the IMU, the light sensor and the temperature and
+// humidity sensor on one task of its own; this task only prints the latest
+// samples.
+void sensors_print_task(void *pvParameters) {
     (void)pvParameters;
 
     while (1) {
-        uint16_t light = veml6030_read_light();
-        printf("Light level: %d\n", light);
-        vTaskDelay(1000);
-    }
-}
-
-void ths_task(void *pvParameters) {
-    (void)pvParameters;
-
-    while (1) {
-        float temp = hdc2021_read_temperature();
-        float humid = hdc2021_read_humidity();
-        printf("Temperature: %.2f°C, Humidity: %.2f%%\n", temp, humid);
-        vTaskDelay(1000);
-    }
-}
-
-
-void imu_task(void *pvParameters) {
-    (void)pvParameters;
-    
-    float ax, ay, az, gx, gy, gz, t;
-
-    while (1)
-    {
-        if (ICM42670_read_sensor_data(&ax, &ay, &az, &gx, &gy, &gz, &t) == 0) {
-            float temp_c = (float)t / 128.0f;
-            printf("Accel: X=%d, Y=%d, Z=%d | Gyro: X=%d, Y=%d, Z=%d | Temp: %.2f°C\n", ax, ay, az, gx, gy, gz, temp_c);
-
+        sensor_hub_light_t light;
+        if (sensor_hub_get_light(&light)) {
+            printf("Light level: %lu lx\n", (unsigned long)(light.reading.lux_mlx / 1000));
+        }
+        sensor_hub_env_t env;
+        if (sensor_hub_get_env(&env)) {
+            printf("Temperature: %.2f°C, Humidity: %.2f%%\n", env.temperature, env.humidity);
+        }
+        sensor_hub_imu_t imu;
+        if (sensor_hub_get_imu(&imu)) {
+            printf("Accel: X=%f, Y=%f, Z=%f | Gyro: X=%f, Y=%f, Z=%f | Temp: %.2f°C\n",
+                   imu.ax, imu.ay, imu.az, imu.gx, imu.gy, imu.gz, imu.t);
         } else {
-            printf("Failed to read imu data\n");
+            printf("No imu data yet\n");
         }
-        vTaskDelay(pdMS_TO_TICKS(60));
+        vTaskDelay(pdMS_TO_TICKS(1000));
     }
-
 }
 
 // void display_task(void *pvParameters) {
@@ -301,12 +285,12 @@ int main() {
     //printf("Initializing the i2c\n");
 
     //Initialize Light Sesnsor VEML6030
-    //veml6030_init();
-    //printf("Initializing the light sensor\n");
+    init_veml6030();
+    printf("Initializing the light sensor\n");
 
     //Initialize the Temp and Humidity Sensor
-    //hdc2021_init();
-    //printf("Initializing the temp/humidity sensor\n");
+    init_hdc2021_();
+    printf("Initializing the temp/humidity sensor\n");
 
     //Initialize the display
     //init_display();
@@ -337,65 +321,22 @@ int main() {
     } else {
         printf("Failed to initialize ICM-42670P.\n");
     }
-    float ax, ay, az, gx, gy, gz, t;
-
-    while(true){
-        set_red_led_status(true);
-        //printf("SW1 state: %d\n", gpio_get(SW1_PIN));
-        //printf("SW2 state: %d\n", gpio_get(SW2_PIN));
-        //buzzer_play_tone(440, 500);
-        /*rgb_led_write(255,0,0);
-        sleep_ms(1000);
-        rgb_led_write(0,255,0);
-        sleep_ms(1000);
-        rgb_led_write(0,0,255);*/
-        //uint16_t reg = _veml6030_read_register(VEML6030_CONFIG_REG);
-        //printf("Register: 0x%04X\n",(unsigned int)reg);
-        //uint32_t light = veml6030_read_light();
-        //printf("Light level: %u\n", light);
-        //float temp = hdc2021_read_temperature();
-        //float humid = hdc2021_read_humidity();
-        //printf("Temperature: %.2f°C, Humidity: %.2f%%\n", temp, humid);
-        // clear_display();
-        // write_text("Hello");
-        // draw_circle(25, 25, 20, true);
-        //draw_line(0, 0, 127, 0);
-        //draw_square(30,10,20,20, true);
-        // draw_square(70,10,20,20, false);
-        // write_text_xy(20,40, "Bye");
-        
-
-        if (ICM42670_read_sensor_data(&ax, &ay, &az, &gx, &gy, &gz, &t) == 0) {
-            
-            printf("Accel: X=%f, Y=%f, Z=%f | Gyro: X=%f, Y=%f, Z=%f| Temp: %2.2f°C\n", ax, ay, az, gx, gy, gz, t);
-
-        } else {
-            printf("Failed to read imu data\n");
-        }
-        sleep_ms(1000);
-        
-
-        
 
-    }// end infite loop
-        
-
- 
+    set_red_led_status(true);
 
-
-    
-    
-
-   
+    // One task samples all the I2C sensors on a schedule (see
+    // tkjhat/sensor_hub.h); the default rates are IMU 100 Hz, light 10 Hz,
+    // temperature and humidity 1 Hz
+    if (sensor_hub_start(NULL) != 0) {
+        printf("Could not start the sensor hub\n");
+    }
 
     // Create tasks
     
     // xTaskCreate(sw2_task, "SW2Task", 256, NULL, 1, NULL);
     // xTaskCreate(rgb_task, "RGBTask", 256, NULL, 1, NULL);
     // xTaskCreate(buzzer_task, "BuzzerTask", 256, NULL, 4, NULL);
-    // xTaskCreate(light_sensor_task, "LightSensorTask", 256, NULL, 3, NULL);
-    // xTaskCreate(ths_task, "THSTask", 256, NULL, 1, NULL);
-    // xTaskCreate(imu_task, "IMUTask", 256, NULL, 1, NULL);
+    xTaskCreate(sensors_print_task, "SensorsPrintTask", 1024, NULL, 1, NULL);
     // xTaskCreate(led_simple_task, "LEDSimpleTask", 64, NULL, 1, NULL);
     // xTaskCreate(sw1_task, "SW1Task", 64, NULL, 1, NULL);
     // xTaskCreate(led_task, "LEDTask", 64, NULL, 2, NULL);
@@ -405,7 +346,7 @@ int main() {
     // // xTaskCreate(mic_task, "MicTask", 256, NULL, 1, NULL);
     
     // Start the FreeRTOS scheduler
-    //vTaskStartScheduler();
+    vTaskStartScheduler();
 
     return 0;
 }
@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <pico/stdlib.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <tusb.h>
+#include "usbSerialDebug/helper.h"
+#include <tkjhat/sdk.h>
+#include <tkjhat/mic_stream.h>
+#include <tkjhat/audio_stream.h>
+
+#if CFG_TUSB_OS != OPT_OS_FREERTOS
+#error "This should be using FREERTOS but the CFG_TUSB_OS is not OPT_OS_FREERTOS"
+#endif
+
+// Microphone to PC over the second serial port:
+// - CDC1 (e.g. /dev/ttyACM1) carries IMA-ADPCM frames of tkjhat/audio_stream.h.
+//   Record them with tools/mic_capture or tools/audio_decode.
+// - CDC0 (e.g. /dev/ttyACM0) keeps the text log, with the encoder time
+//   measured on the board once per second.
+
+#define BUFFER_SIZE 160
+#define REPORT_MS   1000
+
+// Time spent in the CDC1 writer, so it can be taken out of the encoder time
+static uint32_t write_us;
+
+static int cdc1_write(const void *data, size_t len, void *ctx) {
+    (void)ctx;
+    uint32_t t0 = time_us_32();
+    int n = usb_serial_data_write(data, len);
+    write_us += time_us_32() - t0;
+    return n;
+}
+
+void mic_task(void *pvParameters) {
+    (void)pvParameters;
+
+    // The encoder keeps one frame; too big for the task stack
+    static audio_stream_t as;
+    static int16_t pcm[MEMS_BUFFER_SIZE];
+    char buf[BUFFER_SIZE];
+
+    if (init_pdm_microphone() != 0 || mic_stream_start(NULL) != 0) {
+        usb_serial_print("Microphone could not be started\n");
+        vTaskDelete(NULL);
+    }
+    audio_stream_init(&as, AUDIO_CODEC_IMA_ADPCM, MEMS_SAMPLING_FREQUENCY, cdc1_write, NULL);
+
+    uint32_t encode_us = 0, encode_us_max = 0, frames = 0;
+    TickType_t next_report = xTaskGetTickCount() + pdMS_TO_TICKS(REPORT_MS);
+    while (1) {
+        size_t n = mic_stream_read(pcm, MEMS_BUFFER_SIZE, 100);
+
+        // Nobody listening on CDC1: read anyway so the stream does not fill up
+        if (n && usb_serial_data_connected()) {
+            write_us = 0;
+            uint32_t t0 = time_us_32();
+            audio_stream_write(&as, pcm, n);
+            uint32_t us = time_us_32() - t0 - write_us;
+            encode_us += us;
+            if (us > encode_us_max) encode_us_max = us;
+            frames++;
+        }
+
+        if ((int32_t)(xTaskGetTickCount() - next_report) >= 0) {
+            next_report += pdMS_TO_TICKS(REPORT_MS);
+            mic_stream_stats_t st;
+            mic_stream_get_stats(&st);
+            // Encoder share of one core: µs per second of audio, in per mille
+            snprintf(buf, BUFFER_SIZE,
+                     "frames %lu, bytes %lu, write errors %lu | encode %lu us/frame (max %lu), "
+                     "%lu.%lu%% | filter %lu us/buffer\n",
+                     (unsigned long)as.frames, (unsigned long)as.bytes_out,
+                     (unsigned long)as.write_errors,
+                     (unsigned long)(frames ? encode_us / frames : 0),
+                     (unsigned long)encode_us_max, (unsigned long)(encode_us / 10000),
+                     (unsigned long)(encode_us / 1000 % 10), (unsigned long)st.filter_us_avg);
+            usb_serial_print(buf);
+            encode_us = encode_us_max = frames = 0;
+        }
+    }
+}
+
+// ---- Task running USB stack ----
+static void usbTask(void *arg) {
+    (void)arg;
+    while (1) {
+        tud_task();              // With FreeRTOS wait for events
+                                 // Do not add vTaskDelay.
+    }
+}
+
+int main() {
+
+    init_hat_sdk();
+    sleep_ms(300); //Wait some time so initialization of USB and hat is done.
+
+    TaskHandle_t hMicTask, hUsb = NULL;
+
+    xTaskCreate(mic_task, "MicTask", 1024, NULL, 2, &hMicTask);
+    xTaskCreate(usbTask, "usb", 1024, NULL, 3, &hUsb);
+    #if (configNUMBER_OF_CORES > 1)
+        // The microphone DSP task runs on core 1 (mic_stream default)
+        vTaskCoreAffinitySet(hUsb, 1u << 0);
+    #endif
+
+    // VERY IMPORTANT, THIS SHOULD GO JUST BEFORE vTaskStartSheduler
+    // WITHOUT ANY DELAYS. OTHERWISE, THE TinyUSB stack wont recognize
+    // the device.
+    // Initialize TinyUSB
+    tusb_init();
+    //Initialize helper library to write in CDC0)
+    usb_serial_init();
+    // Start the FreeRTOS scheduler
+    vTaskStartScheduler();
+
+    return 0;
+}
@@ -4,7 +4,6 @@
 #include <pico/stdlib.h>
 #include <tkjhat/sdk.h>
 #include <pico/binary_info.h>
-#include <hardware/sync.h>
 
 static inline void _blink(int n){
     for (int i=0;i<n;i++){ 
@@ -19,16 +18,9 @@ static inline void _blink(int n){
     /*============================
     /   MICROPHONE CONFIGURATION
     /=============================*/
-    //Internal sample buffer for sound samples
-    int16_t sample_buffer[MEMS_BUFFER_SIZE];
-    int16_t temp_sample_buffer[MEMS_BUFFER_SIZE];//use to have two different buffers.
-    volatile int samples_read = 0;    
-
-    void on_sound_buffer_ready(){
-        // callback from library when all the samples in the library
-        // internal sample buffer are ready for reading 
-        samples_read = get_microphone_samples(sample_buffer, MEMS_BUFFER_SIZE);
-    }
+    // No sample buffers here: lend_microphone_samples() hands out a block
+    // of the driver's own PCM pool, which goes to fwrite as is and is given
+    // back afterwards.
 
     int main() {
         stdio_init_all();
@@ -48,7 +40,6 @@ static inline void _blink(int n){
         }
         else 
             printf("Initializing the microphone");
-        pdm_microphone_set_callback(on_sound_buffer_ready);
         pdm_microphone_set_filter_max_volume(64); // keep default
         pdm_microphone_set_filter_gain(8);        // safer base gain than 16
         pdm_microphone_set_filter_volume(56);     // was 64 ⇒ lower hiss; raise if still too quiet
@@ -74,29 +65,25 @@ static inline void _blink(int n){
                         set_red_led_status(false);
                         break;
                     }
-                    if (samples_read == 0){
+                    // Filtered here, outside any interrupt, once a raw buffer is complete
+                    if (pdm_microphone_available() == 0){
                         tight_loop_contents(); // yields without sleeping long
                         continue;
                     } 
-                    //Collect samples in a temporary buffer.          
-                    uint32_t irq = save_and_disable_interrupts();
-                    // store and clear the samples read from the callback
-                    int sample_count = samples_read;  
-                    memcpy(temp_sample_buffer, sample_buffer, (size_t)sample_count * sizeof(sample_buffer[0]));
-                    samples_read = 0;// restart the samples read
-                    restore_interrupts(irq);
+                    size_t sample_count;
+                    const int16_t *block = lend_microphone_samples(&sample_count);
+                    if (block == NULL) continue;
 
-                    // loop through any new collected samples
+                    // loop through the samples of the block
                     // OPTION 1 using fwrite
-                    // First we create a temporary buffer, so i can send data even if I receive another irq. 
-                    int sample_sent = fwrite(temp_sample_buffer,sizeof(temp_sample_buffer[0]),sample_count,stdout);
-                    sent_bytes += sizeof(temp_sample_buffer[0]) * sample_sent;
+                    int sample_sent = fwrite(block,sizeof(block[0]),sample_count,stdout);
+                    sent_bytes += sizeof(block[0]) * sample_sent;
                     
                     //stdio_flush();
 
                     //OPTION 2 using putchar
                     /*for (int i = 0; i < sample_count; i++) {
-                        int16_t s = temp_sample_buffer[i];
+                        int16_t s = block[i];
                         putchar_raw((int8_t)(s & 0xFF));       // LSB
                         ++sent_bytes;
                         putchar_raw((int8_t)(s >> 8));         // MSB
@@ -106,10 +93,13 @@ static inline void _blink(int n){
 
                     //OPTION 3: using printf. Only for showing in graph (e.g. in Arduino Uno plotter)
                     /*for (int i = 0; i < sample_count; i++) {
-                        printf("%d\n", temp_sample_buffer[i]);
-                        sent_bytes += sizeof(temp_sample_buffer[0]);
+                        printf("%d\n", block[i]);
+                        sent_bytes += sizeof(block[0]);
                     }
                     stdio_flush();*/
+
+                    // Back to the pool, ready for the next lend
+                    return_microphone_samples(block);
                 }
                 set_red_led_status(false);
                 end_microphone_sampling();
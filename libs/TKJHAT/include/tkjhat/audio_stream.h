@@ -0,0 +1,205 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file tkjhat/audio_stream.h
+ * @brief Framed IMA-ADPCM audio stream for sending microphone data to a PC.
+ *
+ * @details
+ * Raw 16-bit PCM at 8 kHz is 16 KB/s, which nearly fills a USB CDC port
+ * that also carries debug text. IMA-ADPCM stores each sample in 4 bits
+ * (4:1), and the frames add a small header. The stream is meant for a
+ * separate CDC interface (CDC1, see usb_serial_data_write() in
+ * usbSerialDebug/helper.h) while CDC0 keeps the logs.
+ *
+ * ### Frame format
+ * All fields are little-endian:
+ *
+ * | Offset | Size | Field                                            |
+ * |--------|------|--------------------------------------------------|
+ * | 0      | 2    | Magic "AD"                                       |
+ * | 2      | 1    | Version (::AUDIO_STREAM_VERSION)                 |
+ * | 3      | 1    | Codec (::audio_codec_t)                          |
+ * | 4      | 2    | Sequence number, +1 per frame                    |
+ * | 6      | 2    | Samples in the frame                             |
+ * | 8      | 2    | Sample rate in Hz                                |
+ * | 10     | 2    | ADPCM predictor at frame start (signed)          |
+ * | 12     | 1    | ADPCM step index at frame start                  |
+ * | 13     | 1    | Reserved (0)                                     |
+ * | 14     | 2    | CRC-16/CCITT of bytes 0–13 and the payload       |
+ * | 16     | n    | Payload: ceil(samples / 2) bytes of ADPCM (low   |
+ * |        |      | nibble first) or samples × 2 bytes of PCM        |
+ *
+ * Every frame carries the coder state it starts from. A lost frame
+ * therefore only loses its own samples, and the receiver can see the gap
+ * in the sequence numbers.
+ *
+ * The code has no Pico dependencies, so the host tools in @c tools/ build
+ * the same file for decoding (`tools/audio_decode` writes a WAV file).
+ *
+ * ### Typical usage
+ * @code
+ * static int cdc1_write(const void *d, size_t n, void *ctx) {
+ *     return usb_serial_data_write(d, n);
+ * }
+ *
+ * static audio_stream_t as;
+ * audio_stream_init(&as, AUDIO_CODEC_IMA_ADPCM, MEMS_SAMPLING_FREQUENCY, cdc1_write, NULL);
+ *
+ * int16_t pcm[MEMS_BUFFER_SIZE];
+ * for (;;) {
+ *     size_t n = mic_stream_read(pcm, MEMS_BUFFER_SIZE, 100);
+ *     if (n) audio_stream_write(&as, pcm, n);
+ * }
+ * @endcode
+ *
+ * `examples/hat_mic_cdc_ex` does this with the logs on CDC0 and prints the
+ * encoder time per frame measured on the board.
+ */
+
+#ifndef TKJHAT_AUDIO_STREAM_H
+#define TKJHAT_AUDIO_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_STREAM_VERSION        1
+#define AUDIO_STREAM_HEADER_SIZE    16
+#define AUDIO_STREAM_MAX_SAMPLES    512     /**< Samples per frame, at most. */
+#define AUDIO_STREAM_MAX_FRAME      (AUDIO_STREAM_HEADER_SIZE + AUDIO_STREAM_MAX_SAMPLES * 2)
+
+/** Payload encoding. */
+typedef enum {
+    AUDIO_CODEC_PCM16 = 0,      /**< Raw signed 16-bit samples. */
+    AUDIO_CODEC_IMA_ADPCM = 1   /**< 4-bit IMA-ADPCM. */
+} audio_codec_t;
+
+/** IMA-ADPCM coder state. */
+typedef struct {
+    int16_t predictor;
+    uint8_t step_index;
+} ima_adpcm_state_t;
+
+/** Header fields of a received frame. */
+typedef struct {
+    audio_codec_t codec;
+    uint16_t seq;
+    uint16_t samples;
+    uint16_t sample_rate;
+    ima_adpcm_state_t state;
+} audio_frame_info_t;
+
+/**
+ * @brief Sends one complete frame. Returns the number of bytes written.
+ */
+typedef int (*audio_stream_write_fn)(const void *data, size_t len, void *ctx);
+
+/** Encoder side of a stream. */
+typedef struct {
+    audio_codec_t codec;
+    uint16_t sample_rate;
+    uint16_t seq;
+    ima_adpcm_state_t state;
+    audio_stream_write_fn write;
+    void *ctx;
+    uint32_t frames;            /**< Frames built. */
+    uint32_t samples;           /**< Samples encoded. */
+    uint32_t bytes_out;         /**< Bytes handed to @c write. */
+    uint32_t write_errors;      /**< Frames @c write did not take completely. */
+    uint8_t frame[AUDIO_STREAM_MAX_FRAME];
+} audio_stream_t;
+
+/* ---------- IMA-ADPCM ---------- */
+
+/**
+ * @brief Reset a coder state (predictor 0, step index 0).
+ */
+void ima_adpcm_init(ima_adpcm_state_t *st);
+
+/**
+ * @brief Encode @p n samples into ceil(n / 2) bytes, low nibble first.
+ */
+void ima_adpcm_encode(ima_adpcm_state_t *st, const int16_t *pcm, size_t n, uint8_t *out);
+
+/**
+ * @brief Decode @p n samples from ceil(n / 2) bytes.
+ */
+void ima_adpcm_decode(ima_adpcm_state_t *st, const uint8_t *in, size_t n, int16_t *pcm);
+
+/* ---------- Framing ---------- */
+
+/**
+ * @brief CRC-16/CCITT (poly 0x1021); start with @p crc = 0xFFFF.
+ */
+uint16_t audio_stream_crc16(const uint8_t *data, size_t len, uint16_t crc);
+
+/**
+ * @brief Payload bytes of a frame with @p samples samples.
+ */
+size_t audio_stream_payload_size(audio_codec_t codec, size_t samples);
+
+/**
+ * @brief Prepare an encoder.
+ *
+ * @param s           Stream.
+ * @param codec       Payload encoding.
+ * @param sample_rate Rate written into every header.
+ * @param write       Called with each complete frame.
+ * @param ctx         Passed to @p write.
+ */
+void audio_stream_init(audio_stream_t *s, audio_codec_t codec, uint16_t sample_rate,
+                       audio_stream_write_fn write, void *ctx);
+
+/**
+ * @brief Encode PCM and send it in frames of up to ::AUDIO_STREAM_MAX_SAMPLES.
+ *
+ * @return Number of frames sent completely.
+ */
+int audio_stream_write(audio_stream_t *s, const int16_t *pcm, size_t n);
+
+/**
+ * @brief Check for a frame at the start of @p buf.
+ *
+ * @param buf  Received bytes.
+ * @param len  Number of bytes in @p buf.
+ * @param info Filled in when a valid frame is found.
+ * @return Frame size in bytes if a complete, valid frame starts at @p buf;
+ *         0 if more bytes are needed; -1 if @p buf does not start a frame
+ *         (skip one byte and try again).
+ */
+int audio_stream_parse(const uint8_t *buf, size_t len, audio_frame_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_AUDIO_STREAM_H */
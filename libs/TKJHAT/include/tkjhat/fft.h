@@ -0,0 +1,153 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file tkjhat/fft.h
+ * @brief In-place fixed-point FFT (Q15 and Q31) with window and magnitude helpers.
+ *
+ * @details
+ * Radix-4 FFT with one radix-2 stage when log2(n) is odd, for power-of-two
+ * sizes up to ::FFT_SIZE_MAX. The real FFT (::FFT_SIZE_MIN … ::FFT_SIZE_MAX
+ * points) runs a complex FFT of half the size on the packed samples and
+ * splits the result, so it costs about half of a complex FFT.
+ *
+ * Twiddle factors come from one quarter-wave sine table for 1024 points
+ * (257 entries per format), stored as @c const data, so they stay in flash
+ * and need no init call. Smaller sizes step through the same table.
+ *
+ * Every stage scales by 1/4 (1/2 for the radix-2 stage), so the results
+ * are the DFT divided by @c n: a sine of amplitude A shows up as a bin of
+ * magnitude A/2. Intermediate values are saturated, never wrapped.
+ * Complex input is clipped only if its magnitude |re + i·im| exceeds full
+ * scale; real input can use the full range.
+ *
+ * - Q15 is for 16-bit audio (microphone PCM).
+ * - Q31 keeps small signals on top of a large offset, e.g. vibration on
+ *   top of gravity in accelerometer counts.
+ *
+ * The code has no Pico dependencies; `tools/fft_check` builds it on the
+ * PC and compares it with a double-precision DFT.
+ *
+ * ### Real FFT output layout
+ * `rfft` replaces @c n real samples with @c n/2 complex bins
+ * (re, im interleaved). Bins 0 and n/2 are real, so they share the first
+ * slot: @c x[0] is DC and @c x[1] is the Nyquist bin.
+ *
+ * ### Typical usage
+ * @code
+ * int16_t x[512];                    // 512 PCM samples
+ * uint16_t mag[256];
+ * fft_window_hann_q15(x, 512);
+ * fft_rfft_q15(x, 512);
+ * fft_magnitude_q15(x, mag, 256);    // mag[k] is bin k * fs / 512 Hz
+ * @endcode
+ */
+
+#ifndef TKJHAT_FFT_H
+#define TKJHAT_FFT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FFT_SIZE_MIN    64      /**< Smallest real FFT. */
+#define FFT_SIZE_MAX    1024    /**< Largest real or complex FFT. */
+
+/**
+ * @brief @c true if @p n is a power of two in 16 … ::FFT_SIZE_MAX
+ *        (complex FFT sizes).
+ */
+bool fft_size_valid(unsigned n);
+
+/**
+ * @brief Forward complex FFT, in place, Q15.
+ *
+ * @param x @p n complex values as re, im pairs (2·n int16).
+ * @param n Points, power of two 16 … ::FFT_SIZE_MAX.
+ * @return 0, or -1 for an unsupported size. The result is DFT / n.
+ */
+int fft_cfft_q15(int16_t *x, unsigned n);
+
+/**
+ * @brief Forward complex FFT, in place, Q31. See fft_cfft_q15().
+ */
+int fft_cfft_q31(int32_t *x, unsigned n);
+
+/**
+ * @brief Forward real FFT, in place, Q15.
+ *
+ * @param x @p n real samples in, @p n/2 complex bins out (see the layout above).
+ * @param n Points, power of two ::FFT_SIZE_MIN … ::FFT_SIZE_MAX.
+ * @return 0, or -1 for an unsupported size. The result is DFT / n.
+ */
+int fft_rfft_q15(int16_t *x, unsigned n);
+
+/**
+ * @brief Forward real FFT, in place, Q31. See fft_rfft_q15().
+ */
+int fft_rfft_q31(int32_t *x, unsigned n);
+
+/**
+ * @brief Multiply @p n samples by a periodic Hann window (n power of two,
+ *        at most ::FFT_SIZE_MAX). Halves the average level.
+ */
+void fft_window_hann_q15(int16_t *x, unsigned n);
+
+/**
+ * @brief Q31 version of fft_window_hann_q15().
+ */
+void fft_window_hann_q31(int32_t *x, unsigned n);
+
+/**
+ * @brief Magnitudes of real FFT bins.
+ *
+ * @param bins  Output of fft_rfft_q15().
+ * @param mag   @p count magnitudes; @c mag[0] is |DC| (the Nyquist bin is dropped).
+ *              May point to @p bins to compute the magnitudes in place.
+ * @param count Usually n/2.
+ */
+void fft_magnitude_q15(const int16_t *bins, uint16_t *mag, unsigned count);
+
+/**
+ * @brief Q31 version of fft_magnitude_q15().
+ */
+void fft_magnitude_q31(const int32_t *bins, uint32_t *mag, unsigned count);
+
+/**
+ * @brief Integer square root, rounded down.
+ */
+uint32_t fft_isqrt64(uint64_t v);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_FFT_H */
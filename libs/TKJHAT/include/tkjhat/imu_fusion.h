@@ -0,0 +1,171 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file tkjhat/imu_fusion.h
+ * @brief Orientation fusion (Mahony filter) for the ICM-42670 IMU.
+ *
+ * @details
+ * Combines gyroscope and accelerometer data into an orientation quaternion.
+ * The gyroscope gives a smooth, fast response; the accelerometer slowly pulls
+ * the estimate back towards gravity so it does not drift. Compared with a
+ * pitch computed from a single accelerometer sample, the output is much less
+ * noisy while the board moves.
+ *
+ * Two implementations of the same filter are provided:
+ * - ::IMU_FUSION_FLOAT: single-precision float (fast on RP2350 with FPU).
+ * - ::IMU_FUSION_FIXED: Q30 quaternion, Q24 rad/s, integer only (RP2040).
+ *
+ * The filter can run on its own FreeRTOS task at the IMU ODR (100–1600 Hz),
+ * optionally pinned to one core. Rates that divide the FreeRTOS tick rate
+ * are paced by the scheduler; the others (400 and 1600 Hz at a 1 kHz tick)
+ * by a repeating timer on the default alarm pool, which takes one of its
+ * alarms while the task runs. The task sleeps between updates in both
+ * cases. Results are published through a lock-free
+ * snapshot: ::imu_fusion_get() never blocks and can be called from any task
+ * or core.
+ *
+ * The filter itself is in tkjhat/mahony.h and has no Pico dependencies.
+ * Yaw is not observable from the accelerometer, so it drifts slowly.
+ *
+ * ### Typical usage
+ * @code
+ * init_ICM42670();
+ * ICM42670_startAccel(400, 4);
+ * ICM42670_startGyro(400, 250);
+ * ICM42670_enable_accel_gyro_ln_mode();
+ *
+ * imu_fusion_config_t cfg;
+ * imu_fusion_default_config(&cfg);
+ * cfg.odr_hz = 400;
+ * cfg.core = 1;
+ * imu_fusion_start(&cfg);
+ *
+ * // In any task:
+ * imu_orientation_t o;
+ * if (imu_fusion_get(&o)) printf("pitch %.1f\n", o.pitch);
+ * @endcode
+ */
+
+#ifndef TKJHAT_IMU_FUSION_H
+#define TKJHAT_IMU_FUSION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <tkjhat/sdk.h>
+#include <tkjhat/mahony.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IMU_FUSION_ODR_DEFAULT          100
+#define IMU_FUSION_KP_DEFAULT           1.0f    /**< Proportional gain (1/s). */
+#define IMU_FUSION_KI_DEFAULT           0.02f   /**< Integral gain (1/s²). */
+#define IMU_FUSION_STACK_SIZE           1024    /**< Task stack in words. */
+#define IMU_FUSION_PRIORITY_DEFAULT     4
+
+/** Filter implementation. */
+typedef enum {
+    IMU_FUSION_FLOAT = 0,   /**< Single-precision float. */
+    IMU_FUSION_FIXED        /**< Integer only (Q30 quaternion). */
+} imu_fusion_variant_t;
+
+/** Configuration of the fusion task. */
+typedef struct {
+    uint16_t odr_hz;                /**< Update rate; should match the IMU ODR. */
+    imu_fusion_variant_t variant;   /**< Float or fixed-point filter. */
+    float kp;                       /**< Proportional gain. */
+    float ki;                       /**< Integral gain (gyro bias estimation). */
+    int core;                       /**< 0 or 1 to pin the task, -1 to let it float. */
+    uint32_t priority;              /**< FreeRTOS priority of the task. */
+} imu_fusion_config_t;
+
+/** Orientation snapshot. */
+typedef struct {
+    float q[4];             /**< Quaternion (w, x, y, z), body to world. */
+    float roll;             /**< Rotation about X in degrees. */
+    float pitch;            /**< Rotation about Y in degrees. */
+    float yaw;              /**< Rotation about Z in degrees (drifts). */
+    uint32_t timestamp_us;  /**< time_us_32() of the IMU sample. */
+    uint32_t count;         /**< Number of filter updates so far. */
+} imu_orientation_t;
+
+/** Timing statistics of the fusion task. */
+typedef struct {
+    uint32_t updates;           /**< Filter updates done. */
+    uint32_t read_errors;       /**< Failed IMU reads. */
+    uint32_t overruns;          /**< Periods where the task started late. */
+    uint32_t update_us_last;    /**< Duration of the last filter update (µs). */
+    uint32_t update_us_max;     /**< Longest filter update (µs). */
+    uint32_t update_us_avg;     /**< Running average of the filter update (µs). */
+} imu_fusion_stats_t;
+
+/* ---------- Fusion task ---------- */
+
+/**
+ * @brief Fill @p cfg with default values.
+ */
+void imu_fusion_default_config(imu_fusion_config_t *cfg);
+
+/**
+ * @brief Start the fusion task.
+ *
+ * @pre The IMU must be initialized and started (accel + gyro, LN mode).
+ *
+ * @param cfg Task configuration, or @c NULL for defaults.
+ * @return 0 on success, -1 on invalid configuration, -2 if the task or its
+ *         repeating timer could not be created.
+ */
+int imu_fusion_start(const imu_fusion_config_t *cfg);
+
+/**
+ * @brief Stop and delete the fusion task. The last snapshot stays readable.
+ */
+void imu_fusion_stop(void);
+
+/**
+ * @brief Get the latest orientation.
+ *
+ * Lock-free: never blocks the fusion task. Safe from any task or core.
+ *
+ * @param out Destination.
+ * @return @c false if no orientation has been computed yet.
+ */
+bool imu_fusion_get(imu_orientation_t *out);
+
+/**
+ * @brief Get timing statistics of the fusion task.
+ */
+void imu_fusion_get_stats(imu_fusion_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_IMU_FUSION_H */
@@ -0,0 +1,116 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file tkjhat/mahony.h
+ * @brief Mahony orientation filter, float and fixed-point.
+ *
+ * @details
+ * The filter behind tkjhat/imu_fusion.h, without the task around it. It only
+ * needs the C library, so the same code runs on the Pico and in the host
+ * tests (tools/fusion_check).
+ *
+ * The quaternion (w, x, y, z) rotates body to world, with world Z up: a board
+ * lying flat measures +1 g on its Z axis.
+ */
+
+#ifndef TKJHAT_MAHONY_H
+#define TKJHAT_MAHONY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Float Mahony filter state. */
+typedef struct {
+    float q0, q1, q2, q3;
+    float ix, iy, iz;       // integral feedback (rad/s)
+    float kp, ki;
+} mahony_f32_t;
+
+/** Fixed-point Mahony filter state. */
+typedef struct {
+    int32_t q[4];           // Q30
+    int32_t i[3];           // integral feedback, rad/s Q30
+    int32_t kp_q16, ki_q16; // gains, Q16
+    uint32_t half_dt_q32;   // dt / 2 in Q32
+    int32_t gyro_k_q24;     // gyro counts -> rad/s Q24
+} mahony_q30_t;
+
+/**
+ * @brief Reset a float filter to the identity orientation.
+ */
+void mahony_f32_init(mahony_f32_t *f, float kp, float ki);
+
+/**
+ * @brief One float filter step.
+ *
+ * @param f  Filter state.
+ * @param gx,gy,gz Angular rate in rad/s.
+ * @param ax,ay,az Acceleration in any unit (only the direction is used).
+ * @param dt Time step in seconds.
+ */
+void mahony_f32_update(mahony_f32_t *f, float gx, float gy, float gz,
+                       float ax, float ay, float az, float dt);
+
+/**
+ * @brief Reset a fixed-point filter to the identity orientation.
+ *
+ * @param f      Filter state.
+ * @param kp,ki  Gains (converted to Q16).
+ * @param odr_hz Update rate in Hz.
+ * @param gRes   Gyro sensitivity in LSB/dps (see ::icm42670_config_t).
+ */
+void mahony_q30_init(mahony_q30_t *f, float kp, float ki, uint16_t odr_hz, float gRes);
+
+/**
+ * @brief One fixed-point filter step on raw IMU counts.
+ *
+ * @param f        Filter state.
+ * @param gx,gy,gz Gyro counts (calibrated, from ::ICM42670_read_raw()).
+ * @param ax,ay,az Accelerometer counts (only the direction is used).
+ */
+void mahony_q30_update(mahony_q30_t *f, int16_t gx, int16_t gy, int16_t gz,
+                       int16_t ax, int16_t ay, int16_t az);
+
+/**
+ * @brief Change the gyro sensitivity of a running fixed-point filter.
+ *
+ * Keeps the orientation and integral; call it when the gyro FSR changes.
+ *
+ * @param f    Filter state.
+ * @param gRes Gyro sensitivity in LSB/dps.
+ */
+void mahony_q30_set_gyro_res(mahony_q30_t *f, float gRes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_MAHONY_H */
@@ -0,0 +1,129 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file tkjhat/mic_gate.h
+ * @brief Sound activity gate that works on raw PDM data.
+ *
+ * @details
+ * Decimating PDM to PCM is the most expensive part of the microphone path.
+ * In a silent room that work is wasted. The gate estimates the short-term
+ * energy of a raw PDM buffer without running the filter:
+ *
+ * - The buffer is cut into blocks of one output sample (decimation bits).
+ * - The number of ones in a block is a 1st-order CIC (boxcar) of the
+ *   PDM signal, i.e. a coarse PCM sample.
+ * - The variance of those counts over the buffer is the energy. The DC
+ *   offset cancels out.
+ *
+ * The energy is compared with an adaptive noise floor, which drops quickly
+ * and rises slowly, and 16 times slower still while the gate is open so a
+ * sustained sound is not taken for the floor. The gate opens when the
+ * energy exceeds the floor by the threshold ratio. It stays open for a
+ * hangover time after the last loud buffer so that word endings are kept.
+ *
+ * ::mic_stream uses the gate when @c mic_stream_config_t.gate is set. It
+ * also keeps a pre-roll of raw buffers, so the start of a sound is filtered
+ * too.
+ *
+ * The functions are pure and can be run on a host against recorded data.
+ */
+
+#ifndef TKJHAT_MIC_GATE_H
+#define TKJHAT_MIC_GATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MIC_GATE_THRESHOLD_DEFAULT      128     /**< 8× the floor (x16), ≈ +9 dB. */
+#define MIC_GATE_HANGOVER_MS_DEFAULT    300
+#define MIC_GATE_FLOOR_RISE_DEFAULT     6       /**< Floor rises by 1/64 of the gap per buffer (closed). */
+#define MIC_GATE_FLOOR_MIN_DEFAULT      16      /**< Lowest floor (Q8 energy units). */
+
+/** Gate parameters. */
+typedef struct {
+    uint16_t threshold_x16;     /**< Open when energy > floor × threshold_x16 / 16. */
+    uint16_t hangover_ms;       /**< Keep open this long after the last loud buffer. */
+    uint8_t floor_rise_shift;   /**< Floor rise rate: gap >> shift per buffer, shift + 4 while open. */
+    uint32_t floor_min;         /**< Lower bound of the noise floor. */
+} mic_gate_config_t;
+
+/** Gate state and counters. */
+typedef struct {
+    mic_gate_config_t cfg;
+    uint32_t floor;             /**< Current noise floor (Q8 energy). */
+    uint32_t energy;            /**< Energy of the last buffer (Q8). */
+    uint32_t hang_left_us;
+    bool open;
+    uint32_t buffers;           /**< Buffers evaluated. */
+    uint32_t open_buffers;      /**< Buffers with the gate open. */
+    uint32_t onsets;            /**< Closed -> open transitions. */
+} mic_gate_t;
+
+/**
+ * @brief Fill @p cfg with default values.
+ */
+void mic_gate_default_config(mic_gate_config_t *cfg);
+
+/**
+ * @brief Reset the gate (closed, floor unknown).
+ *
+ * @param g   Gate.
+ * @param cfg Parameters, or @c NULL for defaults.
+ */
+void mic_gate_init(mic_gate_t *g, const mic_gate_config_t *cfg);
+
+/**
+ * @brief Short-term energy of a raw PDM buffer.
+ *
+ * @param raw         PDM bytes, first bit in the MSB. Must be 4-byte aligned.
+ * @param bytes       Length of @p raw, a multiple of @p block_bytes.
+ * @param block_bytes Bytes per output sample (decimation / 8), a multiple of 4.
+ * @return Variance of the per-block ones count, Q8.
+ */
+uint32_t mic_gate_energy(const uint8_t *raw, size_t bytes, size_t block_bytes);
+
+/**
+ * @brief Feed the energy of the next buffer.
+ *
+ * @param g         Gate.
+ * @param energy    Result of ::mic_gate_energy().
+ * @param buffer_us Audio time covered by the buffer.
+ * @return @c true if the gate is open for this buffer.
+ */
+bool mic_gate_update(mic_gate_t *g, uint32_t energy, uint32_t buffer_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_MIC_GATE_H */
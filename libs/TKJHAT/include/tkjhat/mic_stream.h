@@ -0,0 +1,160 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file tkjhat/mic_stream.h
+ * @brief Deferred PDM-to-PCM conversion on a DSP task.
+ *
+ * @details
+ * Calling ::get_microphone_samples() from the sample-ready callback runs the
+ * whole OpenPDM2PCM decimation filter inside the DMA interrupt. Every other
+ * interrupt on that core waits for it.
+ *
+ * The mic stream moves that work to a task:
+ * - The DMA callback only notifies the DSP task (a few µs).
+ * - The DSP task, optionally pinned to one core, filters every completed
+ *   raw buffer and appends the PCM samples to a FreeRTOS stream buffer.
+ * - Consumers read PCM with ::mic_stream_read(), blocking up to a timeout.
+ *   No interrupt masking or double buffering is needed in the application.
+ *
+ * ::mic_stream_get_stats() reports the time spent in the callback, the
+ * filter time per buffer (what used to run in the interrupt) and the
+ * end-to-end latency from DMA completion to PCM in the stream.
+ *
+ * With @c gate set, a ::mic_gate_t looks at each raw buffer first. Silent
+ * buffers are dropped without being filtered or streamed. The last
+ * @c preroll raw buffers are held back, so an onset is streamed together
+ * with the sound just before it. `duty_permille` in the stats shows the
+ * share of buffers that were filtered.
+ *
+ * ### Typical usage
+ * @code
+ * init_pdm_microphone();
+ * mic_stream_start(NULL);          // DSP task on core 1
+ *
+ * // In the consumer task:
+ * int16_t pcm[128];
+ * size_t n = mic_stream_read(pcm, 128, 100);
+ * @endcode
+ */
+
+#ifndef TKJHAT_MIC_STREAM_H
+#define TKJHAT_MIC_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <tkjhat/sdk.h>
+#include <tkjhat/mic_gate.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MIC_STREAM_STACK_SIZE           512     /**< DSP task stack (words). */
+#define MIC_STREAM_PRIORITY_DEFAULT     6
+#define MIC_STREAM_FRAMES_DEFAULT       4       /**< Stream capacity in raw buffers. */
+#define MIC_STREAM_PREROLL_DEFAULT      2       /**< Raw buffers kept before an onset. */
+
+/** Configuration of the DSP task. */
+typedef struct {
+    uint32_t priority;      /**< FreeRTOS priority; keep it above the consumers. */
+    int core;               /**< 0 or 1 to pin the task, -1 to let it float. */
+    uint16_t frames;        /**< Stream capacity in units of ::MEMS_BUFFER_SIZE samples. */
+    bool gate;              /**< Skip silent buffers (see tkjhat/mic_gate.h). */
+    uint8_t preroll;        /**< Buffers streamed before an onset; at most raw ring depth - 2. */
+    mic_gate_config_t gate_cfg;
+} mic_stream_config_t;
+
+/** Timing statistics of the deferred path. */
+typedef struct {
+    uint32_t buffers;           /**< Raw buffers filtered. */
+    uint32_t samples;           /**< PCM samples written to the stream. */
+    uint32_t dropped_samples;   /**< Samples lost because the stream was full. */
+    uint32_t isr_us_max;        /**< Longest sample-ready callback (µs). */
+    uint32_t filter_us_max;     /**< Longest filter pass over one buffer (µs). */
+    uint32_t filter_us_avg;     /**< Running average of the filter pass (µs). */
+    uint32_t latency_us_max;    /**< Longest DMA completion to PCM in stream (µs). */
+    uint32_t latency_us_avg;    /**< Running average of that latency (µs). */
+    uint32_t gated_buffers;     /**< Raw buffers dropped as silent, unfiltered. */
+    uint32_t onsets;            /**< Times the gate opened. */
+    uint32_t duty_permille;     /**< Filtered / all buffers, per mille. */
+    uint32_t gate_energy;       /**< Energy of the last evaluated buffer. */
+    uint32_t gate_floor;        /**< Current noise floor. */
+} mic_stream_stats_t;
+
+/**
+ * @brief Fill @p cfg with default values (core 1, 4 frames, gate off).
+ */
+void mic_stream_default_config(mic_stream_config_t *cfg);
+
+/**
+ * @brief Create the DSP task and stream buffer and start sampling.
+ *
+ * Installs its own sample-ready callback; do not set another one.
+ *
+ * @pre ::init_pdm_microphone() or ::init_pdm_microphone_ex() succeeded
+ *      (one channel).
+ *
+ * @param cfg Configuration, or @c NULL for defaults.
+ * @return 0 on success, -1 on invalid configuration or if already running,
+ *         -2 if the task or stream buffer could not be created, -3 if the
+ *         microphone could not be started.
+ */
+int mic_stream_start(const mic_stream_config_t *cfg);
+
+/**
+ * @brief Stop sampling and delete the DSP task and stream buffer.
+ *
+ * @note No task may be blocked in ::mic_stream_read() while stopping.
+ */
+void mic_stream_stop(void);
+
+/**
+ * @brief Read PCM samples from the stream.
+ *
+ * Returns as soon as at least one sample is available, or after
+ * @p timeout_ms. Only one task should read the stream.
+ *
+ * @param buffer     Destination for 16-bit PCM samples.
+ * @param samples    Capacity of @p buffer in samples.
+ * @param timeout_ms Max. time to wait; 0 polls.
+ * @return Number of samples copied (0 on timeout or if not running).
+ */
+size_t mic_stream_read(int16_t *buffer, size_t samples, uint32_t timeout_ms);
+
+/**
+ * @brief Get the timing statistics.
+ */
+void mic_stream_get_stats(mic_stream_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_MIC_STREAM_H */
@@ -13,6 +13,25 @@
 
 #include "hardware/pio.h"
 
+// Raw PDM capture ring depth (power of two). 0 in the config selects the default.
+// A reader has count-1 buffer times to come back, less the DMA IRQ latency.
+#define PDM_RAW_BUFFER_COUNT_DEFAULT 4
+#define PDM_RAW_BUFFER_MAX           16
+
+// 64 or 128; 0 in the config selects the default.
+#define PDM_DECIMATION_DEFAULT       64
+// Highest PDM clock (sample_rate * decimation) the microphone accepts.
+#define PDM_CLOCK_MAX_HZ             3250000u
+#define PDM_SAMPLE_RATE_MAX          48000u
+// 1, or 2 for two microphones sharing the data line (one per clock edge);
+// 0 in the config selects 1.
+#define PDM_CHANNELS_MAX             2
+
+// Filtered PCM blocks that pdm_microphone_lend() can have out at once;
+// 0 in the config selects the default.
+#define PDM_PCM_BLOCK_COUNT_DEFAULT  2
+#define PDM_PCM_BLOCK_MAX            8
+
 typedef void (*pdm_samples_ready_handler_t)(void);
 
 struct pdm_microphone_config {
@@ -22,6 +41,28 @@ struct pdm_microphone_config {
     uint pio_sm;
     uint sample_rate;
     uint sample_buffer_size;
+    uint raw_buffer_count;
+    uint decimation;
+    uint channels;
+    uint pcm_block_count;
+};
+
+struct pdm_microphone_stats {
+    uint32_t buffers_captured;  // raw buffers completed by DMA since start
+    uint32_t buffers_read;      // raw buffers consumed by pdm_microphone_read
+    uint32_t overruns;          // buffers recycled by DMA before they were read
+    uint32_t underruns;         // reads that found no completed buffer
+    uint32_t late_irqs;         // IRQs that had to account for >1 buffer
+    uint32_t pool_overruns;     // lends refused because every PCM block was out
+    uint32_t pcm_blocks_lent;   // PCM blocks currently lent
+    uint32_t raw_buffer_count;
+    uint32_t sample_rate;
+    uint32_t decimation;
+    uint32_t channels;
+    uint32_t buffer_us;         // audio time covered by one buffer
+    uint32_t filter_us_last;    // PDM -> PCM time of the last buffer
+    uint32_t filter_us_max;
+    uint32_t cpu_load_permille; // filter_us_last / buffer_us, per mille of one core
 };
 
 int pdm_microphone_init(const struct pdm_microphone_config* config);
@@ -35,6 +76,29 @@ void pdm_microphone_set_filter_max_volume(uint8_t max_volume);
 void pdm_microphone_set_filter_gain(uint8_t gain);
 void pdm_microphone_set_filter_volume(uint16_t volume);
 
+// With two channels the output is interleaved (first, second, ...) and
+// samples counts values of both, so it should be a multiple of 2.
 int pdm_microphone_read(int16_t* buffer, size_t samples);
+uint pdm_microphone_available();
+
+// Zero-copy read: filters the oldest raw buffer into a free block of the
+// PCM pool and lends it to the caller until pdm_microphone_return();
+// *samples gets its value count (interleaved as for read). NULL when no
+// raw buffer is ready (an underrun) or when every block is lent (a pool
+// overrun; the raw buffer stays queued). Lend from one context at a time;
+// blocks may be returned from any, in any order.
+const int16_t* pdm_microphone_lend(size_t* samples);
+void pdm_microphone_return(const int16_t* block);
+
+// Raw access for analysis before filtering (see tkjhat/mic_gate.h). Buffers
+// are numbered by completion; [oldest, end) are complete and unread. With
+// two channels the bits of both alternate within each byte.
+uint32_t pdm_microphone_raw_window(uint32_t* oldest);
+const uint8_t* pdm_microphone_raw_buffer(uint32_t seq);
+uint pdm_microphone_raw_buffer_size();
+void pdm_microphone_discard(uint32_t seq);  // mark buffers before seq read, unfiltered
+
+void pdm_microphone_get_stats(struct pdm_microphone_stats* stats);
+void pdm_microphone_reset_stats();
 
 #endif
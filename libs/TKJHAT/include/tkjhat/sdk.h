@@ -120,6 +120,11 @@ SOFTWARE.
 #define VEML6030_I2C_ADDR                       0x10
 #define VEML6030_CONFIG_REG                     0x00
 #define VEML6030_ALS_REG                        0x04
+#define VEML6030_WHITE_REG                      0x05
+#define VEML6030_ALS_WH_REG                     0x01
+#define VEML6030_ALS_WL_REG                     0x02
+#define VEML6030_PSM_REG                        0x03
+#define VEML6030_ALS_INT_REG                    0x06
 
 /* =========================
  *  HDC2021
@@ -129,6 +134,8 @@ SOFTWARE.
 #define HDC2021_TEMP_HIGH                       0x01
 #define HDC2021_HUMIDITY_LOW                    0x02
 #define HDC2021_HUMIDITY_HIGH                   0x03
+#define HDC2021_INT_STATUS                      0x04
+#define HDC2021_INT_ENABLE                      0x07
 #define HDC2021_CONFIG                          0x0E
 #define HDC2021_MEASUREMENT_CONFIG              0x0F
 #define HDC2021_TEMP_THR_L                      0x13
@@ -208,6 +215,29 @@ SOFTWARE.
 #define ICM42670_GYRO_MODE_LN                   0x0C
 #define ICM42670_SENSOR_DATA_START_REG          0x09
 
+// APEX (on-chip motion features), user bank 0
+#define ICM42670_APEX_DATA0_REG                 0x31    // step count LSB (DATA1 = MSB)
+#define ICM42670_APEX_CONFIG0_REG               0x25
+#define ICM42670_APEX_CONFIG1_REG               0x26
+#define ICM42670_WOM_CONFIG_REG                 0x27
+#define ICM42670_INT_SOURCE0_REG                0x2B
+#define ICM42670_INT_SOURCE1_REG                0x2C
+#define ICM42670_INT_STATUS2_REG                0x3B
+#define ICM42670_INT_STATUS3_REG                0x3C
+#define ICM42670_BLK_SEL_W_REG                  0x79
+#define ICM42670_MADDR_W_REG                    0x7A
+#define ICM42670_M_W_REG                        0x7B
+#define ICM42670_BLK_SEL_R_REG                  0x7C
+#define ICM42670_MADDR_R_REG                    0x7D
+#define ICM42670_M_R_REG                        0x7E
+
+// APEX, MREG1 bank (accessed through BLK_SEL / MADDR / M_W / M_R)
+#define ICM42670_MREG1_INT_SOURCE6              0x2F
+#define ICM42670_MREG1_APEX_CONFIG4             0x46
+#define ICM42670_MREG1_WOM_X_THR                0x4B
+#define ICM42670_MREG1_WOM_Y_THR                0x4C
+#define ICM42670_MREG1_WOM_Z_THR                0x4D
+
 /* =========================
  *  Public function prototypes
  * ========================= */
@@ -403,10 +433,42 @@ void init_buzzer(void);
  * @param duration_ms   Duration of the tone in milliseconds.
  *
  * @note This implementation is blocking: the CPU is kept busy
- *       toggling the pin for the entire duration.
+ *       toggling the pin for the entire duration. From a task, prefer
+ *       ::buzzer_tone_start() and @c vTaskDelay().
  */
 void buzzer_play_tone(uint32_t frequency, uint32_t duration_ms);
 
+#define BUZZER_TONE_MIN_HZ  20      /**< Lowest tone of ::buzzer_tone_start(). */
+#define BUZZER_TONE_MAX_HZ  20000   /**< Highest tone of ::buzzer_tone_start(). */
+
+/**
+ * @brief Start a tone on the buzzer and return at once.
+ *
+ * The square wave comes from the PWM slice of the buzzer pin, so the CPU
+ * is free while it plays. Wait with @c vTaskDelay() (or do other work)
+ * and end it with ::buzzer_tone_stop():
+ *
+ * @code
+ * buzzer_tone_start(1000);
+ * vTaskDelay(pdMS_TO_TICKS(100));
+ * buzzer_tone_stop();
+ * @endcode
+ *
+ * @param frequency Tone frequency in Hz, ::BUZZER_TONE_MIN_HZ to
+ *                  ::BUZZER_TONE_MAX_HZ.
+ * @return 0 on success, -1 if @p frequency is out of range.
+ *
+ * @pre ::init_buzzer() has been called.
+ */
+int buzzer_tone_start(uint32_t frequency);
+
+/**
+ * @brief Stop a tone started with ::buzzer_tone_start().
+ *
+ * Stops the PWM slice and leaves the pin a low output again.
+ */
+void buzzer_tone_stop(void);
+
 /**
  * @brief Turn the buzzer off.
  *
@@ -443,18 +505,75 @@ void deinit_buzzer(void);
  * Default parameters:
  * - Data pin: GPIO 16
  * - Clock pin: GPIO 15
- * - Sample rate: 16 kHz
- * - Buffer size: 256 samples
+ * - Sample rate: ::MEMS_SAMPLING_FREQUENCY (8 kHz), 64x decimation
+ * - Buffer size: ::MEMS_BUFFER_SIZE samples
+ *
+ * Same as `init_pdm_microphone_ex(MEMS_SAMPLING_FREQUENCY, 64)`.
  *
  * @return 0 on success, negative value on error.
  */
 int init_pdm_microphone(void);
 
+/**
+ * @brief Initialize the PDM MEMS microphone with a given rate and decimation.
+ *
+ * The PDM clock is @p sample_rate × @p decimation and must not exceed
+ * ::PDM_CLOCK_MAX_HZ (3.25 MHz). The PIO clock divider is derived from it.
+ * The buffer holds whole 1 ms filter blocks, i.e. ::MEMS_BUFFER_SIZE rounded
+ * down to a multiple of @p sample_rate / 1000 (240 samples at 48 kHz).
+ *
+ * | Rate   | 64x PDM clock | 128x PDM clock |
+ * |--------|---------------|----------------|
+ * | 8 kHz  | 512 kHz       | 1.024 MHz      |
+ * | 16 kHz | 1.024 MHz     | 2.048 MHz      |
+ * | 32 kHz | 2.048 MHz     | not supported  |
+ * | 48 kHz | 3.072 MHz     | not supported  |
+ *
+ * Filter cost grows with the PDM clock (one table lookup per PDM byte), so
+ * 16 kHz/64x costs about as much as 8 kHz/128x. The measured cost of the
+ * running configuration is reported by ::pdm_microphone_get_stats()
+ * (`filter_us_last`, `cpu_load_permille`).
+ *
+ * @param sample_rate PCM rate in Hz: 8000, 16000, 32000 or 48000.
+ * @param decimation  64 or 128 (128 gives a cleaner low band at a higher
+ *                    PDM clock).
+ * @return 0 on success, negative value on an unsupported combination or
+ *         allocation failure.
+ */
+int init_pdm_microphone_ex(uint32_t sample_rate, uint8_t decimation);
+
+/**
+ * @brief Initialize two PDM microphones sharing the data line.
+ *
+ * For direction of arrival or a noise reference, a second microphone can
+ * be wired to ::PDM_DATA and ::PDM_CLK with its L/R select opposite to the
+ * HAT microphone. Each then drives the data line on one clock edge, and a
+ * PIO program samples both edges. The PDM clock is the same as in mono;
+ * the raw buffers are twice as large.
+ *
+ * ::get_microphone_samples() returns interleaved pairs: the HAT microphone
+ * (sampled while the clock is low, as in mono) first, the second one next.
+ * Both channels are decimated in one pass: each pair of raw bytes is
+ * unzipped into one byte per channel with two table lookups, and both
+ * channels' sinc sums are accumulated in the same loop. The unzip comes on
+ * top of two mono filters: the `pdm_bench` host tool measures stereo at
+ * 2.2-2.5 times the cost of mono.
+ *
+ * @param sample_rate PCM rate per channel, as for ::init_pdm_microphone_ex().
+ * @param decimation  64 or 128.
+ * @return 0 on success, negative value on an unsupported combination or
+ *         allocation failure.
+ *
+ * @note tkjhat/mic_stream.h is mono only and refuses to start on a stereo
+ *       microphone; read the pairs with ::get_microphone_samples().
+ */
+int init_pdm_microphone_stereo(uint32_t sample_rate, uint8_t decimation);
+
 /**
  * @brief Start microphone sampling.
  *
  * Begins continuous capture of PCM samples from the microphone
- * at 16 kHz with a buffer size of 256 samples.
+ * at the rate selected at initialization.
  *
  * @return 0 on success, negative value on error.
  */
@@ -481,16 +600,53 @@ void pdm_microphone_set_callback(pdm_samples_ready_handler_t handler);
 /**
  * @brief Retrieve PCM samples from the microphone buffer.
  *
- * Copies up to @p samples 16-bit values into the provided buffer.
+ * Copies up to @p samples 16-bit values into the provided buffer. With
+ * ::init_pdm_microphone_stereo() the values are interleaved pairs and
+ * @p samples counts both channels.
  *
  * @param buffer  Destination buffer for PCM samples.
  * @param samples Number of samples to read.
  * @return The number of samples actually read, or negative on error.
  *
- * @note This function is called inside the sample-ready callback. Otherwise, might not work. 
+ * @note Usually called from the sample-ready callback. Capture runs from a
+ *       ring of ::PDM_RAW_BUFFER_COUNT_DEFAULT raw buffers, so a caller may
+ *       fall up to that many buffers minus one behind. Older buffers are
+ *       dropped and counted as overruns; see ::pdm_microphone_get_stats().
+ *       The filter runs in the caller's context, i.e. in the DMA interrupt
+ *       when called from the callback; tkjhat/mic_stream.h runs it on a
+ *       task instead.
  */
 int get_microphone_samples(int16_t *buffer, size_t samples);
 
+/**
+ * @brief Borrow the next block of PCM samples without copying it.
+ *
+ * Filters the oldest raw buffer into a free block of the driver's PCM pool
+ * (::PDM_PCM_BLOCK_COUNT_DEFAULT blocks of ::MEMS_BUFFER_SIZE values) and
+ * hands out a pointer to it. The block stays valid until it is given back
+ * with ::return_microphone_samples(), so it can be written out or passed on
+ * to another task as is.
+ *
+ * @param samples Set to the number of values in the block (interleaved
+ *                pairs after ::init_pdm_microphone_stereo()), 0 on NULL.
+ * @return The block, or NULL if no raw buffer is ready yet or every block
+ *         is still lent. The latter is counted in `pool_overruns` of
+ *         ::pdm_microphone_get_stats(); the raw buffer then stays queued
+ *         until a block comes back or the capture ring overwrites it.
+ *
+ * @note Borrow from one context at a time (e.g. one task). Blocks may be
+ *       returned from any context, including an interrupt, in any order.
+ *       Neither call disables interrupts.
+ */
+const int16_t *lend_microphone_samples(size_t *samples);
+
+/**
+ * @brief Give back a block from ::lend_microphone_samples().
+ *
+ * @param block The pointer that was lent; NULL is ignored.
+ */
+void return_microphone_samples(const int16_t *block);
+
 
 
 /**
@@ -737,6 +893,29 @@ void stop_display(void);
  * @{
  */
 
+/**
+ * @brief VEML6030 gain settings (register encoding).
+ */
+typedef enum {
+    VEML6030_GAIN_1   = 0,  /**< x1 */
+    VEML6030_GAIN_2   = 1,  /**< x2 (most sensitive) */
+    VEML6030_GAIN_1_8 = 2,  /**< x1/8 (least sensitive) */
+    VEML6030_GAIN_1_4 = 3   /**< x1/4 */
+} veml6030_gain_t;
+
+/**
+ * @brief One VEML6030 measurement.
+ */
+typedef struct {
+    uint16_t als;               /**< Raw ALS counts. */
+    uint16_t white;             /**< Raw WHITE channel counts (0 if not requested). */
+    veml6030_gain_t gain;       /**< Gain used for this result. */
+    uint16_t it_ms;             /**< Integration time used for this result (ms). */
+    uint32_t resolution_1e4;    /**< ALS resolution in units of 0.0001 lx per count. */
+    uint32_t lux_mlx;           /**< Corrected illuminance in millilux. */
+    bool fresh;                 /**< @c false if this repeats the previous result. */
+} veml6030_reading_t;
+
 /**
  * @brief Initialize the VEML6030 light sensor.
  *
@@ -745,6 +924,7 @@ void stop_display(void);
  * - Integration time: 100 ms
  * - Power: ON
  * - Interrupts: disabled
+ * - Auto-range: enabled
  *
  * @note Call @c init_i2c_default before this function.
  */
@@ -753,17 +933,139 @@ void init_veml6030(void);
 /**
  * @brief Read the current light level in lux.
  *
- * Fetches the raw ALS (ambient light sensing) output and applies the
- * recommended conversion factor. For high-light conditions, a polynomial
- * correction is applied (per Vishay app note).
+ * Shortcut for ::veml6030_read() that returns only the corrected lux value.
  *
- * @return Ambient light level in lux.
+ * @return Ambient light level in lux (0 on I²C error).
  *
  * @note Ensure that sufficient time has passed since the last sample
- *       (> integration time, i.e. 100 ms).
+ *       (> integration time, 100 ms by default).
  */
 uint32_t veml6030_read_light(void);
 
+/**
+ * @brief Read the ALS (and optionally WHITE) channel.
+ *
+ * The raw counts are converted with the resolution of the current gain and
+ * integration time. Above 1000 lx the Vishay non-linearity correction is
+ * applied (integer arithmetic only).
+ *
+ * With auto-range enabled, each call moves the gain/integration time at most
+ * one step to keep the counts between 100 and 10000: more gain first, then
+ * longer integration in the dark, and the reverse in bright light. The call
+ * never waits; until a measurement with the new setting is available the
+ * previous reading is returned with @c fresh = @c false.
+ *
+ * @param out        Destination.
+ * @param with_white Also read the WHITE channel (one extra I²C transfer).
+ * @return 0 on success, -1 on I²C read error, -2 if the new range could not be written.
+ */
+int veml6030_read(veml6030_reading_t *out, bool with_white);
+
+/**
+ * @brief Set a fixed gain and integration time (disables auto-range).
+ *
+ * @param gain  Gain setting.
+ * @param it_ms Integration time: 25, 50, 100, 200, 400 or 800 ms.
+ * @return 0 on success, -1 on invalid argument, -2 on I²C error.
+ */
+int veml6030_set_range(veml6030_gain_t gain, uint16_t it_ms);
+
+/**
+ * @brief Enable or disable automatic gain/integration time selection.
+ */
+void veml6030_set_auto_range(bool enable);
+
+/**
+ * @brief Number of consecutive out-of-window measurements needed to raise
+ *        the interrupt (persistence filter).
+ */
+typedef enum {
+    VEML6030_PERS_1 = 0,
+    VEML6030_PERS_2,
+    VEML6030_PERS_4,
+    VEML6030_PERS_8
+} veml6030_persistence_t;
+
+/**
+ * @brief Threshold interrupt configuration.
+ *
+ * Either a fixed window (@c low_mlx .. @c high_mlx) or, with
+ * @c track_pct > 0, a window of ±track_pct % that is re-centred on the
+ * current level after every event ("light changed" events).
+ */
+typedef struct {
+    uint32_t low_mlx;                   /**< Low threshold (millilux), fixed window. */
+    uint32_t high_mlx;                  /**< High threshold (millilux), fixed window. */
+    uint8_t track_pct;                  /**< Tracking window in %, 0 = fixed window. */
+    veml6030_persistence_t persistence; /**< Persistence filter. */
+} veml6030_threshold_config_t;
+
+/** Light went above the high threshold. */
+#define VEML6030_EVT_HIGH                       0x01
+/** Light went below the low threshold. */
+#define VEML6030_EVT_LOW                        0x02
+
+/**
+ * @brief Interrupt statistics since the threshold interrupt was enabled.
+ */
+typedef struct {
+    uint32_t wakeups;           /**< Interrupts on @ref VEML6030_INTERRUPT. */
+    uint32_t events_high;       /**< High threshold events. */
+    uint32_t events_low;        /**< Low threshold events. */
+    uint32_t elapsed_ms;        /**< Time since enabling. */
+    uint32_t poll_equivalent;   /**< Reads a poller would have made (one per measurement). */
+} veml6030_event_stats_t;
+
+/**
+ * @brief Enable the threshold interrupt on @ref VEML6030_INTERRUPT (GPIO 9).
+ *
+ * Thresholds are converted to counts with the current gain and integration
+ * time, so auto-range is disabled. Choose the range with
+ * ::veml6030_set_range() first if needed.
+ *
+ * @param cfg Threshold configuration.
+ * @return 0 on success, -1 on invalid argument, -2 on I²C error.
+ */
+int veml6030_enable_threshold_interrupt(const veml6030_threshold_config_t *cfg);
+
+/**
+ * @brief Disable the threshold interrupt and release the GPIO handler.
+ *
+ * @return 0 on success, -2 on I²C error.
+ */
+int veml6030_disable_threshold_interrupt(void);
+
+/**
+ * @brief Select the power-saving mode.
+ *
+ * In PSM the sensor waits 500 / 1000 / 2000 / 4000 ms (modes 1–4) between
+ * measurements, cutting its current consumption. Thresholds keep working.
+ *
+ * @param mode 0 = off, 1–4 = PSM mode.
+ * @return 0 on success, -1 on invalid mode, -2 on I²C error.
+ */
+int veml6030_set_power_saving(uint8_t mode);
+
+/**
+ * @brief Block the calling task until a threshold event happens.
+ *
+ * The first call makes the calling task the receiver of the interrupt.
+ * The handler is added with gpio_add_raw_irq_handler(), so it coexists with
+ * the button callbacks.
+ *
+ * @param timeout_ms Maximum time to wait.
+ * @return VEML6030_EVT_* bitmask, 0 on timeout, -1 if the interrupt is not
+ *         enabled, -2 on I²C error.
+ *
+ * @note Call only from a FreeRTOS task.
+ */
+int veml6030_wait_event(uint32_t timeout_ms);
+
+/**
+ * @brief Get wake-up statistics, to compare with polling.
+ */
+void veml6030_get_event_stats(veml6030_event_stats_t *out);
+
 /**
  * @brief Power down the VEML6030.
  *
@@ -880,6 +1182,96 @@ float hdc2021_read_temperature(void);
  */
 float hdc2021_read_humidity(void);
 
+/** Auto-measurement rates (AMM field encoding). */
+typedef enum {
+    HDC2021_RATE_0_2HZ = 4,     /**< One sample every 5 s. */
+    HDC2021_RATE_1HZ   = 5,     /**< Default. */
+    HDC2021_RATE_2HZ   = 6,
+    HDC2021_RATE_5HZ   = 7
+} hdc2021_rate_t;
+
+/** Measurement resolution (longer conversion and more current at 14 bit). */
+typedef enum {
+    HDC2021_RES_14BIT = 0,
+    HDC2021_RES_11BIT = 1,
+    HDC2021_RES_9BIT  = 2
+} hdc2021_resolution_t;
+
+/** @name HDC2021 events (same bits as the status and enable registers) */
+/** @{ */
+#define HDC2021_EVT_DRDY                        0x80  /**< New sample ready. */
+#define HDC2021_EVT_TEMP_HIGH                   0x40  /**< Temperature above high threshold. */
+#define HDC2021_EVT_TEMP_LOW                    0x20  /**< Temperature below low threshold. */
+#define HDC2021_EVT_HUM_HIGH                    0x10  /**< Humidity above high threshold. */
+#define HDC2021_EVT_HUM_LOW                     0x08  /**< Humidity below low threshold. */
+#define HDC2021_EVT_ALL                         0xF8
+/** @} */
+
+/** One temperature/humidity sample. */
+typedef struct {
+    float temperature;          /**< °C */
+    float humidity;             /**< %RH */
+    uint16_t raw_temperature;   /**< Raw register value. */
+    uint16_t raw_humidity;      /**< Raw register value. */
+    uint8_t events;             /**< HDC2021_EVT_* flags pending when the sample was read. */
+    uint32_t timestamp_us;      /**< time_us_32() when the sample was read. */
+} hdc2021_sample_t;
+
+/**
+ * @brief Set the auto-measurement rate and resolutions.
+ *
+ * @param rate     Measurement rate (0.2–5 Hz).
+ * @param temp_res Temperature resolution.
+ * @param hum_res  Humidity resolution.
+ * @return 0 on success, -1 on invalid argument.
+ */
+int hdc2021_configure(hdc2021_rate_t rate, hdc2021_resolution_t temp_res,
+                      hdc2021_resolution_t hum_res);
+
+/**
+ * @brief Route events to @ref HDC2021_INTERRUPT (GPIO 21).
+ *
+ * The pin is configured active low, cleared when the status is read.
+ * Threshold events repeat on every measurement while the value stays out
+ * of range, which suits alarms.
+ *
+ * @param events OR of HDC2021_EVT_* flags.
+ * @return 0 on success, -1 on invalid argument.
+ */
+int hdc2021_enable_interrupts(uint8_t events);
+
+/**
+ * @brief Disable the interrupt pin and release the GPIO handler.
+ */
+void hdc2021_disable_interrupts(void);
+
+/**
+ * @brief Read temperature, humidity and status in one I²C burst.
+ *
+ * Cheaper than ::hdc2021_read_temperature() plus ::hdc2021_read_humidity().
+ * Reading the status clears pending events.
+ *
+ * @param out Destination.
+ * @return 0 on success, -2 on I²C error.
+ */
+int hdc2021_read_sample(hdc2021_sample_t *out);
+
+/**
+ * @brief Block the calling task until the sensor raises an event.
+ *
+ * The GPIO interrupt only notifies the task; the task then reads the four
+ * data bytes and the status register in a single I²C burst.
+ *
+ * @param out        Sample read when the event arrived.
+ * @param timeout_ms Maximum time to wait.
+ * @return HDC2021_EVT_* flags, 0 on timeout, -1 if interrupts are not enabled,
+ *         -2 on I²C error.
+ *
+ * @note Call only from a FreeRTOS task. The handler is added with
+ *       gpio_add_raw_irq_handler(), so it coexists with the button callbacks.
+ */
+int hdc2021_wait_sample(hdc2021_sample_t *out, uint32_t timeout_ms);
+
 /** @} */ // end of group HDC2021
 
 
@@ -989,6 +1381,336 @@ int ICM42670_read_sensor_data(float *ax, float *ay, float *az,
                               float *gx, float *gy, float *gz,
                               float *t);
 
+/**
+ * @brief One raw IMU sample, exactly as stored in the sensor registers.
+ *
+ * Values are signed 16-bit counts. Use the scale factors in
+ * ::icm42670_config_t (or the batch converters) to obtain physical units.
+ */
+struct icm_raw {
+    int16_t ax, ay, az;   /**< Accelerometer counts. */
+    int16_t gx, gy, gz;   /**< Gyroscope counts. */
+    int16_t t;            /**< Temperature counts (°C = t / 128 + 25). */
+};
+
+/**
+ * @brief Scaling configuration of the IMU instance.
+ *
+ * Filled by ::ICM42670_startAccel() and ::ICM42670_startGyro(). Besides the
+ * sensitivities (@c aRes, @c gRes, in LSB per g / LSB per dps) it keeps their
+ * reciprocals, both as float and as a 16-bit multiplier plus right shift, so
+ * conversions never need a division:
+ *
+ * @code
+ * value_q16 = (raw * recip_q + round) >> shift;   // Q16.16 g or dps
+ * @endcode
+ */
+typedef struct {
+    uint16_t accel_fsr_g;     /**< Accelerometer full-scale range (g). */
+    uint16_t accel_odr_hz;    /**< Accelerometer output data rate (Hz). */
+    uint16_t gyro_fsr_dps;    /**< Gyroscope full-scale range (dps). */
+    uint16_t gyro_odr_hz;     /**< Gyroscope output data rate (Hz). */
+    float aRes;               /**< Accelerometer sensitivity (LSB/g). */
+    float gRes;               /**< Gyroscope sensitivity (LSB/dps). */
+    float accel_scale;        /**< 1 / aRes (g per LSB). */
+    float gyro_scale;         /**< 1 / gRes (dps per LSB). */
+    uint16_t accel_recip_q;   /**< 2^(16+accel_shift) / aRes, rounded. */
+    uint16_t gyro_recip_q;    /**< 2^(16+gyro_shift) / gRes, rounded. */
+    uint8_t accel_shift;      /**< Right shift applied after multiplying by accel_recip_q. */
+    uint8_t gyro_shift;       /**< Right shift applied after multiplying by gyro_recip_q. */
+} icm42670_config_t;
+
+/**
+ * @brief Structure-of-arrays view of raw IMU samples.
+ *
+ * Each member points to an array of @c n samples of one channel. Any pointer
+ * may be @c NULL, in which case that channel is skipped by the converters.
+ */
+struct icm_raw_soa {
+    int16_t *ax, *ay, *az;
+    int16_t *gx, *gy, *gz;
+    int16_t *t;
+};
+
+/**
+ * @brief Structure-of-arrays output in Q16.16 fixed point (g, dps, °C).
+ *
+ * Same @c NULL rules as ::icm_raw_soa. A channel is converted only if both
+ * the input and the output pointer are set.
+ */
+struct icm_q16_soa {
+    int32_t *ax, *ay, *az;
+    int32_t *gx, *gy, *gz;
+    int32_t *t;
+};
+
+/**
+ * @brief Structure-of-arrays output in float (g, dps, °C).
+ *
+ * Same @c NULL rules as ::icm_raw_soa.
+ */
+struct icm_float_soa {
+    float *ax, *ay, *az;
+    float *gx, *gy, *gz;
+    float *t;
+};
+
+/**
+ * @brief Read one raw sample (temperature, accel, gyro) in a single burst.
+ *
+ * No unit conversion is done, which keeps the call cheap enough for
+ * high-rate logging. Convert later in batches with
+ * ::ICM42670_convert_batch_q16() or ::ICM42670_convert_batch_float().
+ *
+ * @param raw Destination sample. Must not be @c NULL.
+ *
+ * @return 0 on success, negative value on error.
+ */
+int ICM42670_read_raw(struct icm_raw *raw);
+
+/**
+ * @brief Get the scaling configuration of the IMU.
+ *
+ * @return Pointer to the SDK's IMU configuration. It is updated by
+ *         ::ICM42670_startAccel() and ::ICM42670_startGyro().
+ */
+const icm42670_config_t *ICM42670_get_config(void);
+
+/**
+ * @brief Convert a batch of raw samples to Q16.16 fixed point.
+ *
+ * Every sample is scaled with a 32-bit multiply and a shift (no division,
+ * no float), so it is suitable for the Cortex-M0+ of the RP2040.
+ * Relative error of the scale factor is below 2^-15.
+ *
+ * @param cfg Scaling configuration (usually ::ICM42670_get_config()).
+ * @param in  Raw input arrays.
+ * @param out Output arrays (g, dps and °C in Q16.16).
+ * @param n   Number of samples per array.
+ */
+void ICM42670_convert_batch_q16(const icm42670_config_t *cfg,
+                                const struct icm_raw_soa *in,
+                                struct icm_q16_soa *out, size_t n);
+
+/**
+ * @brief Convert a batch of raw samples to float.
+ *
+ * Multiplies by the precomputed reciprocals instead of dividing by
+ * @c aRes / @c gRes for every value.
+ *
+ * @param cfg Scaling configuration (usually ::ICM42670_get_config()).
+ * @param in  Raw input arrays.
+ * @param out Output arrays (g, dps and °C).
+ * @param n   Number of samples per array.
+ */
+void ICM42670_convert_batch_float(const icm42670_config_t *cfg,
+                                  const struct icm_raw_soa *in,
+                                  struct icm_float_soa *out, size_t n);
+
+/* ---------- Calibration ---------- */
+
+/** Number of samples averaged by default in each calibration capture. */
+#define ICM42670_CALIB_SAMPLES_DEFAULT          512
+/** ODR used while capturing calibration data (Hz). */
+#define ICM42670_CALIB_ODR_HZ                   1600
+/** Max. peak-to-peak gyro motion (dps) accepted as "stationary". */
+#define ICM42670_CALIB_STILL_DPS                3
+
+/**
+ * @brief Orientations used by the six-position accelerometer calibration.
+ *
+ * The name tells which axis points up (against gravity), e.g.
+ * @c ICM42670_FACE_Z_UP is the board lying flat on the table.
+ */
+typedef enum {
+    ICM42670_FACE_X_UP = 0,
+    ICM42670_FACE_X_DOWN,
+    ICM42670_FACE_Y_UP,
+    ICM42670_FACE_Y_DOWN,
+    ICM42670_FACE_Z_UP,
+    ICM42670_FACE_Z_DOWN,
+    ICM42670_FACE_COUNT
+} icm42670_face_t;
+
+/**
+ * @brief IMU calibration data, independent of the configured FSR.
+ *
+ * Offsets are stored in Q16.16 g and dps. Scale factors are Q2.14
+ * (16384 = 1.0) and multiply the offset-corrected counts.
+ */
+typedef struct {
+    int32_t gyro_bias_q16[3];      /**< Gyro zero-rate offset (dps, Q16.16). */
+    int32_t accel_offset_q16[3];   /**< Accel zero-g offset (g, Q16.16). */
+    uint16_t accel_scale_q14[3];   /**< Accel gain correction (Q2.14). */
+    uint16_t flags;                /**< ::ICM42670_CALIB_GYRO / ::ICM42670_CALIB_ACCEL. */
+} icm42670_calibration_t;
+
+#define ICM42670_CALIB_GYRO                     0x0001  /**< Gyro bias is valid. */
+#define ICM42670_CALIB_ACCEL                    0x0002  /**< Accel offset/scale are valid. */
+
+/**
+ * @brief Measure the gyroscope bias.
+ *
+ * Temporarily raises the gyro ODR to @ref ICM42670_CALIB_ODR_HZ, averages
+ * @p samples readings and restores the previous ODR. The board must be
+ * completely still.
+ *
+ * @param samples Number of samples to average (0 = @ref ICM42670_CALIB_SAMPLES_DEFAULT).
+ *
+ * @return 0 on success, -1 if the IMU is not started, -2 on I²C error,
+ *         -3 if the board moved during the capture.
+ *
+ * @note The new bias is applied immediately. Call ::ICM42670_calibration_save()
+ *       to keep it across resets.
+ */
+int ICM42670_calibrate_gyro(uint16_t samples);
+
+/**
+ * @brief Capture one of the six accelerometer calibration orientations.
+ *
+ * Place the board with the given axis pointing up, keep it still and call
+ * this function. When all six orientations have been captured the offset and
+ * scale of each axis are computed and applied.
+ *
+ * @param face    Orientation being captured.
+ * @param samples Number of samples to average (0 = @ref ICM42670_CALIB_SAMPLES_DEFAULT).
+ *
+ * @return Bitmask of the orientations captured so far (0x3F = done and
+ *         applied), or negative value on error (see ::ICM42670_calibrate_gyro()).
+ *         -4 means the selected axis does not read about ±1 g (wrong orientation).
+ */
+int ICM42670_calibrate_accel(icm42670_face_t face, uint16_t samples);
+
+/**
+ * @brief Store the current calibration in the reserved flash sector.
+ *
+ * The record is protected with a CRC-32.
+ *
+ * @return 0 on success, negative value on error.
+ *
+ * @warning Writing flash stalls both cores for a few tens of milliseconds.
+ */
+int ICM42670_calibration_save(void);
+
+/**
+ * @brief Load the calibration from flash and apply it.
+ *
+ * @return 0 on success, -1 if there is no stored calibration, -2 if it is corrupted,
+ *         -3 if the program has grown into the flash sector reserved for it.
+ */
+int ICM42670_calibration_load(void);
+
+/**
+ * @brief Apply a calibration (or remove it with @c NULL).
+ *
+ * @param cal Calibration to use, or @c NULL to read uncorrected data.
+ */
+void ICM42670_set_calibration(const icm42670_calibration_t *cal);
+
+/**
+ * @brief Get the calibration currently applied.
+ *
+ * @return Pointer to the active calibration (flags = 0 if none).
+ */
+const icm42670_calibration_t *ICM42670_get_calibration(void);
+
+/* ---------- APEX motion features ---------- */
+
+/** @name APEX feature selection (::icm42670_apex_config_t::features) */
+/** @{ */
+#define ICM42670_APEX_TILT                      0x01  /**< Tilt detector (>35° held for the wait time). */
+#define ICM42670_APEX_PEDOMETER                 0x02  /**< Step detector and counter. */
+#define ICM42670_APEX_SMD                       0x04  /**< Significant motion (uses the pedometer). */
+#define ICM42670_APEX_WOM                       0x08  /**< Wake-on-motion threshold on any axis. */
+/** @} */
+
+/** @name APEX events returned by ::ICM42670_apex_read_events() */
+/** @{ */
+#define ICM42670_EVT_TILT                       0x0001
+#define ICM42670_EVT_STEP                       0x0002
+#define ICM42670_EVT_STEP_OVERFLOW              0x0004
+#define ICM42670_EVT_SMD                        0x0008
+#define ICM42670_EVT_WOM_X                      0x0010
+#define ICM42670_EVT_WOM_Y                      0x0020
+#define ICM42670_EVT_WOM_Z                      0x0040
+#define ICM42670_EVT_WOM                        (ICM42670_EVT_WOM_X | ICM42670_EVT_WOM_Y | ICM42670_EVT_WOM_Z)
+/** @} */
+
+/** @name Wake-on-motion threshold (mg). The register has 1 g / 256 (~3.9 mg) steps. */
+/** @{ */
+#define ICM42670_WOM_THRESHOLD_DEFAULT          100
+#define ICM42670_WOM_THRESHOLD_MIN              4     /**< 1 LSB. */
+#define ICM42670_WOM_THRESHOLD_MAX              996   /**< 255 LSB. */
+/** @} */
+
+/**
+ * @brief Configuration of the APEX motion features.
+ */
+typedef struct {
+    uint8_t features;          /**< OR of ICM42670_APEX_* flags. */
+    uint16_t wom_threshold_mg; /**< Wake-on-motion threshold, 4..996 mg, rounded to 1 g / 256 steps. */
+    uint8_t tilt_wait_s;       /**< Time the tilt must be held: 0, 2, 4 or 6 s. */
+    bool low_power;            /**< Accel in low-power mode and gyro off while APEX runs. */
+} icm42670_apex_config_t;
+
+/**
+ * @brief Start the APEX motion features of the ICM-42670.
+ *
+ * The motion processor runs inside the sensor at 50 Hz, so gestures are
+ * detected without polling the IMU over I²C. Each enabled feature is routed
+ * to the INT1 pin (@ref ICM42670_INT); use ::ICM42670_apex_wait_events() to
+ * block a task until something happens.
+ *
+ * The accelerometer ODR is set to 50 Hz. With @c low_power the gyroscope is
+ * switched off, otherwise both sensors stay in low-noise mode so raw reads
+ * keep working.
+ *
+ * @param cfg Features and thresholds.
+ * @return 0 on success, -1 on invalid configuration (including a WOM
+ *         threshold outside ::ICM42670_WOM_THRESHOLD_MIN..::ICM42670_WOM_THRESHOLD_MAX),
+ *         -2 on I²C error.
+ *
+ * @note The ICM-42670-P has no tap detector.
+ */
+int ICM42670_apex_start(const icm42670_apex_config_t *cfg);
+
+/**
+ * @brief Disable all APEX features and their interrupts.
+ *
+ * @return 0 on success, negative value on I²C error.
+ */
+int ICM42670_apex_stop(void);
+
+/**
+ * @brief Read (and clear) the pending APEX events.
+ *
+ * @return Bitmask of ICM42670_EVT_* flags (0 if none), or negative value on I²C error.
+ */
+int ICM42670_apex_read_events(void);
+
+/**
+ * @brief Block the calling task until an APEX event happens.
+ *
+ * The first call attaches an interrupt handler to @ref ICM42670_INT and makes
+ * the calling task the receiver of the events. Only one task may wait.
+ * The handler is added with gpio_add_raw_irq_handler(), so it coexists with
+ * the button callbacks.
+ *
+ * @param timeout_ms Maximum time to wait.
+ * @return Bitmask of ICM42670_EVT_* flags, 0 on timeout, negative value on I²C error.
+ *
+ * @note Call only from a FreeRTOS task.
+ */
+int ICM42670_apex_wait_events(uint32_t timeout_ms);
+
+/**
+ * @brief Read the pedometer step counter.
+ *
+ * @param steps Destination for the number of steps since APEX was started.
+ * @return 0 on success, negative value on I²C error.
+ */
+int ICM42670_apex_get_step_count(uint16_t *steps);
+
 /** @} */ // end of group ICM42670
 
 
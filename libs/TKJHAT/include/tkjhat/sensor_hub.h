@@ -0,0 +1,210 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file tkjhat/sensor_hub.h
+ * @brief One task that samples all HAT I²C sensors on a schedule.
+ *
+ * @details
+ * Instead of one task per sensor (each with its own stack and its own
+ * vTaskDelay loop), the hub runs a single task that knows the period and
+ * deadline of every sensor:
+ *
+ * - Due times are absolute (like vTaskDelayUntil), so periods do not drift.
+ * - All sensors due in the same tick are read back to back, one I²C burst
+ *   per sensor, so the bus is used by a single owner.
+ * - Every sample is stored with its timestamp in a snapshot protected by a
+ *   sequence lock. Readers on any task or core never block the hub.
+ * - Per-sensor jitter (start of read vs. ideal due time), deadline misses
+ *   and the stack high-water mark of the hub are available with
+ *   ::sensor_hub_get_stats().
+ *
+ * For comparison: three per-sensor tasks at main.c's DEFAULT_STACK_SIZE
+ * use 3 × 2048 words = 24 KiB of stack, the hub uses
+ * @ref SENSOR_HUB_STACK_SIZE words; check the high-water mark to size it.
+ * tools/hub_jitter compares the jitter of both on the host model.
+ *
+ * Work that must see every sample (a filter, a classifier) can run in
+ * the @ref sensor_hub_config_t::on_sample callback instead of a polling
+ * task of its own; main.c runs its tilt keyer that way. Code that only
+ * shows the latest values reads the snapshots, as examples/hat_example
+ * does.
+ *
+ * @note Initialize and start the sensors before ::sensor_hub_start().
+ *       While the hub runs, no other task should access these sensors
+ *       (e.g. do not run imu_fusion at the same time as the hub IMU channel).
+ *
+ * ### Typical usage
+ * @code
+ * sensor_hub_config_t cfg;
+ * sensor_hub_default_config(&cfg);
+ * cfg.channel[SENSOR_HUB_IMU].period_ms = 5;   // 200 Hz
+ * sensor_hub_start(&cfg);
+ *
+ * sensor_hub_env_t env;
+ * if (sensor_hub_get_env(&env)) printf("%.1f C\n", env.temperature);
+ * @endcode
+ */
+
+#ifndef TKJHAT_SENSOR_HUB_H
+#define TKJHAT_SENSOR_HUB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <tkjhat/sdk.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SENSOR_HUB_STACK_SIZE           768     /**< Hub task stack (words). */
+#define SENSOR_HUB_PRIORITY_DEFAULT     3
+
+/** Sensors handled by the hub. */
+typedef enum {
+    SENSOR_HUB_IMU = 0,     /**< ICM-42670 accel + gyro + temperature. */
+    SENSOR_HUB_LIGHT,       /**< VEML6030 ambient light. */
+    SENSOR_HUB_ENV,         /**< HDC2021 temperature + humidity. */
+    SENSOR_HUB_COUNT
+} sensor_hub_sensor_t;
+
+/** Schedule of one sensor. */
+typedef struct {
+    bool enabled;
+    uint16_t period_ms;     /**< Sampling period. */
+    uint16_t deadline_us;   /**< Max. allowed lateness of a read. */
+} sensor_hub_channel_t;
+
+/**
+ * Called on the hub task after a sample of @p sensor has been published;
+ * read it with the matching sensor_hub_get_*(). Keep it short (no printf,
+ * no blocking): the next sensor waits for it.
+ */
+typedef void (*sensor_hub_callback_t)(sensor_hub_sensor_t sensor, void *ctx);
+
+/** Hub configuration. */
+typedef struct {
+    sensor_hub_channel_t channel[SENSOR_HUB_COUNT];
+    uint32_t priority;      /**< FreeRTOS priority of the hub task. */
+    int core;               /**< 0 or 1 to pin the task, -1 to let it float. */
+    sensor_hub_callback_t on_sample; /**< Optional, @c NULL for none. */
+    void *ctx;              /**< Passed to @ref on_sample. */
+} sensor_hub_config_t;
+
+/** Latest IMU sample. */
+typedef struct {
+    struct icm_raw raw;     /**< Calibrated raw counts. */
+    float ax, ay, az;       /**< g */
+    float gx, gy, gz;       /**< dps */
+    float t;                /**< °C */
+    uint64_t timestamp_us;  /**< When the read started. */
+    uint32_t count;         /**< Samples taken so far. */
+} sensor_hub_imu_t;
+
+/** Latest light sample. */
+typedef struct {
+    veml6030_reading_t reading;
+    uint64_t timestamp_us;
+    uint32_t count;
+} sensor_hub_light_t;
+
+/** Latest temperature/humidity sample. */
+typedef struct {
+    float temperature;      /**< °C */
+    float humidity;         /**< %RH */
+    uint64_t timestamp_us;
+    uint32_t count;
+} sensor_hub_env_t;
+
+/** Timing statistics of one sensor. */
+typedef struct {
+    uint32_t samples;           /**< Successful reads. */
+    uint32_t errors;            /**< Failed reads. */
+    uint32_t deadline_misses;   /**< Reads started later than the deadline. */
+    uint32_t skipped;           /**< Periods dropped because the hub fell behind. */
+    uint32_t jitter_us_max;     /**< Worst lateness of a read (µs). */
+    uint32_t jitter_us_avg;     /**< Running average lateness (µs). */
+    uint32_t read_us_max;       /**< Longest I²C transaction (µs). */
+} sensor_hub_channel_stats_t;
+
+/** Hub statistics. */
+typedef struct {
+    sensor_hub_channel_stats_t channel[SENSOR_HUB_COUNT];
+    uint32_t wakeups;               /**< Times the hub task woke up. */
+    uint32_t stack_words;           /**< Stack given to the hub task. */
+    uint32_t stack_free_min_words;  /**< Stack high-water mark (never used words). */
+} sensor_hub_stats_t;
+
+/**
+ * @brief Fill @p cfg with defaults: IMU 100 Hz, light 10 Hz, temperature
+ *        and humidity 1 Hz, all enabled.
+ */
+void sensor_hub_default_config(sensor_hub_config_t *cfg);
+
+/**
+ * @brief Start the hub task.
+ *
+ * @param cfg Configuration, or @c NULL for defaults.
+ * @return 0 on success, -1 on invalid configuration or already running,
+ *         -2 if the task could not be created.
+ */
+int sensor_hub_start(const sensor_hub_config_t *cfg);
+
+/**
+ * @brief Stop the hub task. The last samples stay readable.
+ */
+void sensor_hub_stop(void);
+
+/**
+ * @brief Copy the latest IMU sample. Never blocks.
+ * @return @c false if no sample has been taken yet.
+ */
+bool sensor_hub_get_imu(sensor_hub_imu_t *out);
+
+/**
+ * @brief Copy the latest light sample. Never blocks.
+ * @return @c false if no sample has been taken yet.
+ */
+bool sensor_hub_get_light(sensor_hub_light_t *out);
+
+/**
+ * @brief Copy the latest temperature/humidity sample. Never blocks.
+ * @return @c false if no sample has been taken yet.
+ */
+bool sensor_hub_get_env(sensor_hub_env_t *out);
+
+/**
+ * @brief Get jitter, deadline and stack statistics.
+ */
+void sensor_hub_get_stats(sensor_hub_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_SENSOR_HUB_H */
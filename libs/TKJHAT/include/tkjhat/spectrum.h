@@ -0,0 +1,234 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file tkjhat/spectrum.h
+ * @brief Optional task that computes spectra of the microphone and the accelerometer.
+ *
+ * @details
+ * Collects blocks of samples, applies a Hann window, runs the fixed-point
+ * real FFT from tkjhat/fft.h and publishes, per source:
+ * - the strongest tone (frequency, amplitude, dBFS),
+ * - the noise floor (average bin level away from that tone),
+ * - all bin magnitudes, through ::spectrum_get_bins().
+ *
+ * Sources:
+ * - ::SPECTRUM_MIC: PCM from ::mic_stream_read(), Q15 FFT. The spectrum
+ *   task becomes the reader of the mic stream.
+ * - ::SPECTRUM_IMU: one accelerometer axis, Q31 FFT. The block mean
+ *   (gravity) is removed first, so small vibrations are not buried under
+ *   the offset. The samples come from one of two places:
+ *   - By default the task reads ::ICM42670_read_raw() itself every
+ *     1 / @c imu_rate_hz. It then owns the IMU: no other task (sensor hub,
+ *     imu_fusion) may use the ICM-42670 or its I²C bus at the same time.
+ *   - With @c imu_push set, the task does not touch the IMU. Another task
+ *     that already samples it, usually the sensor hub from its
+ *     @c on_sample callback, hands every sample to ::spectrum_push_imu().
+ *     @c imu_rate_hz must then be the producer's rate.
+ *
+ * Results are published through lock-free snapshots like in the sensor
+ * hub; ::spectrum_get() never blocks.
+ *
+ * ::spectrum_benchmark() times the FFT building blocks on the calling core
+ * and reports CPU cycles.
+ *
+ * ### Typical usage
+ * @code
+ * init_pdm_microphone();
+ * mic_stream_start(NULL);
+ * init_ICM42670();
+ * ICM42670_startAccel(1600, 4);
+ *
+ * spectrum_config_t cfg;
+ * spectrum_default_config(&cfg);
+ * spectrum_start(&cfg);
+ *
+ * spectrum_result_t r;
+ * if (spectrum_get(SPECTRUM_IMU, &r))
+ *     printf("vibration %.1f Hz, %.3f g\n", r.peak_hz, r.peak_amplitude);
+ * @endcode
+ *
+ * With the sensor hub as the only reader of the IMU:
+ * @code
+ * static void on_sample(sensor_hub_sensor_t sensor, void *ctx) {
+ *     sensor_hub_imu_t s;
+ *     if (sensor == SENSOR_HUB_IMU && sensor_hub_get_imu(&s)) spectrum_push_imu(&s.raw);
+ * }
+ *
+ * sensor_hub_config_t hub_cfg;
+ * sensor_hub_default_config(&hub_cfg);
+ * hub_cfg.channel[SENSOR_HUB_IMU].period_ms = 2;   // 500 Hz
+ * hub_cfg.on_sample = on_sample;
+ * sensor_hub_start(&hub_cfg);
+ *
+ * cfg.imu_push = true;
+ * cfg.imu_rate_hz = 500;
+ * spectrum_start(&cfg);
+ * @endcode
+ */
+
+#ifndef TKJHAT_SPECTRUM_H
+#define TKJHAT_SPECTRUM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <tkjhat/sdk.h>
+#include <tkjhat/fft.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SPECTRUM_STACK_SIZE             512     /**< Task stack (words). */
+#define SPECTRUM_PRIORITY_DEFAULT       2
+#define SPECTRUM_MIC_SIZE_DEFAULT       512
+#define SPECTRUM_IMU_SIZE_DEFAULT       256
+#define SPECTRUM_IMU_RATE_DEFAULT       500     /**< Accelerometer samples per second. */
+#define SPECTRUM_IMU_QUEUE_LENGTH       64      /**< Pushed samples held for the task. */
+
+/** Analysed signals. */
+typedef enum {
+    SPECTRUM_MIC = 0,       /**< PDM microphone PCM. */
+    SPECTRUM_IMU,           /**< One ICM-42670 accelerometer axis. */
+    SPECTRUM_COUNT
+} spectrum_source_t;
+
+/** Task configuration. */
+typedef struct {
+    bool mic;               /**< Analyse the microphone (reads the mic stream). */
+    bool imu;               /**< Analyse the accelerometer. */
+    uint16_t mic_size;      /**< Microphone FFT points, ::FFT_SIZE_MIN … ::FFT_SIZE_MAX. */
+    uint16_t imu_size;      /**< Accelerometer FFT points, ::FFT_SIZE_MIN … ::FFT_SIZE_MAX. */
+    uint16_t imu_rate_hz;   /**< Accelerometer sampling; must divide configTICK_RATE_HZ unless pushed. */
+    bool imu_push;          /**< Take samples from ::spectrum_push_imu() instead of reading the IMU. */
+    uint8_t imu_axis;       /**< 0 = x, 1 = y, 2 = z. */
+    uint32_t priority;      /**< FreeRTOS priority of the task. */
+    int core;               /**< 0 or 1 to pin the task, -1 to let it float. */
+} spectrum_config_t;
+
+/** Features of the latest spectrum of one source. */
+typedef struct {
+    uint16_t size;          /**< FFT points. */
+    uint16_t bins;          /**< Magnitude bins (size / 2). */
+    float bin_hz;           /**< Width of one bin (Hz). */
+    float peak_hz;          /**< Strongest tone, interpolated between bins (DC excluded). */
+    float peak_amplitude;   /**< Its amplitude: PCM counts (mic) or g (IMU). */
+    float peak_dbfs;        /**< Its level relative to a full-scale sine. */
+    float floor_dbfs;       /**< Average bin level without the peak, same scale. */
+    uint32_t fft_us;        /**< Window + FFT + magnitudes (µs). */
+    uint32_t timestamp_us;  /**< time_us_32() when the block was complete. */
+    uint32_t count;         /**< Spectra computed so far. */
+    uint32_t errors;        /**< Failed sensor reads (IMU). */
+    uint32_t overruns;      /**< Late sampling periods, or pushed samples dropped (IMU). */
+} spectrum_result_t;
+
+/** Cycle counts of one run of each FFT building block. */
+typedef struct {
+    uint16_t size;          /**< Points (real FFT size). */
+    uint32_t cpu_hz;        /**< System clock used for the conversion. */
+    uint32_t window_q15;
+    uint32_t rfft_q15;
+    uint32_t cfft_q15;      /**< Complex FFT of @c size points. */
+    uint32_t magnitude_q15;
+    uint32_t window_q31;
+    uint32_t rfft_q31;
+    uint32_t cfft_q31;
+    uint32_t magnitude_q31;
+} spectrum_bench_t;
+
+/**
+ * @brief Fill @p cfg with defaults: microphone 512 points, accelerometer
+ *        z axis at 500 Hz with 256 points, both enabled.
+ */
+void spectrum_default_config(spectrum_config_t *cfg);
+
+/**
+ * @brief Start the spectrum task.
+ *
+ * @pre ::mic_stream_start() for the microphone; the accelerometer running
+ *      (::ICM42670_startAccel() at or above @c imu_rate_hz) for the IMU.
+ *      Unless @c imu_push is set, nothing else may read the IMU while the
+ *      task runs.
+ *
+ * @param cfg Configuration, or @c NULL for defaults.
+ * @return 0 on success, -1 on invalid configuration or already running,
+ *         -2 if the task could not be created.
+ */
+int spectrum_start(const spectrum_config_t *cfg);
+
+/**
+ * @brief Stop the spectrum task. The last results stay readable.
+ *
+ * With @c imu_push, stop calling ::spectrum_push_imu() first.
+ */
+void spectrum_stop(void);
+
+/**
+ * @brief Hand one accelerometer sample to the task (@c imu_push mode).
+ *
+ * Never blocks; call it from a task (e.g. a sensor hub @c on_sample
+ * callback), not from an interrupt. Only the configured axis is kept.
+ *
+ * @return @c false if the task is not running in @c imu_push mode or its
+ *         queue was full (counted in @c overruns).
+ */
+bool spectrum_push_imu(const struct icm_raw *raw);
+
+/**
+ * @brief Copy the latest features of @p src. Never blocks.
+ * @return @c false if no spectrum has been computed yet.
+ */
+bool spectrum_get(spectrum_source_t src, spectrum_result_t *out);
+
+/**
+ * @brief Copy the bin magnitudes of the latest spectrum of @p src.
+ *
+ * Bin @c k is at @c k × @c bin_hz. The values are in FFT units (Q15 for
+ * the microphone, Q31 for the IMU); a sine of amplitude A gives A/4 in its
+ * bin because of the DFT/n scaling and the Hann window.
+ *
+ * @return Number of bins copied (at most @p max), 0 if none yet.
+ */
+size_t spectrum_get_bins(spectrum_source_t src, uint32_t *mag, size_t max);
+
+/**
+ * @brief Time the FFT building blocks for @p n points on the calling core.
+ *
+ * Allocates a work buffer from the FreeRTOS heap for the duration of the
+ * call and runs each block repeatedly for at least 20 ms.
+ *
+ * @return 0 on success, -1 for an invalid size, -2 if out of memory.
+ */
+int spectrum_benchmark(unsigned n, spectrum_bench_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_SPECTRUM_H */
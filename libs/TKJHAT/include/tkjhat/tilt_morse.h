@@ -0,0 +1,141 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file tkjhat/tilt_morse.h
+ * @brief Streaming tilt-gesture Morse classifier.
+ *
+ * @details
+ * Turns a stream of tilt angles (e.g. the pitch from tkjhat/imu_fusion.h)
+ * into Morse symbols. Tilting the board acts as a Morse key: how long it is
+ * held tilted tells a dot from a dash, and how long it is held level tells
+ * the gaps between letters and words.
+ *
+ * - **Hysteresis**: the key goes down when |angle| exceeds @c on_deg and up
+ *   again only when it drops below @c off_deg.
+ * - **Debounce**: a key change must last @c debounce_us before it counts.
+ *   The edge time is taken from where the change started, so durations are
+ *   not shortened by the debounce.
+ * - **Timing** (in Morse units): mark < 2 units is a dot, otherwise a dash.
+ *   A space longer than 2 units ends the letter, longer than 5 the word.
+ *   Gaps are reported as soon as they are long enough, without waiting for
+ *   the next tilt.
+ *
+ * The module is plain C with no hardware dependencies. It can run at any
+ * sample rate (100–400 Hz is typical) and also builds on a PC.
+ *
+ * ### Typical usage
+ * @code
+ * tilt_morse_t tm;
+ * tilt_morse_init(&tm, NULL);
+ * for (;;) {
+ *     tilt_morse_event_t ev;
+ *     if (tilt_morse_update(&tm, pitch_deg, time_us_32(), &ev)) {
+ *         printf("%c", ev.symbol);
+ *     }
+ * }
+ * @endcode
+ */
+
+#ifndef TKJHAT_TILT_MORSE_H
+#define TKJHAT_TILT_MORSE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TILT_MORSE_ON_DEG_DEFAULT       20.0f
+#define TILT_MORSE_OFF_DEG_DEFAULT      12.0f
+#define TILT_MORSE_DEBOUNCE_US_DEFAULT  30000u
+#define TILT_MORSE_UNIT_US_DEFAULT      250000u
+
+/** Symbols produced by the classifier. */
+#define TILT_MORSE_DOT          '.'
+#define TILT_MORSE_DASH         '-'
+#define TILT_MORSE_LETTER_GAP   ' '
+#define TILT_MORSE_WORD_GAP     '/'
+
+/** Classifier settings. */
+typedef struct {
+    float on_deg;           /**< |angle| above which the key is down. */
+    float off_deg;          /**< |angle| below which the key is up (< on_deg). */
+    uint32_t debounce_us;   /**< Minimum duration of a key change. */
+    uint32_t unit_us;       /**< Length of one Morse unit (a dot). */
+} tilt_morse_config_t;
+
+/** One classified symbol. */
+typedef struct {
+    char symbol;            /**< TILT_MORSE_DOT / _DASH / _LETTER_GAP / _WORD_GAP. */
+    uint32_t start_us;      /**< Timestamp where the mark or gap began. */
+    uint32_t duration_us;   /**< Length of the mark, or of the gap so far. */
+} tilt_morse_event_t;
+
+/** Classifier state. Treat as opaque. */
+typedef struct {
+    tilt_morse_config_t cfg;
+    bool started;           // first sample seen
+    bool key_down;          // debounced key state
+    bool pending;           // raw state differs from key_down
+    uint32_t pending_us;    // when the raw state changed
+    uint32_t edge_us;       // start of the current mark/space
+    uint8_t gaps_sent;      // 0: none, 1: letter gap sent, 2: word gap sent
+    bool have_mark;         // a mark was sent since the last word gap
+} tilt_morse_t;
+
+/**
+ * @brief Fill @p cfg with default values.
+ */
+void tilt_morse_default_config(tilt_morse_config_t *cfg);
+
+/**
+ * @brief Reset the classifier.
+ *
+ * @param tm  State to initialize.
+ * @param cfg Settings, or @c NULL for defaults.
+ */
+void tilt_morse_init(tilt_morse_t *tm, const tilt_morse_config_t *cfg);
+
+/**
+ * @brief Feed one tilt sample.
+ *
+ * @param tm        Classifier state.
+ * @param angle_deg Tilt angle in degrees (sign is ignored).
+ * @param t_us      Sample timestamp in µs (free-running, wraps at 2^32).
+ * @param ev        Filled when a symbol is produced.
+ * @return @c true if @p ev holds a new symbol.
+ */
+bool tilt_morse_update(tilt_morse_t *tm, float angle_deg, uint32_t t_us,
+                       tilt_morse_event_t *ev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_TILT_MORSE_H */
@@ -0,0 +1,216 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file tkjhat/tone_morse.h
+ * @brief Streaming Morse receiver for buzzer tones picked up by the microphone.
+ *
+ * @details
+ * Listens for a tone such as one played with ::buzzer_play_tone() by
+ * another board. It decides when the key is down and turns the key timing
+ * into dots, dashes, gaps and letters.
+ *
+ * - **Goertzel filters**: the PCM is cut into blocks of @c block_us. Each
+ *   block is run through a Goertzel filter at the tone frequency, which
+ *   gives the tone level without a full FFT. The filter hears tones within
+ *   about one bin (1 / @c block_us, 100 Hz by default). With @c track on,
+ *   two more filters half a bin below and above pull the centre towards
+ *   the tone while the key is down, so a drifting or slightly detuned
+ *   buzzer is followed up to @c track_range_hz away.
+ * - **AGC threshold**: a noise floor is learned while the key is up and a
+ *   peak level while it is down. The key goes down halfway between them
+ *   (and at least @c min_snr times above the floor), and up again at a
+ *   third of the way, so the decision follows the loudness of the sender.
+ * - **Timing**: the unit is the average of the shortest recent marks and
+ *   spaces (dots and the 1-unit spaces inside a letter), so the receiver
+ *   follows the sender's speed starting from @c unit_us. As in
+ *   tilt_morse.h, a mark over 2 units is a dash, a space over 2 units
+ *   ends the letter and over 5 units the word. The unit also gives the
+ *   speed in words per minute.
+ * - **Decoding**: at each letter gap the collected dots and dashes are
+ *   passed to @c decode (e.g. the application's Morse table lookup), and
+ *   the result is reported with the gap event.
+ *
+ * CPU cost is fixed per sample: at most ::TONE_MORSE_FILTERS Goertzel
+ * updates (two 32-bit multiplies each), plus a constant amount of work per
+ * block. Everything is integer arithmetic except a retune of the tracking
+ * filters (at most once per block). It runs on a Cortex-M0+ without an FPU.
+ *
+ * The module is plain C with no hardware dependencies, so
+ * `tools/morse_rx` runs the same code on synthesized or recorded WAV files.
+ *
+ * ### Typical usage
+ * @code
+ * static void on_morse(const tone_morse_event_t *ev, void *ctx) {
+ *     if (ev->letter) printf("%c", ev->letter);
+ *     if (ev->symbol == TONE_MORSE_WORD_GAP) printf(" ");
+ * }
+ *
+ * tone_morse_config_t cfg;
+ * tone_morse_default_config(&cfg);
+ * cfg.sample_rate = MEMS_SAMPLING_FREQUENCY;
+ * cfg.decode = from_morse;
+ * cfg.on_event = on_morse;
+ *
+ * static tone_morse_t rx;
+ * tone_morse_init(&rx, &cfg);
+ * for (;;) {
+ *     int16_t pcm[128];
+ *     size_t n = mic_stream_read(pcm, 128, 100);
+ *     tone_morse_process(&rx, pcm, n);
+ * }
+ * @endcode
+ */
+
+#ifndef TKJHAT_TONE_MORSE_H
+#define TKJHAT_TONE_MORSE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TONE_MORSE_TONE_HZ_DEFAULT      1000.0f
+#define TONE_MORSE_TRACK_HZ_DEFAULT     300.0f  /**< Tracking range around the tone. */
+#define TONE_MORSE_BLOCK_US_DEFAULT     10000u  /**< Goertzel block length. */
+#define TONE_MORSE_UNIT_US_DEFAULT      100000u /**< Starting unit (12 WPM). */
+#define TONE_MORSE_MIN_SNR_DEFAULT      4       /**< Tone level / noise floor for key down. */
+#define TONE_MORSE_FILTERS              3       /**< Goertzel filters with tracking on. */
+#define TONE_MORSE_MAX_BLOCK            512     /**< Samples per block, at most. */
+#define TONE_MORSE_MAX_CODE             7       /**< Dots and dashes per letter, at most. */
+#define TONE_MORSE_HISTORY              16      /**< Marks and spaces used for the unit. */
+
+/** Symbols produced by the receiver (same characters as tilt_morse.h). */
+#define TONE_MORSE_DOT          '.'
+#define TONE_MORSE_DASH         '-'
+#define TONE_MORSE_LETTER_GAP   ' '
+#define TONE_MORSE_WORD_GAP     '/'
+
+/** One received symbol. */
+typedef struct {
+    char symbol;            /**< TONE_MORSE_DOT / _DASH / _LETTER_GAP / _WORD_GAP. */
+    char letter;            /**< Decoded letter with a letter gap, otherwise 0. */
+    const char *code;       /**< Dots and dashes of that letter, otherwise "". */
+    uint32_t start_us;      /**< Stream time where the mark or gap began. */
+    uint32_t duration_us;   /**< Length of the mark, or of the gap so far. */
+} tone_morse_event_t;
+
+/** Maps a code such as ".-" to a character (e.g. the app's from_morse()). */
+typedef char (*tone_morse_decode_fn)(const char *code);
+
+/** Receives every symbol. */
+typedef void (*tone_morse_event_fn)(const tone_morse_event_t *ev, void *ctx);
+
+/** Receiver settings. */
+typedef struct {
+    uint32_t sample_rate;       /**< PCM rate in Hz. */
+    float tone_hz;              /**< Expected tone frequency. */
+    bool track;                 /**< Follow a tone that is off frequency. */
+    float track_range_hz;       /**< How far tracking may move from @c tone_hz. */
+    uint32_t block_us;          /**< Goertzel block length (time resolution). */
+    uint32_t unit_us;           /**< Starting Morse unit; adapted while receiving. */
+    uint32_t debounce_us;       /**< Minimum duration of a key change. */
+    uint16_t min_snr;           /**< Tone must be this many times above the floor. */
+    uint16_t min_level;         /**< Ignore tones below this amplitude (PCM counts). */
+    tone_morse_decode_fn decode;    /**< Letter lookup, or @c NULL. */
+    tone_morse_event_fn on_event;   /**< Symbol callback, or @c NULL. */
+    void *ctx;                  /**< Passed to @c on_event. */
+} tone_morse_config_t;
+
+/** Receiver state. Treat as opaque; read it with tone_morse_get_status(). */
+typedef struct {
+    tone_morse_config_t cfg;
+    uint16_t block;             // samples per block
+    uint16_t fill;              // samples in the current block
+    uint8_t filters;            // 1, or 3 with tracking
+    int32_t coef[TONE_MORSE_FILTERS];   // 2 cos(w), Q14; centre first
+    int32_t s1[TONE_MORSE_FILTERS], s2[TONE_MORSE_FILTERS];
+    float freq_hz;              // current centre frequency
+    uint32_t floor_q8, peak_q8; // noise floor and tone level, counts << 8
+    uint32_t level;             // last block level (counts)
+    uint64_t samples;           // stream position
+    bool key_down;              // debounced key state
+    bool pending;               // raw state differs from key_down
+    uint32_t pending_us;
+    uint32_t edge_us;           // start of the current mark/space
+    uint8_t gaps_sent;          // 0: none, 1: letter gap sent, 2: word gap sent
+    bool have_mark;
+    uint32_t unit_us;           // adapted unit
+    uint32_t hist_us[TONE_MORSE_HISTORY];   // recent mark and space lengths
+    uint8_t hist_len, hist_pos;
+    char code[TONE_MORSE_MAX_CODE + 1];
+    uint8_t code_len;
+    uint32_t marks;             // dots and dashes received
+    uint32_t letters;           // letters decoded
+} tone_morse_t;
+
+/** Receiver status for display and tuning. */
+typedef struct {
+    float tone_hz;              /**< Frequency being listened to. */
+    float wpm;                  /**< Speed from the adapted unit (PARIS, 50 units/word). */
+    uint32_t unit_us;           /**< Adapted Morse unit. */
+    uint32_t level;             /**< Tone level of the last block (counts). */
+    uint32_t noise_floor;       /**< Learned noise floor (counts). */
+    uint32_t peak;              /**< Learned key-down level (counts). */
+    bool key_down;
+    uint32_t marks;             /**< Dots and dashes received. */
+    uint32_t letters;           /**< Letters decoded. */
+} tone_morse_status_t;
+
+/**
+ * @brief Fill @p cfg with default values (8 kHz, 1 kHz tone, tracking on).
+ */
+void tone_morse_default_config(tone_morse_config_t *cfg);
+
+/**
+ * @brief Reset the receiver.
+ *
+ * @param tm  State to initialize.
+ * @param cfg Settings, or @c NULL for defaults.
+ * @return 0, or -1 if the tone is outside 100 Hz … sample_rate/2 − 100 Hz
+ *         or a block would exceed ::TONE_MORSE_MAX_BLOCK samples.
+ */
+int tone_morse_init(tone_morse_t *tm, const tone_morse_config_t *cfg);
+
+/**
+ * @brief Feed PCM samples; calls @c on_event for every symbol found.
+ */
+void tone_morse_process(tone_morse_t *tm, const int16_t *pcm, size_t n);
+
+/**
+ * @brief Current frequency, speed and levels.
+ */
+void tone_morse_get_status(const tone_morse_t *tm, tone_morse_status_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_TONE_MORSE_H */
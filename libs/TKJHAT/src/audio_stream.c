@@ -0,0 +1,230 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * IMA-ADPCM encoder/decoder and audio frame format. See
+ * tkjhat/audio_stream.h. Plain C without Pico dependencies: also built by
+ * the host tools.
+ */
+
+#include <string.h>
+
+#include "tkjhat/audio_stream.h"
+
+static const uint8_t frame_magic[2] = { 'A', 'D' };
+
+static const int16_t ima_step_table[89] = {
+        7,     8,     9,    10,    11,    12,    13,    14,    16,    17,
+       19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+       50,    55,    60,    66,    73,    80,    88,    97,   107,   118,
+      130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+      337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+      876,   963,  1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+     2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+     5894,  6484,  7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t ima_index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+void ima_adpcm_init(ima_adpcm_state_t *st) {
+    st->predictor = 0;
+    st->step_index = 0;
+}
+
+// Apply one 4-bit code; shared by encoder and decoder so they stay in step
+static inline void ima_step(int32_t *pred, int32_t *index, uint8_t code) {
+    int32_t step = ima_step_table[*index];
+    int32_t diff = step >> 3;
+    if (code & 4) diff += step;
+    if (code & 2) diff += step >> 1;
+    if (code & 1) diff += step >> 2;
+    *pred += (code & 8) ? -diff : diff;
+    if (*pred > 32767) *pred = 32767;
+    if (*pred < -32768) *pred = -32768;
+    *index += ima_index_table[code];
+    if (*index < 0) *index = 0;
+    if (*index > 88) *index = 88;
+}
+
+void ima_adpcm_encode(ima_adpcm_state_t *st, const int16_t *pcm, size_t n, uint8_t *out) {
+    int32_t pred = st->predictor;
+    int32_t index = st->step_index;
+
+    for (size_t i = 0; i < n; i++) {
+        int32_t diff = pcm[i] - pred;
+        int32_t step = ima_step_table[index];
+        uint8_t code = 0;
+        if (diff < 0) {
+            code = 8;
+            diff = -diff;
+        }
+        if (diff >= step) { code |= 4; diff -= step; }
+        step >>= 1;
+        if (diff >= step) { code |= 2; diff -= step; }
+        step >>= 1;
+        if (diff >= step) { code |= 1; }
+
+        ima_step(&pred, &index, code);
+
+        if (i & 1) {
+            out[i >> 1] |= code << 4;
+        } else {
+            out[i >> 1] = code;
+        }
+    }
+
+    st->predictor = (int16_t)pred;
+    st->step_index = (uint8_t)index;
+}
+
+void ima_adpcm_decode(ima_adpcm_state_t *st, const uint8_t *in, size_t n, int16_t *pcm) {
+    int32_t pred = st->predictor;
+    int32_t index = st->step_index;
+
+    for (size_t i = 0; i < n; i++) {
+        uint8_t code = (i & 1) ? (in[i >> 1] >> 4) : (in[i >> 1] & 0x0F);
+        ima_step(&pred, &index, code);
+        pcm[i] = (int16_t)pred;
+    }
+
+    st->predictor = (int16_t)pred;
+    st->step_index = (uint8_t)index;
+}
+
+uint16_t audio_stream_crc16(const uint8_t *data, size_t len, uint16_t crc) {
+    while (len--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+size_t audio_stream_payload_size(audio_codec_t codec, size_t samples) {
+    return codec == AUDIO_CODEC_IMA_ADPCM ? (samples + 1) / 2 : samples * 2;
+}
+
+static inline void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+void audio_stream_init(audio_stream_t *s, audio_codec_t codec, uint16_t sample_rate,
+                       audio_stream_write_fn write, void *ctx) {
+    memset(s, 0, sizeof(*s));
+    s->codec = codec;
+    s->sample_rate = sample_rate;
+    s->write = write;
+    s->ctx = ctx;
+    ima_adpcm_init(&s->state);
+}
+
+int audio_stream_write(audio_stream_t *s, const int16_t *pcm, size_t n) {
+    int sent = 0;
+
+    while (n > 0) {
+        size_t count = n < AUDIO_STREAM_MAX_SAMPLES ? n : AUDIO_STREAM_MAX_SAMPLES;
+        size_t payload = audio_stream_payload_size(s->codec, count);
+        uint8_t *h = s->frame;
+
+        h[0] = frame_magic[0];
+        h[1] = frame_magic[1];
+        h[2] = AUDIO_STREAM_VERSION;
+        h[3] = (uint8_t)s->codec;
+        put_u16(&h[4], s->seq);
+        put_u16(&h[6], (uint16_t)count);
+        put_u16(&h[8], s->sample_rate);
+        put_u16(&h[10], (uint16_t)s->state.predictor);
+        h[12] = s->state.step_index;
+        h[13] = 0;
+
+        uint8_t *body = h + AUDIO_STREAM_HEADER_SIZE;
+        if (s->codec == AUDIO_CODEC_IMA_ADPCM) {
+            ima_adpcm_encode(&s->state, pcm, count, body);
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                put_u16(&body[2 * i], (uint16_t)pcm[i]);
+            }
+        }
+
+        uint16_t crc = audio_stream_crc16(h, 14, 0xFFFF);
+        crc = audio_stream_crc16(body, payload, crc);
+        put_u16(&h[14], crc);
+
+        size_t len = AUDIO_STREAM_HEADER_SIZE + payload;
+        int w = s->write ? s->write(h, len, s->ctx) : 0;
+        if (w == (int)len) {
+            sent++;
+            s->bytes_out += len;
+        } else {
+            s->write_errors++;
+        }
+
+        s->seq++;
+        s->frames++;
+        s->samples += count;
+        pcm += count;
+        n -= count;
+    }
+    return sent;
+}
+
+int audio_stream_parse(const uint8_t *buf, size_t len, audio_frame_info_t *info) {
+    if (len >= 1 && buf[0] != frame_magic[0]) return -1;
+    if (len >= 2 && buf[1] != frame_magic[1]) return -1;
+    if (len >= 3 && buf[2] != AUDIO_STREAM_VERSION) return -1;
+    if (len >= 4 && buf[3] > AUDIO_CODEC_IMA_ADPCM) return -1;
+    if (len < AUDIO_STREAM_HEADER_SIZE) return 0;
+
+    uint16_t samples = get_u16(&buf[6]);
+    if (samples == 0 || samples > AUDIO_STREAM_MAX_SAMPLES || buf[12] > 88) return -1;
+
+    audio_codec_t codec = (audio_codec_t)buf[3];
+    size_t payload = audio_stream_payload_size(codec, samples);
+    if (len < AUDIO_STREAM_HEADER_SIZE + payload) return 0;
+
+    uint16_t crc = audio_stream_crc16(buf, 14, 0xFFFF);
+    crc = audio_stream_crc16(buf + AUDIO_STREAM_HEADER_SIZE, payload, crc);
+    if (crc != get_u16(&buf[14])) return -1;
+
+    info->codec = codec;
+    info->seq = get_u16(&buf[4]);
+    info->samples = samples;
+    info->sample_rate = get_u16(&buf[8]);
+    info->state.predictor = (int16_t)get_u16(&buf[10]);
+    info->state.step_index = buf[12];
+    return (int)(AUDIO_STREAM_HEADER_SIZE + payload);
+}
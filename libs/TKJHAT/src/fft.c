@@ -0,0 +1,423 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Fixed-point radix-4/2 FFT, real FFT split, Hann window and magnitudes.
+ * See tkjhat/fft.h. Plain C without Pico dependencies: also built by the
+ * host tools.
+ *
+ * The radix-4 butterflies are decimation in frequency and store their
+ * outputs in the order 0, 2, 1, 3. That makes the final order plain
+ * bit-reversed (not base-4 digit-reversed), so a trailing radix-2 stage
+ * for odd log2(n) and a single bit-reversal pass work for every size.
+ */
+
+#include "tkjhat/fft.h"
+
+#define TABLE_N     1024    // full circle of the sine tables
+#define Q15_HALF    (1 << 14)
+#define Q31_HALF    (1ll << 30)
+
+// sin(2*pi*k/1024) for k = 0..256, round(x * (2^15 - 1)) and round(x * (2^31 - 1))
+static const int16_t sin_q15[257] = {
+         0,    201,    402,    603,    804,   1005,   1206,   1407,   1608,   1809,
+      2009,   2210,   2410,   2611,   2811,   3012,   3212,   3412,   3612,   3811,
+      4011,   4210,   4410,   4609,   4808,   5007,   5205,   5404,   5602,   5800,
+      5998,   6195,   6393,   6590,   6786,   6983,   7179,   7375,   7571,   7767,
+      7962,   8157,   8351,   8545,   8739,   8933,   9126,   9319,   9512,   9704,
+      9896,  10087,  10278,  10469,  10659,  10849,  11039,  11228,  11417,  11605,
+     11793,  11980,  12167,  12353,  12539,  12725,  12910,  13094,  13279,  13462,
+     13645,  13828,  14010,  14191,  14372,  14553,  14732,  14912,  15090,  15269,
+     15446,  15623,  15800,  15976,  16151,  16325,  16499,  16673,  16846,  17018,
+     17189,  17360,  17530,  17700,  17869,  18037,  18204,  18371,  18537,  18703,
+     18868,  19032,  19195,  19357,  19519,  19680,  19841,  20000,  20159,  20317,
+     20475,  20631,  20787,  20942,  21096,  21250,  21403,  21554,  21705,  21856,
+     22005,  22154,  22301,  22448,  22594,  22739,  22884,  23027,  23170,  23311,
+     23452,  23592,  23731,  23870,  24007,  24143,  24279,  24413,  24547,  24680,
+     24811,  24942,  25072,  25201,  25329,  25456,  25582,  25708,  25832,  25955,
+     26077,  26198,  26319,  26438,  26556,  26674,  26790,  26905,  27019,  27133,
+     27245,  27356,  27466,  27575,  27683,  27790,  27896,  28001,  28105,  28208,
+     28310,  28411,  28510,  28609,  28706,  28803,  28898,  28992,  29085,  29177,
+     29268,  29358,  29447,  29534,  29621,  29706,  29791,  29874,  29956,  30037,
+     30117,  30195,  30273,  30349,  30424,  30498,  30571,  30643,  30714,  30783,
+     30852,  30919,  30985,  31050,  31113,  31176,  31237,  31297,  31356,  31414,
+     31470,  31526,  31580,  31633,  31685,  31736,  31785,  31833,  31880,  31926,
+     31971,  32014,  32057,  32098,  32137,  32176,  32213,  32250,  32285,  32318,
+     32351,  32382,  32412,  32441,  32469,  32495,  32521,  32545,  32567,  32589,
+     32609,  32628,  32646,  32663,  32678,  32692,  32705,  32717,  32728,  32737,
+     32745,  32752,  32757,  32761,  32765,  32766,  32767
+};
+
+static const int32_t sin_q31[257] = {
+              0,    13176712,    26352928,    39528151,    52701887,    65873638,
+       79042909,    92209205,   105372028,   118530885,   131685278,   144834714,
+      157978697,   171116732,   184248325,   197372981,   210490206,   223599506,
+      236700388,   249792358,   262874923,   275947592,   289009871,   302061269,
+      315101294,   328129457,   341145265,   354148229,   367137860,   380113669,
+      393075166,   406021864,   418953276,   431868915,   444768293,   457650927,
+      470516330,   483364019,   496193509,   509004318,   521795963,   534567963,
+      547319836,   560051103,   572761285,   585449903,   598116478,   610760535,
+      623381597,   635979190,   648552837,   661102068,   673626408,   686125386,
+      698598533,   711045377,   723465451,   735858287,   748223418,   760560379,
+      772868706,   785147934,   797397602,   809617248,   821806413,   833964637,
+      846091463,   858186434,   870249095,   882278991,   894275670,   906238681,
+      918167571,   930061894,   941921200,   953745043,   965532978,   977284561,
+      988999351,  1000676905,  1012316784,  1023918549,  1035481765,  1047005996,
+     1058490807,  1069935767,  1081340445,  1092704410,  1104027236,  1115308496,
+     1126547765,  1137744620,  1148898640,  1160009404,  1171076495,  1182099495,
+     1193077990,  1204011566,  1214899812,  1225742318,  1236538675,  1247288477,
+     1257991319,  1268646799,  1279254515,  1289814068,  1300325059,  1310787095,
+     1321199780,  1331562722,  1341875532,  1352137822,  1362349204,  1372509294,
+     1382617710,  1392674071,  1402677999,  1412629117,  1422527050,  1432371426,
+     1442161874,  1451898025,  1461579513,  1471205973,  1480777044,  1490292364,
+     1499751575,  1509154322,  1518500249,  1527789006,  1537020243,  1546193612,
+     1555308767,  1564365366,  1573363067,  1582301533,  1591180425,  1599999410,
+     1608758157,  1617456334,  1626093615,  1634669675,  1643184190,  1651636840,
+     1660027308,  1668355276,  1676620431,  1684822463,  1692961061,  1701035921,
+     1709046738,  1716993211,  1724875039,  1732691927,  1740443580,  1748129706,
+     1755750016,  1763304223,  1770792043,  1778213194,  1785567395,  1792854372,
+     1800073848,  1807225552,  1814309215,  1821324571,  1828271355,  1835149305,
+     1841958164,  1848697673,  1855367580,  1861967633,  1868497585,  1874957188,
+     1881346201,  1887664382,  1893911493,  1900087300,  1906191569,  1912224072,
+     1918184580,  1924072870,  1929888719,  1935631909,  1941302224,  1946899450,
+     1952423376,  1957873795,  1963250500,  1968553291,  1973781966,  1978936330,
+     1984016188,  1989021349,  1993951624,  1998806828,  2003586778,  2008291295,
+     2012920200,  2017473320,  2021950483,  2026351521,  2030676268,  2034924561,
+     2039096240,  2043191149,  2047209132,  2051150040,  2055013722,  2058800035,
+     2062508835,  2066139982,  2069693341,  2073168776,  2076566159,  2079885359,
+     2083126253,  2086288719,  2089372637,  2092377891,  2095304369,  2098151959,
+     2100920555,  2103610053,  2106220351,  2108751351,  2111202958,  2113575079,
+     2115867625,  2118080510,  2120213650,  2122266966,  2124240379,  2126133816,
+     2127947205,  2129680479,  2131333571,  2132906419,  2134398965,  2135811152,
+     2137142926,  2138394239,  2139565042,  2140655292,  2141664947,  2142593970,
+     2143442325,  2144209981,  2144896909,  2145503082,  2146028479,  2146473079,
+     2146836865,  2147119824,  2147321945,  2147443221,  2147483647
+};
+
+// cos and sin of 2*pi*k/1024 for any k in [0, 1024)
+#define TWIDDLE(table, k, c, s) do {                                          \
+        unsigned r_ = (k) & 255;                                              \
+        switch ((k) >> 8) {                                                   \
+            case 0:  s =  table[r_];       c =  table[256 - r_]; break;       \
+            case 1:  s =  table[256 - r_]; c = -table[r_];       break;       \
+            case 2:  s = -table[r_];       c = -table[256 - r_]; break;       \
+            default: s = -table[256 - r_]; c =  table[r_];       break;       \
+        }                                                                     \
+    } while (0)
+
+static inline int16_t sat16(int32_t v) {
+    if (v > INT16_MAX) return INT16_MAX;
+    if (v < INT16_MIN) return INT16_MIN;
+    return (int16_t)v;
+}
+
+static inline int32_t sat32(int64_t v) {
+    if (v > INT32_MAX) return INT32_MAX;
+    if (v < INT32_MIN) return INT32_MIN;
+    return (int32_t)v;
+}
+
+bool fft_size_valid(unsigned n) {
+    return n >= 16 && n <= FFT_SIZE_MAX && (n & (n - 1)) == 0;
+}
+
+#define BIT_REVERSE(x, n, type) do {                                          \
+        for (unsigned i_ = 1, j_ = 0; i_ < (n); i_++) {                       \
+            unsigned bit_ = (n) >> 1;                                         \
+            for (; j_ & bit_; bit_ >>= 1) j_ ^= bit_;                         \
+            j_ ^= bit_;                                                       \
+            if (i_ < j_) {                                                    \
+                type re_ = (x)[2 * i_], im_ = (x)[2 * i_ + 1];                \
+                (x)[2 * i_] = (x)[2 * j_];                                    \
+                (x)[2 * i_ + 1] = (x)[2 * j_ + 1];                            \
+                (x)[2 * j_] = re_;                                            \
+                (x)[2 * j_ + 1] = im_;                                        \
+            }                                                                 \
+        }                                                                     \
+    } while (0)
+
+/* ---------- Q15 ---------- */
+
+// y * (c - i*s), Q15, with rounding and saturation
+static inline void rotate_q15(int16_t *out, int32_t yr, int32_t yi, int32_t c, int32_t s) {
+    out[0] = sat16((yr * c + yi * s + Q15_HALF) >> 15);
+    out[1] = sat16((yi * c - yr * s + Q15_HALF) >> 15);
+}
+
+// shift is 2 for DFT / n; the real FFT passes 3 to get DFT / (2n) for headroom
+static void cfft_q15(int16_t *x, unsigned n, unsigned shift) {
+    unsigned m = n;
+    for (; m >= 4; m >>= 2, shift = 2) {
+        const unsigned q = m >> 2;
+        const unsigned step = TABLE_N / m;
+        const int32_t rnd = 1 << (shift - 1);
+        for (unsigned j = 0; j < q; j++) {
+            int32_t c1 = 0, s1 = 0, c2 = 0, s2 = 0, c3 = 0, s3 = 0;
+            if (j) {
+                TWIDDLE(sin_q15, j * step, c1, s1);
+                TWIDDLE(sin_q15, 2 * j * step, c2, s2);
+                TWIDDLE(sin_q15, 3 * j * step, c3, s3);
+            }
+            for (unsigned g = j; g < n; g += m) {
+                int16_t *a = &x[2 * g], *b = a + 2 * q, *c = b + 2 * q, *d = c + 2 * q;
+                int32_t t0r = a[0] + c[0], t0i = a[1] + c[1];
+                int32_t t1r = a[0] - c[0], t1i = a[1] - c[1];
+                int32_t t2r = b[0] + d[0], t2i = b[1] + d[1];
+                int32_t t3r = b[0] - d[0], t3i = b[1] - d[1];
+
+                // Sums of four inputs: scale by 1/4 (or 1/8) before they can overflow
+                int32_t y0r = (t0r + t2r + rnd) >> shift, y0i = (t0i + t2i + rnd) >> shift;
+                int32_t y2r = (t0r - t2r + rnd) >> shift, y2i = (t0i - t2i + rnd) >> shift;
+                int32_t y1r = (t1r + t3i + rnd) >> shift, y1i = (t1i - t3r + rnd) >> shift;
+                int32_t y3r = (t1r - t3i + rnd) >> shift, y3i = (t1i + t3r + rnd) >> shift;
+
+                a[0] = (int16_t)y0r;
+                a[1] = (int16_t)y0i;
+                if (j) {
+                    rotate_q15(b, y2r, y2i, c2, s2);
+                    rotate_q15(c, y1r, y1i, c1, s1);
+                    rotate_q15(d, y3r, y3i, c3, s3);
+                } else {
+                    b[0] = (int16_t)y2r; b[1] = (int16_t)y2i;
+                    c[0] = (int16_t)y1r; c[1] = (int16_t)y1i;
+                    d[0] = (int16_t)y3r; d[1] = (int16_t)y3i;
+                }
+            }
+        }
+    }
+    if (m == 2) {
+        for (unsigned i = 0; i < 2 * n; i += 4) {
+            int32_t ar = x[i], ai = x[i + 1], br = x[i + 2], bi = x[i + 3];
+            x[i]     = (int16_t)((ar + br + 1) >> 1);
+            x[i + 1] = (int16_t)((ai + bi + 1) >> 1);
+            x[i + 2] = (int16_t)((ar - br + 1) >> 1);
+            x[i + 3] = (int16_t)((ai - bi + 1) >> 1);
+        }
+    }
+    BIT_REVERSE(x, n, int16_t);
+}
+
+int fft_cfft_q15(int16_t *x, unsigned n) {
+    if (!fft_size_valid(n)) return -1;
+    cfft_q15(x, n, 2);
+    return 0;
+}
+
+int fft_rfft_q15(int16_t *x, unsigned n) {
+    if (n < FFT_SIZE_MIN || !fft_size_valid(n)) return -1;
+
+    // The n real samples are n/2 complex ones: z[k] = x[2k] + i*x[2k+1]
+    // (a full-scale real signal can reach |z| = sqrt(2), so the complex FFT
+    // scales by one extra bit and the split below does not)
+    const unsigned h = n >> 1;
+    cfft_q15(x, h, 3);
+
+    int32_t zr = x[0], zi = x[1];
+    x[0] = sat16(zr + zi);
+    x[1] = sat16(zr - zi);
+
+    const unsigned step = TABLE_N / n;
+    for (unsigned k = 1; k <= h / 2; k++) {
+        int16_t *a = &x[2 * k], *b = &x[2 * (h - k)];
+        // Even and odd parts of bin k and bin h - k
+        int32_t er = (a[0] + b[0]) >> 1, ei = (a[1] - b[1]) >> 1;
+        int32_t or_ = (a[0] - b[0]) >> 1, oi = (a[1] + b[1]) >> 1;
+        int32_t s = sin_q15[k * step], c = sin_q15[256 - k * step];
+        int32_t p = (c * or_ + s * oi + Q15_HALF) >> 15;
+        int32_t q = (c * oi - s * or_ + Q15_HALF) >> 15;
+        a[0] = sat16(er + q);
+        a[1] = sat16(ei - p);
+        if (b != a) {
+            b[0] = sat16(er - q);
+            b[1] = sat16(-ei - p);
+        }
+    }
+    return 0;
+}
+
+void fft_window_hann_q15(int16_t *x, unsigned n) {
+    const unsigned step = TABLE_N / n;
+    for (unsigned i = 0; i < n; i++) {
+        int32_t c, s;
+        TWIDDLE(sin_q15, (i * step) & (TABLE_N - 1), c, s);
+        (void)s;
+        int32_t w = (INT16_MAX - c) >> 1;       // 0.5 - 0.5 cos
+        x[i] = (int16_t)((x[i] * w + Q15_HALF) >> 15);
+    }
+}
+
+static uint32_t isqrt32(uint32_t v) {
+    uint32_t r = 0, bit = 1u << 30;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return r;
+}
+
+void fft_magnitude_q15(const int16_t *bins, uint16_t *mag, unsigned count) {
+    if (count == 0) return;
+    mag[0] = (uint16_t)(bins[0] < 0 ? -bins[0] : bins[0]);
+    for (unsigned k = 1; k < count; k++) {
+        int32_t re = bins[2 * k], im = bins[2 * k + 1];
+        uint32_t m = isqrt32((uint32_t)(re * re) + (uint32_t)(im * im));
+        mag[k] = (uint16_t)(m > UINT16_MAX ? UINT16_MAX : m);
+    }
+}
+
+/* ---------- Q31 ---------- */
+
+static inline void rotate_q31(int32_t *out, int64_t yr, int64_t yi, int64_t c, int64_t s) {
+    out[0] = sat32((yr * c + yi * s + Q31_HALF) >> 31);
+    out[1] = sat32((yi * c - yr * s + Q31_HALF) >> 31);
+}
+
+static void cfft_q31(int32_t *x, unsigned n, unsigned shift) {
+    unsigned m = n;
+    for (; m >= 4; m >>= 2, shift = 2) {
+        const unsigned q = m >> 2;
+        const unsigned step = TABLE_N / m;
+        const int64_t rnd = 1 << (shift - 1);
+        for (unsigned j = 0; j < q; j++) {
+            int64_t c1 = 0, s1 = 0, c2 = 0, s2 = 0, c3 = 0, s3 = 0;
+            if (j) {
+                TWIDDLE(sin_q31, j * step, c1, s1);
+                TWIDDLE(sin_q31, 2 * j * step, c2, s2);
+                TWIDDLE(sin_q31, 3 * j * step, c3, s3);
+            }
+            for (unsigned g = j; g < n; g += m) {
+                int32_t *a = &x[2 * g], *b = a + 2 * q, *c = b + 2 * q, *d = c + 2 * q;
+                int64_t t0r = (int64_t)a[0] + c[0], t0i = (int64_t)a[1] + c[1];
+                int64_t t1r = (int64_t)a[0] - c[0], t1i = (int64_t)a[1] - c[1];
+                int64_t t2r = (int64_t)b[0] + d[0], t2i = (int64_t)b[1] + d[1];
+                int64_t t3r = (int64_t)b[0] - d[0], t3i = (int64_t)b[1] - d[1];
+
+                int64_t y0r = (t0r + t2r + rnd) >> shift, y0i = (t0i + t2i + rnd) >> shift;
+                int64_t y2r = (t0r - t2r + rnd) >> shift, y2i = (t0i - t2i + rnd) >> shift;
+                int64_t y1r = (t1r + t3i + rnd) >> shift, y1i = (t1i - t3r + rnd) >> shift;
+                int64_t y3r = (t1r - t3i + rnd) >> shift, y3i = (t1i + t3r + rnd) >> shift;
+
+                a[0] = (int32_t)y0r;
+                a[1] = (int32_t)y0i;
+                if (j) {
+                    rotate_q31(b, y2r, y2i, c2, s2);
+                    rotate_q31(c, y1r, y1i, c1, s1);
+                    rotate_q31(d, y3r, y3i, c3, s3);
+                } else {
+                    b[0] = (int32_t)y2r; b[1] = (int32_t)y2i;
+                    c[0] = (int32_t)y1r; c[1] = (int32_t)y1i;
+                    d[0] = (int32_t)y3r; d[1] = (int32_t)y3i;
+                }
+            }
+        }
+    }
+    if (m == 2) {
+        for (unsigned i = 0; i < 2 * n; i += 4) {
+            int64_t ar = x[i], ai = x[i + 1], br = x[i + 2], bi = x[i + 3];
+            x[i]     = (int32_t)((ar + br + 1) >> 1);
+            x[i + 1] = (int32_t)((ai + bi + 1) >> 1);
+            x[i + 2] = (int32_t)((ar - br + 1) >> 1);
+            x[i + 3] = (int32_t)((ai - bi + 1) >> 1);
+        }
+    }
+    BIT_REVERSE(x, n, int32_t);
+}
+
+int fft_cfft_q31(int32_t *x, unsigned n) {
+    if (!fft_size_valid(n)) return -1;
+    cfft_q31(x, n, 2);
+    return 0;
+}
+
+int fft_rfft_q31(int32_t *x, unsigned n) {
+    if (n < FFT_SIZE_MIN || !fft_size_valid(n)) return -1;
+
+    const unsigned h = n >> 1;
+    cfft_q31(x, h, 3);
+
+    int64_t zr = x[0], zi = x[1];
+    x[0] = sat32(zr + zi);
+    x[1] = sat32(zr - zi);
+
+    const unsigned step = TABLE_N / n;
+    for (unsigned k = 1; k <= h / 2; k++) {
+        int32_t *a = &x[2 * k], *b = &x[2 * (h - k)];
+        int64_t er = ((int64_t)a[0] + b[0]) >> 1, ei = ((int64_t)a[1] - b[1]) >> 1;
+        int64_t or_ = ((int64_t)a[0] - b[0]) >> 1, oi = ((int64_t)a[1] + b[1]) >> 1;
+        int64_t s = sin_q31[k * step], c = sin_q31[256 - k * step];
+        int64_t p = (c * or_ + s * oi + Q31_HALF) >> 31;
+        int64_t q = (c * oi - s * or_ + Q31_HALF) >> 31;
+        a[0] = sat32(er + q);
+        a[1] = sat32(ei - p);
+        if (b != a) {
+            b[0] = sat32(er - q);
+            b[1] = sat32(-ei - p);
+        }
+    }
+    return 0;
+}
+
+void fft_window_hann_q31(int32_t *x, unsigned n) {
+    const unsigned step = TABLE_N / n;
+    for (unsigned i = 0; i < n; i++) {
+        int64_t c, s;
+        TWIDDLE(sin_q31, (i * step) & (TABLE_N - 1), c, s);
+        (void)s;
+        int64_t w = (INT32_MAX - c) >> 1;
+        x[i] = (int32_t)(((int64_t)x[i] * w + Q31_HALF) >> 31);
+    }
+}
+
+uint32_t fft_isqrt64(uint64_t v) {
+    uint64_t r = 0, bit = 1ull << 62;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+void fft_magnitude_q31(const int32_t *bins, uint32_t *mag, unsigned count) {
+    if (count == 0) return;
+    mag[0] = bins[0] < 0 ? (uint32_t)0 - (uint32_t)bins[0] : (uint32_t)bins[0];
+    for (unsigned k = 1; k < count; k++) {
+        int64_t re = bins[2 * k], im = bins[2 * k + 1];
+        mag[k] = fft_isqrt64((uint64_t)(re * re) + (uint64_t)(im * im));
+    }
+}
@@ -0,0 +1,186 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "flash_store.h"
+
+#ifdef PICO_BUILD
+#include <pico/stdlib.h>
+#include <pico/flash.h>
+#include <hardware/flash.h>
+#else
+#include <stdio.h>
+#endif
+
+// Record layout inside the sector
+typedef struct {
+    uint32_t magic;
+    uint32_t tag;
+    uint32_t len;
+    uint32_t crc;   // CRC-32 of the payload
+} flash_store_header_t;
+
+#define FLASH_STORE_MAX_PAYLOAD  (FLASH_STORE_SECTOR_SIZE - sizeof(flash_store_header_t))
+
+uint32_t flash_store_crc32(const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t crc = 0xFFFFFFFFu;
+    while (len--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; ++k) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+/* =========================
+ *  BACKEND: sector access
+ * ========================= */
+#ifdef PICO_BUILD
+
+// Last sector of the flash. Keep it out of the program image.
+#define FLASH_STORE_OFFSET  (PICO_FLASH_SIZE_BYTES - FLASH_STORE_SECTOR_SIZE)
+
+_Static_assert(FLASH_STORE_SECTOR_SIZE == FLASH_SECTOR_SIZE, "store must be one erase sector");
+_Static_assert(FLASH_STORE_OFFSET % FLASH_SECTOR_SIZE == 0, "store sector not aligned");
+
+// End of everything the linker placed in flash (SDK linker script). The
+// default script does not reserve the store sector, so a program that has
+// grown into it must not have it erased under its feet.
+extern char __flash_binary_end;
+
+static bool sector_reserved(void) {
+    return (uintptr_t)&__flash_binary_end <= XIP_BASE + FLASH_STORE_OFFSET;
+}
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;       // multiple of FLASH_PAGE_SIZE, 0 = only erase
+} flash_store_op_t;
+
+// Runs with the other core parked and interrupts disabled (flash_safe_execute)
+static void flash_store_do_write(void *param) {
+    const flash_store_op_t *op = (const flash_store_op_t *)param;
+    flash_range_erase(FLASH_STORE_OFFSET, FLASH_STORE_SECTOR_SIZE);
+    if (op->len) {
+        flash_range_program(FLASH_STORE_OFFSET, op->data, op->len);
+    }
+}
+
+static const uint8_t *sector_read(void) {
+    return (const uint8_t *)(XIP_BASE + FLASH_STORE_OFFSET);
+}
+
+static int sector_write(const uint8_t *data, size_t len) {
+    flash_store_op_t op = { data, len };
+    return flash_safe_execute(flash_store_do_write, &op, 100) == 0 ? 0 : -2;
+}
+
+#else
+
+static bool sector_reserved(void) {
+    return true;
+}
+
+static const char *host_file = FLASH_STORE_HOST_FILE;
+static uint8_t host_sector[FLASH_STORE_SECTOR_SIZE];
+
+void flash_store_set_host_file(const char *path) {
+    host_file = path;
+}
+
+// Erased flash reads as 0xFF; a missing file behaves the same way.
+static const uint8_t *sector_read(void) {
+    memset(host_sector, 0xFF, sizeof(host_sector));
+    FILE *f = fopen(host_file, "rb");
+    if (f) {
+        size_t n = fread(host_sector, 1, sizeof(host_sector), f);
+        (void)n;
+        fclose(f);
+    }
+    return host_sector;
+}
+
+static int sector_write(const uint8_t *data, size_t len) {
+    uint8_t sector[FLASH_STORE_SECTOR_SIZE];
+    memset(sector, 0xFF, sizeof(sector));
+    memcpy(sector, data, len);
+    FILE *f = fopen(host_file, "wb");
+    if (!f) return -2;
+    size_t n = fwrite(sector, 1, sizeof(sector), f);
+    fclose(f);
+    return n == sizeof(sector) ? 0 : -2;
+}
+
+#endif
+
+/* =========================
+ *  PUBLIC API
+ * ========================= */
+
+// Page-aligned staging buffer: flash is programmed in 256-byte pages.
+static uint8_t staging[FLASH_STORE_SECTOR_SIZE] __attribute__((aligned(4)));
+
+int flash_store_save(uint32_t tag, const void *data, size_t len) {
+    if (!sector_reserved()) return -3;
+    if (len > FLASH_STORE_MAX_PAYLOAD) return -1;
+
+    flash_store_header_t hdr = {
+        .magic = FLASH_STORE_MAGIC,
+        .tag = tag,
+        .len = (uint32_t)len,
+        .crc = flash_store_crc32(data, len),
+    };
+    size_t total = sizeof(hdr) + len;
+    size_t padded = (total + 255u) & ~(size_t)255u;
+
+    memset(staging, 0xFF, padded);
+    memcpy(staging, &hdr, sizeof(hdr));
+    memcpy(staging + sizeof(hdr), data, len);
+    return sector_write(staging, padded);
+}
+
+int flash_store_load(uint32_t tag, void *data, size_t len) {
+    if (!sector_reserved()) return -3;
+    const uint8_t *sector = sector_read();
+    flash_store_header_t hdr;
+    memcpy(&hdr, sector, sizeof(hdr));
+
+    if (hdr.magic != FLASH_STORE_MAGIC || hdr.tag != tag || hdr.len != len) return -1;
+    if (flash_store_crc32(sector + sizeof(hdr), len) != hdr.crc) return -2;
+
+    memcpy(data, sector + sizeof(hdr), len);
+    return 0;
+}
+
+int flash_store_erase(void) {
+    if (!sector_reserved()) return -3;
+    return sector_write(staging, 0);
+}
@@ -0,0 +1,81 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Small persistent key/value store in a reserved flash sector.
+ *
+ * Only one record is kept. It is framed with a magic number, a tag that
+ * identifies its content, its length and a CRC-32, so an erased or corrupted
+ * sector is never mistaken for valid data.
+ *
+ * On the Pico the last sector of the flash is used for the store. The SDK's
+ * linker script does not know about it, so every call first checks that the
+ * program image (up to __flash_binary_end) ends before that sector, and
+ * fails with -3 instead of erasing code if it does not. When the file is
+ * built for the host (PICO_BUILD not defined) the sector is emulated by a
+ * regular file, so code using the store can be exercised on a PC.
+ */
+
+#ifndef TKJHAT_FLASH_STORE_H
+#define TKJHAT_FLASH_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FLASH_STORE_SECTOR_SIZE     4096u
+#define FLASH_STORE_MAGIC           0x544B4A48u   // "TKJH"
+
+/* Default file used by the host stand-in (see flash_store_set_host_file()) */
+#define FLASH_STORE_HOST_FILE       "tkjhat_flash.bin"
+
+/**
+ * Save @p len bytes under @p tag, replacing any previous record.
+ * @return 0 on success, -1 if the record does not fit, -2 on write error,
+ *         -3 if the program image reaches into the store sector.
+ */
+int flash_store_save(uint32_t tag, const void *data, size_t len);
+
+/**
+ * Load the record saved under @p tag into @p data.
+ * @return 0 on success, -1 if there is no record with that tag and size,
+ *         -2 if the CRC does not match, -3 if the program image reaches
+ *         into the store sector.
+ */
+int flash_store_load(uint32_t tag, void *data, size_t len);
+
+/** Erase the record. @return 0 on success, negative on error (as save). */
+int flash_store_erase(void);
+
+/** CRC-32 (IEEE 802.3, reflected, polynomial 0xEDB88320). */
+uint32_t flash_store_crc32(const void *data, size_t len);
+
+#ifndef PICO_BUILD
+/** Host only: select the file that emulates the flash sector. */
+void flash_store_set_host_file(const char *path);
+#endif
+
+#endif /* TKJHAT_FLASH_STORE_H */
@@ -0,0 +1,249 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * FreeRTOS task that runs the Mahony filter (mahony.c) on the ICM-42670 at
+ * the IMU ODR and publishes a lock-free snapshot. See tkjhat/imu_fusion.h.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <pico/stdlib.h>
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "tkjhat/imu_fusion.h"
+#include "seqlock.h"
+
+#define RAD_PER_DEG     0.017453292519943295f
+#define DEG_PER_RAD     57.29577951308232f
+#define Q30_ONE         (1 << 30)
+
+/* ---------- Fusion task ---------- */
+
+static TaskHandle_t fusion_task_handle = NULL;
+static volatile bool fusion_running = false;
+static imu_fusion_config_t fusion_cfg;
+
+static seqlock_t orient_lock;
+static imu_orientation_t orient_snapshot;
+static bool orient_valid = false;
+
+static seqlock_t stats_lock;
+static imu_fusion_stats_t fusion_stats;
+
+// Periods that are not a whole number of ticks run from a repeating timer
+// on the hardware alarm; it wakes the task with a notification.
+static repeating_timer_t fusion_timer;
+static bool fusion_timer_on = false;
+
+static bool fusion_timer_cb(repeating_timer_t *rt) {
+    (void)rt;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(fusion_task_handle, &woken);
+    portYIELD_FROM_ISR(woken);
+    return true;
+}
+
+void imu_fusion_default_config(imu_fusion_config_t *cfg) {
+    cfg->odr_hz = IMU_FUSION_ODR_DEFAULT;
+    cfg->variant = IMU_FUSION_FIXED;
+    cfg->kp = IMU_FUSION_KP_DEFAULT;
+    cfg->ki = IMU_FUSION_KI_DEFAULT;
+    cfg->core = -1;
+    cfg->priority = IMU_FUSION_PRIORITY_DEFAULT;
+}
+
+static void publish(const float q[4], uint32_t ts, uint32_t count) {
+    float w = q[0], x = q[1], y = q[2], z = q[3];
+    float sp = 2.0f * (w * y - z * x);
+    if (sp > 1.0f) sp = 1.0f;
+    if (sp < -1.0f) sp = -1.0f;
+
+    imu_orientation_t o;
+    memcpy(o.q, q, sizeof(o.q));
+    o.roll  = atan2f(2.0f * (w * x + y * z), 1.0f - 2.0f * (x * x + y * y)) * DEG_PER_RAD;
+    o.pitch = asinf(sp) * DEG_PER_RAD;
+    o.yaw   = atan2f(2.0f * (w * z + x * y), 1.0f - 2.0f * (y * y + z * z)) * DEG_PER_RAD;
+    o.timestamp_us = ts;
+    o.count = count;
+
+    seqlock_write_begin(&orient_lock);
+    orient_snapshot = o;
+    orient_valid = true;
+    seqlock_write_end(&orient_lock);
+}
+
+static void fusion_task(void *arg) {
+    (void)arg;
+    const imu_fusion_config_t cfg = fusion_cfg;
+    const icm42670_config_t *icm = ICM42670_get_config();
+    // Use the scheduler when the period is a whole number of ticks, otherwise
+    // the alarm (400 and 1600 Hz at a 1 kHz tick)
+    const bool tick_paced = (configTICK_RATE_HZ % cfg.odr_hz) == 0;
+    const TickType_t period_ticks = tick_paced ? configTICK_RATE_HZ / cfg.odr_hz : 0;
+    const float dt = 1.0f / (float)cfg.odr_hz;
+
+    mahony_f32_t ff;
+    mahony_q30_t fq;
+    uint16_t gyro_fsr = icm->gyro_fsr_dps;
+    mahony_f32_init(&ff, cfg.kp, cfg.ki);
+    mahony_q30_init(&fq, cfg.kp, cfg.ki, cfg.odr_hz, icm->gRes);
+
+    imu_fusion_stats_t st;
+    memset(&st, 0, sizeof(st));
+    uint32_t avg_q4 = 0;  // running average in 1/16 us
+
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (fusion_running) {
+        struct icm_raw raw;
+        uint32_t ts = time_us_32();
+
+        if (ICM42670_read_raw(&raw) != 0) {
+            st.read_errors++;
+        } else {
+            float q[4];
+            uint32_t t0 = time_us_32();
+            if (cfg.variant == IMU_FUSION_FIXED) {
+                if (icm->gyro_fsr_dps != gyro_fsr) {
+                    gyro_fsr = icm->gyro_fsr_dps;
+                    mahony_q30_set_gyro_res(&fq, icm->gRes);
+                }
+                mahony_q30_update(&fq, raw.gx, raw.gy, raw.gz, raw.ax, raw.ay, raw.az);
+            } else {
+                const float gs = icm->gyro_scale * RAD_PER_DEG;
+                mahony_f32_update(&ff, raw.gx * gs, raw.gy * gs, raw.gz * gs,
+                                  (float)raw.ax, (float)raw.ay, (float)raw.az, dt);
+            }
+            uint32_t us = time_us_32() - t0;
+
+            if (cfg.variant == IMU_FUSION_FIXED) {
+                for (int i = 0; i < 4; i++) q[i] = (float)fq.q[i] * (1.0f / Q30_ONE);
+            } else {
+                q[0] = ff.q0; q[1] = ff.q1; q[2] = ff.q2; q[3] = ff.q3;
+            }
+            st.updates++;
+            publish(q, ts, st.updates);
+
+            st.update_us_last = us;
+            if (us > st.update_us_max) st.update_us_max = us;
+            avg_q4 += (int32_t)((us << 4) - avg_q4) / 16;
+            st.update_us_avg = (avg_q4 + 8) >> 4;
+        }
+
+        seqlock_write_begin(&stats_lock);
+        fusion_stats = st;
+        seqlock_write_end(&stats_lock);
+
+        if (tick_paced) {
+            if (xTaskDelayUntil(&last_wake, period_ticks) == pdFALSE) {
+                st.overruns++;
+            }
+        } else {
+            // More than one alarm since the last wait: periods were missed.
+            // Timeout only so that a stop request is noticed.
+            uint32_t n = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+            if (n > 1) st.overruns += n - 1;
+        }
+    }
+
+    if (fusion_timer_on) {
+        cancel_repeating_timer(&fusion_timer);
+        fusion_timer_on = false;
+    }
+    fusion_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+int imu_fusion_start(const imu_fusion_config_t *cfg) {
+    if (fusion_task_handle != NULL) return -1;
+
+    imu_fusion_config_t c;
+    if (cfg) {
+        c = *cfg;
+    } else {
+        imu_fusion_default_config(&c);
+    }
+    if (c.odr_hz == 0 || c.odr_hz > 1600 || c.core > 1 || c.kp < 0.0f || c.ki < 0.0f) {
+        return -1;
+    }
+    fusion_cfg = c;
+    fusion_running = true;
+
+    BaseType_t ok = xTaskCreate(fusion_task, "imu_fusion", IMU_FUSION_STACK_SIZE, NULL,
+                                c.priority, &fusion_task_handle);
+    if (ok != pdPASS) {
+        fusion_running = false;
+        fusion_task_handle = NULL;
+        return -2;
+    }
+#if (configNUMBER_OF_CORES > 1) && (configUSE_CORE_AFFINITY == 1)
+    if (c.core >= 0) {
+        vTaskCoreAffinitySet(fusion_task_handle, 1u << c.core);
+    }
+#endif
+    if ((configTICK_RATE_HZ % c.odr_hz) != 0) {
+        // Negative delay: alarm to alarm, not from the end of the callback
+        fusion_timer_on = add_repeating_timer_us(-(int64_t)(1000000u / c.odr_hz),
+                                                 fusion_timer_cb, NULL, &fusion_timer);
+        if (!fusion_timer_on) {
+            imu_fusion_stop();
+            return -2;
+        }
+    }
+    return 0;
+}
+
+void imu_fusion_stop(void) {
+    if (fusion_task_handle == NULL) return;
+    fusion_running = false;
+    // The task finishes its current iteration (never inside a snapshot write)
+    while (fusion_task_handle != NULL) {
+        vTaskDelay(1);
+    }
+}
+
+bool imu_fusion_get(imu_orientation_t *out) {
+    uint32_t s;
+    bool valid;
+    do {
+        s = seqlock_read_begin(&orient_lock);
+        *out = orient_snapshot;
+        valid = orient_valid;
+    } while (seqlock_read_retry(&orient_lock, s));
+    return valid;
+}
+
+void imu_fusion_get_stats(imu_fusion_stats_t *out) {
+    uint32_t s;
+    do {
+        s = seqlock_read_begin(&stats_lock);
+        *out = fusion_stats;
+    } while (seqlock_read_retry(&stats_lock, s));
+}
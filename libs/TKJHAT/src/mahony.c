@@ -0,0 +1,204 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Mahony orientation filter, float and fixed-point. Plain C with no Pico
+ * headers, so the host tools test the same code. See tkjhat/mahony.h.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "tkjhat/mahony.h"
+
+#define RAD_PER_DEG     0.017453292519943295f
+#define Q30_ONE         (1 << 30)
+
+/* ---------- Float filter ---------- */
+
+void mahony_f32_init(mahony_f32_t *f, float kp, float ki) {
+    memset(f, 0, sizeof(*f));
+    f->q0 = 1.0f;
+    f->kp = kp;
+    f->ki = ki;
+}
+
+void mahony_f32_update(mahony_f32_t *f, float gx, float gy, float gz,
+                       float ax, float ay, float az, float dt) {
+    float q0 = f->q0, q1 = f->q1, q2 = f->q2, q3 = f->q3;
+
+    float n2 = ax * ax + ay * ay + az * az;
+    if (n2 > 0.0f) {
+        float inv = 1.0f / sqrtf(n2);
+        ax *= inv; ay *= inv; az *= inv;
+
+        // Gravity direction predicted by the current orientation
+        float vx = 2.0f * (q1 * q3 - q0 * q2);
+        float vy = 2.0f * (q0 * q1 + q2 * q3);
+        float vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+
+        // Error = measured x predicted
+        float ex = ay * vz - az * vy;
+        float ey = az * vx - ax * vz;
+        float ez = ax * vy - ay * vx;
+
+        if (f->ki > 0.0f) {
+            f->ix += f->ki * ex * dt;
+            f->iy += f->ki * ey * dt;
+            f->iz += f->ki * ez * dt;
+            gx += f->ix; gy += f->iy; gz += f->iz;
+        }
+        gx += f->kp * ex;
+        gy += f->kp * ey;
+        gz += f->kp * ez;
+    }
+
+    // q += 0.5 * q (x) (0, g) * dt
+    float h = 0.5f * dt;
+    gx *= h; gy *= h; gz *= h;
+    f->q0 = q0 + (-q1 * gx - q2 * gy - q3 * gz);
+    f->q1 = q1 + ( q0 * gx + q2 * gz - q3 * gy);
+    f->q2 = q2 + ( q0 * gy - q1 * gz + q3 * gx);
+    f->q3 = q3 + ( q0 * gz + q1 * gy - q2 * gx);
+
+    float inv = 1.0f / sqrtf(f->q0 * f->q0 + f->q1 * f->q1 + f->q2 * f->q2 + f->q3 * f->q3);
+    f->q0 *= inv; f->q1 *= inv; f->q2 *= inv; f->q3 *= inv;
+}
+
+/* ---------- Fixed-point filter ----------
+ *
+ * Quaternion and unit vectors are Q30, angular rates are rad/s in Q24
+ * (range +-128 rad/s, i.e. more than the 2000 dps FSR). Products go through
+ * 64-bit intermediates; the only division per step is a 32-bit one to
+ * normalise the accelerometer vector (hardware divider on RP2040).
+ */
+
+// Rounded shifts: plain >> truncates towards -inf, which shows up as a slow
+// yaw drift when it is integrated thousands of times per second.
+static inline int32_t qmul30(int32_t a, int32_t b) {
+    return (int32_t)(((int64_t)a * b + (1 << 29)) >> 30);
+}
+
+static inline int32_t rshift64(int64_t v, int n) {
+    return (int32_t)((v + ((int64_t)1 << (n - 1))) >> n);
+}
+
+static uint32_t isqrt32(uint32_t x) {
+    uint32_t r = 0, bit = 1u << 30;
+    while (bit > x) bit >>= 2;
+    while (bit) {
+        if (x >= r + bit) {
+            x -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return r;
+}
+
+static int32_t gyro_k_q24(float gRes) {
+    // counts -> rad/s Q24
+    return (int32_t)lroundf((float)(1 << 24) * RAD_PER_DEG / gRes);
+}
+
+void mahony_q30_init(mahony_q30_t *f, float kp, float ki, uint16_t odr_hz, float gRes) {
+    memset(f, 0, sizeof(*f));
+    f->q[0] = Q30_ONE;
+    f->kp_q16 = (int32_t)lroundf(kp * 65536.0f);
+    f->ki_q16 = (int32_t)lroundf(ki * 65536.0f);
+    f->half_dt_q32 = (uint32_t)((1ull << 31) / (odr_hz ? odr_hz : 1));
+    mahony_q30_set_gyro_res(f, gRes);
+}
+
+void mahony_q30_set_gyro_res(mahony_q30_t *f, float gRes) {
+    f->gyro_k_q24 = gyro_k_q24(gRes > 0.0f ? gRes : 16.4f);
+}
+
+void mahony_q30_update(mahony_q30_t *f, int16_t raw_gx, int16_t raw_gy, int16_t raw_gz,
+                       int16_t raw_ax, int16_t raw_ay, int16_t raw_az) {
+    const int32_t q0 = f->q[0], q1 = f->q[1], q2 = f->q[2], q3 = f->q[3];
+
+    int32_t gx = raw_gx * f->gyro_k_q24;
+    int32_t gy = raw_gy * f->gyro_k_q24;
+    int32_t gz = raw_gz * f->gyro_k_q24;
+
+    // |a|^2 of three int16 fits in uint32
+    uint32_t n2 = (uint32_t)(raw_ax * raw_ax) + (uint32_t)(raw_ay * raw_ay) +
+                  (uint32_t)(raw_az * raw_az);
+    uint32_t n = isqrt32(n2);
+    if (n > 0) {
+        // a * recip >> 1 is Q30; recip keeps ~17 significant bits
+        uint32_t recip = (1u << 31) / n;
+        int32_t ax = rshift64((int64_t)raw_ax * recip, 1);
+        int32_t ay = rshift64((int64_t)raw_ay * recip, 1);
+        int32_t az = rshift64((int64_t)raw_az * recip, 1);
+
+        int32_t vx = 2 * (qmul30(q1, q3) - qmul30(q0, q2));
+        int32_t vy = 2 * (qmul30(q0, q1) + qmul30(q2, q3));
+        int32_t vz = qmul30(q0, q0) - qmul30(q1, q1) - qmul30(q2, q2) + qmul30(q3, q3);
+
+        int32_t ex = qmul30(ay, vz) - qmul30(az, vy);
+        int32_t ey = qmul30(az, vx) - qmul30(ax, vz);
+        int32_t ez = qmul30(ax, vy) - qmul30(ay, vx);
+
+        // gain Q16 * error Q30 >> 22 -> rad/s Q24
+        if (f->ki_q16 > 0) {
+            uint32_t dt_q32 = f->half_dt_q32 << 1;
+            // The integral is kept in Q30 so tiny increments are not lost
+            f->i[0] += rshift64((int64_t)rshift64((int64_t)f->ki_q16 * ex, 16) * dt_q32, 32);
+            f->i[1] += rshift64((int64_t)rshift64((int64_t)f->ki_q16 * ey, 16) * dt_q32, 32);
+            f->i[2] += rshift64((int64_t)rshift64((int64_t)f->ki_q16 * ez, 16) * dt_q32, 32);
+            gx += rshift64(f->i[0], 6);
+            gy += rshift64(f->i[1], 6);
+            gz += rshift64(f->i[2], 6);
+        }
+        gx += rshift64((int64_t)f->kp_q16 * ex, 22);
+        gy += rshift64((int64_t)f->kp_q16 * ey, 22);
+        gz += rshift64((int64_t)f->kp_q16 * ez, 22);
+    }
+
+    // rate Q24 * dt/2 Q32 >> 26 -> rotation half-angle Q30
+    int32_t hx = rshift64((int64_t)gx * f->half_dt_q32, 26);
+    int32_t hy = rshift64((int64_t)gy * f->half_dt_q32, 26);
+    int32_t hz = rshift64((int64_t)gz * f->half_dt_q32, 26);
+
+    int32_t r0 = q0 - qmul30(q1, hx) - qmul30(q2, hy) - qmul30(q3, hz);
+    int32_t r1 = q1 + qmul30(q0, hx) + qmul30(q2, hz) - qmul30(q3, hy);
+    int32_t r2 = q2 + qmul30(q0, hy) - qmul30(q1, hz) + qmul30(q3, hx);
+    int32_t r3 = q3 + qmul30(q0, hz) + qmul30(q1, hy) - qmul30(q2, hx);
+
+    // Renormalise with one Newton step for 1/sqrt around 1: s = (3 - |r|^2) / 2.
+    // The step is small enough that |r| never strays far from 1.
+    int64_t m2 = rshift64((int64_t)r0 * r0 + (int64_t)r1 * r1 + (int64_t)r2 * r2 + (int64_t)r3 * r3, 30);
+    int32_t s = rshift64(3 * (int64_t)Q30_ONE - m2, 1);
+    f->q[0] = qmul30(r0, s);
+    f->q[1] = qmul30(r1, s);
+    f->q[2] = qmul30(r2, s);
+    f->q[3] = qmul30(r3, s);
+}
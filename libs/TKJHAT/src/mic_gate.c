@@ -0,0 +1,114 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Sound activity gate on raw PDM data. See tkjhat/mic_gate.h.
+ */
+
+#include <string.h>
+
+#include "tkjhat/mic_gate.h"
+
+void mic_gate_default_config(mic_gate_config_t *cfg) {
+    cfg->threshold_x16 = MIC_GATE_THRESHOLD_DEFAULT;
+    cfg->hangover_ms = MIC_GATE_HANGOVER_MS_DEFAULT;
+    cfg->floor_rise_shift = MIC_GATE_FLOOR_RISE_DEFAULT;
+    cfg->floor_min = MIC_GATE_FLOOR_MIN_DEFAULT;
+}
+
+void mic_gate_init(mic_gate_t *g, const mic_gate_config_t *cfg) {
+    memset(g, 0, sizeof(*g));
+    if (cfg) {
+        g->cfg = *cfg;
+    } else {
+        mic_gate_default_config(&g->cfg);
+    }
+}
+
+// Ones in a 32-bit word; M0+ and M33 have no popcount instruction
+static inline uint32_t popcount32(uint32_t v) {
+    v = v - ((v >> 1) & 0x55555555u);
+    v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+    v = (v + (v >> 4)) & 0x0F0F0F0Fu;
+    return (v * 0x01010101u) >> 24;
+}
+
+uint32_t mic_gate_energy(const uint8_t *raw, size_t bytes, size_t block_bytes) {
+    const uint32_t *w = (const uint32_t *)raw;
+    const size_t words_per_block = block_bytes / sizeof(uint32_t);
+    const uint32_t n = bytes / block_bytes;
+    if (n < 2 || words_per_block == 0) return 0;
+
+    // Byte order inside a word does not change the count
+    uint32_t sum = 0, sum_sq = 0;
+    for (uint32_t b = 0; b < n; b++) {
+        uint32_t p = 0;
+        for (size_t i = 0; i < words_per_block; i++) {
+            p += popcount32(*w++);
+        }
+        sum += p;
+        sum_sq += p * p;
+    }
+
+    // n·Σp² - (Σp)² = n²·variance; both terms < 2^32 for n ≤ 256, p ≤ 128
+    uint64_t num = (uint64_t)n * sum_sq - (uint64_t)sum * sum;
+    return (uint32_t)((num << 8) / ((uint64_t)n * n));
+}
+
+bool mic_gate_update(mic_gate_t *g, uint32_t energy, uint32_t buffer_us) {
+    g->energy = energy;
+    g->buffers++;
+
+    if (g->buffers == 1) {
+        g->floor = energy;
+    } else if (energy < g->floor) {
+        g->floor -= (g->floor - energy) >> 1;               // fall fast
+    } else {
+        // Rise slowly; while open, slower still so a long sound stays loud
+        uint8_t shift = g->cfg.floor_rise_shift + (g->open ? 4 : 0);
+        g->floor += (energy - g->floor) >> shift;
+    }
+    if (g->floor < g->cfg.floor_min) g->floor = g->cfg.floor_min;
+
+    bool loud = (uint64_t)energy * 16 > (uint64_t)g->floor * g->cfg.threshold_x16;
+    bool was_open = g->open;
+    if (loud) {
+        g->hang_left_us = (uint32_t)g->cfg.hangover_ms * 1000u;
+        g->open = true;
+    } else if (g->hang_left_us > buffer_us) {
+        g->hang_left_us -= buffer_us;
+    } else {
+        g->hang_left_us = 0;
+        g->open = false;
+    }
+
+    if (g->open) {
+        g->open_buffers++;
+        if (!was_open) g->onsets++;
+    }
+    return g->open;
+}
@@ -0,0 +1,266 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Mic stream: PDM decimation on a DSP task instead of the DMA interrupt.
+ * See tkjhat/mic_stream.h.
+ */
+
+#include <string.h>
+
+#include <pico/stdlib.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <stream_buffer.h>
+
+#include "tkjhat/mic_stream.h"
+#include "seqlock.h"
+
+static TaskHandle_t mic_task_handle = NULL;
+static StreamBufferHandle_t mic_stream = NULL;
+static volatile bool mic_running = false;
+static mic_stream_config_t mic_cfg;
+
+static volatile uint32_t mic_irq_us;        // time_us_32() of the last DMA completion
+static volatile uint32_t mic_isr_us_max;
+
+static seqlock_t stats_lock;
+static mic_stream_stats_t mic_stats_snapshot;
+
+// Filter output; only touched by the DSP task
+static int16_t mic_frame[MEMS_BUFFER_SIZE];
+
+void mic_stream_default_config(mic_stream_config_t *cfg) {
+    cfg->priority = MIC_STREAM_PRIORITY_DEFAULT;
+    cfg->core = 1;
+    cfg->frames = MIC_STREAM_FRAMES_DEFAULT;
+    cfg->gate = false;
+    cfg->preroll = MIC_STREAM_PREROLL_DEFAULT;
+    mic_gate_default_config(&cfg->gate_cfg);
+}
+
+// Runs in the DMA interrupt: timestamp and wake the DSP task, nothing else
+static void mic_stream_on_buffer(void) {
+    uint32_t t0 = time_us_32();
+    mic_irq_us = t0;
+
+    BaseType_t woken = pdFALSE;
+    if (mic_task_handle != NULL) {
+        vTaskNotifyGiveFromISR(mic_task_handle, &woken);
+    }
+
+    uint32_t dt = time_us_32() - t0;
+    if (dt > mic_isr_us_max) mic_isr_us_max = dt;
+    portYIELD_FROM_ISR(woken);
+}
+
+typedef struct {
+    mic_stream_stats_t st;
+    uint32_t filter_avg_q4;
+    uint32_t latency_avg_q4;
+} mic_stream_acc_t;
+
+// Filter the oldest raw buffer into the stream; false if there was none
+static bool mic_stream_filter_one(mic_stream_acc_t *acc) {
+    mic_stream_stats_t *st = &acc->st;
+    uint32_t irq_us = mic_irq_us;
+    uint32_t t0 = time_us_32();
+    int n = get_microphone_samples(mic_frame, MEMS_BUFFER_SIZE);
+    uint32_t t1 = time_us_32();
+    if (n <= 0) return false;
+
+    size_t bytes = (size_t)n * sizeof(mic_frame[0]);
+    size_t sent = xStreamBufferSend(mic_stream, mic_frame, bytes, 0);
+    uint32_t t2 = time_us_32();
+
+    uint32_t filter_us = t1 - t0;
+    uint32_t latency_us = t2 - irq_us;
+    st->buffers++;
+    st->samples += sent / sizeof(mic_frame[0]);
+    st->dropped_samples += (bytes - sent) / sizeof(mic_frame[0]);
+    if (filter_us > st->filter_us_max) st->filter_us_max = filter_us;
+    if (latency_us > st->latency_us_max) st->latency_us_max = latency_us;
+    acc->filter_avg_q4 += (int32_t)((filter_us << 4) - acc->filter_avg_q4) / 16;
+    acc->latency_avg_q4 += (int32_t)((latency_us << 4) - acc->latency_avg_q4) / 16;
+    st->filter_us_avg = (acc->filter_avg_q4 + 8) >> 4;
+    st->latency_us_avg = (acc->latency_avg_q4 + 8) >> 4;
+    return true;
+}
+
+static void mic_stream_task(void *arg) {
+    (void)arg;
+    const mic_stream_config_t cfg = mic_cfg;
+    mic_stream_acc_t acc;
+    memset(&acc, 0, sizeof(acc));
+    mic_stream_stats_t *st = &acc.st;
+
+    struct pdm_microphone_stats mic;
+    pdm_microphone_get_stats(&mic);
+    const size_t raw_size = pdm_microphone_raw_buffer_size();
+    const size_t block_bytes = mic.decimation / 8;
+
+    mic_gate_t gate;
+    mic_gate_init(&gate, &cfg.gate_cfg);
+    uint32_t next_eval = 0;     // next raw buffer for the gate to look at
+    bool first = true;
+
+    while (mic_running) {
+        // Timeout only so that a stop request is noticed
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100)) == 0) continue;
+
+        // A late interrupt may cover several buffers: drain all of them
+        while (mic_running) {
+            uint32_t oldest;
+            uint32_t end = pdm_microphone_raw_window(&oldest);
+            if (oldest == end) break;
+
+            if (!cfg.gate) {
+                if (!mic_stream_filter_one(&acc)) break;
+                continue;
+            }
+
+            if (first || (int32_t)(next_eval - oldest) < 0) {
+                next_eval = oldest;
+                first = false;
+            }
+
+            // Closed: look ahead of the read position, so the buffers before
+            // an onset are still unread (pre-roll). Open: check each buffer
+            // as it is filtered so the gate can close again.
+            if (!gate.open || next_eval == oldest) {
+                if (next_eval == end) {
+                    if (end - oldest > cfg.preroll) {
+                        st->gated_buffers += end - cfg.preroll - oldest;
+                        pdm_microphone_discard(end - cfg.preroll);
+                    }
+                    break;
+                }
+                const uint8_t *raw = pdm_microphone_raw_buffer(next_eval);
+                if (raw == NULL) continue;      // recycled meanwhile; window moved
+                mic_gate_update(&gate, mic_gate_energy(raw, raw_size, block_bytes), mic.buffer_us);
+                next_eval++;
+                if (!gate.open) continue;
+            }
+
+            if (!mic_stream_filter_one(&acc)) break;
+        }
+
+        st->onsets = gate.onsets;
+        st->gate_energy = gate.energy;
+        st->gate_floor = gate.floor;
+        uint32_t total = st->buffers + st->gated_buffers;
+        st->duty_permille = total ? (uint32_t)((uint64_t)st->buffers * 1000u / total) : 0;
+
+        seqlock_write_begin(&stats_lock);
+        mic_stats_snapshot = *st;
+        seqlock_write_end(&stats_lock);
+    }
+
+    mic_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+int mic_stream_start(const mic_stream_config_t *cfg) {
+    if (mic_task_handle != NULL) return -1;
+
+    mic_stream_config_t c;
+    if (cfg) {
+        c = *cfg;
+    } else {
+        mic_stream_default_config(&c);
+    }
+    if (c.core > 1 || c.frames == 0) return -1;
+
+    // The pre-roll stays in the raw ring, next to the buffer being filled
+    // and the one being evaluated
+    struct pdm_microphone_stats mic;
+    pdm_microphone_get_stats(&mic);
+    if (c.gate && c.preroll + 2u > mic.raw_buffer_count) return -1;
+    if (mic.channels != 1) return -1;      // frames and gate assume one channel
+    mic_cfg = c;
+
+    mic_stream = xStreamBufferCreate((size_t)c.frames * sizeof(mic_frame),
+                                     sizeof(mic_frame[0]));
+    if (mic_stream == NULL) return -2;
+
+    memset(&mic_stats_snapshot, 0, sizeof(mic_stats_snapshot));
+    mic_isr_us_max = 0;
+    mic_running = true;
+
+    if (xTaskCreate(mic_stream_task, "mic_dsp", MIC_STREAM_STACK_SIZE, NULL,
+                    c.priority, &mic_task_handle) != pdPASS) {
+        mic_running = false;
+        mic_task_handle = NULL;
+        vStreamBufferDelete(mic_stream);
+        mic_stream = NULL;
+        return -2;
+    }
+#if (configNUMBER_OF_CORES > 1) && (configUSE_CORE_AFFINITY == 1)
+    if (c.core >= 0) {
+        vTaskCoreAffinitySet(mic_task_handle, 1u << c.core);
+    }
+#endif
+
+    pdm_microphone_set_callback(mic_stream_on_buffer);
+    if (init_microphone_sampling() < 0) {
+        mic_stream_stop();
+        return -3;
+    }
+    return 0;
+}
+
+void mic_stream_stop(void) {
+    if (mic_task_handle == NULL) return;
+
+    end_microphone_sampling();
+    pdm_microphone_set_callback(NULL);
+
+    mic_running = false;
+    xTaskNotifyGive(mic_task_handle);
+    while (mic_task_handle != NULL) {
+        vTaskDelay(1);
+    }
+
+    vStreamBufferDelete(mic_stream);
+    mic_stream = NULL;
+}
+
+size_t mic_stream_read(int16_t *buffer, size_t samples, uint32_t timeout_ms) {
+    if (mic_stream == NULL || samples == 0) return 0;
+    size_t got = xStreamBufferReceive(mic_stream, buffer, samples * sizeof(buffer[0]),
+                                      pdMS_TO_TICKS(timeout_ms));
+    return got / sizeof(buffer[0]);
+}
+
+void mic_stream_get_stats(mic_stream_stats_t *out) {
+    uint32_t s;
+    do {
+        s = seqlock_read_begin(&stats_lock);
+        *out = mic_stats_snapshot;
+    } while (seqlock_read_retry(&stats_lock, s));
+    out->isr_us_max = mic_isr_us_max;
+}
@@ -29,233 +29,269 @@
  
 /* Includes ------------------------------------------------------------------*/
  
+#include <stdlib.h>
+#include <string.h>
 #include "OpenPDMFilter.h"
  
  
 /* Variables -----------------------------------------------------------------*/
  
-uint32_t div_const = 0;
-int64_t sub_const = 0;
-uint32_t sinc[DECIMATION_MAX * SINCN];
-uint32_t sinc1[DECIMATION_MAX];
-uint32_t sinc2[DECIMATION_MAX * 2];
-uint32_t coef[SINCN][DECIMATION_MAX];
+/*
+ * All filter arithmetic fits in 32 bits: for decimation D the sinc^3 output
+ * is bounded by D^3 / 2 (2^20 at D = 128), the HP/LP IIR states by a few
+ * times that, and their 8-bit coefficient products by 2^30. The output
+ * scaling is clamped before the multiply (see open_pdm_filter), so the
+ * result is bit-exact with the original 64-bit implementation.
+ */
+ 
+/* Generated by gen_openpdm_tables.py at build time; const, so in flash */
+extern const TPDMFilter_Tables open_pdm_tables_64, open_pdm_tables_128;
+/*
+ * Unzip tables for bit-interleaved stereo. A pair of input bytes holds one
+ * byte of each channel; unzip[0][first] | unzip[1][second] gives the first
+ * channel's byte in bits 0-7 and the second channel's in bits 8-15.
+ */
+extern const uint16_t open_pdm_unzip[2][256];
 #ifdef USE_LUT
-int32_t lut[256][DECIMATION_MAX / 8][SINCN];
+/*
+ * RAM copy of the 128x tables, made by the first 128x Init and kept: its
+ * 48 KB LUT, read whole for every output sample, would thrash the 16 KB
+ * XIP cache from flash. NULL until then, or while malloc fails (the
+ * filter then reads the flash copy).
+ */
+static TPDMFilter_Tables *ram_tables_128;
 #endif
  
  
 /* Functions -----------------------------------------------------------------*/
  
-#ifdef USE_LUT
-int32_t filter_table_mono_64(uint8_t *data, uint8_t sincn)
-{
-  return (int32_t)
-    lut[data[0]][0][sincn] +
-    lut[data[1]][1][sincn] +
-    lut[data[2]][2][sincn] +
-    lut[data[3]][3][sincn] +
-    lut[data[4]][4][sincn] +
-    lut[data[5]][5][sincn] +
-    lut[data[6]][6][sincn] +
-    lut[data[7]][7][sincn];
-}
-int32_t filter_table_stereo_64(uint8_t *data, uint8_t sincn)
+/*
+ * The three sinc stages see the same input bits with different coefficient
+ * segments, so Z0, Z1 and Z2 are accumulated in a single pass over the data.
+ */
+static inline void filter_sinc3(const TPDMFilter_Tables *t, const uint8_t *data, uint8_t bytes,
+                                uint8_t stride, int32_t *Z0, int32_t *Z1, int32_t *Z2)
 {
-  return (int32_t)
-    lut[data[0]][0][sincn] +
-    lut[data[2]][1][sincn] +
-    lut[data[4]][2][sincn] +
-    lut[data[6]][3][sincn] +
-    lut[data[8]][4][sincn] +
-    lut[data[10]][5][sincn] +
-    lut[data[12]][6][sincn] +
-    lut[data[14]][7][sincn];
+  int32_t z0 = 0, z1 = 0, z2 = 0;
+  uint8_t d;
+ 
+#ifdef USE_LUT
+  /* bytes is a constant here, so only one of the two loops is compiled in */
+  if (bytes == 64 / 8) {
+    const uint16_t *lut = t->Lut16;
+    for (d = 0; d < bytes; d++, lut += 256 * SINCN) {
+      const uint16_t *l = lut + data[d * stride] * SINCN;
+      z0 += l[0];
+      z1 += l[1];
+      z2 += l[2];
+    }
+  } else {
+    const int32_t *lut = t->Lut32;
+    for (d = 0; d < bytes; d++, lut += 256 * SINCN) {
+      const int32_t *l = lut + data[d * stride] * SINCN;
+      z0 += l[0];
+      z1 += l[1];
+      z2 += l[2];
+    }
+  }
+#else
+  const uint32_t *coef = t->Coef;
+  const uint16_t decimation = bytes * 8;
+  for (d = 0; d < bytes; d++) {
+    uint8_t c = data[d * stride];
+    uint8_t b;
+    for (b = 0; b < 8; b++) {
+      /* All-ones mask when the bit is set: no branch, no multiply */
+      int32_t m = -(int32_t)((c >> (7 - b)) & 0x01);
+      z0 += coef[d * 8 + b] & m;
+      z1 += coef[decimation + d * 8 + b] & m;
+      z2 += coef[2 * decimation + d * 8 + b] & m;
+    }
+  }
+#endif
+ 
+  *Z0 = z0;
+  *Z1 = z1;
+  *Z2 = z2;
 }
-int32_t filter_table_mono_128(uint8_t *data, uint8_t sincn)
+ 
+/*
+ * Stereo version: every pair of input bytes holds one byte of each channel,
+ * bit-interleaved. The pair is unzipped with two table lookups and both
+ * channels are accumulated in the same loop.
+ */
+static inline void filter_sinc3_stereo(const TPDMFilter_Tables *t, const uint8_t *data, uint8_t bytes,
+                                       int32_t *L, int32_t *R)
 {
-  return (int32_t)
-    lut[data[0]][0][sincn] +
-    lut[data[1]][1][sincn] +
-    lut[data[2]][2][sincn] +
-    lut[data[3]][3][sincn] +
-    lut[data[4]][4][sincn] +
-    lut[data[5]][5][sincn] +
-    lut[data[6]][6][sincn] +
-    lut[data[7]][7][sincn] +
-    lut[data[8]][8][sincn] +
-    lut[data[9]][9][sincn] +
-    lut[data[10]][10][sincn] +
-    lut[data[11]][11][sincn] +
-    lut[data[12]][12][sincn] +
-    lut[data[13]][13][sincn] +
-    lut[data[14]][14][sincn] +
-    lut[data[15]][15][sincn];
+  int32_t l0 = 0, l1 = 0, l2 = 0;
+  int32_t r0 = 0, r1 = 0, r2 = 0;
+  uint8_t d;
+#ifdef USE_LUT
+  const uint16_t *lut16 = t->Lut16;
+  const int32_t *lut32 = t->Lut32;
+#else
+  const uint32_t *coef = t->Coef;
+  const uint16_t decimation = bytes * 8;
+#endif
+ 
+  for (d = 0; d < bytes; d++) {
+    uint16_t w = open_pdm_unzip[0][data[2 * d]] | open_pdm_unzip[1][data[2 * d + 1]];
+    uint8_t cl = (uint8_t)w;
+    uint8_t cr = (uint8_t)(w >> 8);
+#ifdef USE_LUT
+    if (bytes == 64 / 8) {
+      const uint16_t *a = lut16 + cl * SINCN;
+      const uint16_t *b = lut16 + cr * SINCN;
+      l0 += a[0]; l1 += a[1]; l2 += a[2];
+      r0 += b[0]; r1 += b[1]; r2 += b[2];
+      lut16 += 256 * SINCN;
+    } else {
+      const int32_t *a = lut32 + cl * SINCN;
+      const int32_t *b = lut32 + cr * SINCN;
+      l0 += a[0]; l1 += a[1]; l2 += a[2];
+      r0 += b[0]; r1 += b[1]; r2 += b[2];
+      lut32 += 256 * SINCN;
+    }
+#else
+    uint8_t b;
+    for (b = 0; b < 8; b++) {
+      int32_t ml = -(int32_t)((cl >> (7 - b)) & 0x01);
+      int32_t mr = -(int32_t)((cr >> (7 - b)) & 0x01);
+      l0 += coef[d * 8 + b] & ml;
+      l1 += coef[decimation + d * 8 + b] & ml;
+      l2 += coef[2 * decimation + d * 8 + b] & ml;
+      r0 += coef[d * 8 + b] & mr;
+      r1 += coef[decimation + d * 8 + b] & mr;
+      r2 += coef[2 * decimation + d * 8 + b] & mr;
+    }
+#endif
+  }
+ 
+  L[0] = l0; L[1] = l1; L[2] = l2;
+  R[0] = r0; R[1] = r1; R[2] = r2;
 }
-int32_t filter_table_stereo_128(uint8_t *data, uint8_t sincn)
+ 
+size_t Open_PDM_Filter_Table_Bytes(uint8_t decimation)
 {
-  return (int32_t)
-    lut[data[0]][0][sincn] +
-    lut[data[2]][1][sincn] +
-    lut[data[4]][2][sincn] +
-    lut[data[6]][3][sincn] +
-    lut[data[8]][4][sincn] +
-    lut[data[10]][5][sincn] +
-    lut[data[12]][6][sincn] +
-    lut[data[14]][7][sincn] +
-    lut[data[16]][8][sincn] +
-    lut[data[18]][9][sincn] +
-    lut[data[20]][10][sincn] +
-    lut[data[22]][11][sincn] +
-    lut[data[24]][12][sincn] +
-    lut[data[26]][13][sincn] +
-    lut[data[28]][14][sincn] +
-    lut[data[30]][15][sincn];
+  if (decimation != 64 && decimation != 128) {
+    return 0;
+  }
+  size_t bytes = sizeof(TPDMFilter_Tables) + sizeof(uint32_t) * SINCN * decimation;
+#ifdef USE_LUT
+  bytes += (decimation == 64 ? sizeof(uint16_t) : sizeof(int32_t)) * (decimation / 8) * 256 * SINCN;
+#endif
+  return bytes;
 }
-int32_t (* filter_tables_64[2]) (uint8_t *data, uint8_t sincn) = {filter_table_mono_64, filter_table_stereo_64};
-int32_t (* filter_tables_128[2]) (uint8_t *data, uint8_t sincn) = {filter_table_mono_128, filter_table_stereo_128};
-#else
-int32_t filter_table(uint8_t *data, uint8_t sincn, TPDMFilter_InitStruct *param)
+ 
+size_t Open_PDM_Filter_Ram_Bytes(void)
 {
-  uint8_t c, i;
-  uint16_t data_index = 0;
-  uint32_t *coef_p = &coef[sincn][0];
-  int32_t F = 0;
-  uint8_t decimation = param->Decimation;
-  uint8_t channels = param->In_MicChannels;
- 
-  for (i = 0; i < decimation; i += 8) {
-    c = data[data_index];
-    F += ((c >> 7)       ) * coef_p[i    ] +
-         ((c >> 6) & 0x01) * coef_p[i + 1] +
-         ((c >> 5) & 0x01) * coef_p[i + 2] +
-         ((c >> 4) & 0x01) * coef_p[i + 3] +
-         ((c >> 3) & 0x01) * coef_p[i + 4] +
-         ((c >> 2) & 0x01) * coef_p[i + 5] +
-         ((c >> 1) & 0x01) * coef_p[i + 6] +
-         ((c     ) & 0x01) * coef_p[i + 7];
-    data_index += channels;
+#ifdef USE_LUT
+  if (ram_tables_128 != NULL) {
+    return sizeof(TPDMFilter_Tables) + sizeof(int32_t) * (128 / 8) * 256 * SINCN;
   }
-  return F;
-}
 #endif
+  return 0;
+}
  
-void convolve(uint32_t Signal[/* SignalLen */], unsigned short SignalLen,
-              uint32_t Kernel[/* KernelLen */], unsigned short KernelLen,
-              uint32_t Result[/* SignalLen + KernelLen - 1 */])
+static const TPDMFilter_Tables *tables_128(void)
 {
-  uint16_t n;
- 
-  for (n = 0; n < SignalLen + KernelLen - 1; n++)
-  {
-    unsigned short kmin, kmax, k;
-    
-    Result[n] = 0;
-    
-    kmin = (n >= KernelLen - 1) ? n - (KernelLen - 1) : 0;
-    kmax = (n < SignalLen - 1) ? n : SignalLen - 1;
-    
-    for (k = kmin; k <= kmax; k++) {
-      Result[n] += Signal[k] * Kernel[n - k];
+#ifdef USE_LUT
+  if (ram_tables_128 == NULL) {
+    size_t lut_bytes = sizeof(int32_t) * (128 / 8) * 256 * SINCN;
+    TPDMFilter_Tables *t = malloc(sizeof(TPDMFilter_Tables) + lut_bytes);
+    if (t == NULL) {
+      return &open_pdm_tables_128;
     }
+    *t = open_pdm_tables_128;
+    t->Lut32 = memcpy(t + 1, open_pdm_tables_128.Lut32, lut_bytes);
+    ram_tables_128 = t;
   }
+  return ram_tables_128;
+#else
+  return &open_pdm_tables_128;
+#endif
 }
  
-void Open_PDM_Filter_Init(TPDMFilter_InitStruct *Param)
+int Open_PDM_Filter_Init(TPDMFilter_InitStruct *Param)
 {
-  uint16_t i, j;
-  int64_t sum = 0;
- 
-  uint8_t decimation = Param->Decimation;
+  uint16_t i;
+ 
+  if (Param->Decimation == 64) {
+    Param->Tables = &open_pdm_tables_64;
+  } else if (Param->Decimation == 128) {
+    Param->Tables = tables_128();
+  } else {
+    return -1;
+  }
  
   for (i = 0; i < SINCN; i++) {
     Param->Coef[i] = 0;
     Param->bit[i] = 0;
   }
-  for (i = 0; i < decimation; i++) {
-    sinc1[i] = 1;
-  }
  
   Param->OldOut = Param->OldIn = Param->OldZ = 0;
   Param->LP_ALFA = (Param->LP_HZ != 0 ? (uint16_t) (Param->LP_HZ * 256 / (Param->LP_HZ + Param->Fs / (2 * 3.14159))) : 0);
   Param->HP_ALFA = (Param->HP_HZ != 0 ? (uint16_t) (Param->Fs * 256 / (2 * 3.14159 * Param->HP_HZ + Param->Fs)) : 0);
  
-  Param->FilterLen = decimation * SINCN;       
-  sinc[0] = 0;
-  sinc[decimation * SINCN - 1] = 0;      
-  convolve(sinc1, decimation, sinc1, decimation, sinc2);
-  convolve(sinc2, decimation * 2 - 1, sinc1, decimation, &sinc[1]);     
-  for(j = 0; j < SINCN; j++) {
-    for (i = 0; i < decimation; i++) {
-      coef[j][i] = sinc[j * decimation + i];
-      sum += sinc[j * decimation + i];
-    }
-  }
- 
-  sub_const = sum >> 1;
-  div_const = sub_const * Param->MaxVolume / 32768 / FILTER_GAIN;
-  div_const = (div_const == 0 ? 1 : div_const);
+  Param->FilterLen = Param->Decimation * SINCN;
  
-#ifdef USE_LUT
-  /* Look-Up Table. */
-  uint16_t c, d, s;
-  for (s = 0; s < SINCN; s++)
-  {
-    uint32_t *coef_p = &coef[s][0];
-    for (c = 0; c < 256; c++)
-      for (d = 0; d < decimation / 8; d++)
-        lut[c][d][s] = ((c >> 7)       ) * coef_p[d * 8    ] +
-                       ((c >> 6) & 0x01) * coef_p[d * 8 + 1] +
-                       ((c >> 5) & 0x01) * coef_p[d * 8 + 2] +
-                       ((c >> 4) & 0x01) * coef_p[d * 8 + 3] +
-                       ((c >> 3) & 0x01) * coef_p[d * 8 + 4] +
-                       ((c >> 2) & 0x01) * coef_p[d * 8 + 5] +
-                       ((c >> 1) & 0x01) * coef_p[d * 8 + 6] +
-                       ((c     ) & 0x01) * coef_p[d * 8 + 7];
-  }
-#endif
+  Param->DivConst = Param->Tables->SubConst * Param->MaxVolume / 32768 / FILTER_GAIN;
+  Param->DivConst = (Param->DivConst == 0 ? 1 : Param->DivConst);
+  return 0;
 }
  
-void Open_PDM_Filter_64(uint8_t* data, uint16_t* dataOut, uint16_t volume, TPDMFilter_InitStruct *Param)
+/*
+ * Sinc^3 combination, DC removal (HP), smoothing (LP) and volume scaling of
+ * one output sample. State is passed in locals so the caller's loop can keep
+ * it in registers.
+ */
+static inline int16_t filter_output(TPDMFilter_InitStruct *Param, int32_t Z0, int32_t Z1, int32_t Z2,
+                                    int32_t *OldOut, int32_t *OldIn, int32_t *OldZ,
+                                    uint16_t volume, int32_t zmax, int32_t sub_const)
 {
-  uint8_t i, data_out_index;
-  uint8_t channels = Param->In_MicChannels;
-  uint8_t data_inc = ((DECIMATION_MAX >> 4) * channels);
-  int64_t Z, Z0, Z1, Z2;
-  int64_t OldOut, OldIn, OldZ;
- 
-  OldOut = Param->OldOut;
-  OldIn = Param->OldIn;
-  OldZ = Param->OldZ;
+  int32_t Z = Param->Coef[1] + Z2 - sub_const;
+  Param->Coef[1] = Param->Coef[0] + Z1;
+  Param->Coef[0] = Z0;
  
-#ifdef USE_LUT
-  uint8_t j = channels - 1;
-#endif
- 
-  for (i = 0, data_out_index = 0; i < Param->Fs / 1000; i++, data_out_index += channels) {
-#ifdef USE_LUT
-    Z0 = filter_tables_64[j](data, 0);
-    Z1 = filter_tables_64[j](data, 1);
-    Z2 = filter_tables_64[j](data, 2);
-#else
-    Z0 = filter_table(data, 0, Param);
-    Z1 = filter_table(data, 1, Param);
-    Z2 = filter_table(data, 2, Param);
-#endif
+  *OldOut = (Param->HP_ALFA * (*OldOut + Z - *OldIn)) >> 8;
+  *OldIn = Z;
+  *OldZ = ((256 - Param->LP_ALFA) * *OldZ + Param->LP_ALFA * *OldOut) >> 8;
  
-    Z = Param->Coef[1] + Z2 - sub_const;
-    Param->Coef[1] = Param->Coef[0] + Z1;
-    Param->Coef[0] = Z0;
+  Z = SaturaLH(*OldZ, -zmax, zmax) * volume;
+  Z = RoundDiv(Z, Param->DivConst);
+  return (int16_t)SaturaLH(Z, -32700, 32700);
+}
  
-    OldOut = (Param->HP_ALFA * (OldOut + Z - OldIn)) >> 8;
-    OldIn = Z;
-    OldZ = ((256 - Param->LP_ALFA) * OldZ + Param->LP_ALFA * OldOut) >> 8;
+/*
+ * |OldZ| > zmax saturates the output for this volume anyway, so clamping
+ * OldZ first keeps OldZ * volume within 32 bits without changing the
+ * result: zmax * volume > 32701 * DivConst.
+ */
+static inline int32_t output_zmax(const TPDMFilter_InitStruct *Param, uint16_t volume)
+{
+  return volume ? (32701 * Param->DivConst) / volume + 1 : 0;
+}
  
-    Z = OldZ * volume;
-    Z = RoundDiv(Z, div_const);
-    Z = SaturaLH(Z, -32700, 32700);
+/*
+ * Common body of the 64x and 128x filters; bytes = decimation / 8 input
+ * bytes per output sample and channel.
+ */
+static inline void open_pdm_filter(uint8_t* data, uint16_t* dataOut, uint16_t volume,
+                                   TPDMFilter_InitStruct *Param, uint8_t bytes)
+{
+  uint8_t i, data_out_index;
+  uint8_t channels = Param->In_MicChannels;
+  uint8_t data_inc = bytes * channels;
+  int32_t Z0, Z1, Z2;
+  int32_t OldOut = Param->OldOut, OldIn = Param->OldIn, OldZ = Param->OldZ;
+  int32_t zmax = output_zmax(Param, volume);
+  const TPDMFilter_Tables *t = Param->Tables;
+  int32_t sub_const = t->SubConst;
  
-    dataOut[data_out_index] = Z;
+  for (i = 0, data_out_index = 0; i < Param->Fs / 1000; i++, data_out_index += channels) {
+    filter_sinc3(t, data, bytes, channels, &Z0, &Z1, &Z2);
+    dataOut[data_out_index] = filter_output(Param, Z0, Z1, Z2, &OldOut, &OldIn, &OldZ, volume, zmax,
+                                            sub_const);
     data += data_inc;
   }
  
@@ -264,51 +300,55 @@ void Open_PDM_Filter_64(uint8_t* data, uint16_t* dataOut, uint16_t volume, TPDMF
   Param->OldZ = OldZ;
 }
  
-void Open_PDM_Filter_128(uint8_t* data, uint16_t* dataOut, uint16_t volume, TPDMFilter_InitStruct *Param)
+/* Stereo body: 2 * bytes bit-interleaved input bytes per output pair */
+static inline void open_pdm_filter_stereo(uint8_t* data, uint16_t* dataOut, uint16_t volume,
+                                          TPDMFilter_InitStruct *Left, TPDMFilter_InitStruct *Right,
+                                          uint8_t bytes)
 {
-  uint8_t i, data_out_index;
-  uint8_t channels = Param->In_MicChannels;
-  uint8_t data_inc = ((DECIMATION_MAX >> 3) * channels);
-  int64_t Z, Z0, Z1, Z2;
-  int64_t OldOut, OldIn, OldZ;
- 
-  OldOut = Param->OldOut;
-  OldIn = Param->OldIn;
-  OldZ = Param->OldZ;
- 
-#ifdef USE_LUT
-  uint8_t j = channels - 1;
-#endif
- 
-  for (i = 0, data_out_index = 0; i < Param->Fs / 1000; i++, data_out_index += channels) {
-#ifdef USE_LUT
-    Z0 = filter_tables_128[j](data, 0);
-    Z1 = filter_tables_128[j](data, 1);
-    Z2 = filter_tables_128[j](data, 2);
-#else
-    Z0 = filter_table(data, 0, Param);
-    Z1 = filter_table(data, 1, Param);
-    Z2 = filter_table(data, 2, Param);
-#endif
- 
-    Z = Param->Coef[1] + Z2 - sub_const;
-    Param->Coef[1] = Param->Coef[0] + Z1;
-    Param->Coef[0] = Z0;
+  uint8_t i;
+  int32_t L[SINCN], R[SINCN];
+  int32_t LOldOut = Left->OldOut, LOldIn = Left->OldIn, LOldZ = Left->OldZ;
+  int32_t ROldOut = Right->OldOut, ROldIn = Right->OldIn, ROldZ = Right->OldZ;
+  int32_t lzmax = output_zmax(Left, volume);
+  int32_t rzmax = output_zmax(Right, volume);
+  const TPDMFilter_Tables *t = Left->Tables;
+  int32_t sub_const = t->SubConst;
+ 
+  for (i = 0; i < Left->Fs / 1000; i++) {
+    filter_sinc3_stereo(t, data, bytes, L, R);
+    dataOut[2 * i] = filter_output(Left, L[0], L[1], L[2], &LOldOut, &LOldIn, &LOldZ, volume, lzmax,
+                                   sub_const);
+    dataOut[2 * i + 1] = filter_output(Right, R[0], R[1], R[2], &ROldOut, &ROldIn, &ROldZ, volume, rzmax,
+                                       sub_const);
+    data += 2 * bytes;
+  }
  
-    OldOut = (Param->HP_ALFA * (OldOut + Z - OldIn)) >> 8;
-    OldIn = Z;
-    OldZ = ((256 - Param->LP_ALFA) * OldZ + Param->LP_ALFA * OldOut) >> 8;
+  Left->OldOut = LOldOut;
+  Left->OldIn = LOldIn;
+  Left->OldZ = LOldZ;
+  Right->OldOut = ROldOut;
+  Right->OldIn = ROldIn;
+  Right->OldZ = ROldZ;
+}
  
-    Z = OldZ * volume;
-    Z = RoundDiv(Z, div_const);
-    Z = SaturaLH(Z, -32700, 32700);
+void Open_PDM_Filter_64(uint8_t* data, uint16_t* dataOut, uint16_t volume, TPDMFilter_InitStruct *Param)
+{
+  open_pdm_filter(data, dataOut, volume, Param, 64 / 8);
+}
  
-    dataOut[data_out_index] = Z;
-    data += data_inc;
-  }
+void Open_PDM_Filter_128(uint8_t* data, uint16_t* dataOut, uint16_t volume, TPDMFilter_InitStruct *Param)
+{
+  open_pdm_filter(data, dataOut, volume, Param, 128 / 8);
+}
  
-  Param->OldOut = OldOut;
-  Param->OldIn = OldIn;
-  Param->OldZ = OldZ;
+void Open_PDM_Filter_Stereo_64(uint8_t* data, uint16_t* dataOut, uint16_t volume,
+                               TPDMFilter_InitStruct *Left, TPDMFilter_InitStruct *Right)
+{
+  open_pdm_filter_stereo(data, dataOut, volume, Left, Right, 64 / 8);
 }
  
+void Open_PDM_Filter_Stereo_128(uint8_t* data, uint16_t* dataOut, uint16_t volume,
+                                TPDMFilter_InitStruct *Left, TPDMFilter_InitStruct *Right)
+{
+  open_pdm_filter_stereo(data, dataOut, volume, Left, Right, 128 / 8);
+}
@@ -39,6 +39,7 @@
  
 /* Includes ------------------------------------------------------------------*/
  
+#include <stddef.h>
 #include <stdint.h>
  
  
@@ -48,8 +49,11 @@
  * Enable to use a Look-Up Table to improve performances while using more FLASH
  * and RAM memory.
  * Note: Without Look-Up Table up to stereo@16KHz configuration is supported.
+ * Define OPEN_PDM_NO_LUT when compiling to leave it out (e.g. to compare).
  */
+#ifndef OPEN_PDM_NO_LUT
 #define USE_LUT
+#endif
  
 #define SINCN            3
 #define DECIMATION_MAX 128
@@ -67,6 +71,29 @@
  
 /* Types ---------------------------------------------------------------------*/
  
+/*
+ * Coefficient tables for one decimation, generated at build time by
+ * gen_openpdm_tables.py; every filter at that decimation reads the same
+ * ones. The LUT holds, per input byte position d and byte
+ * value c, the three stages' sums of the 8 coefficients selected by c:
+ * [Decimation / 8][256][SINCN], so a block of output walks it forwards.
+ * At 64x the entries fit 16 bits (Lut16, 12 KB, fits the XIP cache); at
+ * 128x they need 32 (Lut32, 48 KB). Coef: 768 / 1536 bytes. All of it is
+ * in flash. Lut32 is three times the 16 KB XIP cache and read whole for
+ * every output sample, so the first 128x Open_PDM_Filter_Init() copies
+ * the 128x tables to the heap (48 KB of RAM from then on, see
+ * Open_PDM_Filter_Ram_Bytes()); at 64x no RAM is used for tables.
+ */
+typedef struct {
+  uint8_t Decimation;
+  int32_t SubConst;          /* half the sum of the sinc^3 kernel */
+  const uint32_t *Coef;      /* [SINCN][Decimation] */
+#ifdef USE_LUT
+  const uint16_t *Lut16;     /* 64x, else NULL */
+  const int32_t *Lut32;      /* 128x, else NULL */
+#endif
+} TPDMFilter_Tables;
+
 typedef struct {
   /* Public */
   float LP_HZ;
@@ -80,21 +107,47 @@ typedef struct {
   uint8_t Gain;
 #endif
   /* Private */
-  uint32_t Coef[SINCN];
+  int32_t Coef[SINCN];
   uint16_t FilterLen;
-  int64_t OldOut, OldIn, OldZ;
+  int32_t OldOut, OldIn, OldZ;
   uint16_t LP_ALFA;
   uint16_t HP_ALFA;
   uint16_t bit[5];
   uint16_t byte;
+  int32_t DivConst;
+  const TPDMFilter_Tables *Tables;
 } TPDMFilter_InitStruct;
  
  
 /* Exported functions ------------------------------------------------------- */
  
-void Open_PDM_Filter_Init(TPDMFilter_InitStruct *init_struct);
+/*
+ * All state lives in the struct, so filters with different parameters can
+ * run side by side, and one can be re-initialised while another runs.
+ * Init only resets the state and picks the tables, so it is cheap enough
+ * for every start (the first at 128x also copies the LUT to RAM; if that
+ * allocation fails the filter reads it from flash, slower but the same
+ * output); returns -1 for an unsupported decimation.
+ */
+int Open_PDM_Filter_Init(TPDMFilter_InitStruct *init_struct);
+/* Bytes of the tables for a decimation (0 if not supported) */
+size_t Open_PDM_Filter_Table_Bytes(uint8_t decimation);
+/* Heap bytes taken by table copies so far (0 until a 128x filter starts) */
+size_t Open_PDM_Filter_Ram_Bytes(void);
 void Open_PDM_Filter_64(uint8_t* data, uint16_t* data_out, uint16_t mic_gain, TPDMFilter_InitStruct *init_struct);
 void Open_PDM_Filter_128(uint8_t* data, uint16_t* data_out, uint16_t mic_gain, TPDMFilter_InitStruct *init_struct);
+
+/*
+ * Two microphones sharing one data line, sampled on both clock edges: the
+ * input bits alternate between the channels (first channel in bit 7 of each
+ * byte). Both channels are decimated in one pass into interleaved output
+ * (first, second, first, ...). Each channel keeps its own filter state in
+ * left / right, both initialised with the same parameters.
+ */
+void Open_PDM_Filter_Stereo_64(uint8_t* data, uint16_t* data_out, uint16_t mic_gain,
+                               TPDMFilter_InitStruct *left, TPDMFilter_InitStruct *right);
+void Open_PDM_Filter_Stereo_128(uint8_t* data, uint16_t* data_out, uint16_t mic_gain,
+                                TPDMFilter_InitStruct *left, TPDMFilter_InitStruct *right);
  
 #ifdef __cplusplus
 }
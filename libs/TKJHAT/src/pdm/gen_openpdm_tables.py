@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""Generate the OpenPDM2PCM coefficient tables as const C arrays.
+
+    gen_openpdm_tables.py <out.c>
+
+Run by the build (see libs/TKJHAT/CMakeLists.txt and tools/CMakeLists.txt)
+so the tables land in flash instead of being computed into RAM at every
+Open_PDM_Filter_Init(). (The 128x LUT is copied to RAM by the first 128x
+Open_PDM_Filter_Init(), see OpenPDMFilter.c.) The values are the ones the filter used to build
+at run time: the sinc^3 kernel (three boxcars of length D convolved, with a
+zero tap before and after), its per-byte lookup table and the stereo unzip
+tables. The layout is described in OpenPDMFilter.h (TPDMFilter_Tables).
+"""
+
+import os
+import sys
+
+SINCN = 3
+DECIMATIONS = (64, 128)
+
+
+def boxcar_conv(a, b):
+    out = [0] * (len(a) + len(b) - 1)
+    for i, x in enumerate(a):
+        for j, y in enumerate(b):
+            out[i + j] += x * y
+    return out
+
+
+def sinc3(decimation):
+    box = [1] * decimation
+    kernel = boxcar_conv(boxcar_conv(box, box), box)
+    return [0] + kernel + [0]
+
+
+def lut(coef, decimation):
+    # [decimation / 8][256][SINCN]: for each 8-tap segment, every byte value
+    # against the three stages, first PDM bit in bit 7. The filter walks the
+    # segments in order, one 256-entry block per input byte.
+    out = []
+    for d in range(decimation // 8):
+        for c in range(256):
+            for s in range(SINCN):
+                seg = coef[s * decimation + d * 8:s * decimation + d * 8 + 8]
+                out.append(sum(seg[b] for b in range(8) if c >> (7 - b) & 1))
+    return out
+
+
+def unzip():
+    first_tab, second_tab = [], []
+    for i in range(256):
+        first = second = 0
+        for j in range(4):
+            first |= ((i >> (7 - 2 * j)) & 1) << (3 - j)
+            second |= ((i >> (6 - 2 * j)) & 1) << (3 - j)
+        first_tab.append((first << 4) | (second << 12))
+        second_tab.append(first | (second << 8))
+    return first_tab, second_tab
+
+
+def array(out, decl, values, per_line=12):
+    out.append(decl + " = {")
+    for i in range(0, len(values), per_line):
+        out.append("  " + ", ".join(str(v) for v in values[i:i + per_line]) + ",")
+    out.append("};")
+    out.append("")
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    out = [
+        "/* Generated by gen_openpdm_tables.py; do not edit. */",
+        "",
+        '#include "OpenPDMFilter.h"',
+        "",
+    ]
+    for d in DECIMATIONS:
+        coef = sinc3(d)
+        assert len(coef) == SINCN * d
+        array(out, "static const uint32_t coef_%d[SINCN * %d]" % (d, d), coef)
+        # 16-bit entries wherever the largest one fits (64x: 8 taps of a
+        # kernel peaking at 3D^2/4 stay below 2^15)
+        table = lut(coef, d)
+        lut_type = "uint16_t" if max(table) <= 0xFFFF else "int32_t"
+        assert lut_type == "uint16_t" or max(table) < 2 ** 31
+        out.append("#ifdef USE_LUT")
+        array(out, "static const %s lut_%d[%d * 256 * SINCN]" % (lut_type, d, d // 8), table)
+        out.append("#endif")
+        out.append("")
+        out.append("const TPDMFilter_Tables open_pdm_tables_%d = {" % d)
+        out.append("  %d, %d, coef_%d," % (d, sum(coef) >> 1, d))
+        out.append("#ifdef USE_LUT")
+        if lut_type == "uint16_t":
+            out.append("  lut_%d, 0," % d)
+        else:
+            out.append("  0, lut_%d," % d)
+        out.append("#endif")
+        out.append("};")
+        out.append("")
+    first, second = unzip()
+    out.append("const uint16_t open_pdm_unzip[2][256] = {")
+    for tab in (first, second):
+        out.append("  {")
+        for i in range(0, 256, 12):
+            out.append("    " + ", ".join(str(v) for v in tab[i:i + 12]) + ",")
+        out.append("  },")
+    out.append("};")
+
+    os.makedirs(os.path.dirname(os.path.abspath(sys.argv[1])), exist_ok=True)
+    with open(sys.argv[1], "w") as f:
+        f.write("\n".join(out) + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -13,6 +13,7 @@
 #include "hardware/clocks.h"
 #include "hardware/dma.h"
 #include "hardware/irq.h"
+#include "pico/stdlib.h"
 
 #include "OpenPDM2PCM/OpenPDMFilter.h"
 
@@ -20,18 +21,41 @@
 
 #include <tkjhat/pdm_microphone.h>
 
-#define PDM_DECIMATION       64
-#define PDM_RAW_BUFFER_COUNT 2
+// Capture ring: the data channel fills raw_buffer[i] from the PIO FIFO and
+// chains to the control channel, which loads the next entry of
+// write_addr_ring into the data channel's WRITE_ADDR_TRIG. The control
+// channel reads the table through a DMA address ring, so the two channels
+// keep cycling through the buffers without any CPU involvement. The IRQ
+// only counts completed buffers.
+static uint32_t write_addr_ring[PDM_RAW_BUFFER_MAX] __attribute__((aligned(PDM_RAW_BUFFER_MAX * sizeof(uint32_t))));
 
 static struct {
     struct pdm_microphone_config config;
     int dma_channel;
-    uint8_t* raw_buffer[PDM_RAW_BUFFER_COUNT];
-    volatile int raw_buffer_write_index;
-    volatile int raw_buffer_read_index;
+    int ctrl_dma_channel;
+    uint8_t* raw_buffer_block;
+    uint8_t* raw_buffer[PDM_RAW_BUFFER_MAX];
+    uint raw_buffer_count;
+    volatile uint32_t buffers_captured;
+    volatile uint32_t buffers_read;
+    volatile uint32_t overruns;
+    volatile uint32_t underruns;
+    volatile uint32_t late_irqs;
+    volatile uint32_t pool_overruns;
     uint raw_buffer_size;
+    uint decimation;
+    uint channels;
+    uint32_t buffer_us;
+    // PCM pool for lend/return. Only the lender sets a flag and only the
+    // borrower clears it, so neither side needs a critical section.
+    int16_t* pcm_pool;
+    uint pcm_block_count;
+    uint pcm_block_samples;
+    volatile bool pcm_lent[PDM_PCM_BLOCK_MAX];
+    volatile uint32_t filter_us_last;
+    volatile uint32_t filter_us_max;
     uint dma_irq;
-    TPDMFilter_InitStruct filter;
+    TPDMFilter_InitStruct filter[PDM_CHANNELS_MAX];    // one state per channel
     uint16_t filter_volume;
     pdm_samples_ready_handler_t samples_ready_handler;
     volatile bool stopping; 
@@ -41,37 +65,133 @@ static struct {
 
 static void pdm_dma_handler();
 
+// Program both channels so that a single start of the data channel begins
+// the endless raw_buffer[0] -> raw_buffer[1] -> ... cycle.
+static void pdm_microphone_configure_dma() {
+    dma_channel_config data_cfg = dma_channel_get_default_config(pdm_mic.dma_channel);
+
+    // One bus transfer per 32 PDM bits. The PIO shifts left, so the first
+    // bit is the MSB of the word; bswap stores the bytes in arrival order,
+    // which is what the filter's byte LUT expects.
+    channel_config_set_transfer_data_size(&data_cfg, DMA_SIZE_32);
+    channel_config_set_bswap(&data_cfg, true);
+    channel_config_set_read_increment(&data_cfg, false);
+    channel_config_set_write_increment(&data_cfg, true);
+    channel_config_set_dreq(&data_cfg, pio_get_dreq(pdm_mic.config.pio, pdm_mic.config.pio_sm, false));
+    channel_config_set_chain_to(&data_cfg, pdm_mic.ctrl_dma_channel);
+
+    dma_channel_configure(
+        pdm_mic.dma_channel,
+        &data_cfg,
+        pdm_mic.raw_buffer[0],
+        &pdm_mic.config.pio->rxf[pdm_mic.config.pio_sm],
+        pdm_mic.raw_buffer_size / sizeof(uint32_t),
+        false
+    );
+
+    dma_channel_config ctrl_cfg = dma_channel_get_default_config(pdm_mic.ctrl_dma_channel);
+
+    channel_config_set_transfer_data_size(&ctrl_cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&ctrl_cfg, true);
+    channel_config_set_write_increment(&ctrl_cfg, false);
+    channel_config_set_ring(&ctrl_cfg, false, __builtin_ctz(pdm_mic.raw_buffer_count * sizeof(uint32_t)));
+
+    // The control channel is pre-advanced to entry 1: entry 0 is loaded above
+    dma_channel_configure(
+        pdm_mic.ctrl_dma_channel,
+        &ctrl_cfg,
+        &dma_hw->ch[pdm_mic.dma_channel].al2_write_addr_trig,
+        &write_addr_ring[1 & (pdm_mic.raw_buffer_count - 1)],
+        1,
+        false
+    );
+}
+
+// Index of the buffer the data channel is currently filling, derived from
+// the control channel's read pointer (which is always one entry ahead).
+static inline uint pdm_microphone_active_buffer() {
+    uint32_t next = (dma_hw->ch[pdm_mic.ctrl_dma_channel].read_addr - (uint32_t)(uintptr_t)write_addr_ring)
+                    / sizeof(uint32_t);
+    return (next - 1) & (pdm_mic.raw_buffer_count - 1);
+}
+
 int pdm_microphone_init(const struct pdm_microphone_config* config) {
     memset(&pdm_mic, 0x00, sizeof(pdm_mic));
     memcpy(&pdm_mic.config, config, sizeof(pdm_mic.config));
 
     pdm_mic.stopping = false;
+    pdm_mic.dma_channel = -1;
+    pdm_mic.ctrl_dma_channel = -1;
 
-    if (config->sample_buffer_size % (config->sample_rate / 1000)) {
+    if (config->sample_rate == 0 || config->sample_rate % 1000 ||
+        config->sample_rate > PDM_SAMPLE_RATE_MAX ||
+        config->sample_buffer_size == 0 ||
+        config->sample_buffer_size % (config->sample_rate / 1000)) {
         return -1;
     }
 
-    pdm_mic.raw_buffer_size = config->sample_buffer_size * (PDM_DECIMATION / 8);
+    // OpenPDM2PCM only implements 64x and 128x; the mic caps the PDM clock
+    pdm_mic.decimation = config->decimation ? config->decimation : PDM_DECIMATION_DEFAULT;
+    if (pdm_mic.decimation != 64 && pdm_mic.decimation != 128) {
+        return -1;
+    }
+    if (config->sample_rate * pdm_mic.decimation > PDM_CLOCK_MAX_HZ) {
+        return -1;
+    }
+    pdm_mic.channels = config->channels ? config->channels : 1;
+    if (pdm_mic.channels > PDM_CHANNELS_MAX) {
+        return -1;
+    }
+    pdm_mic.buffer_us = (uint32_t)((uint64_t)config->sample_buffer_size * 1000000u / config->sample_rate);
+
+    // Ring length must be a power of two for the DMA address ring
+    pdm_mic.raw_buffer_count = config->raw_buffer_count ? config->raw_buffer_count
+                                                        : PDM_RAW_BUFFER_COUNT_DEFAULT;
+    if (pdm_mic.raw_buffer_count < 2 || pdm_mic.raw_buffer_count > PDM_RAW_BUFFER_MAX ||
+        (pdm_mic.raw_buffer_count & (pdm_mic.raw_buffer_count - 1))) {
+        return -1;
+    }
 
-    for (int i = 0; i < PDM_RAW_BUFFER_COUNT; i++) {
-        pdm_mic.raw_buffer[i] = malloc(pdm_mic.raw_buffer_size);
-        if (pdm_mic.raw_buffer[i] == NULL) {
-            pdm_microphone_deinit();
+    // Both channels share the PIO words: twice the bits at the same PDM clock
+    pdm_mic.raw_buffer_size = config->sample_buffer_size * (pdm_mic.decimation / 8) * pdm_mic.channels;
 
-            return -1;   
-        }
+    pdm_mic.raw_buffer_block = malloc(pdm_mic.raw_buffer_size * pdm_mic.raw_buffer_count);
+    if (pdm_mic.raw_buffer_block == NULL) {
+        return -1;
+    }
+    for (uint i = 0; i < pdm_mic.raw_buffer_count; i++) {
+        pdm_mic.raw_buffer[i] = pdm_mic.raw_buffer_block + i * pdm_mic.raw_buffer_size;
+        write_addr_ring[i] = (uint32_t)(uintptr_t)pdm_mic.raw_buffer[i];
     }
 
-    pdm_mic.dma_channel = dma_claim_unused_channel(true);
-    if (pdm_mic.dma_channel < 0) {
+    pdm_mic.pcm_block_count = config->pcm_block_count ? config->pcm_block_count
+                                                      : PDM_PCM_BLOCK_COUNT_DEFAULT;
+    if (pdm_mic.pcm_block_count > PDM_PCM_BLOCK_MAX) {
         pdm_microphone_deinit();
 
         return -1;
     }
+    pdm_mic.pcm_block_samples = config->sample_buffer_size * pdm_mic.channels;
+    pdm_mic.pcm_pool = malloc(pdm_mic.pcm_block_samples * pdm_mic.pcm_block_count * sizeof(int16_t));
+    if (pdm_mic.pcm_pool == NULL) {
+        pdm_microphone_deinit();
 
-    uint pio_sm_offset = pio_add_program(config->pio, &pdm_microphone_data_program);
+        return -1;
+    }
 
-    float clk_div = clock_get_hz(clk_sys) / (config->sample_rate * PDM_DECIMATION * 4.0);
+    pdm_mic.dma_channel = dma_claim_unused_channel(false);
+    pdm_mic.ctrl_dma_channel = dma_claim_unused_channel(false);
+    if (pdm_mic.dma_channel < 0 || pdm_mic.ctrl_dma_channel < 0) {
+        pdm_microphone_deinit();
+
+        return -1;
+    }
+
+    const bool stereo = pdm_mic.channels == 2;
+    uint pio_sm_offset = pio_add_program(config->pio, stereo ? &pdm_microphone_stereo_data_program
+                                                             : &pdm_microphone_data_program);
+
+    float clk_div = clock_get_hz(clk_sys) / (config->sample_rate * pdm_mic.decimation * 4.0);
 
     pdm_microphone_data_init(
         config->pio,
@@ -79,47 +199,42 @@ int pdm_microphone_init(const struct pdm_microphone_config* config) {
         pio_sm_offset,
         clk_div,
         config->gpio_data,
-        config->gpio_clk
+        config->gpio_clk,
+        stereo
     );
 
-    dma_channel_config dma_channel_cfg = dma_channel_get_default_config(pdm_mic.dma_channel);
-
-    channel_config_set_transfer_data_size(&dma_channel_cfg, DMA_SIZE_8);
-    channel_config_set_read_increment(&dma_channel_cfg, false);
-    channel_config_set_write_increment(&dma_channel_cfg, true);
-    channel_config_set_dreq(&dma_channel_cfg, pio_get_dreq(config->pio, config->pio_sm, false));
-
     pdm_mic.dma_irq = DMA_IRQ_0;
 
-    dma_channel_configure(
-        pdm_mic.dma_channel,
-        &dma_channel_cfg,
-        pdm_mic.raw_buffer[0],
-        &config->pio->rxf[config->pio_sm],
-        pdm_mic.raw_buffer_size,
-        false
-    );
-
-    pdm_mic.filter.Fs = config->sample_rate;
-    pdm_mic.filter.LP_HZ = config->sample_rate / 2;
-    pdm_mic.filter.HP_HZ = 10; 
-    pdm_mic.filter.In_MicChannels = 1;
-    pdm_mic.filter.Out_MicChannels = 1;
-    pdm_mic.filter.Decimation = PDM_DECIMATION;
-    pdm_mic.filter.MaxVolume = 64;
-    pdm_mic.filter.Gain = 16;
+    pdm_microphone_configure_dma();
+
+    for (uint c = 0; c < pdm_mic.channels; c++) {
+        TPDMFilter_InitStruct* filter = &pdm_mic.filter[c];
+        filter->Fs = config->sample_rate;
+        filter->LP_HZ = config->sample_rate / 2;
+        filter->HP_HZ = 10;
+        filter->In_MicChannels = pdm_mic.channels;
+        filter->Out_MicChannels = pdm_mic.channels;
+        filter->Decimation = pdm_mic.decimation;
+        filter->MaxVolume = 64;
+        filter->Gain = 16;
+    }
 
-    pdm_mic.filter_volume = pdm_mic.filter.MaxVolume;
+    pdm_mic.filter_volume = pdm_mic.filter[0].MaxVolume;
     return 0;
 }
 
 void pdm_microphone_deinit() {
-    for (int i = 0; i < PDM_RAW_BUFFER_COUNT; i++) {
-        if (pdm_mic.raw_buffer[i]) {
-            free(pdm_mic.raw_buffer[i]);
+    if (pdm_mic.raw_buffer_block) {
+        free(pdm_mic.raw_buffer_block);
 
-            pdm_mic.raw_buffer[i] = NULL;
-        }
+        pdm_mic.raw_buffer_block = NULL;
+    }
+    memset(pdm_mic.raw_buffer, 0x00, sizeof(pdm_mic.raw_buffer));
+
+    if (pdm_mic.pcm_pool) {
+        free(pdm_mic.pcm_pool);
+
+        pdm_mic.pcm_pool = NULL;
     }
 
     if (pdm_mic.dma_channel > -1) {
@@ -127,11 +242,25 @@ void pdm_microphone_deinit() {
 
         pdm_mic.dma_channel = -1;
     }
+
+    if (pdm_mic.ctrl_dma_channel > -1) {
+        dma_channel_unclaim(pdm_mic.ctrl_dma_channel);
+
+        pdm_mic.ctrl_dma_channel = -1;
+    }
 }
 
 int pdm_microphone_start() {
     pdm_mic.stopping = false;
 
+    // Only resets the filter state: the coefficient tables are in flash (the
+    // first start at 128x copies its LUT to RAM)
+    for (uint c = 0; c < pdm_mic.channels; c++) {
+        if (Open_PDM_Filter_Init(&pdm_mic.filter[c]) < 0) {
+            return -1;
+        }
+    }
+
     // Reset SM cleanly before enabling
     pio_sm_set_enabled(pdm_mic.config.pio, pdm_mic.config.pio_sm, false);
     pio_sm_clear_fifos(pdm_mic.config.pio, pdm_mic.config.pio_sm);
@@ -150,19 +279,14 @@ int pdm_microphone_start() {
     }
     irq_set_enabled(pdm_mic.dma_irq, true);
 
-    Open_PDM_Filter_Init(&pdm_mic.filter);
-
     // Enable SM and start the first DMA transfer
     pio_sm_set_enabled(pdm_mic.config.pio, pdm_mic.config.pio_sm, true);
 
-    pdm_mic.raw_buffer_write_index = 0;
-    pdm_mic.raw_buffer_read_index  = 0;
+    pdm_mic.buffers_captured = 0;
+    pdm_mic.buffers_read     = 0;
 
-    dma_channel_transfer_to_buffer_now(
-        pdm_mic.dma_channel,
-        pdm_mic.raw_buffer[0],
-        pdm_mic.raw_buffer_size
-    );
+    pdm_microphone_configure_dma();
+    dma_channel_start(pdm_mic.dma_channel);
 
     return 0;
 }
@@ -182,34 +306,36 @@ void pdm_microphone_stop() {
         dma_hw->ints1 = (1u << pdm_mic.dma_channel);
     }
 
-    dma_channel_abort(pdm_mic.dma_channel);  // 4) now it's safe to abort DMA
-
-    // 5) stop the PIO state machine
+    // 4) stop the PIO state machine so the data channel stalls on DREQ
     pio_sm_set_enabled(pdm_mic.config.pio, pdm_mic.config.pio_sm, false);
 
+    // 5) now it's safe to abort DMA; data first so it cannot chain again
+    dma_channel_abort(pdm_mic.dma_channel);
+    dma_channel_abort(pdm_mic.ctrl_dma_channel);
+
     // 6) reset indices
-    pdm_mic.raw_buffer_write_index = 0;
-    pdm_mic.raw_buffer_read_index  = 0;
+    pdm_mic.buffers_captured = 0;
+    pdm_mic.buffers_read     = 0;
 
     // leave stopping=true; start() will clear it
 }
 
 static void pdm_dma_handler() {
-    // clear IRQ first
+    // Sample the ring position before clearing, so a completion that lands
+    // in between is picked up by the next IRQ instead of being lost
+    uint active = pdm_microphone_active_buffer();
+
     if (pdm_mic.dma_irq == DMA_IRQ_0) dma_hw->ints0 = (1u << pdm_mic.dma_channel);
     else                              dma_hw->ints1 = (1u << pdm_mic.dma_channel);
 
-    if (pdm_mic.stopping) return;  // don't re-arm or callback while stopping
+    if (pdm_mic.stopping) return;  // don't count or callback while stopping
 
-    // normal handler body
-    pdm_mic.raw_buffer_read_index  = pdm_mic.raw_buffer_write_index;
-    pdm_mic.raw_buffer_write_index = (pdm_mic.raw_buffer_write_index + 1) % PDM_RAW_BUFFER_COUNT;
-
-    dma_channel_transfer_to_buffer_now(
-        pdm_mic.dma_channel,
-        pdm_mic.raw_buffer[pdm_mic.raw_buffer_write_index],
-        pdm_mic.raw_buffer_size
-    );
+    // The DMA keeps running on its own; catch up on every buffer completed
+    // since the last IRQ, even if this one was serviced late
+    uint32_t completed = (active - pdm_mic.buffers_captured) & (pdm_mic.raw_buffer_count - 1);
+    if (completed == 0) return;
+    if (completed > 1) pdm_mic.late_irqs++;
+    pdm_mic.buffers_captured += completed;
 
     if (pdm_mic.samples_ready_handler) pdm_mic.samples_ready_handler();
 }
@@ -220,46 +346,175 @@ void pdm_microphone_set_samples_ready_handler(pdm_samples_ready_handler_t handle
 }
 
 void pdm_microphone_set_filter_max_volume(uint8_t max_volume) {
-    pdm_mic.filter.MaxVolume = max_volume;
+    for (uint c = 0; c < PDM_CHANNELS_MAX; c++) pdm_mic.filter[c].MaxVolume = max_volume;
 }
 
 void pdm_microphone_set_filter_gain(uint8_t gain) {
-    pdm_mic.filter.Gain = gain;
+    for (uint c = 0; c < PDM_CHANNELS_MAX; c++) pdm_mic.filter[c].Gain = gain;
 }
 
 void pdm_microphone_set_filter_volume(uint16_t volume) {
     pdm_mic.filter_volume = volume;
 }
 
+// Drop the buffers the DMA has already recycled; returns the oldest readable
+static uint32_t pdm_microphone_oldest() {
+    uint32_t read = pdm_mic.buffers_read;
+    uint32_t pending = pdm_mic.buffers_captured - read;
+    if (pending >= pdm_mic.raw_buffer_count) {
+        uint32_t lost = pending - (pdm_mic.raw_buffer_count - 1);
+        pdm_mic.overruns += lost;
+        read += lost;
+        pdm_mic.buffers_read = read;
+    }
+    return read;
+}
+
 int pdm_microphone_read(int16_t* buffer, size_t samples) {
-    int filter_stride = (pdm_mic.filter.Fs / 1000);
+    // One filter call makes 1 ms of output for every channel
+    size_t filter_stride = (size_t)(pdm_mic.filter[0].Fs / 1000) * pdm_mic.channels;
     samples = (samples / filter_stride) * filter_stride;
 
-    if (samples > pdm_mic.config.sample_buffer_size) {
-        samples = pdm_mic.config.sample_buffer_size;
+    if (samples > pdm_mic.pcm_block_samples) {
+        samples = pdm_mic.pcm_block_samples;
     }
 
-    if (pdm_mic.raw_buffer_write_index == pdm_mic.raw_buffer_read_index) {
+    // Up to count-1 completed buffers are safe; the next one is being filled
+    uint32_t read = pdm_microphone_oldest();
+    if (pdm_mic.buffers_captured == read) {
+        pdm_mic.underruns++;
         return 0;
     }
 
-    uint8_t* in = pdm_mic.raw_buffer[pdm_mic.raw_buffer_read_index];
+    uint8_t* in = pdm_mic.raw_buffer[read & (pdm_mic.raw_buffer_count - 1)];
     int16_t* out = buffer;
 
-    pdm_mic.raw_buffer_read_index++;
-
-    for (int i = 0; i < samples; i += filter_stride) {
-#if PDM_DECIMATION == 64
-        Open_PDM_Filter_64(in, out, pdm_mic.filter_volume, &pdm_mic.filter);
-#elif PDM_DECIMATION == 128
-        Open_PDM_Filter_128(in, out, pdm_mic.filter_volume, &pdm_mic.filter);
-#else
-        #error "Unsupported PDM_DECIMATION value!"
-#endif
+    pdm_mic.buffers_read = read + 1;
+
+    uint32_t t0 = time_us_32();
+    TPDMFilter_InitStruct* left = &pdm_mic.filter[0];
+    TPDMFilter_InitStruct* right = &pdm_mic.filter[1];
+    for (size_t i = 0; i < samples; i += filter_stride) {
+        if (pdm_mic.channels == 2) {
+            // Both channels in one pass over the interleaved bits
+            if (pdm_mic.decimation == 128) {
+                Open_PDM_Filter_Stereo_128(in, (uint16_t*)out, pdm_mic.filter_volume, left, right);
+            } else {
+                Open_PDM_Filter_Stereo_64(in, (uint16_t*)out, pdm_mic.filter_volume, left, right);
+            }
+        } else if (pdm_mic.decimation == 128) {
+            Open_PDM_Filter_128(in, (uint16_t*)out, pdm_mic.filter_volume, left);
+        } else {
+            Open_PDM_Filter_64(in, (uint16_t*)out, pdm_mic.filter_volume, left);
+        }
 
-        in += filter_stride * (PDM_DECIMATION / 8);
+        in += filter_stride * (pdm_mic.decimation / 8);
         out += filter_stride;
     }
+    uint32_t dt = time_us_32() - t0;
+    pdm_mic.filter_us_last = dt;
+    if (dt > pdm_mic.filter_us_max) pdm_mic.filter_us_max = dt;
+
+    // The DMA may have wrapped onto this buffer while it was being filtered
+    if (pdm_mic.buffers_captured - read >= pdm_mic.raw_buffer_count) {
+        pdm_mic.overruns++;
+    }
 
     return samples;
 }
+
+const int16_t* pdm_microphone_lend(size_t* samples) {
+    *samples = 0;
+    if (pdm_mic.pcm_pool == NULL) {
+        return NULL;
+    }
+
+    uint block = 0;
+    while (block < pdm_mic.pcm_block_count && pdm_mic.pcm_lent[block]) block++;
+    if (block == pdm_mic.pcm_block_count) {
+        pdm_mic.pool_overruns++;
+        return NULL;
+    }
+
+    int16_t* pcm = pdm_mic.pcm_pool + block * pdm_mic.pcm_block_samples;
+    int n = pdm_microphone_read(pcm, pdm_mic.pcm_block_samples);
+    if (n <= 0) {
+        return NULL;
+    }
+    pdm_mic.pcm_lent[block] = true;
+    *samples = (size_t)n;
+    return pcm;
+}
+
+void pdm_microphone_return(const int16_t* block) {
+    if (block == NULL || pdm_mic.pcm_pool == NULL) {
+        return;
+    }
+    uint i = (uint)((block - pdm_mic.pcm_pool) / pdm_mic.pcm_block_samples);
+    if (i < pdm_mic.pcm_block_count) {
+        // The caller's reads of the block must be done before it is reused
+        __compiler_memory_barrier();
+        pdm_mic.pcm_lent[i] = false;
+    }
+}
+
+uint32_t pdm_microphone_raw_window(uint32_t* oldest) {
+    uint32_t end = pdm_mic.buffers_captured;
+    *oldest = pdm_microphone_oldest();
+    return end;
+}
+
+const uint8_t* pdm_microphone_raw_buffer(uint32_t seq) {
+    uint32_t oldest = pdm_microphone_oldest();
+    if (seq - oldest >= pdm_mic.buffers_captured - oldest) {
+        return NULL;
+    }
+    return pdm_mic.raw_buffer[seq & (pdm_mic.raw_buffer_count - 1)];
+}
+
+uint pdm_microphone_raw_buffer_size() {
+    return pdm_mic.raw_buffer_size;
+}
+
+void pdm_microphone_discard(uint32_t seq) {
+    uint32_t oldest = pdm_microphone_oldest();
+    if (seq - oldest <= pdm_mic.buffers_captured - oldest) {
+        pdm_mic.buffers_read = seq;
+    }
+}
+
+uint pdm_microphone_available() {
+    uint32_t pending = pdm_mic.buffers_captured - pdm_mic.buffers_read;
+    return pending < pdm_mic.raw_buffer_count ? pending : pdm_mic.raw_buffer_count - 1;
+}
+
+void pdm_microphone_get_stats(struct pdm_microphone_stats* stats) {
+    stats->buffers_captured = pdm_mic.buffers_captured;
+    stats->buffers_read     = pdm_mic.buffers_read;
+    stats->overruns         = pdm_mic.overruns;
+    stats->underruns        = pdm_mic.underruns;
+    stats->late_irqs        = pdm_mic.late_irqs;
+    stats->pool_overruns    = pdm_mic.pool_overruns;
+    stats->pcm_blocks_lent  = 0;
+    for (uint i = 0; i < pdm_mic.pcm_block_count; i++) {
+        stats->pcm_blocks_lent += pdm_mic.pcm_lent[i];
+    }
+    stats->raw_buffer_count = pdm_mic.raw_buffer_count;
+    stats->sample_rate      = pdm_mic.config.sample_rate;
+    stats->decimation       = pdm_mic.decimation;
+    stats->channels         = pdm_mic.channels;
+    stats->buffer_us        = pdm_mic.buffer_us;
+    stats->filter_us_last   = pdm_mic.filter_us_last;
+    stats->filter_us_max    = pdm_mic.filter_us_max;
+    // Share of one core spent filtering: filter time per buffer / buffer time
+    stats->cpu_load_permille = pdm_mic.buffer_us ?
+        (uint32_t)((uint64_t)pdm_mic.filter_us_last * 1000u / pdm_mic.buffer_us) : 0;
+}
+
+void pdm_microphone_reset_stats() {
+    pdm_mic.overruns  = 0;
+    pdm_mic.underruns = 0;
+    pdm_mic.late_irqs = 0;
+    pdm_mic.pool_overruns = 0;
+    pdm_mic.filter_us_max = 0;
+}
@@ -30,11 +30,17 @@ SOFTWARE.
 //#include "tusb.h" //is it needed?
 #include "hardware/irq.h"
 #include "hardware/pwm.h"
+#include "hardware/clocks.h"
 #include <tkjhat/ssd1306.h>
 #include <tkjhat/pdm_microphone.h>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 
+#include "flash_store.h"
+#include <FreeRTOS.h>
+#include <task.h>
+
 
 
 
@@ -194,10 +200,6 @@ void stop_rgb_led(){
     r = 255-r;
     g = 255-g;
     b = 255-b;
-    // Get the PWM slice numbers for each GPIO pin
-    uint slice_num_r = pwm_gpio_to_slice_num(RGB_LED_R);
-    uint slice_num_g = pwm_gpio_to_slice_num(RGB_LED_G);
-    uint slice_num_b = pwm_gpio_to_slice_num(RGB_LED_B);
 
     // Convert the 0-255 value to a 16-bit duty cycle (0-65535)
     uint16_t r_value = r * r; // Mapping 0-255 to 0-65535 (linearly)
@@ -234,6 +236,33 @@ void stop_rgb_led(){
     }
 }
 
+ int buzzer_tone_start(uint32_t frequency) {
+    if (frequency < BUZZER_TONE_MIN_HZ || frequency > BUZZER_TONE_MAX_HZ) return -1;
+
+    // Smallest divider (in 1/16) that fits one period in the 16-bit counter
+    const uint32_t clk = clock_get_hz(clk_sys);
+    uint32_t div16 = (uint32_t)(((uint64_t)clk * 16 + (uint64_t)frequency * 65536 - 1) /
+                                ((uint64_t)frequency * 65536));
+    if (div16 < 16) div16 = 16;
+    if (div16 > 255 * 16 + 15) return -1;
+    const uint32_t top = (uint32_t)(((uint64_t)clk * 16 / div16 + frequency / 2) / frequency) - 1;
+
+    const uint slice = pwm_gpio_to_slice_num(BUZZER_PIN);
+    pwm_set_clkdiv(slice, (float)div16 / 16.0f);
+    pwm_set_wrap(slice, (uint16_t)top);
+    pwm_set_gpio_level(BUZZER_PIN, (uint16_t)((top + 1) / 2));    // square wave
+    pwm_set_enabled(slice, true);
+    gpio_set_function(BUZZER_PIN, GPIO_FUNC_PWM);
+    return 0;
+}
+
+ void buzzer_tone_stop() {
+    // Back to the plain output set up by init_buzzer(), low
+    gpio_put(BUZZER_PIN, 0);
+    gpio_set_function(BUZZER_PIN, GPIO_FUNC_SIO);
+    pwm_set_enabled(pwm_gpio_to_slice_num(BUZZER_PIN), false);
+}
+
  void buzzer_turn_off() {
     // Turn off the buzzer by setting the pin to low
     gpio_put(BUZZER_PIN, 0);
@@ -278,9 +307,20 @@ bool i2c_read(uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
 // Uses https://github.com/ArmDeveloperEcosystem/microphone-library-for-pico/tree/main
 // Uses pio to read pdm data and OpenPDM2PCM library to transform PDM to PCM
 // Microphone related functions
-// Sample rate: 16Khz
-// Buffer size: 256 samples.
- int init_pdm_microphone() {
+// Default: 8 kHz, 64x decimation, buffer of MEMS_BUFFER_SIZE samples.
+int init_pdm_microphone() {
+    return init_pdm_microphone_ex(MEMS_SAMPLING_FREQUENCY, 64);
+}
+
+static int init_pdm(uint32_t sample_rate, uint8_t decimation, uint channels) {
+    if (sample_rate != 8000 && sample_rate != 16000 &&
+        sample_rate != 32000 && sample_rate != 48000) {
+        return -1;
+    }
+
+    // The filter works in 1 ms blocks: round the buffer down to whole blocks
+    uint stride = sample_rate / 1000;
+
     const struct pdm_microphone_config config = {
     // GPIO pin for the PDM DAT signal
     .gpio_data = PDM_DATA,
@@ -295,14 +335,27 @@ bool i2c_read(uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
     .pio_sm = 0,
 
     // sample rate in Hz
-    .sample_rate = MEMS_SAMPLING_FREQUENCY,
+    .sample_rate = sample_rate,
 
     // number of samples to buffer
-    .sample_buffer_size = MEMS_BUFFER_SIZE,
+    .sample_buffer_size = (MEMS_BUFFER_SIZE / stride) * stride,
+
+    // PDM clock = sample_rate * decimation
+    .decimation = decimation,
+
+    // 2: a second microphone on the same data line, other clock edge
+    .channels = channels,
     };
 
     return pdm_microphone_init(&config);
-   
+}
+
+int init_pdm_microphone_ex(uint32_t sample_rate, uint8_t decimation) {
+    return init_pdm(sample_rate, decimation, 1);
+}
+
+int init_pdm_microphone_stereo(uint32_t sample_rate, uint8_t decimation) {
+    return init_pdm(sample_rate, decimation, 2);
 }
 
  int init_microphone_sampling(){
@@ -321,6 +374,14 @@ int get_microphone_samples(int16_t* buffer, size_t samples) {
     return pdm_microphone_read(buffer,samples);
 }
 
+const int16_t* lend_microphone_samples(size_t* samples) {
+    return pdm_microphone_lend(samples);
+}
+
+void return_microphone_samples(const int16_t* block) {
+    pdm_microphone_return(block);
+}
+
 
 /* =========================
  *  DISPLAY SSD1306
@@ -509,90 +570,380 @@ void stop_display() {
 // Useful info at: https://learn.sparkfun.com/tutorials/qwiic-ambient-light-sensor-veml6030-hookup-guide/all#arduino-library
 // Programming application: https://www.vishay.com/docs/84367/designingveml6030.pdf
 // Datasheet: https://www.vishay.com/docs/84366/veml6030.pdf
+// Config register (0x00) fields
+#define VEML_CFG_GAIN_SHIFT     11
+#define VEML_CFG_IT_SHIFT       6
+#define VEML_CFG_SD             0x0001  // shut down
+#define VEML_CFG_INT_EN         0x0002
+#define VEML_CFG_PERS_SHIFT     4
+#define VEML_PSM_EN             0x0001
+#define VEML_ALS_INT_HIGH       0x4000  // ALS_INT (0x06), cleared on read
+#define VEML_ALS_INT_LOW        0x8000
+
+// ALS resolution is 0.0036 lx/count at gain x2 and 800 ms; it doubles for
+// every halving of gain or integration time. Stored in 1e-4 lx units.
+#define VEML_RES_BASE_1E4       36
+
+// Auto-range: Vishay app note recommends keeping counts in 100..10000
+#define VEML_COUNTS_LOW         100
+#define VEML_COUNTS_HIGH        10000
+#define VEML_CORRECTION_LUX     1000
+
+// Auto-range ladder, least sensitive first. Gain is raised before the
+// integration time so reads stay fast until the light is really low.
+static const struct {
+    uint8_t gain;       // veml6030_gain_t
+    uint8_t it_bits;
+    uint16_t it_ms;
+} veml_ladder[] = {
+    { VEML6030_GAIN_1_8, 0x0C,  25 },
+    { VEML6030_GAIN_1_8, 0x08,  50 },
+    { VEML6030_GAIN_1_8, 0x00, 100 },
+    { VEML6030_GAIN_1_4, 0x00, 100 },
+    { VEML6030_GAIN_1,   0x00, 100 },
+    { VEML6030_GAIN_2,   0x00, 100 },
+    { VEML6030_GAIN_2,   0x01, 200 },
+    { VEML6030_GAIN_2,   0x02, 400 },
+    { VEML6030_GAIN_2,   0x03, 800 },
+};
+#define VEML_LADDER_DEFAULT     2       // gain 1/8, 100 ms (as before)
+#define VEML_LADDER_COUNT       (sizeof(veml_ladder) / sizeof(veml_ladder[0]))
+
+static struct {
+    uint16_t cfg;               // shadow of the config register
+    veml6030_gain_t gain;
+    uint16_t it_ms;
+    uint8_t step;               // position in veml_ladder
+    bool auto_range;
+    uint32_t changed_us;        // when gain/IT last changed
+    uint32_t settle_us;         // time until a result with the new range exists
+    veml6030_reading_t last;
+} veml = { .gain = VEML6030_GAIN_1_8, .it_ms = 100, .step = VEML_LADDER_DEFAULT,
+           .auto_range = true };
+
+static int veml6030_write_register(uint8_t reg, uint16_t value) {
+    // Registers are 16-bit, LSB first
+    uint8_t buf[3] = { reg, (uint8_t)(value & 0xFF), (uint8_t)(value >> 8) };
+    int rc = i2c_write_blocking(i2c_default, VEML6030_I2C_ADDR, buf, sizeof(buf), false);
+    return rc == (int)sizeof(buf) ? 0 : -1;
+}
+
+static int _veml6030_read_register(uint8_t reg, uint16_t *value) {
+    uint8_t data[2] = {0,0};
+
+    // Select the register, then read two bytes (LSB first)
+    if (i2c_write_blocking(i2c_default, VEML6030_I2C_ADDR, &reg, 1, true) != 1) return -1;
+    if (i2c_read_blocking(i2c_default, VEML6030_I2C_ADDR, data, sizeof(data), false) != 2) return -1;
+    *value = ((uint16_t)data[0]) | ((uint16_t)data[1] << 8);
+    return 0;
+}
+
+static uint8_t veml_it_bits(uint16_t it_ms) {
+    switch (it_ms) {
+        case 25:  return 0x0C;
+        case 50:  return 0x08;
+        case 100: return 0x00;
+        case 200: return 0x01;
+        case 400: return 0x02;
+        case 800: return 0x03;
+        default:  return 0xFF;
+    }
+}
+
+// Resolution in 1e-4 lx per count: 36 * (800 / IT) * (2 / gain)
+static uint32_t veml_resolution_1e4(veml6030_gain_t gain, uint16_t it_ms) {
+    static const uint8_t gain_shift[4] = { 1, 0, 4, 3 }; // x1, x2, x1/8, x1/4
+    uint8_t it_shift = 0;
+    for (uint16_t it = it_ms; it < 800; it <<= 1) it_shift++;
+    return (uint32_t)VEML_RES_BASE_1E4 << (gain_shift[gain & 3] + it_shift);
+}
+
+static int veml_apply_range(veml6030_gain_t gain, uint16_t it_ms) {
+    uint8_t it_bits = veml_it_bits(it_ms);
+    if (it_bits == 0xFF || (unsigned)gain > VEML6030_GAIN_1_4) return -1;
+
+    uint16_t cfg = veml.cfg & ~((0x3u << VEML_CFG_GAIN_SHIFT) | (0xFu << VEML_CFG_IT_SHIFT));
+    cfg |= ((uint16_t)gain << VEML_CFG_GAIN_SHIFT) | ((uint16_t)it_bits << VEML_CFG_IT_SHIFT);
+    if (veml6030_write_register(VEML6030_CONFIG_REG, cfg) != 0) return -2;
+
+    // A measurement started with the old settings may still complete first
+    veml.settle_us = ((uint32_t)veml.it_ms + it_ms) * 1000u;
+    veml.changed_us = time_us_32();
+    veml.cfg = cfg;
+    veml.gain = gain;
+    veml.it_ms = it_ms;
+    return 0;
+}
+
+// Vishay non-linearity correction for > 1000 lx:
+//   y = 6.0135e-13 x^4 - 9.3924e-9 x^3 + 8.1488e-5 x^2 + 1.0023 x
+// evaluated in Horner form with 64-bit fixed point. x is lux in Q8. The
+// coefficients shrink by ~1e4 per power, so the accumulator moves from Q60
+// to Q40 to Q20 as it grows; every product stays below 2^63 up to the
+// 120 klx full scale. The result saturates at UINT32_MAX millilux.
+#define VEML_C4_Q60     693309LL            // 6.0135e-13 * 2^60
+#define VEML_C3_Q60     (-10828699940LL)    // -9.3924e-9 * 2^60
+#define VEML_C2_Q40     89597004LL          // 8.1488e-5 * 2^40
+#define VEML_C1_Q20     1050988LL           // 1.0023 * 2^20
+
+static uint32_t veml_correct_mlx(int64_t x_q8) {
+    int64_t t = ((VEML_C4_Q60 * x_q8) >> 8) + VEML_C3_Q60;  // Q60
+    t = (t * x_q8) >> 8;                                     // Q60
+    t = (t >> 20) + VEML_C2_Q40;                             // Q40
+    t = (t * x_q8) >> 8;                                     // Q40
+    t = (t >> 20) + VEML_C1_Q20;                             // Q20
+    t = (t * x_q8) >> 8;                                     // Q20 lux
+    if (t <= 0) return 0;
+    uint64_t mlx = ((uint64_t)t * 1000u) >> 20;
+    return mlx > UINT32_MAX ? UINT32_MAX : (uint32_t)mlx;
+}
+
 void init_veml6030() {
-    // Configure sensor settings (100ms integration time, gain 1/8, power on)
-    //Bit 12:11 = 10 (gain1/8)
-    //Bit 9:6 = 0000 (Integration time 100ms)
-    //Bit 5:4 Persisentec protect number setting (00 -> 1) 
-    //Bit 1 =0 INT disable
-    //Bit 0 = 0 Power on
-    // 0b0001 0000 0000 0000 -> =0x1000
-
-    uint8_t config[3] = {
-        VEML6030_CONFIG_REG,  // Configuration register
-        0x00,                 // High byte: Gain 1/8 (00), reserved bits
-        0x10                  // Low byte: 100ms integration time (010 in bits 6-8), power on (bit 0 = 0)
-    };
-    
-    // Write configuration to sensor
-    i2c_write_blocking(i2c_default, VEML6030_I2C_ADDR, config, sizeof(config), false);
+    // Gain 1/8, 100 ms integration time, persistence 1, interrupt off, power on
+    veml.cfg = 0;
+    veml.it_ms = 100;
+    veml.step = VEML_LADDER_DEFAULT;
+    veml.auto_range = true;
+    memset(&veml.last, 0, sizeof(veml.last));
+    veml_apply_range(VEML6030_GAIN_1_8, 100);
     sleep_ms(10);
 }
 
-// Read light level from VEML6030
-// Ligt in LUX
-// Note: sampling time should be > IT -> in this case it has been 100ms by defintion. 
-uint32_t veml6030_read_light() {
+int veml6030_set_range(veml6030_gain_t gain, uint16_t it_ms) {
+    int rc = veml_apply_range(gain, it_ms);
+    if (rc == 0) veml.auto_range = false;
+    return rc;
+}
 
-    // Exercise 2: In order to get the luminance we need to read the value of the VEML6030_ALS_REG (see VEML6030 datasheet)
-    //            Use functions i2c_write_blocking and i2_read_blocking to collect luminance data.
-    //            These functions are found in the Pico SDK:
-    //            https://www.raspberrypi.com/documentation/pico-sdk/hardware.html#group_hardware_i2c
-    //            The i2c that you must use is i2c_default.  
-    //            from the sensor. Make necessary bitwise operation to store the results in a register of 16 bits.
-    //            Multiply the value by the adequate value considering Integration Time of 100 ms and Gain of 1/8
-    //            using data of page 5 of VEML6030 design application document: https://www.vishay.com/docs/84367/designingveml6030.pdf
-    //            Finally, store the value in the variable luxVal_uncorrected.
-    //
-    // Tehtävä 2: Saadaksemme luminanssin meidän tulee lukea VEML6030_ALS_REG -rekisterin arvo (katso VEML6030-datalehti).
-    //            Käytä funktioita i2c_write_blocking ja i2_read_blocking luminanssidatan keräämiseen.
-    //            Nämä funktiot löytyvät Pico SDK:sta:
-    //            https://www.raspberrypi.com/documentation/pico-sdk/hardware.html#group_hardware_i2c
-    //            Käytettävä i2c-väylä on i2c_default.
-    //            Tee tarvittavat bittikohtaiset operaatiot tallettaksesi tuloksen 16-bittiseen rekisteriin.
-    //            Kerro arvo sopivalla kertoimella huomioiden 100 ms integraatioaika ja vahvistus 1/8
-    //            käyttäen VEML6030-sovellussuunnitteluasiakirjan sivun 5 tietoja:https://www.vishay.com/docs/84367/designingveml6030.pdf
-    //            Lopuksi tallenna arvo muuttujaan luxVal_uncorrected.
-  
-    uint32_t luxVal_uncorrected = 0; 
-    if (luxVal_uncorrected>1000){
-        // Polynomial is pulled from pg 10 of the datasheet. 
-        // See https://github.com/sparkfun/SparkFun_Ambient_Light_Sensor_Arduino_Library/blob/efde0817bd6857863067bd1653a2cfafe6c68732/src/SparkFun_VEML6030_Ambient_Light_Sensor.cpp#L409
-        uint32_t luxVal = (.00000000000060135 * (pow(luxVal_uncorrected, 4))) - 
-                            (.0000000093924 * (pow(luxVal_uncorrected, 3))) + 
-                            (.000081488 * (pow(luxVal_uncorrected,2))) + 
-                            (1.0023 * luxVal_uncorrected);
-        return luxVal;
-    }
-    return  luxVal_uncorrected;
-}
-
-
-
-//This method might be utility method in the future.
-static uint16_t _veml6030_read_register(uint8_t reg) {
-    uint8_t data[2] = {0,0};
+void veml6030_set_auto_range(bool enable) {
+    if (enable && !veml.auto_range) {
+        // Continue from the ladder step closest to the current resolution
+        uint32_t res = veml_resolution_1e4(veml.gain, veml.it_ms);
+        uint8_t step = 0;
+        while (step + 1u < VEML_LADDER_COUNT &&
+               veml_resolution_1e4(veml_ladder[step].gain, veml_ladder[step].it_ms) > res) {
+            step++;
+        }
+        veml.step = step;
+    }
+    veml.auto_range = enable;
+}
+
+int veml6030_read(veml6030_reading_t *out, bool with_white) {
+    // Until a full integration with the new range has finished, the data
+    // register still holds the old result: report the cached reading.
+    if (time_us_32() - veml.changed_us < veml.settle_us) {
+        *out = veml.last;
+        out->fresh = false;
+        return 0;
+    }
+
+    veml6030_reading_t r = {0};
+    if (_veml6030_read_register(VEML6030_ALS_REG, &r.als) != 0) return -1;
+    if (with_white && _veml6030_read_register(VEML6030_WHITE_REG, &r.white) != 0) return -1;
+
+    r.gain = veml.gain;
+    r.it_ms = veml.it_ms;
+    r.resolution_1e4 = veml_resolution_1e4(veml.gain, veml.it_ms);
+    r.fresh = true;
 
-    // Select ALS output register
-    i2c_write_blocking(i2c_default, VEML6030_I2C_ADDR, &reg, 1, true);
-    // Read two bytes (MSB first)
-    i2c_read_blocking(i2c_default, VEML6030_I2C_ADDR, data, sizeof(data), false);
-    //data [0] contains the LSB and data[1] the MSB
-    return ((uint16_t)data[0]) |((uint16_t) data[1]<<8);
+    // raw * res fits in 32 bits: 65535 * 18432 < 2^31
+    uint32_t lin_1e4 = (uint32_t)r.als * r.resolution_1e4;
+    if (lin_1e4 > VEML_CORRECTION_LUX * 10000u) {
+        r.lux_mlx = veml_correct_mlx(((int64_t)lin_1e4 << 8) / 10000);
+    } else {
+        r.lux_mlx = (lin_1e4 + 5) / 10;
+    }
+    veml.last = r;
+    *out = r;
+
+    // One ladder step per read at most; the new range takes effect for the
+    // next result, so this never blocks.
+    if (veml.auto_range) {
+        if (r.als > VEML_COUNTS_HIGH && veml.step > 0) {
+            veml.step--;
+        } else if (r.als < VEML_COUNTS_LOW && veml.step + 1u < VEML_LADDER_COUNT) {
+            veml.step++;
+        } else {
+            return 0;
+        }
+        if (veml_apply_range((veml6030_gain_t)veml_ladder[veml.step].gain,
+                             veml_ladder[veml.step].it_ms) != 0) {
+            return -2;
+        }
+    }
+    return 0;
+}
+
+// Read light level from VEML6030
+// Light in lux
+// Note: sampling time should be > IT (100 ms by default; the auto-range
+// changes it between 25 and 800 ms).
+uint32_t veml6030_read_light() {
+    veml6030_reading_t r;
+    if (veml6030_read(&r, false) != 0) return 0;
+    return (r.lux_mlx + 500) / 1000;
 }
 
 void veml6030_stop(){
-    uint8_t config[3] = {
-        VEML6030_CONFIG_REG,  // Configuration register
-        0x00,                 // High byte: Gain 1/8 (00), reserved bits
-        0x11                  // Low byte: 100ms integration time (010 in bits 6-8), power on (bit 0 = 0). Power off (last bit to 1)
-    };
-    
-    // Write configuration to sensor
-    i2c_write_blocking(i2c_default, VEML6030_I2C_ADDR, config, sizeof(config), false);
+    // Power off (SD bit), keeping the rest of the configuration
+    veml.cfg |= VEML_CFG_SD;
+    veml6030_write_register(VEML6030_CONFIG_REG, veml.cfg);
     sleep_ms(10);
 }
 
+/* ---------- Threshold interrupt ---------- */
+
+static struct {
+    TaskHandle_t task;
+    bool irq_attached;
+    bool enabled;
+    uint8_t track_pct;
+    uint16_t psm_wait_ms;       // refresh time added by power-saving mode
+    uint32_t start_us;
+    volatile uint32_t wakeups;  // interrupts seen
+    uint32_t events_high;
+    uint32_t events_low;
+} veml_irq;
+
+// INT is open-drain, active low, and stays low until ALS_INT is read
+static void veml_irq_handler(void) {
+    if (gpio_get_irq_event_mask(VEML6030_INTERRUPT) & GPIO_IRQ_EDGE_FALL) {
+        gpio_acknowledge_irq(VEML6030_INTERRUPT, GPIO_IRQ_EDGE_FALL);
+        veml_irq.wakeups++;
+        BaseType_t woken = pdFALSE;
+        if (veml_irq.task != NULL) {
+            vTaskNotifyGiveFromISR(veml_irq.task, &woken);
+        }
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+static uint16_t veml_mlx_to_counts(uint32_t mlx) {
+    // counts = lux / res, res in 1e-4 lx -> counts = mlx * 10 / res
+    uint64_t c = ((uint64_t)mlx * 10u + veml_resolution_1e4(veml.gain, veml.it_ms) / 2) /
+                 veml_resolution_1e4(veml.gain, veml.it_ms);
+    return c > 0xFFFF ? 0xFFFF : (uint16_t)c;
+}
+
+static int veml_write_window(uint16_t low, uint16_t high) {
+    if (veml6030_write_register(VEML6030_ALS_WL_REG, low) != 0) return -2;
+    if (veml6030_write_register(VEML6030_ALS_WH_REG, high) != 0) return -2;
+    return 0;
+}
+
+// Centre a +-pct window on the current reading
+static int veml_track_window(uint16_t counts, uint8_t pct) {
+    uint32_t d = ((uint32_t)counts * pct + 99) / 100;
+    if (d == 0) d = 1;
+    uint32_t low = counts > d ? counts - d : 0;
+    uint32_t high = counts + d > 0xFFFF ? 0xFFFF : counts + d;
+    return veml_write_window((uint16_t)low, (uint16_t)high);
+}
+
+int veml6030_enable_threshold_interrupt(const veml6030_threshold_config_t *cfg) {
+    if (cfg == NULL || (unsigned)cfg->persistence > VEML6030_PERS_8) return -1;
+    if (cfg->track_pct == 0 && cfg->low_mlx >= cfg->high_mlx) return -1;
+
+    // Thresholds are compared with raw counts, so the range must stay fixed
+    veml.auto_range = false;
+
+    int rc;
+    if (cfg->track_pct > 0) {
+        uint16_t als;
+        if (_veml6030_read_register(VEML6030_ALS_REG, &als) != 0) return -2;
+        rc = veml_track_window(als, cfg->track_pct);
+    } else {
+        rc = veml_write_window(veml_mlx_to_counts(cfg->low_mlx), veml_mlx_to_counts(cfg->high_mlx));
+    }
+    if (rc != 0) return rc;
+
+    uint16_t conf = veml.cfg & ~(0x3u << VEML_CFG_PERS_SHIFT);
+    conf |= ((uint16_t)cfg->persistence << VEML_CFG_PERS_SHIFT) | VEML_CFG_INT_EN;
+    if (veml6030_write_register(VEML6030_CONFIG_REG, conf) != 0) return -2;
+    veml.cfg = conf;
+
+    uint16_t dummy;
+    _veml6030_read_register(VEML6030_ALS_INT_REG, &dummy); // clear stale flags
+
+    if (!veml_irq.irq_attached) {
+        gpio_init(VEML6030_INTERRUPT);
+        gpio_set_dir(VEML6030_INTERRUPT, GPIO_IN);
+        gpio_pull_up(VEML6030_INTERRUPT);
+        gpio_add_raw_irq_handler(VEML6030_INTERRUPT, veml_irq_handler);
+        gpio_set_irq_enabled(VEML6030_INTERRUPT, GPIO_IRQ_EDGE_FALL, true);
+        irq_set_enabled(IO_IRQ_BANK0, true);
+        veml_irq.irq_attached = true;
+    }
+    veml_irq.track_pct = cfg->track_pct;
+    veml_irq.start_us = time_us_32();
+    veml_irq.wakeups = 0;
+    veml_irq.events_high = 0;
+    veml_irq.events_low = 0;
+    veml_irq.enabled = true;
+    return 0;
+}
+
+int veml6030_disable_threshold_interrupt(void) {
+    veml_irq.enabled = false;
+    if (veml_irq.irq_attached) {
+        gpio_set_irq_enabled(VEML6030_INTERRUPT, GPIO_IRQ_EDGE_FALL, false);
+        gpio_remove_raw_irq_handler(VEML6030_INTERRUPT, veml_irq_handler);
+        veml_irq.irq_attached = false;
+    }
+    veml_irq.task = NULL;
+    veml.cfg &= ~VEML_CFG_INT_EN;
+    return veml6030_write_register(VEML6030_CONFIG_REG, veml.cfg) == 0 ? 0 : -2;
+}
+
+int veml6030_set_power_saving(uint8_t mode) {
+    static const uint16_t wait_ms[4] = { 500, 1000, 2000, 4000 };
+    if (mode > 4) return -1;
+    uint16_t psm = mode ? (uint16_t)(((mode - 1) << 1) | VEML_PSM_EN) : 0;
+    if (veml6030_write_register(VEML6030_PSM_REG, psm) != 0) return -2;
+    veml_irq.psm_wait_ms = mode ? wait_ms[mode - 1] : 0;
+    return 0;
+}
+
+int veml6030_wait_event(uint32_t timeout_ms) {
+    if (!veml_irq.enabled) return -1;
+    veml_irq.task = xTaskGetCurrentTaskHandle();
+
+    uint16_t status;
+    const TickType_t start = xTaskGetTickCount();
+    const TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+    for (;;) {
+        // Reading ALS_INT clears the flags and releases the INT pin
+        if (_veml6030_read_register(VEML6030_ALS_INT_REG, &status) != 0) return -2;
+        int ev = 0;
+        if (status & VEML_ALS_INT_HIGH) { ev |= VEML6030_EVT_HIGH; veml_irq.events_high++; }
+        if (status & VEML_ALS_INT_LOW)  { ev |= VEML6030_EVT_LOW;  veml_irq.events_low++; }
+        if (ev) {
+            if (veml_irq.track_pct > 0) {
+                uint16_t als;
+                if (_veml6030_read_register(VEML6030_ALS_REG, &als) != 0 ||
+                    veml_track_window(als, veml_irq.track_pct) != 0) {
+                    return -2;
+                }
+            }
+            return ev;
+        }
+
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) return 0;
+        if (ulTaskNotifyTake(pdTRUE, timeout - elapsed) == 0) return 0;
+    }
+}
+
+void veml6030_get_event_stats(veml6030_event_stats_t *out) {
+    out->wakeups = veml_irq.wakeups;
+    out->events_high = veml_irq.events_high;
+    out->events_low = veml_irq.events_low;
+    out->elapsed_ms = (time_us_32() - veml_irq.start_us) / 1000u;
+    // A poller needs one read per measurement to see the same changes
+    out->poll_equivalent = out->elapsed_ms / (veml.it_ms + veml_irq.psm_wait_ms);
+}
+
 
 
 
@@ -723,7 +1074,138 @@ void stop_hdc2021() {
     //turn heater & DRDY pin off to minimize current
     cfg &= ~(uint8_t)(1<<3); // HEAT_EN=0
     cfg &= ~(uint8_t)(1<<2); // DRDY/INT_EN=0 (pin Hi-Z)
+    write_register(HDC2021_CONFIG, cfg);
+    write_register(HDC2021_INT_ENABLE, 0);
+}
+
+/* ---------- Interrupt-driven acquisition ---------- */
+
+// DEVICE_CONFIG (0x0E) fields
+#define HDC_CFG_AMM_SHIFT       4
+#define HDC_CFG_AMM_MASK        0x70
+#define HDC_CFG_INT_EN          0x04    // DRDY/INT pin enabled
+#define HDC_CFG_INT_POL         0x02    // 1 = active high
+#define HDC_CFG_INT_MODE        0x01    // 1 = comparator, 0 = clear on status read
+// MEASUREMENT_CONFIG (0x0F) fields
+#define HDC_MEAS_TRES_SHIFT     6
+#define HDC_MEAS_HRES_SHIFT     4
+
+static TaskHandle_t hdc_task = NULL;
+static bool hdc_irq_attached = false;
+static bool hdc_primed = false;         // pending status read after enabling
+
+// The pin is active low and stays asserted until the status is read
+static void hdc_irq_handler(void) {
+    if (gpio_get_irq_event_mask(HDC2021_INTERRUPT) & GPIO_IRQ_EDGE_FALL) {
+        gpio_acknowledge_irq(HDC2021_INTERRUPT, GPIO_IRQ_EDGE_FALL);
+        BaseType_t woken = pdFALSE;
+        if (hdc_task != NULL) {
+            vTaskNotifyGiveFromISR(hdc_task, &woken);
+        }
+        portYIELD_FROM_ISR(woken);
+    }
+}
 
+int hdc2021_configure(hdc2021_rate_t rate, hdc2021_resolution_t temp_res,
+                      hdc2021_resolution_t hum_res) {
+    if (rate < HDC2021_RATE_0_2HZ || rate > HDC2021_RATE_5HZ ||
+        temp_res > HDC2021_RES_9BIT || hum_res > HDC2021_RES_9BIT) {
+        return -1;
+    }
+    uint8_t cfg = read_hdc2021_register(HDC2021_CONFIG);
+    uint8_t meas = read_hdc2021_register(HDC2021_MEASUREMENT_CONFIG);
+
+    // Stop auto mode while changing the resolution, then restart it. The
+    // intermediate write drops MEAS_TRIG, which would start a one-shot.
+    write_register(HDC2021_CONFIG, cfg & ~HDC_CFG_AMM_MASK);
+    meas = (meas & 0x0E) | (uint8_t)(temp_res << HDC_MEAS_TRES_SHIFT) |
+           (uint8_t)(hum_res << HDC_MEAS_HRES_SHIFT);
+    write_register(HDC2021_MEASUREMENT_CONFIG, meas);
+    cfg = (cfg & ~HDC_CFG_AMM_MASK) | (uint8_t)(rate << HDC_CFG_AMM_SHIFT);
+    write_register(HDC2021_CONFIG, cfg);
+    write_register(HDC2021_MEASUREMENT_CONFIG, meas | 0x01); // MEAS_TRIG
+    return 0;
+}
+
+int hdc2021_enable_interrupts(uint8_t events) {
+    if (events == 0 || (events & 0x07)) return -1;
+
+    write_register(HDC2021_INT_ENABLE, events);
+    uint8_t cfg = read_hdc2021_register(HDC2021_CONFIG);
+    cfg = (cfg | HDC_CFG_INT_EN) & ~(HDC_CFG_INT_POL | HDC_CFG_INT_MODE);
+    write_register(HDC2021_CONFIG, cfg);
+    read_hdc2021_register(HDC2021_INT_STATUS); // release the pin
+    hdc_primed = false;
+
+    if (!hdc_irq_attached) {
+        gpio_init(HDC2021_INTERRUPT);
+        gpio_set_dir(HDC2021_INTERRUPT, GPIO_IN);
+        gpio_pull_up(HDC2021_INTERRUPT);
+        gpio_add_raw_irq_handler(HDC2021_INTERRUPT, hdc_irq_handler);
+        gpio_set_irq_enabled(HDC2021_INTERRUPT, GPIO_IRQ_EDGE_FALL, true);
+        irq_set_enabled(IO_IRQ_BANK0, true);
+        hdc_irq_attached = true;
+    }
+    return 0;
+}
+
+void hdc2021_disable_interrupts(void) {
+    write_register(HDC2021_INT_ENABLE, 0);
+    uint8_t cfg = read_hdc2021_register(HDC2021_CONFIG);
+    write_register(HDC2021_CONFIG, cfg & ~HDC_CFG_INT_EN);
+    if (hdc_irq_attached) {
+        gpio_set_irq_enabled(HDC2021_INTERRUPT, GPIO_IRQ_EDGE_FALL, false);
+        gpio_remove_raw_irq_handler(HDC2021_INTERRUPT, hdc_irq_handler);
+        hdc_irq_attached = false;
+    }
+    hdc_task = NULL;
+}
+
+// Data (0x00-0x03) and status (0x04) in one burst; reading the status
+// clears it and releases the interrupt pin.
+static int hdc_read_burst(hdc2021_sample_t *out) {
+    uint8_t reg = HDC2021_TEMP_LOW;
+    uint8_t buf[5];
+    if (!i2c_write(HDC2021_I2C_ADDRESS, &reg, 1, true) ||
+        !i2c_read(HDC2021_I2C_ADDRESS, buf, sizeof(buf), false)) {
+        return -2;
+    }
+    out->raw_temperature = (uint16_t)(buf[0] | (buf[1] << 8));
+    out->raw_humidity = (uint16_t)(buf[2] | (buf[3] << 8));
+    out->temperature = out->raw_temperature * 165.0f / 65536.0f - 40.0f;
+    out->humidity = out->raw_humidity * 100.0f / 65536.0f;
+    out->events = buf[4] & HDC2021_EVT_ALL;
+    out->timestamp_us = time_us_32();
+    return 0;
+}
+
+int hdc2021_read_sample(hdc2021_sample_t *out) {
+    return hdc_read_burst(out);
+}
+
+int hdc2021_wait_sample(hdc2021_sample_t *out, uint32_t timeout_ms) {
+    if (!hdc_irq_attached) return -1;
+    hdc_task = xTaskGetCurrentTaskHandle();
+
+    // Edges before the first wait had no task to notify: service anything
+    // already pending, which also releases the pin for the next edge.
+    if (!hdc_primed) {
+        hdc_primed = true;
+        int rc = hdc_read_burst(out);
+        if (rc != 0) return rc;
+        if (out->events) return out->events;
+    }
+
+    const TickType_t start = xTaskGetTickCount();
+    const TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+    for (;;) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) return 0;
+        if (ulTaskNotifyTake(pdTRUE, timeout - elapsed) == 0) return 0;
+        int rc = hdc_read_burst(out);
+        if (rc != 0) return rc;
+        if (out->events) return out->events;
+    }
 }
 
 /* =========================
@@ -733,7 +1215,23 @@ void stop_hdc2021() {
 // IMU related function
 // https://invensense.tdk.com/wp-content/uploads/2021/07/DS-000451-ICM-42670-P-v1.0.pdf
 
-float aRes, gRes;      // scale resolutions per LSB for the sensors
+// Scale resolutions per LSB for the sensors and their reciprocals. 
+static icm42670_config_t icm_cfg;
+
+// Compute 1/res as a 16-bit multiplier and a right shift, using as many
+// fractional bits as fit: raw (16 bit) * recip (16 bit) still fits in int32.
+static void icm_set_reciprocal(float res, uint16_t *recip, uint8_t *shift) {
+    for (int k = 15; k >= 0; --k) {
+        float r = (65536.0f * (float)(1u << k)) / res + 0.5f;
+        if (r <= 65535.0f) {
+            *recip = (uint16_t)r;
+            *shift = (uint8_t)k;
+            return;
+        }
+    }
+    *recip = 0xFFFF;
+    *shift = 0;
+}
 
 static int icm_i2c_write_byte(uint8_t reg, uint8_t value) {
     uint8_t buf[2] = { reg, value };
@@ -794,14 +1292,178 @@ static int ICM42670_autodetect_address(void) {
     return -1;
 }
 
-//TODO do initial calibration. 
-static void calibrateAccel(float *dest1){
+/* ---------- Calibration ---------- */
+
+#define ICM42670_CALIB_FLASH_TAG    0x434D4349u   // "ICMC"
+
+// Calibration in physical units (persisted) and the same data converted to
+// counts for the current FSR (used in the read path).
+static icm42670_calibration_t icm_cal;
+static struct {
+    int16_t gyro_off[3];
+    int16_t accel_off[3];
+    int16_t accel_scale_q14[3];
+    bool gyro;
+    bool accel;
+} icm_cal_raw;
+
+// Six-position capture state
+static int32_t icm_face_mean_q16[ICM42670_FACE_COUNT];
+static uint8_t icm_faces_done;
+
+static inline int16_t icm_sat16(int32_t v) {
+    return (int16_t)(v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v));
+}
+
+// Convert the Q16.16 calibration to counts. Called whenever the calibration
+// or the FSR changes, so the read path only needs integer math.
+static void icm_cal_update(void) {
+    icm_cal_raw.gyro = (icm_cal.flags & ICM42670_CALIB_GYRO) && icm_cfg.gRes > 0;
+    icm_cal_raw.accel = (icm_cal.flags & ICM42670_CALIB_ACCEL) && icm_cfg.aRes > 0;
+    for (int i = 0; i < 3; ++i) {
+        icm_cal_raw.gyro_off[i] = icm_sat16((int32_t)lroundf(icm_cal.gyro_bias_q16[i] * icm_cfg.gRes / 65536.0f));
+        icm_cal_raw.accel_off[i] = icm_sat16((int32_t)lroundf(icm_cal.accel_offset_q16[i] * icm_cfg.aRes / 65536.0f));
+        icm_cal_raw.accel_scale_q14[i] = (int16_t)icm_cal.accel_scale_q14[i];
+    }
+}
+
+// Apply the calibration to a raw sample. Scales are limited to [0.5, 2.0) so
+// (int16 * Q14) always fits in 32 bits.
+static inline void icm_cal_apply(struct icm_raw *raw) {
+    if (icm_cal_raw.gyro) {
+        raw->gx = icm_sat16((int32_t)raw->gx - icm_cal_raw.gyro_off[0]);
+        raw->gy = icm_sat16((int32_t)raw->gy - icm_cal_raw.gyro_off[1]);
+        raw->gz = icm_sat16((int32_t)raw->gz - icm_cal_raw.gyro_off[2]);
+    }
+    if (icm_cal_raw.accel) {
+        int16_t *a[3] = { &raw->ax, &raw->ay, &raw->az };
+        for (int i = 0; i < 3; ++i) {
+            int32_t v = icm_sat16((int32_t)*a[i] - icm_cal_raw.accel_off[i]);
+            *a[i] = icm_sat16((v * icm_cal_raw.accel_scale_q14[i] + (1 << 13)) >> 14);
+        }
+    }
+}
+
+static int icm_read_raw_uncal(struct icm_raw *raw);
+
+// Average accel and gyro at the calibration ODR. Means are returned in
+// Q16.16 g / dps. Fails with -3 if the gyro shows the board moved.
+static int icm_capture_mean(int32_t accel_q16[3], int32_t gyro_q16[3], uint16_t samples) {
+    if (icm_cfg.aRes <= 0 || icm_cfg.gRes <= 0) return -1;
+    if (samples == 0) samples = ICM42670_CALIB_SAMPLES_DEFAULT;
+
+    const uint16_t accel_odr = icm_cfg.accel_odr_hz, gyro_odr = icm_cfg.gyro_odr_hz;
+    if (ICM42670_startAccel(ICM42670_CALIB_ODR_HZ, icm_cfg.accel_fsr_g) != 0 ||
+        ICM42670_startGyro(ICM42670_CALIB_ODR_HZ, icm_cfg.gyro_fsr_dps) != 0) {
+        return -2;
+    }
+    const uint32_t period_us = 1000000u / ICM42670_CALIB_ODR_HZ;
+    sleep_ms(20); // let the filters settle at the new ODR
+
+    int64_t sum[6] = {0};
+    int16_t gmin[3] = {INT16_MAX, INT16_MAX, INT16_MAX};
+    int16_t gmax[3] = {INT16_MIN, INT16_MIN, INT16_MIN};
+    int rc = 0;
+    for (uint16_t n = 0; n < samples; ++n) {
+        struct icm_raw raw;
+        if (icm_read_raw_uncal(&raw) != 0) { rc = -2; break; }
+        const int16_t v[6] = { raw.ax, raw.ay, raw.az, raw.gx, raw.gy, raw.gz };
+        for (int i = 0; i < 6; ++i) sum[i] += v[i];
+        for (int i = 0; i < 3; ++i) {
+            if (v[3 + i] < gmin[i]) gmin[i] = v[3 + i];
+            if (v[3 + i] > gmax[i]) gmax[i] = v[3 + i];
+        }
+        busy_wait_us(period_us);
+    }
+
+    ICM42670_startAccel(accel_odr, icm_cfg.accel_fsr_g);
+    ICM42670_startGyro(gyro_odr, icm_cfg.gyro_fsr_dps);
+    if (rc != 0) return rc;
+
+    const int32_t still = (int32_t)(ICM42670_CALIB_STILL_DPS * icm_cfg.gRes);
+    for (int i = 0; i < 3; ++i) {
+        if ((int32_t)gmax[i] - gmin[i] > still) return -3;
+        accel_q16[i] = (int32_t)lroundf((float)sum[i] / samples * 65536.0f / icm_cfg.aRes);
+        gyro_q16[i] = (int32_t)lroundf((float)sum[3 + i] / samples * 65536.0f / icm_cfg.gRes);
+    }
+    return 0;
+}
+
+// Mean acceleration of a stationary capture (Q16.16 g)
+static int calibrateAccel(int32_t *dest1, uint16_t samples){
+    int32_t gyro[3];
+    return icm_capture_mean(dest1, gyro, samples);
+}
 
+// Zero-rate offset of the gyro (Q16.16 dps)
+static int calibrateGyro(int32_t *dest2, uint16_t samples){
+    int32_t accel[3];
+    return icm_capture_mean(accel, dest2, samples);
 }
 
-static void calibrateGyro(float *dest2){
+int ICM42670_calibrate_gyro(uint16_t samples) {
+    int32_t bias[3];
+    int rc = calibrateGyro(bias, samples);
+    if (rc != 0) return rc;
+    memcpy(icm_cal.gyro_bias_q16, bias, sizeof(bias));
+    icm_cal.flags |= ICM42670_CALIB_GYRO;
+    icm_cal_update();
+    return 0;
+}
 
+int ICM42670_calibrate_accel(icm42670_face_t face, uint16_t samples) {
+    if (face < 0 || face >= ICM42670_FACE_COUNT) return -1;
 
+    int32_t mean[3];
+    int rc = calibrateAccel(mean, samples);
+    if (rc != 0) return rc;
+
+    // The axis facing up/down must see roughly +1 g / -1 g
+    const int axis = face / 2;
+    const int32_t g = (face % 2 == 0) ? mean[axis] : -mean[axis];
+    if (g < 65536 / 2 || g > 65536 * 3 / 2) return -4;
+
+    icm_face_mean_q16[face] = mean[axis];
+    icm_faces_done |= (uint8_t)(1u << face);
+    if (icm_faces_done != 0x3F) return icm_faces_done;
+
+    // offset = (up + down) / 2, sensitivity = (up - down) / 2 (ideally 1 g)
+    for (int i = 0; i < 3; ++i) {
+        const int32_t up = icm_face_mean_q16[2 * i];
+        const int32_t down = icm_face_mean_q16[2 * i + 1];
+        const int32_t half = (up - down) / 2;
+        int64_t scale = ((int64_t)65536 << 14) / half;
+        if (scale < (1 << 13)) scale = 1 << 13;        // 0.5
+        if (scale > (1 << 15) - 1) scale = (1 << 15) - 1; // ~2.0
+        icm_cal.accel_offset_q16[i] = (up + down) / 2;
+        icm_cal.accel_scale_q14[i] = (uint16_t)scale;
+    }
+    icm_cal.flags |= ICM42670_CALIB_ACCEL;
+    icm_faces_done = 0;
+    icm_cal_update();
+    return 0x3F;
+}
+
+int ICM42670_calibration_save(void) {
+    return flash_store_save(ICM42670_CALIB_FLASH_TAG, &icm_cal, sizeof(icm_cal));
+}
+
+int ICM42670_calibration_load(void) {
+    icm42670_calibration_t cal;
+    int rc = flash_store_load(ICM42670_CALIB_FLASH_TAG, &cal, sizeof(cal));
+    if (rc != 0) return rc;
+    ICM42670_set_calibration(&cal);
+    return 0;
+}
+
+void ICM42670_set_calibration(const icm42670_calibration_t *cal) {
+    if (cal) icm_cal = *cal;
+    else memset(&icm_cal, 0, sizeof(icm_cal));
+    icm_cal_update();
+}
+
+const icm42670_calibration_t *ICM42670_get_calibration(void) {
+    return &icm_cal;
 }
 
 int init_ICM42670() {
@@ -843,6 +1505,8 @@ int ICM42670_startAccel(uint16_t odr_hz, uint16_t fsr_g) {
     uint8_t fsr_bits = 0;
     uint8_t odr_bits = 0;
 
+    float aRes;
+
     // Map FSR to register bits, aRes (See Datasheet Table 2)
     switch (fsr_g) {
         case 2:  
@@ -881,12 +1545,20 @@ int ICM42670_startAccel(uint16_t odr_hz, uint16_t fsr_g) {
     int rc = icm_i2c_write_byte(ICM42670_ACCEL_CONFIG0_REG, accel_config0_val);
     busy_wait_us(400); 
     if (rc != 0) return -3;
+
+    icm_cfg.accel_fsr_g = fsr_g;
+    icm_cfg.accel_odr_hz = odr_hz;
+    icm_cfg.aRes = aRes;
+    icm_cfg.accel_scale = 1.0f / aRes;
+    icm_set_reciprocal(aRes, &icm_cfg.accel_recip_q, &icm_cfg.accel_shift);
+    icm_cal_update();
     return 0; // success
 }
 
 int ICM42670_startGyro(uint16_t odr_hz, uint16_t fsr_dps) {
     uint8_t fsr_bits = 0;
     uint8_t odr_bits = 0;
+    float gRes;
  
     // Map FSR, gRes (See Datasheet Table 1)
     switch (fsr_dps) {
@@ -925,6 +1597,13 @@ int ICM42670_startGyro(uint16_t odr_hz, uint16_t fsr_dps) {
     uint8_t gyro_config0_val = (fsr_bits << 5) | (odr_bits & 0x0F);
     if (icm_i2c_write_byte(ICM42670_GYRO_CONFIG0_REG, gyro_config0_val) != 0) return -3;
     busy_wait_us(400); 
+
+    icm_cfg.gyro_fsr_dps = fsr_dps;
+    icm_cfg.gyro_odr_hz = odr_hz;
+    icm_cfg.gRes = gRes;
+    icm_cfg.gyro_scale = 1.0f / gRes;
+    icm_set_reciprocal(gRes, &icm_cfg.gyro_recip_q, &icm_cfg.gyro_shift);
+    icm_cal_update();
     return 0;
 }
 
@@ -975,30 +1654,282 @@ int ICM42670_start_with_default_values(void) {
 }
 
 
+static int icm_read_raw_uncal(struct icm_raw *raw) {
+    uint8_t buf[14]; // 14 bytes total from TEMP to GYRO Z
+
+    int rc = icm_i2c_read_bytes(ICM42670_SENSOR_DATA_START_REG, buf, sizeof(buf));
+    if (rc != 0) return rc;
+
+    // Convert to signed 16-bit integers (big-endian)
+    raw->t  = (int16_t)((buf[0] << 8) | buf[1]);
+    raw->ax = (int16_t)((buf[2] << 8) | buf[3]);
+    raw->ay = (int16_t)((buf[4] << 8) | buf[5]);
+    raw->az = (int16_t)((buf[6] << 8) | buf[7]);
+    raw->gx = (int16_t)((buf[8] << 8) | buf[9]);
+    raw->gy = (int16_t)((buf[10] << 8) | buf[11]);
+    raw->gz = (int16_t)((buf[12] << 8) | buf[13]);
+    return 0;
+}
+
+int ICM42670_read_raw(struct icm_raw *raw) {
+    int rc = icm_read_raw_uncal(raw);
+    if (rc != 0) return rc;
+    icm_cal_apply(raw);
+    return 0;
+}
+
+const icm42670_config_t *ICM42670_get_config(void) {
+    return &icm_cfg;
+}
+
 int ICM42670_read_sensor_data(float *ax, float *ay, float *az,
     float *gx, float *gy, float *gz,float *t) {
-        
-        uint8_t raw[14]; // 14 bytes total from TEMP to GYRO Z
 
-        int rc = icm_i2c_read_bytes(ICM42670_SENSOR_DATA_START_REG, raw, sizeof(raw));
+        struct icm_raw raw;
+        int rc = ICM42670_read_raw(&raw);
         if (rc != 0) return rc;
 
-        // Convert to signed 16-bit integers (big-endian)
-        int16_t t_raw = (int16_t)((raw[0] << 8) | raw[1]);
-        int16_t ax_raw = ((int16_t)raw[2] << 8) | raw[3];
-        int16_t ay_raw = ((int16_t)raw[4] << 8) | raw[5];
-        int16_t az_raw = ((int16_t)raw[6] << 8) | raw[7];
-        int16_t gx_raw = (int16_t)((raw[8] << 8) | raw[9]);
-        int16_t gy_raw = (int16_t)((raw[10] << 8) | raw[11]);
-        int16_t gz_raw = (int16_t)((raw[12] << 8) | raw[13]);
-
-        *t = ((float)t_raw / 128.0f)+ 25.0;
-        *ax =  (float)ax_raw / aRes; 
-        *ay =  (float)ay_raw / aRes; 
-        *az =  (float)az_raw / aRes;
-        *gx =  (float)gx_raw / gRes; 
-        *gy =  (float)gy_raw / gRes; 
-        *gz =  (float)gz_raw / gRes;
+        *t = ((float)raw.t / 128.0f)+ 25.0f;
+        *ax =  (float)raw.ax * icm_cfg.accel_scale; 
+        *ay =  (float)raw.ay * icm_cfg.accel_scale; 
+        *az =  (float)raw.az * icm_cfg.accel_scale;
+        *gx =  (float)raw.gx * icm_cfg.gyro_scale; 
+        *gy =  (float)raw.gy * icm_cfg.gyro_scale; 
+        *gz =  (float)raw.gz * icm_cfg.gyro_scale;
         return 0; // success
 }
 
+// Scale one channel: out = raw * recip >> shift (rounded), Q16.16.
+static void icm_scale_q16(const int16_t *in, int32_t *out, size_t n,
+                          uint16_t recip, uint8_t shift) {
+    if (!in || !out) return;
+    const int32_t m = recip;
+    const int32_t round = shift ? (1 << (shift - 1)) : 0;
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = ((int32_t)in[i] * m + round) >> shift;
+    }
+}
+
+static void icm_scale_float(const int16_t *in, float *out, size_t n, float scale) {
+    if (!in || !out) return;
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = (float)in[i] * scale;
+    }
+}
+
+void ICM42670_convert_batch_q16(const icm42670_config_t *cfg,
+                                const struct icm_raw_soa *in,
+                                struct icm_q16_soa *out, size_t n) {
+    icm_scale_q16(in->ax, out->ax, n, cfg->accel_recip_q, cfg->accel_shift);
+    icm_scale_q16(in->ay, out->ay, n, cfg->accel_recip_q, cfg->accel_shift);
+    icm_scale_q16(in->az, out->az, n, cfg->accel_recip_q, cfg->accel_shift);
+    icm_scale_q16(in->gx, out->gx, n, cfg->gyro_recip_q, cfg->gyro_shift);
+    icm_scale_q16(in->gy, out->gy, n, cfg->gyro_recip_q, cfg->gyro_shift);
+    icm_scale_q16(in->gz, out->gz, n, cfg->gyro_recip_q, cfg->gyro_shift);
+    // Temperature: t / 128 + 25 -> t * 2^9 + 25 * 2^16 in Q16.16
+    if (in->t && out->t) {
+        for (size_t i = 0; i < n; ++i) {
+            out->t[i] = (int32_t)in->t[i] * 512 + (25 << 16);
+        }
+    }
+}
+
+void ICM42670_convert_batch_float(const icm42670_config_t *cfg,
+                                  const struct icm_raw_soa *in,
+                                  struct icm_float_soa *out, size_t n) {
+    icm_scale_float(in->ax, out->ax, n, cfg->accel_scale);
+    icm_scale_float(in->ay, out->ay, n, cfg->accel_scale);
+    icm_scale_float(in->az, out->az, n, cfg->accel_scale);
+    icm_scale_float(in->gx, out->gx, n, cfg->gyro_scale);
+    icm_scale_float(in->gy, out->gy, n, cfg->gyro_scale);
+    icm_scale_float(in->gz, out->gz, n, cfg->gyro_scale);
+    if (in->t && out->t) {
+        for (size_t i = 0; i < n; ++i) {
+            out->t[i] = (float)in->t[i] * (1.0f / 128.0f) + 25.0f;
+        }
+    }
+}
+
+/* ---------- APEX motion features ---------- */
+
+// Bit fields used below (ICM-42670-P datasheet, register map)
+#define ICM_PWR_MGMT0_IDLE          0x10    // keep RC oscillator on with sensors off
+#define ICM_APEX0_DMP_INIT_EN       0x04
+#define ICM_APEX0_DMP_MEM_RESET_EN  0x01
+#define ICM_APEX1_SMD_ENABLE        0x40
+#define ICM_APEX1_TILT_ENABLE       0x10
+#define ICM_APEX1_PED_ENABLE        0x08
+#define ICM_APEX1_DMP_ODR_50HZ      0x02
+#define ICM_WOM_MODE_PREVIOUS       0x02    // compare with the previous sample
+#define ICM_WOM_EN                  0x01
+#define ICM_INT1_SMD                0x08    // INT_SOURCE1 / INT_STATUS2
+#define ICM_INT1_WOM_XYZ            0x07
+#define ICM_INT6_STEP_DET           0x08    // INT_SOURCE6
+#define ICM_INT6_STEP_CNT_OFL       0x04
+#define ICM_INT6_TILT_DET           0x02
+#define ICM_STATUS3_STEP_DET        0x20
+#define ICM_STATUS3_STEP_CNT_OVF    0x10
+#define ICM_STATUS3_TILT_DET        0x08
+
+static TaskHandle_t icm_apex_task = NULL;
+static bool icm_apex_irq_attached = false;
+
+// MREG1 registers are reached indirectly; the datasheet asks for 10 us
+// between accesses and the internal clock must be running (sensor on or IDLE).
+static int icm_mreg1_write(uint8_t reg, uint8_t value) {
+    int rc = icm_i2c_write_byte(ICM42670_BLK_SEL_W_REG, 0x00);
+    if (rc == 0) rc = icm_i2c_write_byte(ICM42670_MADDR_W_REG, reg);
+    if (rc == 0) rc = icm_i2c_write_byte(ICM42670_M_W_REG, value);
+    busy_wait_us(10);
+    return rc;
+}
+
+static int icm_mreg1_read(uint8_t reg, uint8_t *value) {
+    int rc = icm_i2c_write_byte(ICM42670_BLK_SEL_R_REG, 0x00);
+    if (rc == 0) rc = icm_i2c_write_byte(ICM42670_MADDR_R_REG, reg);
+    busy_wait_us(10);
+    if (rc == 0) rc = icm_i2c_read_byte(ICM42670_M_R_REG, value);
+    busy_wait_us(10);
+    return rc;
+}
+
+// INT1 is left at its reset configuration (open-drain, active-low, pulsed),
+// see the note in init_ICM42670().
+static void icm_int_irq_handler(void) {
+    if (gpio_get_irq_event_mask(ICM42670_INT) & GPIO_IRQ_EDGE_FALL) {
+        gpio_acknowledge_irq(ICM42670_INT, GPIO_IRQ_EDGE_FALL);
+        BaseType_t woken = pdFALSE;
+        if (icm_apex_task != NULL) {
+            vTaskNotifyGiveFromISR(icm_apex_task, &woken);
+        }
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+int ICM42670_apex_start(const icm42670_apex_config_t *cfg) {
+    if (cfg == NULL || cfg->features == 0 || (cfg->features & ~0x0F)) return -1;
+    if (cfg->tilt_wait_s > 6 || (cfg->tilt_wait_s & 1)) return -1;
+    if ((cfg->features & ICM42670_APEX_WOM) &&
+        (cfg->wom_threshold_mg < ICM42670_WOM_THRESHOLD_MIN ||
+         cfg->wom_threshold_mg > ICM42670_WOM_THRESHOLD_MAX)) return -1;
+
+    const bool tilt = cfg->features & ICM42670_APEX_TILT;
+    const bool smd  = cfg->features & ICM42670_APEX_SMD;
+    const bool ped  = smd || (cfg->features & ICM42670_APEX_PEDOMETER);
+    const bool wom  = cfg->features & ICM42670_APEX_WOM;
+    int rc = 0;
+
+    // Sensors off but clock on while the motion processor is set up
+    rc |= icm_i2c_write_byte(ICM42670_PWR_MGMT0_REG, ICM_PWR_MGMT0_IDLE);
+    busy_wait_us(300);
+    rc |= ICM42670_startAccel(50, icm_cfg.accel_fsr_g ? icm_cfg.accel_fsr_g
+                                                      : ICM42670_ACCEL_FSR_DEFAULT);
+    rc |= icm_i2c_write_byte(ICM42670_APEX_CONFIG1_REG, ICM_APEX1_DMP_ODR_50HZ);
+    rc |= icm_i2c_write_byte(ICM42670_APEX_CONFIG0_REG, ICM_APEX0_DMP_MEM_RESET_EN);
+    sleep_ms(1);
+
+    rc |= icm_mreg1_write(ICM42670_MREG1_APEX_CONFIG4, (uint8_t)((cfg->tilt_wait_s / 2) << 6));
+    if (wom) {
+        // 1 LSB = 1 g / 256; the range check keeps the result within 1..255
+        uint8_t thr = (uint8_t)((cfg->wom_threshold_mg * 256u + 500u) / 1000u);
+        rc |= icm_mreg1_write(ICM42670_MREG1_WOM_X_THR, thr);
+        rc |= icm_mreg1_write(ICM42670_MREG1_WOM_Y_THR, thr);
+        rc |= icm_mreg1_write(ICM42670_MREG1_WOM_Z_THR, thr);
+    }
+
+    if (tilt || ped) {
+        rc |= icm_i2c_write_byte(ICM42670_APEX_CONFIG0_REG, ICM_APEX0_DMP_INIT_EN);
+        sleep_ms(50);
+    }
+    uint8_t apex1 = ICM_APEX1_DMP_ODR_50HZ;
+    if (tilt) apex1 |= ICM_APEX1_TILT_ENABLE;
+    if (ped)  apex1 |= ICM_APEX1_PED_ENABLE;
+    if (smd)  apex1 |= ICM_APEX1_SMD_ENABLE;
+    rc |= icm_i2c_write_byte(ICM42670_APEX_CONFIG1_REG, apex1);
+    rc |= icm_i2c_write_byte(ICM42670_WOM_CONFIG_REG, wom ? (ICM_WOM_MODE_PREVIOUS | ICM_WOM_EN) : 0);
+
+    // Route the events to INT1
+    uint8_t src1 = (smd ? ICM_INT1_SMD : 0) | (wom ? ICM_INT1_WOM_XYZ : 0);
+    uint8_t src6 = (tilt ? ICM_INT6_TILT_DET : 0) |
+                   (ped ? (ICM_INT6_STEP_DET | ICM_INT6_STEP_CNT_OFL) : 0);
+    uint8_t int6 = 0;
+    rc |= icm_mreg1_read(ICM42670_MREG1_INT_SOURCE6, &int6);
+    int6 &= (uint8_t)~(ICM_INT6_TILT_DET | ICM_INT6_STEP_DET | ICM_INT6_STEP_CNT_OFL);
+    rc |= icm_i2c_write_byte(ICM42670_INT_SOURCE1_REG, src1);
+    rc |= icm_mreg1_write(ICM42670_MREG1_INT_SOURCE6, int6 | src6);
+
+    rc |= cfg->low_power ? ICM42670_enable_ultra_low_power_mode()
+                         : ICM42670_enable_accel_gyro_ln_mode();
+    if (rc != 0) return -2;
+
+    // Drop anything latched while configuring
+    return ICM42670_apex_read_events() < 0 ? -2 : 0;
+}
+
+int ICM42670_apex_stop(void) {
+    int rc = 0;
+    uint8_t int6 = 0;
+    rc |= icm_i2c_write_byte(ICM42670_INT_SOURCE1_REG, 0);
+    rc |= icm_mreg1_read(ICM42670_MREG1_INT_SOURCE6, &int6);
+    int6 &= (uint8_t)~(ICM_INT6_TILT_DET | ICM_INT6_STEP_DET | ICM_INT6_STEP_CNT_OFL);
+    rc |= icm_mreg1_write(ICM42670_MREG1_INT_SOURCE6, int6);
+    rc |= icm_i2c_write_byte(ICM42670_WOM_CONFIG_REG, 0);
+    rc |= icm_i2c_write_byte(ICM42670_APEX_CONFIG1_REG, ICM_APEX1_DMP_ODR_50HZ);
+    if (icm_apex_irq_attached) {
+        gpio_set_irq_enabled(ICM42670_INT, GPIO_IRQ_EDGE_FALL, false);
+        gpio_remove_raw_irq_handler(ICM42670_INT, icm_int_irq_handler);
+        icm_apex_irq_attached = false;
+    }
+    icm_apex_task = NULL;
+    return rc ? -2 : 0;
+}
+
+int ICM42670_apex_read_events(void) {
+    uint8_t st[2]; // INT_STATUS2, INT_STATUS3 (both clear on read)
+    if (icm_i2c_read_bytes(ICM42670_INT_STATUS2_REG, st, sizeof(st)) != 0) return -2;
+
+    int ev = 0;
+    if (st[0] & ICM_INT1_SMD)              ev |= ICM42670_EVT_SMD;
+    if (st[0] & 0x01)                      ev |= ICM42670_EVT_WOM_X;
+    if (st[0] & 0x02)                      ev |= ICM42670_EVT_WOM_Y;
+    if (st[0] & 0x04)                      ev |= ICM42670_EVT_WOM_Z;
+    if (st[1] & ICM_STATUS3_STEP_DET)      ev |= ICM42670_EVT_STEP;
+    if (st[1] & ICM_STATUS3_STEP_CNT_OVF)  ev |= ICM42670_EVT_STEP_OVERFLOW;
+    if (st[1] & ICM_STATUS3_TILT_DET)      ev |= ICM42670_EVT_TILT;
+    return ev;
+}
+
+int ICM42670_apex_wait_events(uint32_t timeout_ms) {
+    if (!icm_apex_irq_attached) {
+        gpio_init(ICM42670_INT);
+        gpio_set_dir(ICM42670_INT, GPIO_IN);
+        gpio_pull_up(ICM42670_INT); // open-drain output
+        gpio_add_raw_irq_handler(ICM42670_INT, icm_int_irq_handler);
+        gpio_set_irq_enabled(ICM42670_INT, GPIO_IRQ_EDGE_FALL, true);
+        irq_set_enabled(IO_IRQ_BANK0, true);
+        icm_apex_irq_attached = true;
+    }
+    icm_apex_task = xTaskGetCurrentTaskHandle();
+
+    // Events may have fired before we started waiting
+    int ev = ICM42670_apex_read_events();
+    if (ev != 0) return ev;
+
+    const TickType_t start = xTaskGetTickCount();
+    const TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+    for (;;) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) return 0;
+        if (ulTaskNotifyTake(pdTRUE, timeout - elapsed) == 0) return 0;
+        // A pulse whose status was already read above gives an empty mask
+        ev = ICM42670_apex_read_events();
+        if (ev != 0) return ev;
+    }
+}
+
+int ICM42670_apex_get_step_count(uint16_t *steps) {
+    uint8_t buf[2];
+    if (icm_i2c_read_bytes(ICM42670_APEX_DATA0_REG, buf, sizeof(buf)) != 0) return -2;
+    *steps = (uint16_t)(buf[0] | (buf[1] << 8));
+    return 0;
+}
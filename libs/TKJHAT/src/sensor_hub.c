@@ -0,0 +1,269 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Sensor hub: a single task samples the HAT I2C sensors on absolute
+ * deadlines and publishes the results through seqlock-protected
+ * snapshots. See tkjhat/sensor_hub.h.
+ */
+
+#include <string.h>
+
+#include <pico/stdlib.h>
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "tkjhat/sensor_hub.h"
+#include "seqlock.h"
+
+#define US_PER_TICK         (1000000u / configTICK_RATE_HZ)
+#define STACK_CHECK_EVERY   64      // wakeups between high-water mark scans
+
+static TaskHandle_t hub_task_handle = NULL;
+static volatile bool hub_running = false;
+static sensor_hub_config_t hub_cfg;
+
+static seqlock_t imu_lock, light_lock, env_lock, stats_lock;
+static sensor_hub_imu_t imu_snapshot;
+static sensor_hub_light_t light_snapshot;
+static sensor_hub_env_t env_snapshot;
+static bool imu_valid, light_valid, env_valid;
+static sensor_hub_stats_t hub_stats_snapshot;
+
+void sensor_hub_default_config(sensor_hub_config_t *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->channel[SENSOR_HUB_IMU]   = (sensor_hub_channel_t){ true,   10,   2000 };
+    cfg->channel[SENSOR_HUB_LIGHT] = (sensor_hub_channel_t){ true,  100,  10000 };
+    cfg->channel[SENSOR_HUB_ENV]   = (sensor_hub_channel_t){ true, 1000,  50000 };
+    cfg->priority = SENSOR_HUB_PRIORITY_DEFAULT;
+    cfg->core = -1;
+}
+
+// One I2C burst per sensor; the sample is published before returning
+static int hub_read(sensor_hub_sensor_t ch, uint64_t ts, uint32_t count) {
+    switch (ch) {
+        case SENSOR_HUB_IMU: {
+            sensor_hub_imu_t s;
+            if (ICM42670_read_raw(&s.raw) != 0) return -1;
+            const icm42670_config_t *c = ICM42670_get_config();
+            s.ax = s.raw.ax * c->accel_scale;
+            s.ay = s.raw.ay * c->accel_scale;
+            s.az = s.raw.az * c->accel_scale;
+            s.gx = s.raw.gx * c->gyro_scale;
+            s.gy = s.raw.gy * c->gyro_scale;
+            s.gz = s.raw.gz * c->gyro_scale;
+            s.t = s.raw.t / 128.0f + 25.0f;
+            s.timestamp_us = ts;
+            s.count = count;
+            seqlock_write_begin(&imu_lock);
+            imu_snapshot = s;
+            imu_valid = true;
+            seqlock_write_end(&imu_lock);
+            return 0;
+        }
+        case SENSOR_HUB_LIGHT: {
+            sensor_hub_light_t s;
+            if (veml6030_read(&s.reading, false) != 0) return -1;
+            s.timestamp_us = ts;
+            s.count = count;
+            seqlock_write_begin(&light_lock);
+            light_snapshot = s;
+            light_valid = true;
+            seqlock_write_end(&light_lock);
+            return 0;
+        }
+        case SENSOR_HUB_ENV: {
+            hdc2021_sample_t h;
+            if (hdc2021_read_sample(&h) != 0) return -1;
+            sensor_hub_env_t s = { h.temperature, h.humidity, ts, count };
+            seqlock_write_begin(&env_lock);
+            env_snapshot = s;
+            env_valid = true;
+            seqlock_write_end(&env_lock);
+            return 0;
+        }
+        default:
+            return -1;
+    }
+}
+
+static void hub_task(void *arg) {
+    (void)arg;
+    const sensor_hub_config_t cfg = hub_cfg;
+    sensor_hub_stats_t st;
+    memset(&st, 0, sizeof(st));
+    st.stack_words = SENSOR_HUB_STACK_SIZE;
+    st.stack_free_min_words = SENSOR_HUB_STACK_SIZE;
+    uint32_t jitter_avg_q4[SENSOR_HUB_COUNT] = {0};
+
+    TickType_t period[SENSOR_HUB_COUNT];
+    TickType_t due[SENSOR_HUB_COUNT];
+    const TickType_t start = xTaskGetTickCount();
+    const uint64_t start_us = time_us_64();
+    for (int i = 0; i < SENSOR_HUB_COUNT; i++) {
+        period[i] = pdMS_TO_TICKS(cfg.channel[i].period_ms);
+        if (period[i] == 0) period[i] = 1;
+        due[i] = start;
+    }
+    TickType_t wake = start;
+
+    while (hub_running) {
+        // Sleep until the earliest due time (absolute, so no drift)
+        int32_t wait = INT32_MAX;
+        for (int i = 0; i < SENSOR_HUB_COUNT; i++) {
+            if (!cfg.channel[i].enabled) continue;
+            int32_t d = (int32_t)(due[i] - wake);
+            if (d < wait) wait = d;
+        }
+        if (wait == INT32_MAX) break;
+        if (wait > 0) {
+            xTaskDelayUntil(&wake, (TickType_t)wait);
+        }
+        st.wakeups++;
+
+        // Read everything that is due back to back
+        for (int i = 0; i < SENSOR_HUB_COUNT; i++) {
+            if (!cfg.channel[i].enabled || (int32_t)(wake - due[i]) < 0) continue;
+            sensor_hub_channel_stats_t *cs = &st.channel[i];
+
+            const uint64_t ideal_us = start_us + (uint64_t)(due[i] - start) * US_PER_TICK;
+            const uint64_t t0 = time_us_64();
+            const uint32_t late = t0 > ideal_us ? (uint32_t)(t0 - ideal_us) : 0;
+            const int rc = hub_read((sensor_hub_sensor_t)i, t0, cs->samples + 1);
+            const uint32_t dur = (uint32_t)(time_us_64() - t0);
+            if (rc == 0) {
+                cs->samples++;
+                if (cfg.on_sample) cfg.on_sample((sensor_hub_sensor_t)i, cfg.ctx);
+            } else {
+                cs->errors++;
+            }
+
+            if (dur > cs->read_us_max) cs->read_us_max = dur;
+            if (late > cs->jitter_us_max) cs->jitter_us_max = late;
+            if (late > cfg.channel[i].deadline_us) cs->deadline_misses++;
+            jitter_avg_q4[i] += (int32_t)((late << 4) - jitter_avg_q4[i]) / 16;
+            cs->jitter_us_avg = (jitter_avg_q4[i] + 8) >> 4;
+
+            // Next period; drop the ones we are already a full period past
+            due[i] += period[i];
+            const TickType_t now = xTaskGetTickCount();
+            while ((int32_t)(now - due[i]) >= (int32_t)period[i]) {
+                due[i] += period[i];
+                cs->skipped++;
+            }
+        }
+
+        if ((st.wakeups % STACK_CHECK_EVERY) == 1) {
+            st.stack_free_min_words = uxTaskGetStackHighWaterMark(NULL);
+        }
+        seqlock_write_begin(&stats_lock);
+        hub_stats_snapshot = st;
+        seqlock_write_end(&stats_lock);
+    }
+
+    hub_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+int sensor_hub_start(const sensor_hub_config_t *cfg) {
+    if (hub_task_handle != NULL) return -1;
+
+    sensor_hub_config_t c;
+    if (cfg) {
+        c = *cfg;
+    } else {
+        sensor_hub_default_config(&c);
+    }
+    if (c.core > 1) return -1;
+    for (int i = 0; i < SENSOR_HUB_COUNT; i++) {
+        if (c.channel[i].enabled && c.channel[i].period_ms == 0) return -1;
+    }
+    hub_cfg = c;
+    hub_running = true;
+
+    if (xTaskCreate(hub_task, "sensor_hub", SENSOR_HUB_STACK_SIZE, NULL,
+                    c.priority, &hub_task_handle) != pdPASS) {
+        hub_running = false;
+        hub_task_handle = NULL;
+        return -2;
+    }
+#if (configNUMBER_OF_CORES > 1) && (configUSE_CORE_AFFINITY == 1)
+    if (c.core >= 0) {
+        vTaskCoreAffinitySet(hub_task_handle, 1u << c.core);
+    }
+#endif
+    return 0;
+}
+
+void sensor_hub_stop(void) {
+    if (hub_task_handle == NULL) return;
+    hub_running = false;
+    while (hub_task_handle != NULL) {
+        vTaskDelay(1);
+    }
+}
+
+bool sensor_hub_get_imu(sensor_hub_imu_t *out) {
+    uint32_t s;
+    bool valid;
+    do {
+        s = seqlock_read_begin(&imu_lock);
+        *out = imu_snapshot;
+        valid = imu_valid;
+    } while (seqlock_read_retry(&imu_lock, s));
+    return valid;
+}
+
+bool sensor_hub_get_light(sensor_hub_light_t *out) {
+    uint32_t s;
+    bool valid;
+    do {
+        s = seqlock_read_begin(&light_lock);
+        *out = light_snapshot;
+        valid = light_valid;
+    } while (seqlock_read_retry(&light_lock, s));
+    return valid;
+}
+
+bool sensor_hub_get_env(sensor_hub_env_t *out) {
+    uint32_t s;
+    bool valid;
+    do {
+        s = seqlock_read_begin(&env_lock);
+        *out = env_snapshot;
+        valid = env_valid;
+    } while (seqlock_read_retry(&env_lock, s));
+    return valid;
+}
+
+void sensor_hub_get_stats(sensor_hub_stats_t *out) {
+    uint32_t s;
+    do {
+        s = seqlock_read_begin(&stats_lock);
+        *out = hub_stats_snapshot;
+    } while (seqlock_read_retry(&stats_lock, s));
+}
@@ -0,0 +1,74 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Minimal sequence lock for "latest value" snapshots shared between tasks and
+ * cores. There must be a single writer. Readers never block the writer: they
+ * copy the data and retry if the writer touched it meanwhile.
+ *
+ *   writer:  seqlock_write_begin(&l); data = v; seqlock_write_end(&l);
+ *   reader:  do { s = seqlock_read_begin(&l); v = data; } while (seqlock_read_retry(&l, s));
+ */
+
+#ifndef TKJHAT_SEQLOCK_H
+#define TKJHAT_SEQLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pico/stdlib.h>
+#include <hardware/sync.h>
+
+typedef struct {
+    volatile uint32_t seq;   // odd while a write is in progress
+} seqlock_t;
+
+static inline void seqlock_write_begin(seqlock_t *l) {
+    l->seq = l->seq + 1;
+    __dmb();
+}
+
+static inline void seqlock_write_end(seqlock_t *l) {
+    __dmb();
+    l->seq = l->seq + 1;
+}
+
+static inline uint32_t seqlock_read_begin(const seqlock_t *l) {
+    uint32_t s;
+    while ((s = l->seq) & 1u) {
+        tight_loop_contents();
+    }
+    __dmb();
+    return s;
+}
+
+static inline bool seqlock_read_retry(const seqlock_t *l, uint32_t start) {
+    __dmb();
+    return l->seq != start;
+}
+
+#endif /* TKJHAT_SEQLOCK_H */
@@ -0,0 +1,420 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Spectrum task: windowed fixed-point FFTs of the microphone and the
+ * accelerometer, published through seqlock snapshots. See
+ * tkjhat/spectrum.h.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <pico/stdlib.h>
+#include <hardware/clocks.h>
+#include <FreeRTOS.h>
+#include <queue.h>
+#include <task.h>
+
+#include "tkjhat/spectrum.h"
+#include "tkjhat/mic_stream.h"
+#include "seqlock.h"
+
+#define MIC_WAIT_MS         100     // mic_stream_read() timeout when the IMU is off
+#define PUSH_WAIT_MS        5       // pushed IMU sample wait while the mic is polled
+#define BENCH_MIN_US        20000   // run each benchmarked block at least this long
+#define PEAK_GUARD_BINS     2       // bins next to the peak left out of the floor
+
+static TaskHandle_t spec_task_handle = NULL;
+static volatile bool spec_running = false;
+static spectrum_config_t spec_cfg;
+
+// Pushed accelerometer samples (imu_push): the configured axis only
+static QueueHandle_t imu_queue = NULL;
+static volatile uint32_t imu_push_dropped;
+
+// Sample blocks, transformed in place into bins and then magnitudes. The
+// 32-bit magnitudes of n/2 bins take exactly the space of n samples.
+static union {
+    int16_t x[FFT_SIZE_MAX];
+    uint16_t mag16[FFT_SIZE_MAX / 2];
+    uint32_t mag[FFT_SIZE_MAX / 2];
+} mic_work;
+
+static union {
+    int32_t x[FFT_SIZE_MAX];
+    uint32_t mag[FFT_SIZE_MAX / 2];
+} imu_work;
+
+typedef struct {
+    seqlock_t lock;
+    spectrum_result_t result;
+    uint32_t mag[FFT_SIZE_MAX / 2];
+    bool valid;
+} spectrum_snapshot_t;
+
+static spectrum_snapshot_t snapshot[SPECTRUM_COUNT];
+
+void spectrum_default_config(spectrum_config_t *cfg) {
+    cfg->mic = true;
+    cfg->imu = true;
+    cfg->mic_size = SPECTRUM_MIC_SIZE_DEFAULT;
+    cfg->imu_size = SPECTRUM_IMU_SIZE_DEFAULT;
+    cfg->imu_rate_hz = SPECTRUM_IMU_RATE_DEFAULT;
+    cfg->imu_axis = 2;
+    cfg->imu_push = false;
+    cfg->priority = SPECTRUM_PRIORITY_DEFAULT;
+    cfg->core = -1;
+}
+
+static bool rfft_size_valid(unsigned n) {
+    return n >= FFT_SIZE_MIN && fft_size_valid(n);
+}
+
+// Level relative to a full-scale (32768 counts) sine, whose bin is 1/4 of that
+static float bin_dbfs(float counts) {
+    if (counts <= 0.0f) return -200.0f;
+    return 20.0f * log10f(4.0f * counts / 32768.0f);
+}
+
+/*
+ * Peak search, noise floor and publication. mag holds r->bins magnitudes;
+ * counts_per_unit converts them to input counts and units_per_count the
+ * counts to the unit of peak_amplitude.
+ */
+static void publish(spectrum_source_t src, spectrum_result_t *r, const uint32_t *mag,
+                    float counts_per_unit, float units_per_count) {
+    const unsigned bins = r->bins;
+    unsigned peak = 1;
+    for (unsigned k = 2; k < bins; k++) {
+        if (mag[k] > mag[peak]) peak = k;
+    }
+
+    uint64_t sum = 0;
+    unsigned used = 0;
+    for (unsigned k = 1; k < bins; k++) {
+        if (k + PEAK_GUARD_BINS >= peak && k <= peak + PEAK_GUARD_BINS) continue;
+        sum += mag[k];
+        used++;
+    }
+
+    // Parabolic interpolation between the peak and its neighbours
+    float offset = 0.0f;
+    if (peak > 1 && peak + 1 < bins) {
+        float l = (float)mag[peak - 1], c = (float)mag[peak], h = (float)mag[peak + 1];
+        float den = l - 2.0f * c + h;
+        if (den < 0.0f) offset = 0.5f * (l - h) / den;
+    }
+
+    const float peak_counts = (float)mag[peak] * counts_per_unit;
+    r->peak_hz = ((float)peak + offset) * r->bin_hz;
+    r->peak_amplitude = 4.0f * peak_counts * units_per_count;
+    r->peak_dbfs = bin_dbfs(peak_counts);
+    r->floor_dbfs = used ? bin_dbfs((float)sum / (float)used * counts_per_unit) : -200.0f;
+
+    spectrum_snapshot_t *s = &snapshot[src];
+    seqlock_write_begin(&s->lock);
+    s->result = *r;
+    memcpy(s->mag, mag, bins * sizeof(uint32_t));
+    s->valid = true;
+    seqlock_write_end(&s->lock);
+}
+
+static void analyse_mic(spectrum_result_t *r) {
+    const unsigned n = r->size;
+    uint32_t t0 = time_us_32();
+    fft_window_hann_q15(mic_work.x, n);
+    fft_rfft_q15(mic_work.x, n);
+    fft_magnitude_q15(mic_work.x, mic_work.mag16, r->bins);
+    r->fft_us = time_us_32() - t0;
+
+    // Widen to 32 bits in place, from the top so nothing is overwritten early
+    for (unsigned k = r->bins; k-- > 0;) {
+        mic_work.mag[k] = mic_work.mag16[k];
+    }
+    r->timestamp_us = t0;
+    r->count++;
+    publish(SPECTRUM_MIC, r, mic_work.mag, 1.0f, 1.0f);
+}
+
+static void analyse_imu(spectrum_result_t *r, float g_per_count) {
+    const unsigned n = r->size;
+    uint32_t t0 = time_us_32();
+
+    // Remove gravity, then raw counts (< 2^16 apart) to Q31 with 1.0 = 2^16 counts
+    int64_t sum = 0;
+    for (unsigned i = 0; i < n; i++) sum += imu_work.x[i];
+    const int32_t mean = (int32_t)(sum / (int64_t)n);
+    for (unsigned i = 0; i < n; i++) imu_work.x[i] = (imu_work.x[i] - mean) * (1 << 15);
+
+    fft_window_hann_q31(imu_work.x, n);
+    fft_rfft_q31(imu_work.x, n);
+    fft_magnitude_q31(imu_work.x, imu_work.mag, r->bins);
+    r->fft_us = time_us_32() - t0;
+    r->timestamp_us = t0;
+    r->count++;
+    publish(SPECTRUM_IMU, r, imu_work.mag, 1.0f / 32768.0f, g_per_count);
+}
+
+static int16_t imu_axis_value(const struct icm_raw *raw, uint8_t axis) {
+    switch (axis) {
+        case 0:  return raw->ax;
+        case 1:  return raw->ay;
+        default: return raw->az;
+    }
+}
+
+static void spectrum_task(void *arg) {
+    (void)arg;
+    const spectrum_config_t cfg = spec_cfg;
+    const TickType_t period = cfg.imu && !cfg.imu_push ? configTICK_RATE_HZ / cfg.imu_rate_hz : 0;
+
+    spectrum_result_t mic_r, imu_r;
+    memset(&mic_r, 0, sizeof(mic_r));
+    memset(&imu_r, 0, sizeof(imu_r));
+    if (cfg.mic) {
+        struct pdm_microphone_stats mic;
+        pdm_microphone_get_stats(&mic);
+        mic_r.size = cfg.mic_size;
+        mic_r.bins = cfg.mic_size / 2;
+        mic_r.bin_hz = (float)mic.sample_rate / (float)cfg.mic_size;
+    }
+    if (cfg.imu) {
+        imu_r.size = cfg.imu_size;
+        imu_r.bins = cfg.imu_size / 2;
+        imu_r.bin_hz = (float)cfg.imu_rate_hz / (float)cfg.imu_size;
+    }
+
+    size_t mic_fill = 0, imu_fill = 0;
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (spec_running) {
+        if (cfg.imu && cfg.imu_push) {
+            // Wait for the producer, then take whatever has queued up
+            TickType_t wait = pdMS_TO_TICKS(cfg.mic ? PUSH_WAIT_MS : MIC_WAIT_MS);
+            int16_t v;
+            while (imu_fill < cfg.imu_size && xQueueReceive(imu_queue, &v, wait) == pdTRUE) {
+                imu_work.x[imu_fill++] = v;
+                wait = 0;
+            }
+            imu_r.overruns = imu_push_dropped;
+        } else if (cfg.imu) {
+            if (xTaskDelayUntil(&last_wake, period) == pdFALSE) {
+                imu_r.overruns++;
+            }
+            struct icm_raw raw;
+            if (ICM42670_read_raw(&raw) == 0) {
+                imu_work.x[imu_fill++] = imu_axis_value(&raw, cfg.imu_axis);
+            } else {
+                imu_r.errors++;
+            }
+        }
+        if (cfg.imu && imu_fill == cfg.imu_size) {
+            // Scale looked up per block: the full-scale range may change
+            analyse_imu(&imu_r, ICM42670_get_config()->accel_scale);
+            imu_fill = 0;
+        }
+        if (cfg.mic) {
+            // Poll while pacing the IMU, otherwise wait for audio
+            mic_fill += mic_stream_read(&mic_work.x[mic_fill], cfg.mic_size - mic_fill,
+                                        cfg.imu ? 0 : MIC_WAIT_MS);
+            if (mic_fill == cfg.mic_size) {
+                analyse_mic(&mic_r);
+                mic_fill = 0;
+            }
+        }
+    }
+
+    spec_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+int spectrum_start(const spectrum_config_t *cfg) {
+    if (spec_task_handle != NULL) return -1;
+
+    spectrum_config_t c;
+    if (cfg) {
+        c = *cfg;
+    } else {
+        spectrum_default_config(&c);
+    }
+    if (!c.mic && !c.imu) return -1;
+    if (c.mic && !rfft_size_valid(c.mic_size)) return -1;
+    if (c.imu && (!rfft_size_valid(c.imu_size) || c.imu_rate_hz == 0 || c.imu_axis > 2)) {
+        return -1;
+    }
+    // Paced by the task itself: whole ticks per sample
+    if (c.imu && !c.imu_push && (c.imu_rate_hz > configTICK_RATE_HZ ||
+                                 configTICK_RATE_HZ % c.imu_rate_hz != 0)) {
+        return -1;
+    }
+    if (c.core > 1) return -1;
+    spec_cfg = c;
+
+    QueueHandle_t q = NULL;
+    if (c.imu && c.imu_push) {
+        q = xQueueCreate(SPECTRUM_IMU_QUEUE_LENGTH, sizeof(int16_t));
+        if (q == NULL) return -2;
+    }
+    imu_push_dropped = 0;
+    spec_running = true;
+
+    BaseType_t ok = xTaskCreate(spectrum_task, "spectrum", SPECTRUM_STACK_SIZE, NULL,
+                                c.priority, &spec_task_handle);
+    if (ok != pdPASS) {
+        spec_running = false;
+        spec_task_handle = NULL;
+        if (q) vQueueDelete(q);
+        return -2;
+    }
+    // Published last: spectrum_push_imu() takes a set queue as running
+    imu_queue = q;
+#if (configNUMBER_OF_CORES > 1) && (configUSE_CORE_AFFINITY == 1)
+    if (c.core >= 0) {
+        vTaskCoreAffinitySet(spec_task_handle, 1u << c.core);
+    }
+#endif
+    return 0;
+}
+
+void spectrum_stop(void) {
+    if (spec_task_handle == NULL) return;
+    spec_running = false;
+    while (spec_task_handle != NULL) {
+        vTaskDelay(1);
+    }
+    if (imu_queue != NULL) {
+        QueueHandle_t q = imu_queue;
+        imu_queue = NULL;
+        vQueueDelete(q);
+    }
+}
+
+bool spectrum_push_imu(const struct icm_raw *raw) {
+    QueueHandle_t q = imu_queue;
+    if (q == NULL) return false;
+    int16_t v = imu_axis_value(raw, spec_cfg.imu_axis);
+    if (xQueueSend(q, &v, 0) != pdTRUE) {
+        imu_push_dropped++;
+        return false;
+    }
+    return true;
+}
+
+bool spectrum_get(spectrum_source_t src, spectrum_result_t *out) {
+    if (src >= SPECTRUM_COUNT) return false;
+    spectrum_snapshot_t *s = &snapshot[src];
+    uint32_t seq;
+    bool valid;
+    do {
+        seq = seqlock_read_begin(&s->lock);
+        *out = s->result;
+        valid = s->valid;
+    } while (seqlock_read_retry(&s->lock, seq));
+    return valid;
+}
+
+size_t spectrum_get_bins(spectrum_source_t src, uint32_t *mag, size_t max) {
+    if (src >= SPECTRUM_COUNT) return 0;
+    spectrum_snapshot_t *s = &snapshot[src];
+    uint32_t seq;
+    size_t n;
+    do {
+        seq = seqlock_read_begin(&s->lock);
+        n = s->valid ? s->result.bins : 0;
+        if (n > max) n = max;
+        memcpy(mag, s->mag, n * sizeof(uint32_t));
+    } while (seqlock_read_retry(&s->lock, seq));
+    return n;
+}
+
+/* ---------- Benchmark ---------- */
+
+typedef void (*bench_fn_t)(void *buf, unsigned n);
+
+static void bench_window_q15(void *b, unsigned n) { fft_window_hann_q15(b, n); }
+static void bench_rfft_q15(void *b, unsigned n) { fft_rfft_q15(b, n); }
+static void bench_cfft_q15(void *b, unsigned n) { fft_cfft_q15(b, n); }
+static void bench_mag_q15(void *b, unsigned n) { fft_magnitude_q15(b, (uint16_t *)b + n, n / 2); }
+static void bench_window_q31(void *b, unsigned n) { fft_window_hann_q31(b, n); }
+static void bench_rfft_q31(void *b, unsigned n) { fft_rfft_q31(b, n); }
+static void bench_cfft_q31(void *b, unsigned n) { fft_cfft_q31(b, n); }
+static void bench_mag_q31(void *b, unsigned n) { fft_magnitude_q31(b, (uint32_t *)b + n, n / 2); }
+
+// Deterministic full-range test input: 2n values, enough for a complex FFT
+static void bench_fill(void *buf, unsigned n, bool q31) {
+    for (unsigned i = 0; i < 2 * n; i++) {
+        int32_t v = (int32_t)((i * 7919u) & 0x3FFFu) - 0x2000;
+        if (q31) {
+            ((volatile int32_t *)buf)[i] = v * (1 << 17);
+        } else {
+            ((volatile int16_t *)buf)[i] = (int16_t)(v * 2);
+        }
+    }
+}
+
+// Cycles of one call. The input is refilled before every run so it never
+// decays to zeros; the refill time is measured separately and subtracted.
+static uint32_t bench_cycles(bench_fn_t fn, void *buf, unsigned n, bool q31, uint32_t cpu_hz) {
+    uint32_t runs = 0;
+    uint32_t t0 = time_us_32(), us;
+    do {
+        bench_fill(buf, n, q31);
+        fn(buf, n);
+        runs++;
+        us = time_us_32() - t0;
+    } while (us < BENCH_MIN_US);
+
+    uint32_t r0 = time_us_32();
+    for (uint32_t r = 0; r < runs; r++) bench_fill(buf, n, q31);
+    uint32_t fill_us = time_us_32() - r0;
+    if (fill_us > us) fill_us = us;
+    return (uint32_t)((uint64_t)(us - fill_us) * cpu_hz / 1000000u / runs);
+}
+
+int spectrum_benchmark(unsigned n, spectrum_bench_t *out) {
+    if (!rfft_size_valid(n)) return -1;
+    // Complex FFT of n points: 2n values of 32 bits
+    void *buf = pvPortMalloc(2 * n * sizeof(int32_t));
+    if (buf == NULL) return -2;
+
+    memset(out, 0, sizeof(*out));
+    out->size = (uint16_t)n;
+    out->cpu_hz = clock_get_hz(clk_sys);
+    const uint32_t hz = out->cpu_hz;
+    out->window_q15    = bench_cycles(bench_window_q15, buf, n, false, hz);
+    out->rfft_q15      = bench_cycles(bench_rfft_q15, buf, n, false, hz);
+    out->cfft_q15      = bench_cycles(bench_cfft_q15, buf, n, false, hz);
+    out->magnitude_q15 = bench_cycles(bench_mag_q15, buf, n, false, hz);
+    out->window_q31    = bench_cycles(bench_window_q31, buf, n, true, hz);
+    out->rfft_q31      = bench_cycles(bench_rfft_q31, buf, n, true, hz);
+    out->cfft_q31      = bench_cycles(bench_cfft_q31, buf, n, true, hz);
+    out->magnitude_q31 = bench_cycles(bench_mag_q31, buf, n, true, hz);
+
+    vPortFree(buf);
+    return 0;
+}
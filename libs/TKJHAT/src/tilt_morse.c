@@ -0,0 +1,130 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Streaming tilt-gesture Morse classifier. See tkjhat/tilt_morse.h.
+ */
+
+#include <stddef.h>
+
+#include "tkjhat/tilt_morse.h"
+
+// Decision points, in Morse units: the midpoints between dot (1) and
+// dash (3), element gap (1) and letter gap (3), letter gap (3) and word
+// gap (7).
+#define DASH_MIN_UNITS          2
+#define LETTER_GAP_MIN_UNITS    2
+#define WORD_GAP_MIN_UNITS      5
+
+void tilt_morse_default_config(tilt_morse_config_t *cfg) {
+    cfg->on_deg = TILT_MORSE_ON_DEG_DEFAULT;
+    cfg->off_deg = TILT_MORSE_OFF_DEG_DEFAULT;
+    cfg->debounce_us = TILT_MORSE_DEBOUNCE_US_DEFAULT;
+    cfg->unit_us = TILT_MORSE_UNIT_US_DEFAULT;
+}
+
+void tilt_morse_init(tilt_morse_t *tm, const tilt_morse_config_t *cfg) {
+    if (cfg) {
+        tm->cfg = *cfg;
+    } else {
+        tilt_morse_default_config(&tm->cfg);
+    }
+    if (tm->cfg.off_deg > tm->cfg.on_deg) tm->cfg.off_deg = tm->cfg.on_deg;
+    tm->started = false;
+    tm->key_down = false;
+    tm->pending = false;
+    tm->pending_us = 0;
+    tm->edge_us = 0;
+    tm->gaps_sent = 2;      // nothing to terminate yet
+    tm->have_mark = false;
+}
+
+static inline void emit(tilt_morse_event_t *ev, char symbol, uint32_t start, uint32_t now) {
+    ev->symbol = symbol;
+    ev->start_us = start;
+    ev->duration_us = now - start;
+}
+
+bool tilt_morse_update(tilt_morse_t *tm, float angle_deg, uint32_t t_us,
+                       tilt_morse_event_t *ev) {
+    const float a = angle_deg < 0.0f ? -angle_deg : angle_deg;
+
+    if (!tm->started) {
+        tm->started = true;
+        tm->edge_us = t_us;
+        tm->key_down = a > tm->cfg.on_deg;
+    }
+
+    // Hysteresis: what the key would be from this sample alone
+    bool raw = tm->key_down ? (a >= tm->cfg.off_deg) : (a > tm->cfg.on_deg);
+
+    if (raw == tm->key_down) {
+        tm->pending = false;
+    } else {
+        if (!tm->pending) {
+            tm->pending = true;
+            tm->pending_us = t_us;
+        }
+        if (t_us - tm->pending_us >= tm->cfg.debounce_us) {
+            // Accepted edge, dated from where it started
+            const uint32_t start = tm->edge_us, edge = tm->pending_us;
+            tm->key_down = raw;
+            tm->pending = false;
+            tm->edge_us = edge;
+            if (!raw) {
+                // Key released: classify the mark
+                const uint32_t len = edge - start;
+                tm->gaps_sent = 0;
+                tm->have_mark = true;
+                emit(ev, len < DASH_MIN_UNITS * tm->cfg.unit_us ? TILT_MORSE_DOT
+                                                                : TILT_MORSE_DASH,
+                     start, edge);
+                return true;
+            }
+            return false;
+        }
+    }
+
+    // Key up: report gaps once they are long enough. A pending key-down
+    // that is still being debounced does not count as space.
+    if (!tm->key_down && tm->have_mark && tm->gaps_sent < 2) {
+        const uint32_t now = tm->pending ? tm->pending_us : t_us;
+        const uint32_t len = now - tm->edge_us;
+        if (tm->gaps_sent == 0 && len >= LETTER_GAP_MIN_UNITS * tm->cfg.unit_us) {
+            tm->gaps_sent = 1;
+            emit(ev, TILT_MORSE_LETTER_GAP, tm->edge_us, now);
+            return true;
+        }
+        if (tm->gaps_sent == 1 && len >= WORD_GAP_MIN_UNITS * tm->cfg.unit_us) {
+            tm->gaps_sent = 2;
+            tm->have_mark = false;
+            emit(ev, TILT_MORSE_WORD_GAP, tm->edge_us, now);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,317 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Goertzel tone detector and Morse timing for the microphone. See
+ * tkjhat/tone_morse.h.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "tkjhat/tone_morse.h"
+#include "tkjhat/fft.h"
+
+// Decision points in Morse units, as in tilt_morse.c
+#define DASH_MIN_UNITS          2
+#define LETTER_GAP_MIN_UNITS    2
+#define WORD_GAP_MIN_UNITS      5
+
+#define UNIT_US_MIN             10000u      // 120 WPM
+#define UNIT_US_MAX             1200000u    // 1 WPM
+
+// History entries needed before the unit is taken from it
+#define HISTORY_MIN             4
+
+// Samples are scaled down by 4 first. With at most TONE_MORSE_MAX_BLOCK
+// samples and a tone of at least 100 Hz the Goertzel state then stays
+// below 2^29, which mul_q14() needs.
+#define INPUT_SHIFT             2
+
+#define TONE_MIN_HZ             100.0f
+
+void tone_morse_default_config(tone_morse_config_t *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->sample_rate = 8000;
+    cfg->tone_hz = TONE_MORSE_TONE_HZ_DEFAULT;
+    cfg->track = true;
+    cfg->track_range_hz = TONE_MORSE_TRACK_HZ_DEFAULT;
+    cfg->block_us = TONE_MORSE_BLOCK_US_DEFAULT;
+    cfg->unit_us = TONE_MORSE_UNIT_US_DEFAULT;
+    cfg->debounce_us = 2 * TONE_MORSE_BLOCK_US_DEFAULT;
+    cfg->min_snr = TONE_MORSE_MIN_SNR_DEFAULT;
+    cfg->min_level = 16;
+}
+
+// c * s / 2^14 for c <= 2^15 and |s| < 2^29 with two 32-bit multiplies
+static inline int32_t mul_q14(int32_t c, int32_t s) {
+    return c * (s >> 14) + ((c * (s & 0x3FFF)) >> 14);
+}
+
+static int32_t goertzel_coef(float hz, uint32_t rate) {
+    return (int32_t)lrintf(2.0f * cosf(6.2831853f * hz / (float)rate) * 16384.0f);
+}
+
+// Centre filter, then half a bin below and above for tracking
+static void tune(tone_morse_t *tm, float hz) {
+    const float half_bin = 0.5f * (float)tm->cfg.sample_rate / (float)tm->block;
+    tm->freq_hz = hz;
+    tm->coef[0] = goertzel_coef(hz, tm->cfg.sample_rate);
+    tm->coef[1] = goertzel_coef(hz - half_bin, tm->cfg.sample_rate);
+    tm->coef[2] = goertzel_coef(hz + half_bin, tm->cfg.sample_rate);
+}
+
+int tone_morse_init(tone_morse_t *tm, const tone_morse_config_t *cfg) {
+    memset(tm, 0, sizeof(*tm));
+    if (cfg) {
+        tm->cfg = *cfg;
+    } else {
+        tone_morse_default_config(&tm->cfg);
+    }
+    const tone_morse_config_t *c = &tm->cfg;
+    const uint32_t block = (uint32_t)((uint64_t)c->sample_rate * c->block_us / 1000000u);
+    const float nyquist = 0.5f * (float)c->sample_rate;
+    float lo = c->tone_hz, hi = c->tone_hz;
+    if (c->track) {
+        lo -= c->track_range_hz;
+        hi += c->track_range_hz;
+    }
+    if (block < 8 || block > TONE_MORSE_MAX_BLOCK || lo < TONE_MIN_HZ ||
+        hi > nyquist - TONE_MIN_HZ) {
+        return -1;
+    }
+    tm->block = (uint16_t)block;
+    tm->filters = c->track ? TONE_MORSE_FILTERS : 1;
+    tm->unit_us = c->unit_us;
+    tm->gaps_sent = 2;      // nothing to terminate yet
+    tune(tm, c->tone_hz);
+    return 0;
+}
+
+static void emit(tone_morse_t *tm, char symbol, char letter, const char *code,
+                 uint32_t start, uint32_t now) {
+    if (!tm->cfg.on_event) return;
+    tone_morse_event_t ev = { symbol, letter, code, start, now - start };
+    tm->cfg.on_event(&ev, tm->cfg.ctx);
+}
+
+// Amplitude of the tone seen by filter f over the last block, in PCM counts
+static uint32_t block_level(tone_morse_t *tm, unsigned f) {
+    const int64_t s1 = tm->s1[f], s2 = tm->s2[f];
+    int64_t p = s1 * s1 + s2 * s2 - ((tm->coef[f] * s1) >> 14) * s2;
+    tm->s1[f] = tm->s2[f] = 0;
+    if (p <= 0) return 0;
+    // |X| = sqrt(p); a sine of amplitude A gives |X| = A * N / 2
+    return (uint32_t)(((uint64_t)fft_isqrt64((uint64_t)p) << (INPUT_SHIFT + 1)) / tm->block);
+}
+
+// Follow the tone: parabola through the three filter levels
+static void track(tone_morse_t *tm, const uint32_t *lv) {
+    const float c = (float)lv[0], lo = (float)lv[1], hi = (float)lv[2];
+    const float den = 2.0f * c - lo - hi;
+    if (den <= 0.0f) return;
+    float d = 0.5f * (hi - lo) / den;      // in half bins
+    if (d > 1.0f) d = 1.0f;
+    if (d < -1.0f) d = -1.0f;
+    const float half_bin = 0.5f * (float)tm->cfg.sample_rate / (float)tm->block;
+    float hz = tm->freq_hz + 0.5f * d * half_bin;
+    const float min_hz = tm->cfg.tone_hz - tm->cfg.track_range_hz;
+    const float max_hz = tm->cfg.tone_hz + tm->cfg.track_range_hz;
+    if (hz < min_hz) hz = min_hz;
+    if (hz > max_hz) hz = max_hz;
+    if (fabsf(hz - tm->freq_hz) >= 0.5f) tune(tm, hz);
+}
+
+static uint32_t clamp_unit(uint32_t u) {
+    if (u < UNIT_US_MIN) return UNIT_US_MIN;
+    if (u > UNIT_US_MAX) return UNIT_US_MAX;
+    return u;
+}
+
+// Remember a mark or space length and re-estimate the unit from the
+// shortest ones: dots and the spaces inside letters are both 1 unit, and
+// nearly every stretch of Morse has some of either. Dots alone would not
+// do: a long run of dashes would look like slow dots.
+static void learn(tone_morse_t *tm, uint32_t len) {
+    tm->hist_us[tm->hist_pos] = len;
+    tm->hist_pos = (uint8_t)((tm->hist_pos + 1) % TONE_MORSE_HISTORY);
+    if (tm->hist_len < TONE_MORSE_HISTORY) tm->hist_len++;
+    if (tm->hist_len < HISTORY_MIN) return;
+
+    // Third shortest rather than the shortest, so that a single noise
+    // dropout inside a mark does not halve the unit
+    uint32_t low[3] = { UINT32_MAX, UINT32_MAX, UINT32_MAX };
+    for (unsigned i = 0; i < tm->hist_len; i++) {
+        uint32_t v = tm->hist_us[i];
+        for (unsigned k = 0; k < 3; k++) {
+            if (v < low[k]) {
+                uint32_t t = low[k];
+                low[k] = v;
+                v = t;
+            }
+        }
+    }
+    const uint32_t min = low[2];
+    // Average everything within 1.5x of the shortest, i.e. the 1-unit cluster
+    uint32_t sum = 0, count = 0;
+    for (unsigned i = 0; i < tm->hist_len; i++) {
+        if (tm->hist_us[i] <= min + min / 2 && tm->hist_us[i] >= min / 2) {
+            sum += tm->hist_us[i];
+            count++;
+        }
+    }
+    tm->unit_us = clamp_unit(sum / count);
+}
+
+static void mark_done(tone_morse_t *tm, uint32_t start, uint32_t len) {
+    const bool dash = len >= DASH_MIN_UNITS * tm->unit_us;
+    learn(tm, len);
+    if (tm->code_len < TONE_MORSE_MAX_CODE) {
+        tm->code[tm->code_len++] = dash ? TONE_MORSE_DASH : TONE_MORSE_DOT;
+        tm->code[tm->code_len] = '\0';
+    }
+    tm->marks++;
+    emit(tm, dash ? TONE_MORSE_DASH : TONE_MORSE_DOT, 0, "", start, start + len);
+}
+
+static void end_block(tone_morse_t *tm) {
+    uint32_t lv[TONE_MORSE_FILTERS];
+    uint32_t level = 0;
+    for (unsigned f = 0; f < tm->filters; f++) {
+        lv[f] = block_level(tm, f);
+        if (lv[f] > level) level = lv[f];
+    }
+    const uint32_t start_us = (uint32_t)(tm->samples * 1000000u / tm->cfg.sample_rate);
+    tm->samples += tm->block;
+    tm->fill = 0;
+    const uint32_t now = (uint32_t)(tm->samples * 1000000u / tm->cfg.sample_rate);
+    tm->level = level;
+
+    // AGC thresholds between the noise floor and the key-down level
+    const uint32_t l8 = level << 8;
+    if (tm->samples == tm->block) {
+        tm->floor_q8 = tm->peak_q8 = l8;
+        tm->edge_us = start_us;
+    }
+    const uint32_t floor = tm->floor_q8;
+    const uint32_t span = tm->peak_q8 > floor ? tm->peak_q8 - floor : 0;
+    const uint32_t min8 = (uint32_t)tm->cfg.min_level << 8;
+    uint32_t on = floor + span / 2, off = floor + span / 3;
+    if (on < floor * tm->cfg.min_snr) on = floor * tm->cfg.min_snr;
+    if (off < floor * tm->cfg.min_snr / 2) off = floor * tm->cfg.min_snr / 2;
+    if (on < min8) on = min8;
+    if (off < min8 / 2) off = min8 / 2;
+
+    const bool raw = tm->key_down ? (l8 >= off) : (l8 > on);
+
+    if (raw) {
+        if (l8 > tm->peak_q8) {
+            tm->peak_q8 = l8;
+        } else if (tm->key_down) {
+            tm->peak_q8 -= (tm->peak_q8 - l8) >> 3;
+        }
+        if (tm->key_down && tm->filters > 1) track(tm, lv);
+    } else {
+        // Noise floor: quick to fall, slow to rise
+        if (l8 < floor) {
+            tm->floor_q8 -= (floor - l8) >> 2;
+        } else {
+            tm->floor_q8 += (l8 - floor) >> 5;
+        }
+        if (tm->peak_q8 > tm->floor_q8) tm->peak_q8 -= (tm->peak_q8 - tm->floor_q8) >> 9;
+    }
+
+    // Debounced key, edges dated to the block where the change started
+    if (raw == tm->key_down) {
+        tm->pending = false;
+    } else {
+        if (!tm->pending) {
+            tm->pending = true;
+            tm->pending_us = start_us;
+        }
+        // Changes shorter than a quarter unit are noise at any speed
+        uint32_t debounce = tm->unit_us / 4;
+        if (debounce < tm->cfg.debounce_us) debounce = tm->cfg.debounce_us;
+        if (now - tm->pending_us >= debounce) {
+            const uint32_t start = tm->edge_us, edge = tm->pending_us;
+            tm->key_down = raw;
+            tm->pending = false;
+            tm->edge_us = edge;
+            if (!raw) {
+                tm->gaps_sent = 0;
+                tm->have_mark = true;
+                mark_done(tm, start, edge - start);
+            } else if (tm->have_mark) {
+                learn(tm, edge - start);    // space before this mark
+            }
+            return;
+        }
+    }
+
+    // Key up: report gaps once they are long enough
+    if (!tm->key_down && tm->have_mark && tm->gaps_sent < 2) {
+        const uint32_t t = tm->pending ? tm->pending_us : now;
+        const uint32_t len = t - tm->edge_us;
+        if (tm->gaps_sent == 0 && len >= LETTER_GAP_MIN_UNITS * tm->unit_us) {
+            tm->gaps_sent = 1;
+            char letter = tm->code_len && tm->cfg.decode ? tm->cfg.decode(tm->code) : 0;
+            if (tm->code_len) tm->letters++;
+            emit(tm, TONE_MORSE_LETTER_GAP, letter, tm->code, tm->edge_us, t);
+            tm->code_len = 0;
+            tm->code[0] = '\0';
+        } else if (tm->gaps_sent == 1 && len >= WORD_GAP_MIN_UNITS * tm->unit_us) {
+            tm->gaps_sent = 2;
+            tm->have_mark = false;
+            emit(tm, TONE_MORSE_WORD_GAP, 0, "", tm->edge_us, t);
+        }
+    }
+}
+
+void tone_morse_process(tone_morse_t *tm, const int16_t *pcm, size_t n) {
+    const unsigned filters = tm->filters;
+    for (size_t i = 0; i < n; i++) {
+        const int32_t x = pcm[i] >> INPUT_SHIFT;
+        for (unsigned f = 0; f < filters; f++) {
+            const int32_t s0 = x + mul_q14(tm->coef[f], tm->s1[f]) - tm->s2[f];
+            tm->s2[f] = tm->s1[f];
+            tm->s1[f] = s0;
+        }
+        if (++tm->fill == tm->block) end_block(tm);
+    }
+}
+
+void tone_morse_get_status(const tone_morse_t *tm, tone_morse_status_t *out) {
+    out->tone_hz = tm->freq_hz;
+    out->unit_us = tm->unit_us;
+    out->wpm = tm->unit_us ? 1200000.0f / (float)tm->unit_us : 0.0f;
+    out->level = tm->level;
+    out->noise_floor = tm->floor_q8 >> 8;
+    out->peak = tm->peak_q8 >> 8;
+    out->key_down = tm->key_down;
+    out->marks = tm->marks;
+    out->letters = tm->letters;
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -8,9 +9,11 @@ extern "C" {
 
 /**
  * @file helper.h
- * @brief USB logging helpers for CDC0 (TinyUSB + FreeRTOS).
+ * @brief USB logging helpers for CDC0 and a binary writer for CDC1 (TinyUSB + FreeRTOS).
  *
  * These helpers write directly to CDC interface 0 using TinyUSB.
+ * ::usb_serial_data_write() sends application data (e.g. an audio stream)
+ * on CDC interface 1 so that it does not mix with the logs.
  * They are thread-safe (use a mutex internally) and designed to avoid
  * blocking forever. Do not call them from ISRs or TinyUSB callbacks.
  *
@@ -78,6 +81,32 @@ bool usb_serial_connected(void);
  */
 int usb_serial_print(const char *s);
 
+/**
+ * @brief Check whether the host has opened CDC1 (DTR set).
+ *
+ * @return @c true if the host opened CDC1; @c false otherwise.
+ */
+bool usb_serial_data_connected(void);
+
+/**
+ * @brief Thread-safe write of binary data to CDC1.
+ *
+ * Writes @p len bytes to USB CDC interface 1 and flushes them. Waits for TX
+ * space for at most 50 ms in total, so a slow or closed host port cannot
+ * stall the caller.
+ *
+ * @param data Bytes to send. Must not be @c NULL.
+ * @param len  Number of bytes.
+ *
+ * @return Number of bytes written (may be less than @p len on timeout),
+ *         0 if CDC1 is not open, or -1 if @p data is @c NULL.
+ *
+ * @note Do not call from ISRs or TinyUSB callbacks.
+ * @note Matches audio_stream_write_fn (tkjhat/audio_stream.h) when wrapped, e.g.
+ *       `static int w(const void *d, size_t n, void *c) { return usb_serial_data_write(d, n); }`
+ */
+int usb_serial_data_write(const void *data, size_t len);
+
 
 #ifdef __cplusplus
 }
@@ -8,17 +8,25 @@
 #include "usbSerialDebug/helper.h"
 
 static SemaphoreHandle_t g_log_mtx;
+static SemaphoreHandle_t g_data_mtx;
 static const TickType_t wait = pdMS_TO_TICKS(5);
 static const TickType_t io_timeout = pdMS_TO_TICKS(10);
+static const TickType_t data_timeout = pdMS_TO_TICKS(50);
+
+#define CDC_ITF_DATA 1
 
 static inline bool cdc0_ready(void) {
     return tud_mounted() && tud_cdc_n_connected(0);
 }
 
-static SemaphoreHandle_t g_log_mtx;
+static inline bool cdc1_ready(void) {
+    return tud_mounted() && tud_cdc_n_connected(CDC_ITF_DATA);
+}
+
 bool usb_serial_init(void) {
     g_log_mtx = xSemaphoreCreateMutex();
-    return g_log_mtx != NULL;
+    g_data_mtx = xSemaphoreCreateMutex();
+    return g_log_mtx != NULL && g_data_mtx != NULL;
 }
 
 
@@ -73,4 +81,44 @@ int usb_serial_print(const char *s) {
     }
     xSemaphoreGive(g_log_mtx);
     return initial-n;
-}
\ No newline at end of file
+}
+
+bool usb_serial_data_connected(void) {
+    return cdc1_ready();
+}
+
+int usb_serial_data_write(const void *data, size_t len) {
+    if (!data) {
+        return -1;
+    }
+    if (!cdc1_ready())
+        return 0;
+
+    if (xSemaphoreTake(g_data_mtx, wait) != pdTRUE)
+        return 0;
+
+    const uint8_t *p = data;
+    size_t left = len;
+    TickType_t deadline = xTaskGetTickCount() + data_timeout;
+
+    while (left) {
+        uint32_t avail = tud_cdc_n_write_available(CDC_ITF_DATA);
+        if (avail) {
+            uint32_t chunk = (left < avail) ? (uint32_t)left : avail;
+            tud_cdc_n_write(CDC_ITF_DATA, p, chunk);
+            p += chunk;
+            left -= chunk;
+        }
+        else {
+            // Buffer full: push it out and give the USB task time to send
+            tud_cdc_n_write_flush(CDC_ITF_DATA);
+            if ((int32_t)(xTaskGetTickCount() - deadline) >= 0 || !cdc1_ready()) {
+                break;
+            }
+            vTaskDelay(pdMS_TO_TICKS(1));
+        }
+    }
+    tud_cdc_n_write_flush(CDC_ITF_DATA);
+    xSemaphoreGive(g_data_mtx);
+    return (int)(len - left);
+}
@@ -10,6 +10,12 @@
 #include <queue.h>          // FreeRTOS queues for safe task communication
 #include <task.h>           // FreeRTOS task creation and management
 #include "tkjhat/sdk.h"     // JTKJ Hat SDK (LEDs, buttons, display, buzzer)
+#include "tkjhat/sensor_hub.h" // One task samples the HAT sensors on a schedule
+#include "tkjhat/mahony.h"     // Gyro + accel orientation filter
+#include "tkjhat/tilt_morse.h" // Tilt duration -> dot/dash/gap classifier
+#include "tkjhat/mic_stream.h" // Microphone PCM on a DSP task
+#include "tkjhat/tone_morse.h" // Buzzer tone -> Morse receiver
+#include "tkjhat/spectrum.h"   // FFT cycle benchmark (.fft)
 #include <ctype.h>          // Character handling (toupper, isdigit, etc.)v
 
 // -------------------- Constants --------------------
@@ -17,6 +23,8 @@
 #define DEFAULT_STACK_SIZE 2048
 #define CDC_ITF_TX         1
 #define UNIT               200   // base Morse timing unit in ms
+#define MORSE_TONE_HZ      1000  // buzzer pitch of dots and dashes, also what the microphone listens for
+#define MUTE_TAIL_MS       200   // microphone stays muted this long after our own buzzer (mic path latency)
 
 // Morse timing units
 #define DOT_UNITS          1
@@ -24,12 +32,15 @@
 #define LETTER_GAP         3
 #define WORD_GAP           7
 
-// Angle threshold for deciding dot/dash
-#define ANGLE_THRESHOLD    10.0f
+#define SENSOR_PERIOD_MS   10    // IMU sample period on the sensor hub (100 Hz)
+#define TILT_KP            1.0f  // orientation filter gains (imu_fusion defaults)
+#define TILT_KI            0.02f
+#define DEG_PER_RAD        57.29577951f
 
 // Task priorities (higher = more important)
 #define PRIORITY_SENSOR    3
 #define PRIORITY_RECEIVE   2
+#define PRIORITY_AUDIO     2
 #define PRIORITY_PRINT     1
 
 // -------------------- Enums --------------------
@@ -89,23 +100,26 @@ char from_morse(const char* code);
 /** Decode Morse string into ASCII output */
 void decode_from_morse(const char* morse_input, char* output_buffer);
 
-/** Convert pitch angle to Morse symbol */
-char morse_from_angle(float angle);
-
 /** Play buzzer theme */
 void play_theme(void);
 
 /** Print Morse string to OLED, LED, and buzzer */
 void print_morse_output(void);
 
-/** Calculate pitch from accelerometer data */
-float calculate_pitch(float ax, float ay, float az);
-
 /** Button interrupt handler */
 static void btn_fxn(uint gpio, uint32_t eventMask);
 
-/** Sensor task: reads accelerometer and sends Morse symbols */
-static void sensor_task(void *arg);
+/** Start the IMU and the sensor hub that samples it */
+static void start_sensors(void);
+
+/** Sensor hub callback: fuses each IMU sample and sends Morse symbols */
+static void imu_sample(sensor_hub_sensor_t sensor, void *ctx);
+
+/** Print sampling jitter and stack use of the sensor hub */
+static void print_sensor_stats(void);
+
+/** Print the CPU cycles of the FFT building blocks on this board */
+static void print_fft_bench(void);
 
 /** Receive task: handles user input (ASCII or Morse) */
 void receive_task(void *arg);
@@ -190,22 +204,29 @@ void decode_from_morse(const char* morse_input, char* output_buffer) {
     output_buffer[out_index] = '\0'; // Null-terminate final string
 }
 
-// Convert IMU pitch angle to Morse symbol (Tier 1)
-char morse_from_angle(float angle) {
-    if (angle > ANGLE_THRESHOLD) return '-';   // Dash for positive tilt
-    else if (angle < -ANGLE_THRESHOLD) return '.'; // Dot for negative tilt
-    else return ' ';                           // Neutral, no symbol
+// Set while our own buzzer plays, so the audio receiver does not decode it
+static volatile bool transmitting = false;
+static volatile TickType_t transmit_end;
+
+// Audio receive task, woken by btn_fxn() on entering DECODING mode
+static TaskHandle_t audio_task;
+
+// Tone from the buzzer PWM; the task sleeps instead of toggling the pin
+static void play_tone(uint32_t frequency, uint32_t duration_ms) {
+    buzzer_tone_start(frequency);
+    vTaskDelay(pdMS_TO_TICKS(duration_ms));
+    buzzer_tone_stop();
 }
 
 // Play a short buzzer melody Tier2
 void play_theme(void) {
-    buzzer_play_tone(659, 150); vTaskDelay(pdMS_TO_TICKS(50));
-    buzzer_play_tone(784, 150); vTaskDelay(pdMS_TO_TICKS(50));
-    buzzer_play_tone(880, 150); vTaskDelay(pdMS_TO_TICKS(100));
-    buzzer_play_tone(1046, 200); vTaskDelay(pdMS_TO_TICKS(100));
-    buzzer_play_tone(880, 150); vTaskDelay(pdMS_TO_TICKS(50));
-    buzzer_play_tone(784, 150); vTaskDelay(pdMS_TO_TICKS(50));
-    buzzer_play_tone(659, 300);
+    play_tone(659, 150); vTaskDelay(pdMS_TO_TICKS(50));
+    play_tone(784, 150); vTaskDelay(pdMS_TO_TICKS(50));
+    play_tone(880, 150); vTaskDelay(pdMS_TO_TICKS(100));
+    play_tone(1046, 200); vTaskDelay(pdMS_TO_TICKS(100));
+    play_tone(880, 150); vTaskDelay(pdMS_TO_TICKS(50));
+    play_tone(784, 150); vTaskDelay(pdMS_TO_TICKS(50));
+    play_tone(659, 300);
 }
 
 // Send a string to the other Pico via UART (Tier 3)
@@ -218,6 +239,7 @@ void send_string_to_pico(const char *msg) {
 }
 // Print Morse string to OLED, LED, and buzzer (Tier 2)
 void print_morse_output(void) {
+   transmitting = true;                            // Mute the audio receiver (see audio_receive_task)
    if ((rand() % 3) == 0)  play_theme();
     printf("\nMorse word: %s\n", morse_string);
     clear_display();
@@ -225,21 +247,23 @@ void print_morse_output(void) {
 
  for (int i = 0; morse_string[i] != '\0'; i++) {                    // Loop through each Morse symbol in the string
     if (morse_string[i] == '.') {
-        toggle_led(); vTaskDelay(pdMS_TO_TICKS(UNIT * DOT_UNITS)); // LED on for dot duration
+        toggle_led(); play_tone(MORSE_TONE_HZ, UNIT * DOT_UNITS);   // LED and buzzer on for dot duration
         toggle_led(); vTaskDelay(pdMS_TO_TICKS(UNIT));             // Quick LED off break
     } else if (morse_string[i] == '-') {
-        toggle_led(); vTaskDelay(pdMS_TO_TICKS(UNIT * DASH_UNITS)); // LED on for dash duration
+        toggle_led(); play_tone(MORSE_TONE_HZ, UNIT * DASH_UNITS);  // LED and buzzer on for dash duration
         toggle_led(); vTaskDelay(pdMS_TO_TICKS(UNIT));              // Quick LED off break
     } else if (morse_string[i] == ' ') {
-        vTaskDelay(pdMS_TO_TICKS(UNIT * (WORD_GAP - 1)));          // Longer delay for space between words
+        // One space ends a letter, two or more end a word (same as decode_from_morse)
+        int spaces = 1;
+        while (morse_string[i + 1] == ' ') { spaces++; i++; }
+        int gap = (spaces == 1) ? LETTER_GAP : WORD_GAP;
+        vTaskDelay(pdMS_TO_TICKS(UNIT * (gap - 1)));               // Symbol break already took one unit
     }
     }
+    transmit_end = xTaskGetTickCount();
+    transmitting = false;
 }
 
-// Calculate pitch angle from accelerometer readings Tier1
-float calculate_pitch(float ax, float ay, float az) {
-    return atan2f(ax, sqrtf(ay * ay + az * az)) * 180.0f / M_PI; // Convert to degrees
-}
 // -------------------- Button Interrupt Handler -------------------- (Tier 2 and 3)
 // Handles BUTTON1 and BUTTON2 presses 
 static void btn_fxn(uint gpio, uint32_t eventMask) {
@@ -293,6 +317,11 @@ static void btn_fxn(uint gpio, uint32_t eventMask) {
             } else if (programMode == RECEIVING) {
                 programMode = DECODING;
                 printf("Now decoding, use Morse\n");
+                if (audio_task != NULL) {                /* Start listening on the microphone */
+                    BaseType_t woken = pdFALSE;
+                    vTaskNotifyGiveFromISR(audio_task, &woken);
+                    portYIELD_FROM_ISR(woken);
+                }
             } else if (programMode == DECODING) {
                 uartMode = ON;
                 programMode = SENDING;
@@ -306,36 +335,109 @@ static void btn_fxn(uint gpio, uint32_t eventMask) {
         }
     }
 
-// -------------------- Sensor Task --------------------
+// -------------------- Sensor Hub --------------------
+// The sensor hub task reads the IMU every SENSOR_PERIOD_MS on an absolute
+// schedule. imu_sample() runs on that task right after each sample, so the
+// filter and the keyer see every sample exactly once. Keep it short and
+// don't print from it: the hub's next read waits for it.
+static mahony_q30_t tilt_filter;
+static tilt_morse_t keyer;
+static volatile uint32_t symbols_dropped;          // queue was full
+
+// Initializes the IMU and starts the sensor hub (TASK 1)
+static void start_sensors(void) {
+    if (init_ICM42670() != 0) {
+        printf("Failed to initialize ICM-42670P.\n");
+        return;
+    }
+    printf("ICM-42670P initialized successfully!\n");
+    if (ICM42670_start_with_default_values() != 0) {
+        printf("ICM-42670P could not initialize accelerometer or gyroscope\n");
+    }
+    // Use the stored bias/scale so the pitch threshold is not skewed
+    if (ICM42670_calibration_load() != 0) {
+        printf("No IMU calibration stored, using raw data\n");
+    }
 
-// Reads IMU, calculates pitch, and sends Morse symbols (TASK 1)
-static void sensor_task(void *arg) {
-    (void)arg;
-    float ax, ay, az, gx, gy, gz, temp;
+    // Fused orientation is much steadier than one accelerometer sample
+    mahony_q30_init(&tilt_filter, TILT_KP, TILT_KI, 1000 / SENSOR_PERIOD_MS,
+                    ICM42670_get_config()->gRes);
+
+    // How long the board is held tilted decides dot/dash and the gaps
+    tilt_morse_config_t keyer_cfg;
+    tilt_morse_default_config(&keyer_cfg);
+    keyer_cfg.unit_us = UNIT * 1000;
+    tilt_morse_init(&keyer, &keyer_cfg);
+
+    // Only the IMU is used here; the hub is the only one on its I2C bus
+    sensor_hub_config_t cfg;
+    sensor_hub_default_config(&cfg);
+    cfg.channel[SENSOR_HUB_IMU].period_ms = SENSOR_PERIOD_MS;
+    cfg.channel[SENSOR_HUB_LIGHT].enabled = false;
+    cfg.channel[SENSOR_HUB_ENV].enabled = false;
+    cfg.priority = PRIORITY_SENSOR;
+    cfg.on_sample = imu_sample;
+    if (sensor_hub_start(&cfg) != 0) {
+        printf("Could not start the sensor hub\n");
+    }
+}
 
-    // Initialize ICM-42670 sensor
-    if (init_ICM42670() == 0) {
-        printf("ICM-42670P initialized successfully!\n");
-        if (ICM42670_start_with_default_values() != 0) {
-            printf("ICM-42670P could not initialize accelerometer or gyroscope\n");
+static void imu_sample(sensor_hub_sensor_t sensor, void *ctx) {
+    (void)ctx;
+    sensor_hub_imu_t s;
+    if (sensor != SENSOR_HUB_IMU || !sensor_hub_get_imu(&s)) return;
+    mahony_q30_update(&tilt_filter, s.raw.gx, s.raw.gy, s.raw.gz, s.raw.ax, s.raw.ay, s.raw.az);
+    if (programMode != SENDING) return;
+
+    // Pitch of the Q30 quaternion (w, x, y, z)
+    const float k = 1.0f / (float)(1 << 30);
+    float w = tilt_filter.q[0] * k, x = tilt_filter.q[1] * k;
+    float y = tilt_filter.q[2] * k, z = tilt_filter.q[3] * k;
+    float sp = 2.0f * (w * y - z * x);
+    if (sp > 1.0f) sp = 1.0f;
+    if (sp < -1.0f) sp = -1.0f;
+    float pitch = asinf(sp) * DEG_PER_RAD;
+
+    tilt_morse_event_t ev;
+    if (tilt_morse_update(&keyer, pitch, (uint32_t)s.timestamp_us, &ev)) {
+        if (xQueueSend(morseQueue, &ev.symbol, 0) != pdPASS) {
+            symbols_dropped++;                      // print_task is behind; see .stats
         }
-    } else {
-        printf("Failed to initialize ICM-42670P.\n");
     }
+}
 
-    for (;;) {
-        if (programMode == SENDING) {
-            ICM42670_read_sensor_data(&ax, &ay, &az, &gx, &gy, &gz, &temp); // Read sensor
-            float pitch = calculate_pitch(ax, ay, az);                       // Calculate tilt
-            char symbol = morse_from_angle(pitch);                          // Convert to dot/dash
-            printf("Pitch: %.2f  Symbol: %c\n", pitch, symbol);
-
-            // Send symbol to queue (with timeout)
-            if (xQueueSend(morseQueue, &symbol, pdMS_TO_TICKS(100)) != pdPASS) {
-                printf("Queue full, symbol dropped\n");  // Queue overflow
-            }
+// Sampling jitter and stack use of the sensor hub (USB command .stats)
+static void print_sensor_stats(void) {
+    sensor_hub_stats_t st;
+    sensor_hub_get_stats(&st);
+    const sensor_hub_channel_stats_t *c = &st.channel[SENSOR_HUB_IMU];
+    printf("IMU: %lu samples, %lu errors, %lu late, %lu skipped\n",
+           (unsigned long)c->samples, (unsigned long)c->errors,
+           (unsigned long)c->deadline_misses, (unsigned long)c->skipped);
+    printf("IMU jitter: avg %lu us, max %lu us; read max %lu us\n",
+           (unsigned long)c->jitter_us_avg, (unsigned long)c->jitter_us_max,
+           (unsigned long)c->read_us_max);
+    printf("Sensor hub stack: %lu of %lu words used\n",
+           (unsigned long)(st.stack_words - st.stack_free_min_words),
+           (unsigned long)st.stack_words);
+    printf("Symbols dropped: %lu\n", (unsigned long)symbols_dropped);
+}
+
+// Cycles of the FFT blocks of the spectrum task (USB command .fft)
+static void print_fft_bench(void) {
+    static const unsigned sizes[] = {256, 512};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        spectrum_bench_t b;
+        if (spectrum_benchmark(sizes[i], &b) != 0) {
+            printf("FFT %u: benchmark failed\n", sizes[i]);
+            continue;
         }
-        vTaskDelay(pdMS_TO_TICKS(500)); // Wait before next reading
+        printf("FFT %u at %lu MHz, cycles: Q15 window %lu rfft %lu cfft %lu mag %lu\n",
+               b.size, (unsigned long)(b.cpu_hz / 1000000), (unsigned long)b.window_q15,
+               (unsigned long)b.rfft_q15, (unsigned long)b.cfft_q15, (unsigned long)b.magnitude_q15);
+        printf("FFT %u Q31 window %lu rfft %lu cfft %lu mag %lu\n", b.size,
+               (unsigned long)b.window_q31, (unsigned long)b.rfft_q31, (unsigned long)b.cfft_q31,
+               (unsigned long)b.magnitude_q31);
     }
 }
 
@@ -365,6 +467,10 @@ void receive_task(void *arg) {
                         printf("\x1b[2J\x1b[H"); // ANSI clear
                         usb_index = 0;
                         input_buffer[0] = '\0';
+                    } else if (strcmp(input_buffer, ".stats") == 0) {
+                        print_sensor_stats();
+                    } else if (strcmp(input_buffer, ".fft") == 0) {
+                        print_fft_bench();
                     } else if (strcmp(input_buffer, ".exit") == 0) {
                         printf("Exiting program...\n");
                         vTaskEndScheduler(); // attempt to stop FreeRTOS
@@ -504,14 +610,16 @@ static void print_task(void *arg) {
     for (;;) {
         if (xQueueReceive(morseQueue, &symbol, portMAX_DELAY) && programMode == SENDING) {  // Wait for next Morse symbol
             if (programState == RUNNING) {       // Only record symbols when active
-                programState = WAITING;          // Reset state until next button press
                 int length = strlen(morse_string); // Current size of the Morse message
 
-                if (symbol != ' ') {             // If it's a dot or dash
-                    morse_string[length] = symbol;       // Add symbol to buffer
-                    morse_string[length + 1] = '\0';     // Close string properly
+                if (symbol != TILT_MORSE_WORD_GAP) { // Dot, dash or letter gap
+                    if (length + 2 < (int)sizeof(morse_string)) {
+                        morse_string[length] = symbol;       // Add symbol to buffer
+                        morse_string[length + 1] = '\0';     // Close string properly
+                    }
                     printf("Symbol: %c  Buffer: %s\n", symbol, morse_string); // Debug output
-                } else {                          // Space means "end of letter/word"
+                } else {                          // Word gap means "end of message"
+                    programState = WAITING;       // Wait for the next button press
                     if (length > 0 && uartMode != ON) {   // If not in USB→UART mode
                         print_morse_output();     // Show Morse on LED/OLED/buzzer
                     } else if (length > 0 && uartMode == ON) {  // If UART sending is active
@@ -525,6 +633,70 @@ static void print_task(void *arg) {
     }
 }
 
+// -------------------- Audio Receive Task --------------------
+// Listens for another board's buzzer Morse on the HAT microphone.
+// Letters are collected into a word and printed at each word gap, only in DECODING mode.
+// The microphone, its DSP task and the receiver run only in that mode.
+static char heard_word[32];
+static size_t heard_len;
+
+static void audio_morse_event(const tone_morse_event_t *ev, void *ctx) {
+    (void)ctx;
+    if (programMode != DECODING) {
+        heard_len = 0;                               // Ignore what is heard in other modes
+        return;
+    }
+    if (ev->symbol == TONE_MORSE_LETTER_GAP && ev->letter) {
+        if (heard_len < sizeof(heard_word) - 1) heard_word[heard_len++] = ev->letter;
+    } else if (ev->symbol == TONE_MORSE_WORD_GAP && heard_len > 0) {
+        heard_word[heard_len] = '\0';
+        printf("Heard: %s\n", heard_word);
+        heard_len = 0;
+    }
+}
+
+static void audio_receive_task(void *arg) {
+    (void)arg;
+    static tone_morse_t rx;                          // Goertzel filters and timing state
+    tone_morse_config_t cfg;
+    tone_morse_default_config(&cfg);
+    cfg.sample_rate = MEMS_SAMPLING_FREQUENCY;
+    cfg.tone_hz     = MORSE_TONE_HZ;
+    cfg.unit_us     = UNIT * 1000;                   // Start from our own speed, adapts to the sender
+    cfg.decode      = from_morse;                    // Same table as USB/UART decoding
+    cfg.on_event    = audio_morse_event;
+
+    if (init_pdm_microphone() != 0) {
+        printf("Audio Morse receiver not available\n");
+        vTaskDelete(NULL);
+    }
+    audio_task = xTaskGetCurrentTaskHandle();
+
+    int16_t pcm[MEMS_BUFFER_SIZE];
+    for (;;) {
+        while (programMode != DECODING) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+        // Fresh receiver timing and an empty word each time DECODING starts
+        heard_len = 0;
+        if (tone_morse_init(&rx, &cfg) != 0 || mic_stream_start(NULL) != 0) {
+            printf("Audio Morse receiver not available\n");
+            audio_task = NULL;
+            vTaskDelete(NULL);
+        }
+
+        // The 100 ms timeout notices the mode change
+        while (programMode == DECODING) {
+            size_t n = mic_stream_read(pcm, MEMS_BUFFER_SIZE, 100);
+            // Our own buzzer: feed silence instead, so the receiver keeps its timing
+            if (transmitting || xTaskGetTickCount() - transmit_end < pdMS_TO_TICKS(MUTE_TAIL_MS)) {
+                memset(pcm, 0, n * sizeof(pcm[0]));
+            }
+            tone_morse_process(&rx, pcm, n);
+        }
+        mic_stream_stop();                           // Sampling, DSP task and stream off
+    }
+}
 
 // -------------------- Main Function -------------------- (Tier 1,2,3)
 
@@ -557,14 +729,10 @@ if (morseQueue == NULL) {
     return 1;
 }
 
-TaskHandle_t hSensorTask, hPrintTask, hReceiveTask;  // Task handles for FreeRTOS
+TaskHandle_t hPrintTask, hReceiveTask, hAudioTask;  // Task handles for FreeRTOS
 
-// Create sensor task
-if (xTaskCreate(sensor_task, "sensor", DEFAULT_STACK_SIZE, NULL,
-                PRIORITY_SENSOR, &hSensorTask) != pdPASS) {
-    printf("Sensor task creation failed\n");
-    return 0;
-}
+// IMU and the sensor hub task that samples it (needs the queue)
+start_sensors();
 
 // Create print/output task
 if (xTaskCreate(print_task, "print", DEFAULT_STACK_SIZE, NULL,
@@ -580,6 +748,13 @@ if (xTaskCreate(receive_task, "receive", DEFAULT_STACK_SIZE, NULL,
     return 0;
 }
 
+// Create audio Morse receive task
+if (xTaskCreate(audio_receive_task, "audio_rx", DEFAULT_STACK_SIZE, NULL,
+                PRIORITY_AUDIO, &hAudioTask) != pdPASS) {
+    printf("Audio receive task creation failed\n");
+    return 0;
+}
+
 // Start FreeRTOS scheduler (this function never returns)
 vTaskStartScheduler();
 return 0; // Should never reach here
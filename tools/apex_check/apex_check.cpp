@@ -0,0 +1,176 @@
+// apex_check: register sequence of the ICM-42670 APEX driver
+// (ICM42670_apex_* in sdk.c) on host_pico against the Icm42670 model.
+//
+//   apex_check
+//
+// - Every wake-on-motion threshold from ICM42670_WOM_THRESHOLD_MIN to _MAX
+//   must land in the three MREG1 WOM_*_THR registers as round(mg * 256 /
+//   1000), without wrapping at the top of the range.
+// - Thresholds outside the range are refused before anything is written.
+// - The WOM enable and INT1 routing are checked after start and stop, and
+//   an INT1 pulse must wake ICM42670_apex_wait_events() with the latched
+//   events, while no pulse gives 0 after the timeout.
+// - Every INT_STATUS2 (SMD, WOM) and INT_STATUS3 (step, step overflow,
+//   tilt) bit must come back as its event and be cleared by the read. The
+//   model uses the datasheet addresses, so this checks the SDK's map.
+//
+// Prints one line per failed check; the exit code is 1 if any failed.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include "host_pico.h"
+#include "icm42670_model.hpp"
+
+namespace {
+
+namespace reg = model::icm42670_reg;
+
+int failures = 0;
+
+void check(bool ok, const char *what, long got, long want) {
+    if (!ok) {
+        std::printf("FAIL %s: got %ld, want %ld\n", what, got, want);
+        failures++;
+    }
+}
+
+icm42670_apex_config_t wom_config(uint16_t mg) {
+    icm42670_apex_config_t cfg{};
+    cfg.features = ICM42670_APEX_WOM;
+    cfg.wom_threshold_mg = mg;
+    return cfg;
+}
+
+void check_thresholds(model::Icm42670 &imu) {
+    for (unsigned mg = ICM42670_WOM_THRESHOLD_MIN; mg <= ICM42670_WOM_THRESHOLD_MAX; ++mg) {
+        icm42670_apex_config_t cfg = wom_config(uint16_t(mg));
+        int rc = ICM42670_apex_start(&cfg);
+        check(rc == 0, "apex_start in range", rc, 0);
+
+        const long want = std::lround(mg * 256.0 / 1000.0);
+        for (uint8_t r : {reg::MREG1_WOM_X_THR, reg::MREG1_WOM_Y_THR,
+                          reg::MREG1_WOM_Z_THR}) {
+            char what[48];
+            std::snprintf(what, sizeof(what), "WOM threshold %u mg (MREG1 0x%02X)", mg, r);
+            check(imu.mreg1(r) == want, what, imu.mreg1(r), want);
+        }
+    }
+    check(imu.mreg1(reg::MREG1_WOM_X_THR) == 255, "threshold at the top",
+          imu.mreg1(reg::MREG1_WOM_X_THR), 255);
+}
+
+void check_rejected(model::Icm42670 &imu) {
+    for (unsigned mg : {0u, 3u, 997u, 1000u, 1020u, 65535u}) {
+        imu.clear_log();
+        size_t mreg1_before = imu.mreg1_writes().size();
+        icm42670_apex_config_t cfg = wom_config(uint16_t(mg));
+        int rc = ICM42670_apex_start(&cfg);
+        char what[48];
+        std::snprintf(what, sizeof(what), "apex_start with %u mg", mg);
+        check(rc == -1, what, rc, -1);
+        check(imu.writes().empty() && imu.mreg1_writes().size() == mreg1_before,
+              "register writes after a refused threshold", long(imu.writes().size()), 0);
+    }
+    // The other features do not look at the threshold
+    icm42670_apex_config_t cfg{};
+    cfg.features = ICM42670_APEX_TILT;
+    cfg.wom_threshold_mg = 2000;
+    int rc = ICM42670_apex_start(&cfg);
+    check(rc == 0, "tilt only, threshold ignored", rc, 0);
+    check(imu.reg(reg::WOM_CONFIG) == 0, "WOM_CONFIG without WOM",
+          imu.reg(reg::WOM_CONFIG), 0);
+}
+
+void check_events(model::Icm42670 &imu) {
+    icm42670_apex_config_t cfg = wom_config(ICM42670_WOM_THRESHOLD_DEFAULT);
+    int rc = ICM42670_apex_start(&cfg);
+    check(rc == 0, "apex_start", rc, 0);
+    check(imu.reg(reg::WOM_CONFIG) == 0x03, "WOM_CONFIG (previous sample, enabled)",
+          imu.reg(reg::WOM_CONFIG), 0x03);
+    check(imu.reg(reg::INT_SOURCE1) == 0x07, "INT_SOURCE1 (WOM X/Y/Z on INT1)",
+          imu.reg(reg::INT_SOURCE1), 0x07);
+
+    // Motion on X and Z 20 ms after the task starts waiting
+    struct Pulse {
+        model::Icm42670 *imu;
+        uint64_t at_us;
+    } pulse{&imu, time_us_64() + 20000};
+    host_add_tick_hook([](void *ctx, uint64_t now) {
+        auto *p = static_cast<Pulse *>(ctx);
+        if (p->at_us && now >= p->at_us) {
+            p->at_us = 0;
+            p->imu->raise(0x05, 0);
+        }
+    }, &pulse);
+
+    uint64_t t0 = time_us_64();
+    rc = ICM42670_apex_wait_events(1000);
+    long waited_ms = long((time_us_64() - t0) / 1000);
+    check(rc == (ICM42670_EVT_WOM_X | ICM42670_EVT_WOM_Z), "events after the pulse", rc,
+          ICM42670_EVT_WOM_X | ICM42670_EVT_WOM_Z);
+    check(waited_ms >= 20 && waited_ms <= 21, "ms until woken", waited_ms, 20);
+
+    // Nothing more latched: the full timeout, then 0
+    t0 = time_us_64();
+    rc = ICM42670_apex_wait_events(50);
+    waited_ms = long((time_us_64() - t0) / 1000);
+    check(rc == 0, "events without a pulse", rc, 0);
+    check(waited_ms == 50, "ms until timeout", waited_ms, 50);
+
+    rc = ICM42670_apex_stop();
+    check(rc == 0, "apex_stop", rc, 0);
+    check(imu.reg(reg::WOM_CONFIG) == 0, "WOM_CONFIG after stop",
+          imu.reg(reg::WOM_CONFIG), 0);
+    check(imu.reg(reg::INT_SOURCE1) == 0, "INT_SOURCE1 after stop",
+          imu.reg(reg::INT_SOURCE1), 0);
+}
+
+void check_status_map(model::Icm42670 &imu) {
+    const struct { uint8_t status2, status3; int event; const char *name; } bits[] = {
+        {0x01, 0, ICM42670_EVT_WOM_X, "WOM X"},
+        {0x02, 0, ICM42670_EVT_WOM_Y, "WOM Y"},
+        {0x04, 0, ICM42670_EVT_WOM_Z, "WOM Z"},
+        {0x08, 0, ICM42670_EVT_SMD, "SMD"},
+        {0, 0x08, ICM42670_EVT_TILT, "tilt"},
+        {0, 0x10, ICM42670_EVT_STEP_OVERFLOW, "step overflow"},
+        {0, 0x20, ICM42670_EVT_STEP, "step"},
+    };
+    // FIFO_COUNTH follows INT_STATUS3 and must not be taken for it
+    imu.set_reg(reg::FIFO_COUNTH, 0xFF);
+    for (const auto &b : bits) {
+        imu.raise(b.status2, b.status3);
+        int rc = ICM42670_apex_read_events();
+        char what[48];
+        std::snprintf(what, sizeof(what), "%s event", b.name);
+        check(rc == b.event, what, rc, b.event);
+        std::snprintf(what, sizeof(what), "%s status left latched", b.name);
+        const long left = imu.reg(reg::INT_STATUS2) | imu.reg(reg::INT_STATUS3);
+        check(left == 0, what, left, 0);
+    }
+    imu.raise(0x0F, 0x38);
+    const int all = ICM42670_EVT_WOM_X | ICM42670_EVT_WOM_Y | ICM42670_EVT_WOM_Z |
+                    ICM42670_EVT_SMD | ICM42670_EVT_TILT | ICM42670_EVT_STEP_OVERFLOW |
+                    ICM42670_EVT_STEP;
+    int rc = ICM42670_apex_read_events();
+    check(rc == all, "all events at once", rc, all);
+    check(ICM42670_apex_read_events() == 0, "events after the status was read", 1, 0);
+}
+
+} // namespace
+
+int main() {
+    host_pico_reset();
+    model::Icm42670 imu;
+    int rc = init_ICM42670();
+    check(rc == 0, "init_ICM42670", rc, 0);
+
+    check_thresholds(imu);
+    check_rejected(imu);
+    check_events(imu);
+    check_status_map(imu);
+
+    std::printf("%s\n", failures ? "apex_check: FAILED" : "apex_check: ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,176 @@
+// audio_decode: turn the framed audio stream sent on CDC1 (see
+// tkjhat/audio_stream.h) into a WAV file.
+//
+//   audio_decode <capture.bin | /dev/ttyACM1 | -> <out.wav>
+//       Decode a raw byte capture (or read the port/stdin until EOF).
+//   audio_decode --roundtrip <in.wav> [out.wav]
+//       Encode a WAV file with the firmware encoder, decode it again and
+//       report encoder speed, bandwidth and SNR.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "tkjhat/audio_stream.h"
+#include "wav.hpp"
+
+namespace {
+
+struct DecodeStats {
+    size_t frames = 0;
+    size_t lost_frames = 0;
+    size_t skipped_bytes = 0;
+    uint32_t sample_rate = 0;
+};
+
+// Decodes every valid frame in buf; lost frames (sequence gaps) become silence
+std::vector<int16_t> decode(const std::vector<uint8_t> &buf, DecodeStats &st) {
+    std::vector<int16_t> pcm;
+    bool have_seq = false;
+    uint16_t next_seq = 0;
+    uint16_t last_samples = 0;
+    size_t pos = 0;
+
+    while (pos < buf.size()) {
+        audio_frame_info_t info;
+        int len = audio_stream_parse(&buf[pos], buf.size() - pos, &info);
+        if (len == 0) break;            // truncated frame at the end
+        if (len < 0) {
+            pos++;
+            st.skipped_bytes++;
+            continue;
+        }
+
+        if (have_seq && info.seq != next_seq) {
+            uint16_t gap = uint16_t(info.seq - next_seq);
+            st.lost_frames += gap;
+            pcm.insert(pcm.end(), size_t(gap) * last_samples, 0);
+        }
+        have_seq = true;
+        next_seq = uint16_t(info.seq + 1);
+        last_samples = info.samples;
+        st.sample_rate = info.sample_rate;
+
+        const uint8_t *payload = &buf[pos + AUDIO_STREAM_HEADER_SIZE];
+        size_t at = pcm.size();
+        pcm.resize(at + info.samples);
+        if (info.codec == AUDIO_CODEC_IMA_ADPCM) {
+            ima_adpcm_state_t state = info.state;
+            ima_adpcm_decode(&state, payload, info.samples, &pcm[at]);
+        } else {
+            for (size_t i = 0; i < info.samples; i++) {
+                pcm[at + i] = int16_t(payload[2 * i] | payload[2 * i + 1] << 8);
+            }
+        }
+        st.frames++;
+        pos += size_t(len);
+    }
+    return pcm;
+}
+
+bool read_all(const std::string &path, std::vector<uint8_t> &out) {
+    std::FILE *f = path == "-" ? stdin : std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+    if (f != stdin) std::fclose(f);
+    return true;
+}
+
+int collect(const void *data, size_t len, void *ctx) {
+    auto *out = static_cast<std::vector<uint8_t> *>(ctx);
+    auto *p = static_cast<const uint8_t *>(data);
+    out->insert(out->end(), p, p + len);
+    return int(len);
+}
+
+int roundtrip(const std::string &in_path, const std::string &out_path) {
+    uint32_t rate = 0;
+    std::vector<int16_t> pcm;
+    if (!wav::read(in_path, rate, pcm) || pcm.empty()) {
+        std::fprintf(stderr, "cannot read 16-bit PCM WAV %s\n", in_path.c_str());
+        return 1;
+    }
+
+    // Same block size as the firmware microphone buffer
+    const size_t block = 256;
+    std::vector<uint8_t> bytes;
+    audio_stream_t s;
+    audio_stream_init(&s, AUDIO_CODEC_IMA_ADPCM, uint16_t(rate), collect, &bytes);
+
+    // Best of several passes to keep scheduler noise out of the timing
+    double best_ns = 1e30;
+    for (int pass = 0; pass < 5; pass++) {
+        bytes.clear();
+        audio_stream_init(&s, AUDIO_CODEC_IMA_ADPCM, uint16_t(rate), collect, &bytes);
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < pcm.size(); i += block) {
+            audio_stream_write(&s, &pcm[i], std::min(block, pcm.size() - i));
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / double(pcm.size());
+        if (ns < best_ns) best_ns = ns;
+    }
+
+    DecodeStats st;
+    std::vector<int16_t> out = decode(bytes, st);
+
+    double sig = 0, err = 0;
+    for (size_t i = 0; i < pcm.size() && i < out.size(); i++) {
+        double d = double(pcm[i]) - double(out[i]);
+        sig += double(pcm[i]) * pcm[i];
+        err += d * d;
+    }
+    double seconds = double(pcm.size()) / rate;
+    std::printf("input        %zu samples @ %u Hz (%.2f s)\n", pcm.size(), rate, seconds);
+    std::printf("PCM16        %.0f B/s\n", pcm.size() * 2 / seconds);
+    std::printf("ADPCM frames %zu frames, %zu bytes, %.0f B/s (%.2f:1 incl. headers)\n",
+                st.frames, bytes.size(), bytes.size() / seconds,
+                double(pcm.size() * 2) / bytes.size());
+    std::printf("encode       %.1f ns/sample (host, framing + CRC included)\n", best_ns);
+    std::printf("SNR          %.1f dB\n", err > 0 ? 10 * std::log10(sig / err) : 99.0);
+
+    if (!out_path.empty() && !wav::write(out_path, rate, out)) {
+        std::fprintf(stderr, "cannot write %s\n", out_path.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc >= 3 && std::strcmp(argv[1], "--roundtrip") == 0) {
+        return roundtrip(argv[2], argc > 3 ? argv[3] : "");
+    }
+    if (argc != 3) {
+        std::fprintf(stderr,
+                     "usage: %s <capture.bin|device|-> <out.wav>\n"
+                     "       %s --roundtrip <in.wav> [out.wav]\n", argv[0], argv[0]);
+        return 2;
+    }
+
+    std::vector<uint8_t> bytes;
+    if (!read_all(argv[1], bytes)) {
+        std::fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 1;
+    }
+
+    DecodeStats st;
+    std::vector<int16_t> pcm = decode(bytes, st);
+    if (st.frames == 0) {
+        std::fprintf(stderr, "no audio frames found in %zu bytes\n", bytes.size());
+        return 1;
+    }
+    if (!wav::write(argv[2], st.sample_rate, pcm)) {
+        std::fprintf(stderr, "cannot write %s\n", argv[2]);
+        return 1;
+    }
+    std::printf("%zu frames, %zu samples @ %u Hz, %zu lost frames, %zu bytes skipped -> %s\n",
+                st.frames, pcm.size(), st.sample_rate, st.lost_frames, st.skipped_bytes, argv[2]);
+    return 0;
+}
@@ -0,0 +1,112 @@
+// buzzer_check: PWM tones of the buzzer (buzzer_tone_start() and
+// buzzer_tone_stop() in sdk.c) on host_pico.
+//
+//   buzzer_check
+//
+// - Every tone from BUZZER_TONE_MIN_HZ to BUZZER_TONE_MAX_HZ (1/12 octave
+//   steps, plus the ends, main.c's Morse tone and theme notes) must come
+//   out of the buzzer pin's PWM slice within 0.05% of the request, as a
+//   square wave (level half the period), with the pin on GPIO_FUNC_PWM.
+// - Starting a tone must return at once: no virtual time may pass, where
+//   buzzer_play_tone() busy-waits for the whole tone.
+// - buzzer_tone_stop() must disable the slice and leave the pin a low SIO
+//   output; frequencies out of range must be refused.
+//
+// Prints one line per failed check; the exit code is 1 if any failed.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "host_pico.h"
+
+extern "C" {
+#include "hardware/clocks.h"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include "tkjhat/sdk.h"
+}
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what, long got, long want) {
+    if (!ok) {
+        std::printf("FAIL %s: got %ld, want %ld\n", what, got, want);
+        failures++;
+    }
+}
+
+const unsigned slice = pwm_gpio_to_slice_num(BUZZER_PIN);
+
+// Output frequency of the slice as programmed
+double programmed_hz() {
+    const host_pwm_slice_t *s = host_pwm_slice(slice);
+    return double(clock_get_hz(clk_sys)) / (s->clkdiv * (double(s->wrap) + 1.0));
+}
+
+void check_tone(uint32_t hz) {
+    char what[64];
+    const uint64_t t0 = time_us_64();
+    int rc = buzzer_tone_start(hz);
+    std::snprintf(what, sizeof(what), "%u Hz start", hz);
+    check(rc == 0, what, rc, 0);
+    std::snprintf(what, sizeof(what), "%u Hz us spent starting", hz);
+    check(time_us_64() == t0, what, long(time_us_64() - t0), 0);
+
+    const host_pwm_slice_t *s = host_pwm_slice(slice);
+    const double got = programmed_hz();
+    std::snprintf(what, sizeof(what), "%u Hz output mHz", hz);
+    check(std::fabs(got - hz) <= 5e-4 * hz, what, std::lround(got * 1000), long(hz) * 1000);
+    std::snprintf(what, sizeof(what), "%u Hz clkdiv x16 in 1..255.9375", hz);
+    check(s->clkdiv >= 1.0f && s->clkdiv < 256.0f, what, std::lround(s->clkdiv * 16), 16);
+    std::snprintf(what, sizeof(what), "%u Hz level (square wave)", hz);
+    const long half = (long(s->wrap) + 1) / 2;
+    check(s->level[pwm_gpio_to_channel(BUZZER_PIN)] == half, what,
+          s->level[pwm_gpio_to_channel(BUZZER_PIN)], half);
+    std::snprintf(what, sizeof(what), "%u Hz slice enabled", hz);
+    check(s->enabled, what, s->enabled, 1);
+    std::snprintf(what, sizeof(what), "%u Hz pin function", hz);
+    check(host_gpio_function(BUZZER_PIN) == GPIO_FUNC_PWM, what,
+          host_gpio_function(BUZZER_PIN), GPIO_FUNC_PWM);
+
+    buzzer_tone_stop();
+    std::snprintf(what, sizeof(what), "%u Hz slice after stop", hz);
+    check(!s->enabled, what, s->enabled, 0);
+    std::snprintf(what, sizeof(what), "%u Hz pin function after stop", hz);
+    check(host_gpio_function(BUZZER_PIN) == GPIO_FUNC_SIO, what,
+          host_gpio_function(BUZZER_PIN), GPIO_FUNC_SIO);
+    std::snprintf(what, sizeof(what), "%u Hz pin after stop", hz);
+    check(!host_gpio_output(BUZZER_PIN), what, host_gpio_output(BUZZER_PIN), 0);
+}
+
+} // namespace
+
+int main() {
+    host_pico_reset();
+    init_buzzer();
+
+    std::vector<uint32_t> tones{BUZZER_TONE_MIN_HZ, BUZZER_TONE_MAX_HZ, 1000,
+                                659, 784, 880, 1046};
+    for (double f = BUZZER_TONE_MIN_HZ; f < BUZZER_TONE_MAX_HZ; f *= std::pow(2.0, 1.0 / 12)) {
+        tones.push_back(uint32_t(std::lround(f)));
+    }
+    for (uint32_t hz : tones) check_tone(hz);
+
+    check(buzzer_tone_start(BUZZER_TONE_MIN_HZ - 1) == -1, "start below the range", 0, -1);
+    check(buzzer_tone_start(BUZZER_TONE_MAX_HZ + 1) == -1, "start above the range", 0, -1);
+    check(!host_pwm_slice(slice)->enabled, "slice after refused starts", 1, 0);
+
+    // The bit-banged tone holds the CPU for its whole length
+    const uint64_t t0 = time_us_64();
+    buzzer_play_tone(1000, 100);
+    const long busy_ms = long((time_us_64() - t0 + 500) / 1000);
+    check(busy_ms == 100, "buzzer_play_tone ms busy", busy_ms, 100);
+
+    std::printf("%zu tones, buzzer_play_tone(1000, 100) busy %ld ms, buzzer_tone_start 0 ms\n",
+                tones.size(), busy_ms);
+    std::printf("%s\n", failures ? "buzzer_check: FAILED" : "buzzer_check: ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+// HDC2021 temperature/humidity sensor model for the host_pico bus.
+//
+// Covers the auto-measurement mode the SDK uses: once MEAS_TRIG is set
+// with a non-zero AMM rate, a conversion starts every period and its
+// result lands in the data registers after the conversion time of the
+// selected resolutions. Each result sets DRDY and the threshold flags in
+// INT_STATUS (read clears). With DRDY/INT_EN set and an enabled flag
+// pending, the DRDY/INT pin (HDC2021_INTERRUPT) is driven to its active
+// level until the status is read (level mode) or for the conversion only
+// (comparator mode is not modelled). The soft reset bit restores the
+// power-on registers.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "i2c_model.hpp"
+
+extern "C" {
+#include "tkjhat/sdk.h"
+}
+
+namespace model {
+
+class Hdc2021 : public RegisterDevice {
+public:
+    Hdc2021() : RegisterDevice(HDC2021_I2C_ADDRESS) {
+        power_on();
+        host_add_tick_hook([](void *ctx, uint64_t now) { static_cast<Hdc2021 *>(ctx)->tick(now); },
+                           this);
+    }
+
+    void set_climate(double temp_c, double rh) {
+        temp_c_ = temp_c;
+        rh_ = rh;
+    }
+
+    // Conversions completed so far
+    uint32_t conversions() const { return conversions_; }
+
+    // Period of the AMM rate in the config register (0 = off)
+    static uint64_t period_us(uint8_t cfg) {
+        static const uint64_t us[8] = {0, 120000000, 60000000, 10000000, 5000000,
+                                       1000000, 500000, 200000};
+        return us[(cfg >> 4) & 7];
+    }
+
+    // Conversion time from the datasheet: 14/11/9-bit temperature
+    // 610/350/225 us, humidity 660/400/275 us
+    static uint64_t conversion_us(uint8_t meas) {
+        static const uint64_t t_us[3] = {610, 350, 225}, h_us[3] = {660, 400, 275};
+        return t_us[std::min(2, (meas >> 6) & 3)] + h_us[std::min(2, (meas >> 4) & 3)];
+    }
+
+protected:
+    void write_reg(uint8_t r, uint8_t v) override {
+        if (r == HDC2021_CONFIG && (v & 0x80)) {
+            power_on();
+            return;
+        }
+        if (r == HDC2021_INT_STATUS || r <= HDC2021_HUMIDITY_HIGH) return; // read-only
+        regs_[r] = v;
+        if (r == HDC2021_MEASUREMENT_CONFIG && (v & 0x01) && period_us(regs_[HDC2021_CONFIG])) {
+            next_start_us_ = time_us_64();
+            running_ = true;
+        }
+        if (r == HDC2021_CONFIG && period_us(v) == 0) running_ = false;
+        update_pin();
+    }
+
+    uint8_t read_reg(uint8_t r) override {
+        uint8_t v = regs_[r];
+        if (r == HDC2021_INT_STATUS) {
+            regs_[r] = 0;
+            update_pin();
+        }
+        return v;
+    }
+
+private:
+    void power_on() {
+        std::fill(std::begin(regs_), std::end(regs_), uint8_t(0));
+        regs_[HDC2021_TEMP_THR_H] = 0xFF;
+        regs_[HDC2021_HUMID_THR_H] = 0xFF;
+        running_ = false;
+        pending_ = false;
+        update_pin();
+    }
+
+    void tick(uint64_t now) {
+        for (;;) {
+            if (pending_ && now >= done_us_) {
+                pending_ = false;
+                complete();
+                continue;
+            }
+            if (running_ && !pending_ && now >= next_start_us_) {
+                pending_ = true;
+                done_us_ = next_start_us_ + conversion_us(regs_[HDC2021_MEASUREMENT_CONFIG]);
+                next_start_us_ += period_us(regs_[HDC2021_CONFIG]);
+                regs_[HDC2021_MEASUREMENT_CONFIG] &= uint8_t(~0x01);   // MEAS_TRIG clears
+                continue;
+            }
+            return;
+        }
+    }
+
+    void complete() {
+        uint16_t t = uint16_t(std::clamp(std::lround((temp_c_ + 40.0) * 65536.0 / 165.0), 0L, 65535L));
+        uint16_t h = uint16_t(std::clamp(std::lround(rh_ * 65536.0 / 100.0), 0L, 65535L));
+        regs_[HDC2021_TEMP_LOW] = uint8_t(t);
+        regs_[HDC2021_TEMP_HIGH] = uint8_t(t >> 8);
+        regs_[HDC2021_HUMIDITY_LOW] = uint8_t(h);
+        regs_[HDC2021_HUMIDITY_HIGH] = uint8_t(h >> 8);
+
+        // Thresholds compare the upper 8 bits of the results
+        uint8_t st = HDC2021_EVT_DRDY;
+        if ((t >> 8) > regs_[HDC2021_TEMP_THR_H]) st |= HDC2021_EVT_TEMP_HIGH;
+        if ((t >> 8) < regs_[HDC2021_TEMP_THR_L]) st |= HDC2021_EVT_TEMP_LOW;
+        if ((h >> 8) > regs_[HDC2021_HUMID_THR_H]) st |= HDC2021_EVT_HUM_HIGH;
+        if ((h >> 8) < regs_[HDC2021_HUMID_THR_L]) st |= HDC2021_EVT_HUM_LOW;
+        regs_[HDC2021_INT_STATUS] |= st;
+        conversions_++;
+        update_pin();
+    }
+
+    // Pin level from INT_EN, polarity and the enabled pending flags
+    void update_pin() {
+        const uint8_t cfg = regs_[HDC2021_CONFIG];
+        bool active = (cfg & 0x04) && (regs_[HDC2021_INT_STATUS] & regs_[HDC2021_INT_ENABLE]);
+        bool level = active ? (cfg & 0x02) != 0 : true;   // released: pulled up
+        host_gpio_set_input(HDC2021_INTERRUPT, level);
+    }
+
+    double temp_c_ = 22.0, rh_ = 40.0;
+    bool running_ = false, pending_ = false;
+    uint64_t next_start_us_ = 0, done_us_ = 0;
+    uint32_t conversions_ = 0;
+};
+
+} // namespace model
@@ -0,0 +1,103 @@
+// Simulated I2C devices for the host_pico bus (tools/host_pico).
+//
+// RegisterDevice is the usual sensor layout: the first byte of a write
+// selects a register, further bytes are written from there on and reads
+// continue at the selected register, both with auto-increment. Every
+// register access is logged with the virtual time so tests can check the
+// sequence a driver sends.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "host_pico.h"
+#include "pico/stdlib.h"
+
+namespace model {
+
+class I2cDevice {
+public:
+    explicit I2cDevice(uint8_t addr) : addr_(addr) {
+        dev_.write = [](void *ctx, const uint8_t *src, size_t len, bool nostop) {
+            return static_cast<I2cDevice *>(ctx)->write(src, len, nostop);
+        };
+        dev_.read = [](void *ctx, uint8_t *dst, size_t len, bool nostop) {
+            return static_cast<I2cDevice *>(ctx)->read(dst, len, nostop);
+        };
+        dev_.ctx = this;
+        host_i2c_attach(addr_, &dev_);
+    }
+    virtual ~I2cDevice() { host_i2c_attach(addr_, nullptr); }
+
+    I2cDevice(const I2cDevice &) = delete;
+    I2cDevice &operator=(const I2cDevice &) = delete;
+
+    uint8_t address() const { return addr_; }
+
+protected:
+    virtual int write(const uint8_t *src, size_t len, bool nostop) = 0;
+    virtual int read(uint8_t *dst, size_t len, bool nostop) = 0;
+
+private:
+    uint8_t addr_;
+    host_i2c_device_t dev_{};
+};
+
+struct Access {
+    bool write;
+    uint8_t reg;
+    uint8_t value;
+    uint64_t t_us;
+};
+
+class RegisterDevice : public I2cDevice {
+public:
+    explicit RegisterDevice(uint8_t addr) : I2cDevice(addr) {}
+
+    uint8_t reg(uint8_t r) const { return regs_[r]; }
+    void set_reg(uint8_t r, uint8_t v) { regs_[r] = v; }
+
+    const std::vector<Access> &log() const { return log_; }
+    void clear_log() { log_.clear(); }
+
+    // Register writes in the log, in order
+    std::vector<Access> writes() const {
+        std::vector<Access> w;
+        for (const Access &a : log_) {
+            if (a.write) w.push_back(a);
+        }
+        return w;
+    }
+
+protected:
+    // Hooks for registers with side effects; the defaults are plain storage
+    virtual uint8_t read_reg(uint8_t r) { return regs_[r]; }
+    virtual void write_reg(uint8_t r, uint8_t v) { regs_[r] = v; }
+
+    int write(const uint8_t *src, size_t len, bool) override {
+        if (len == 0) return 0;
+        ptr_ = src[0];
+        for (size_t i = 1; i < len; ++i) {
+            log_.push_back({true, ptr_, src[i], time_us_64()});
+            write_reg(ptr_++, src[i]);
+        }
+        return int(len);
+    }
+
+    int read(uint8_t *dst, size_t len, bool) override {
+        for (size_t i = 0; i < len; ++i) {
+            dst[i] = read_reg(ptr_);
+            log_.push_back({false, ptr_, dst[i], time_us_64()});
+            ptr_++;
+        }
+        return int(len);
+    }
+
+    uint8_t regs_[256] = {};
+    uint8_t ptr_ = 0;
+    std::vector<Access> log_;
+};
+
+} // namespace model
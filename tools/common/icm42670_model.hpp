@@ -0,0 +1,110 @@
+// ICM-42670-P register model for the host_pico bus.
+//
+// Covers what the SDK driver touches: WHO_AM_I, the reset handshake, the
+// sensor data burst (big-endian, TEMP first), the indirect MREG1 bank and
+// the clear-on-read interrupt status registers. The sensor data is
+// whatever the test last set with set_sample(). Raising an event latches
+// its status bits and pulses INT1 (active low).
+//
+// The register addresses are the datasheet's, not the SDK's
+// macros, so a wrong address in sdk.h shows up as a failed check.
+
+#pragma once
+
+#include <cstdint>
+
+#include "i2c_model.hpp"
+
+extern "C" {
+#include "tkjhat/sdk.h"
+}
+
+namespace model {
+
+// ICM-42670-P user bank 0 and MREG1, from the datasheet register map
+namespace icm42670_reg {
+constexpr uint8_t MCLK_RDY = 0x00;
+constexpr uint8_t SIGNAL_PATH_RESET = 0x02;
+constexpr uint8_t TEMP_DATA1 = 0x09;        // first of the 14-byte data burst
+constexpr uint8_t APEX_CONFIG0 = 0x25;
+constexpr uint8_t APEX_CONFIG1 = 0x26;
+constexpr uint8_t WOM_CONFIG = 0x27;
+constexpr uint8_t INT_SOURCE0 = 0x2B;
+constexpr uint8_t INT_SOURCE1 = 0x2C;
+constexpr uint8_t APEX_DATA0 = 0x31;
+constexpr uint8_t INT_STATUS2 = 0x3B;       // SMD, WOM Z/Y/X; clear on read
+constexpr uint8_t INT_STATUS3 = 0x3C;       // step, step overflow, tilt; clear on read
+constexpr uint8_t FIFO_COUNTH = 0x3D;
+constexpr uint8_t WHO_AM_I = 0x75;
+constexpr uint8_t MADDR_W = 0x7A;
+constexpr uint8_t M_W = 0x7B;
+constexpr uint8_t MADDR_R = 0x7D;
+constexpr uint8_t M_R = 0x7E;
+
+constexpr uint8_t MREG1_INT_SOURCE6 = 0x2F;
+constexpr uint8_t MREG1_APEX_CONFIG4 = 0x46;
+constexpr uint8_t MREG1_WOM_X_THR = 0x4B;
+constexpr uint8_t MREG1_WOM_Y_THR = 0x4C;
+constexpr uint8_t MREG1_WOM_Z_THR = 0x4D;
+} // namespace icm42670_reg
+
+class Icm42670 : public RegisterDevice {
+public:
+    Icm42670() : RegisterDevice(ICM42670_I2C_ADDRESS) {
+        regs_[icm42670_reg::MCLK_RDY] = 0x08;
+        regs_[icm42670_reg::WHO_AM_I] = ICM42670_WHO_AM_I_RESPONSE;
+    }
+
+    void set_sample(const icm_raw &s) { sample_ = s; }
+
+    uint8_t mreg1(uint8_t r) const { return mreg1_[r]; }
+
+    // MREG1 writes in order (the bank-0 log only shows the indirection)
+    const std::vector<Access> &mreg1_writes() const { return mreg1_log_; }
+
+    // Latch INT_STATUS2 / INT_STATUS3 bits and pulse INT1
+    void raise(uint8_t status2, uint8_t status3) {
+        regs_[icm42670_reg::INT_STATUS2] |= status2;
+        regs_[icm42670_reg::INT_STATUS3] |= status3;
+        host_gpio_set_input(ICM42670_INT, false);
+        host_gpio_set_input(ICM42670_INT, true);
+    }
+
+protected:
+    uint8_t read_reg(uint8_t r) override {
+        using namespace icm42670_reg;
+        if (r >= TEMP_DATA1 && r < TEMP_DATA1 + 14) {
+            const int16_t v[7] = {sample_.t, sample_.ax, sample_.ay, sample_.az,
+                                  sample_.gx, sample_.gy, sample_.gz};
+            unsigned i = r - TEMP_DATA1;
+            uint16_t w = uint16_t(v[i / 2]);
+            return uint8_t(i & 1 ? w : w >> 8);
+        }
+        if (r == M_R) return mreg1_[regs_[MADDR_R]];
+        if (r == INT_STATUS2 || r == INT_STATUS3) {
+            uint8_t v = regs_[r];
+            regs_[r] = 0;
+            return v;
+        }
+        return regs_[r];
+    }
+
+    void write_reg(uint8_t r, uint8_t v) override {
+        using namespace icm42670_reg;
+        if (r == M_W) {
+            uint8_t a = regs_[MADDR_W];
+            mreg1_[a] = v;
+            mreg1_log_.push_back({true, a, v, time_us_64()});
+            return;
+        }
+        if (r == SIGNAL_PATH_RESET && (v & ICM42670_RESET_CONFIG_BITS)) return;
+        regs_[r] = v;
+    }
+
+private:
+    icm_raw sample_{};
+    uint8_t mreg1_[256] = {};
+    std::vector<Access> mreg1_log_;
+};
+
+} // namespace model
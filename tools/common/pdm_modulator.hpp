@@ -0,0 +1,44 @@
+// PDM test streams for the host tools: the second-order sigma-delta
+// modulator pdm_bench uses, and packing its bits as the capture DMA stores
+// them (first bit in bit 7 of the first byte).
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pdm {
+
+// x in [-1, 1] per PDM bit, bits one at a time. A little dither keeps it
+// out of idle tones at low levels.
+class Modulator {
+public:
+    explicit Modulator(uint32_t seed) : rng_(seed) {}
+
+    uint8_t bit(double x) {
+        rng_ = rng_ * 1664525u + 1013904223u;
+        const double dither = (double(rng_ >> 8) / double(1u << 24) - 0.5) * 1e-3;
+        const double y = i2_ + dither >= 0 ? 1.0 : -1.0;
+        i1_ += x - y;
+        i2_ += i1_ - 2.0 * y;
+        return y > 0;
+    }
+
+private:
+    double i1_ = 0, i2_ = 0;
+    uint32_t rng_;
+};
+
+// Modulate bits values of f(bit index) into packed bytes
+template <typename F>
+std::vector<uint8_t> modulate(size_t bits, uint32_t seed, F f) {
+    Modulator m(seed);
+    std::vector<uint8_t> out((bits + 7) / 8, 0);
+    for (size_t i = 0; i < bits; i++) {
+        if (m.bit(f(i))) out[i / 8] |= uint8_t(0x80 >> (i % 8));
+    }
+    return out;
+}
+
+} // namespace pdm
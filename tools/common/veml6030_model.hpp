@@ -0,0 +1,133 @@
+// VEML6030 ambient light sensor model for the host_pico bus.
+//
+// 16-bit registers, LSB first, selected by the first byte of a write. The
+// sensor integrates continuously: a result lands in ALS (and WHITE) at the
+// end of every integration period, and a change of gain or integration
+// time only applies from the next period, as on the chip. Shutdown stops
+// the measurements.
+//
+// The light is set in true lux and taken as constant over each period
+// (the result uses the level at its end). The counts are what the chip reports for
+// it: above ~1000 lx its response is non-linear, modelled as the inverse
+// of the correction polynomial in Vishay's application note, so a driver
+// that applies the correction gets the true lux back.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "i2c_model.hpp"
+
+extern "C" {
+#include "tkjhat/sdk.h"
+}
+
+namespace model {
+
+class Veml6030 : public I2cDevice {
+public:
+    Veml6030() : I2cDevice(VEML6030_I2C_ADDR) {
+        regs_[VEML6030_CONFIG_REG] = 0x0001;   // shut down until configured
+        host_add_tick_hook([](void *ctx, uint64_t now) { static_cast<Veml6030 *>(ctx)->tick(now); },
+                           this);
+    }
+
+    void set_lux(double lux) { lux_ = lux; }
+    uint16_t reg(uint8_t r) const { return regs_[r & 7]; }
+
+    // Virtual time of the last result written to ALS
+    uint64_t result_us() const { return result_us_; }
+
+    // Resolution in lx per count for a config register value
+    static double resolution(uint16_t cfg) {
+        static const double gain[4] = {1.0, 2.0, 0.125, 0.25};
+        return 0.0036 * (800.0 / it_ms(cfg)) * (2.0 / gain[(cfg >> 11) & 3]);
+    }
+
+    // Vishay's correction, lux as reported -> true lux
+    static double correction(double x) {
+        return ((6.0135e-13 * x - 9.3924e-9) * x + 8.1488e-5) * x * x + 1.0023 * x;
+    }
+
+    // What the linear count scale shows for true lux (inverse of the
+    // correction above 1000 lx, which is monotonic)
+    static double uncorrected(double lux) {
+        if (lux <= 1000.0) return lux;
+        double lo = 1000.0 / 1.2, hi = lux;
+        for (int i = 0; i < 100; ++i) {
+            double mid = 0.5 * (lo + hi);
+            (correction(mid) < lux ? lo : hi) = mid;
+        }
+        return 0.5 * (lo + hi);
+    }
+
+private:
+    static double it_ms(uint16_t cfg) {
+        switch ((cfg >> 6) & 0xF) {
+            case 0x0C: return 25;
+            case 0x08: return 50;
+            case 0x01: return 200;
+            case 0x02: return 400;
+            case 0x03: return 800;
+            default:   return 100;
+        }
+    }
+
+    bool shut_down() const { return regs_[VEML6030_CONFIG_REG] & 0x0001; }
+
+    void tick(uint64_t now) {
+        if (!running_) return;
+        while (now >= cycle_end_us_) {
+            double counts = std::round(uncorrected(lux_) / resolution(cycle_cfg_));
+            regs_[VEML6030_ALS_REG] = uint16_t(std::min(counts, 65535.0));
+            regs_[VEML6030_WHITE_REG] = uint16_t(std::min(counts * 1.25, 65535.0));
+            result_us_ = cycle_end_us_;
+            if (shut_down()) {
+                running_ = false;
+                return;
+            }
+            // The next period uses whatever the config is now
+            cycle_cfg_ = regs_[VEML6030_CONFIG_REG];
+            cycle_end_us_ += uint64_t(it_ms(cycle_cfg_) * 1000.0);
+        }
+    }
+
+    int write(const uint8_t *src, size_t len, bool) override {
+        if (len == 0) return 0;
+        ptr_ = src[0] & 7;
+        if (len >= 3) {
+            uint16_t v = uint16_t(src[1] | (src[2] << 8));
+            if (ptr_ == VEML6030_ALS_REG || ptr_ == VEML6030_WHITE_REG ||
+                ptr_ == VEML6030_ALS_INT_REG) {
+                return int(len);    // read-only
+            }
+            regs_[ptr_] = v;
+            if (ptr_ == VEML6030_CONFIG_REG && !running_ && !shut_down()) {
+                running_ = true;
+                cycle_cfg_ = v;
+                cycle_end_us_ = time_us_64() + uint64_t(it_ms(v) * 1000.0);
+            }
+        }
+        return int(len);
+    }
+
+    int read(uint8_t *dst, size_t len, bool) override {
+        uint16_t v = regs_[ptr_];
+        if (ptr_ == VEML6030_ALS_INT_REG) regs_[ptr_] = 0;
+        for (size_t i = 0; i < len; ++i) dst[i] = uint8_t(i & 1 ? v >> 8 : v);
+        return int(len);
+    }
+
+    uint16_t regs_[8] = {};
+    uint8_t ptr_ = 0;
+    double lux_ = 0.0;
+    bool running_ = false;
+    uint16_t cycle_cfg_ = 0;
+    uint64_t cycle_end_us_ = 0;
+    uint64_t result_us_ = 0;
+};
+
+} // namespace model
@@ -0,0 +1,95 @@
+// Minimal 16-bit PCM WAV reading and writing for the host tools.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace wav {
+
+constexpr size_t kHeaderBytes = 44;
+
+inline void put_u32(std::FILE *f, uint32_t v) {
+    uint8_t b[4] = { uint8_t(v), uint8_t(v >> 8), uint8_t(v >> 16), uint8_t(v >> 24) };
+    std::fwrite(b, 1, 4, f);
+}
+
+inline void put_u16(std::FILE *f, uint16_t v) {
+    uint8_t b[2] = { uint8_t(v), uint8_t(v >> 8) };
+    std::fwrite(b, 1, 2, f);
+}
+
+// Header for mono 16-bit PCM with data_bytes of samples following
+inline void header(uint8_t *h, uint32_t sample_rate, uint32_t data_bytes) {
+    auto u16 = [&](size_t o, uint32_t v) { h[o] = uint8_t(v); h[o + 1] = uint8_t(v >> 8); };
+    auto u32 = [&](size_t o, uint32_t v) { u16(o, v & 0xFFFF); u16(o + 2, v >> 16); };
+    std::memcpy(h, "RIFF", 4);
+    u32(4, 36 + data_bytes);
+    std::memcpy(h + 8, "WAVEfmt ", 8);
+    u32(16, 16);
+    u16(20, 1);                     // PCM
+    u16(22, 1);                     // mono
+    u32(24, sample_rate);
+    u32(28, sample_rate * 2);       // byte rate
+    u16(32, 2);                     // block align
+    u16(34, 16);                    // bits per sample
+    std::memcpy(h + 36, "data", 4);
+    u32(40, data_bytes);
+}
+
+inline void write_header(std::FILE *f, uint32_t sample_rate, uint32_t data_bytes) {
+    uint8_t h[kHeaderBytes];
+    header(h, sample_rate, data_bytes);
+    std::fwrite(h, 1, sizeof(h), f);
+}
+
+inline bool write(const std::string &path, uint32_t sample_rate, const std::vector<int16_t> &pcm) {
+    std::FILE *f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    write_header(f, sample_rate, uint32_t(pcm.size() * 2));
+    for (int16_t s : pcm) put_u16(f, uint16_t(s));
+    return std::fclose(f) == 0;
+}
+
+// Reads the first channel of a 16-bit PCM WAV file
+inline bool read(const std::string &path, uint32_t &sample_rate, std::vector<int16_t> &pcm) {
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    std::vector<uint8_t> d;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) d.insert(d.end(), buf, buf + n);
+    std::fclose(f);
+
+    auto u16 = [&](size_t o) { return uint32_t(d[o] | d[o + 1] << 8); };
+    auto u32 = [&](size_t o) { return u16(o) | u16(o + 2) << 16; };
+    if (d.size() < 12 || std::string(d.begin(), d.begin() + 4) != "RIFF" ||
+        std::string(d.begin() + 8, d.begin() + 12) != "WAVE") {
+        return false;
+    }
+
+    uint32_t channels = 0, bits = 0;
+    for (size_t o = 12; o + 8 <= d.size();) {
+        std::string id(d.begin() + o, d.begin() + o + 4);
+        size_t len = u32(o + 4);
+        size_t body = o + 8;
+        if (body + len > d.size()) len = d.size() - body;
+        if (id == "fmt " && len >= 16) {
+            channels = u16(body + 2);
+            sample_rate = u32(body + 4);
+            bits = u16(body + 14);
+        } else if (id == "data" && channels && bits == 16) {
+            size_t frames = len / (2 * channels);
+            pcm.resize(frames);
+            for (size_t i = 0; i < frames; i++) pcm[i] = int16_t(u16(body + i * 2 * channels));
+            return true;
+        }
+        o = body + len + (len & 1);
+    }
+    return false;
+}
+
+} // namespace wav
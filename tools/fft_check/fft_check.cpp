@@ -0,0 +1,241 @@
+// fft_check: compare the fixed-point FFT (tkjhat/fft.h) with a
+// double-precision DFT for every supported size.
+//
+//   fft_check [-v]
+//
+// For each size and format it runs a few test signals (full-scale noise,
+// a two-tone signal, a small tone on a large offset) through the complex
+// and the real FFT, the Hann window and the magnitude helper, and prints
+// the signal-to-error ratio in dB against the exact result. The exit code
+// is 1 if any result is below the limit for its format.
+
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "tkjhat/fft.h"
+
+namespace {
+
+using cplx = std::complex<double>;
+
+// Result limits; Q15 loses about 0.5 bit per stage to the 1/4 scaling
+constexpr double kMinSnrQ15 = 50.0;
+constexpr double kMinSnrQ31 = 140.0;
+
+std::vector<cplx> dft(const std::vector<cplx> &x) {
+    const size_t n = x.size();
+    std::vector<cplx> out(n);
+    for (size_t k = 0; k < n; k++) {
+        cplx acc = 0;
+        for (size_t i = 0; i < n; i++) {
+            double a = -2.0 * M_PI * double((k * i) % n) / double(n);
+            acc += x[i] * cplx(std::cos(a), std::sin(a));
+        }
+        out[k] = acc / double(n);       // same scaling as the fixed-point code
+    }
+    return out;
+}
+
+double snr_db(double sig, double err) {
+    if (err <= 0) return 200.0;
+    return 10.0 * std::log10(sig / err);
+}
+
+// Test signals in [-1, 1)
+enum class Signal { Noise, TwoTone, Offset };
+const char *signal_name(Signal s) {
+    switch (s) {
+    case Signal::Noise: return "noise";
+    case Signal::TwoTone: return "2-tone";
+    default: return "offset";
+    }
+}
+
+std::vector<double> make_signal(Signal s, size_t n, std::mt19937 &rng) {
+    std::vector<double> v(n);
+    std::uniform_real_distribution<double> u(-0.99, 0.99);
+    for (size_t i = 0; i < n; i++) {
+        double t = double(i);
+        switch (s) {
+        case Signal::Noise: v[i] = u(rng); break;
+        case Signal::TwoTone:
+            v[i] = 0.6 * std::sin(2 * M_PI * 5.3 * t / n) + 0.3 * std::cos(2 * M_PI * 0.23 * t + 1.0);
+            break;
+        case Signal::Offset:
+            // Gravity-like offset with a 1 % vibration on top
+            v[i] = 0.5 + 0.01 * std::sin(2 * M_PI * 37.0 * t / n);
+            break;
+        }
+    }
+    return v;
+}
+
+template <typename T> struct Fmt;
+template <> struct Fmt<int16_t> {
+    static constexpr double scale = 32768.0;
+    static constexpr const char *name = "Q15";
+    static int cfft(int16_t *x, unsigned n) { return fft_cfft_q15(x, n); }
+    static int rfft(int16_t *x, unsigned n) { return fft_rfft_q15(x, n); }
+    static void hann(int16_t *x, unsigned n) { fft_window_hann_q15(x, n); }
+};
+template <> struct Fmt<int32_t> {
+    static constexpr double scale = 2147483648.0;
+    static constexpr const char *name = "Q31";
+    static int cfft(int32_t *x, unsigned n) { return fft_cfft_q31(x, n); }
+    static int rfft(int32_t *x, unsigned n) { return fft_rfft_q31(x, n); }
+    static void hann(int32_t *x, unsigned n) { fft_window_hann_q31(x, n); }
+};
+
+template <typename T> T quantize(double v) {
+    double q = std::lround(v * Fmt<T>::scale);
+    double lim = Fmt<T>::scale;
+    if (q >= lim) q = lim - 1;
+    if (q < -lim) q = -lim;
+    return T(q);
+}
+
+struct Result {
+    double cfft, rfft, hann;
+};
+
+template <typename T> Result check(unsigned n, Signal sig, std::mt19937 &rng) {
+    const double sc = Fmt<T>::scale;
+    Result r{};
+
+    // Complex FFT: real and imaginary parts from two signals, scaled to
+    // keep |x| below full scale as the API asks
+    {
+        auto re = make_signal(sig, n, rng), im = make_signal(Signal::Noise, n, rng);
+        std::vector<T> x(2 * n);
+        std::vector<cplx> ref(n);
+        for (unsigned i = 0; i < n; i++) {
+            x[2 * i] = quantize<T>(re[i] * M_SQRT1_2);
+            x[2 * i + 1] = quantize<T>(im[i] * M_SQRT1_2);
+            ref[i] = cplx(x[2 * i] / sc, x[2 * i + 1] / sc);
+        }
+        auto X = dft(ref);
+        Fmt<T>::cfft(x.data(), n);
+        double s = 0, e = 0;
+        for (unsigned k = 0; k < n; k++) {
+            cplx got(x[2 * k] / sc, x[2 * k + 1] / sc);
+            s += std::norm(X[k]);
+            e += std::norm(got - X[k]);
+        }
+        r.cfft = snr_db(s, e);
+    }
+
+    // Real FFT, DC and Nyquist packed into the first bin
+    {
+        auto v = make_signal(sig, n, rng);
+        std::vector<T> x(n);
+        std::vector<cplx> ref(n);
+        for (unsigned i = 0; i < n; i++) {
+            x[i] = quantize<T>(v[i]);
+            ref[i] = x[i] / sc;
+        }
+        auto X = dft(ref);
+        Fmt<T>::rfft(x.data(), n);
+        double s = std::norm(X[0]) + std::norm(X[n / 2]);
+        double e = std::pow(x[0] / sc - X[0].real(), 2) + std::pow(x[1] / sc - X[n / 2].real(), 2);
+        for (unsigned k = 1; k < n / 2; k++) {
+            cplx got(x[2 * k] / sc, x[2 * k + 1] / sc);
+            s += std::norm(X[k]);
+            e += std::norm(got - X[k]);
+        }
+        r.rfft = snr_db(s, e);
+    }
+
+    // Hann window
+    {
+        auto v = make_signal(sig, n, rng);
+        std::vector<T> x(n);
+        for (unsigned i = 0; i < n; i++) x[i] = quantize<T>(v[i]);
+        std::vector<T> w = x;
+        Fmt<T>::hann(w.data(), n);
+        double s = 0, e = 0;
+        for (unsigned i = 0; i < n; i++) {
+            double want = x[i] / sc * (0.5 - 0.5 * std::cos(2 * M_PI * i / n));
+            s += want * want;
+            e += std::pow(w[i] / sc - want, 2);
+        }
+        r.hann = snr_db(s, e);
+    }
+    return r;
+}
+
+// Magnitudes against hypot() on random bins
+bool check_magnitude() {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int32_t> d16(INT16_MIN, INT16_MAX), d32(INT32_MIN, INT32_MAX);
+    const unsigned count = 4096;
+    std::vector<int16_t> b16(2 * count);
+    std::vector<int32_t> b32(2 * count);
+    for (auto &v : b16) v = int16_t(d16(rng));
+    for (auto &v : b32) v = d32(rng);
+    b16[0] = INT16_MIN;
+    b32[0] = INT32_MIN;
+    std::vector<uint16_t> m16(count);
+    std::vector<uint32_t> m32(count);
+    fft_magnitude_q15(b16.data(), m16.data(), count);
+    fft_magnitude_q31(b32.data(), m32.data(), count);
+
+    bool ok = m16[0] == 32768u && m32[0] == 2147483648u;
+    for (unsigned k = 1; k < count; k++) {
+        double want16 = std::floor(std::hypot(double(b16[2 * k]), double(b16[2 * k + 1])));
+        double want32 = std::floor(std::hypot(double(b32[2 * k]), double(b32[2 * k + 1])));
+        if (std::fabs(m16[k] - std::min(want16, 65535.0)) > 0) ok = false;
+        if (std::fabs(double(m32[k]) - want32) > 1) ok = false;    // hypot rounding
+    }
+    std::printf("magnitude    Q15/Q31 exact isqrt: %s\n", ok ? "ok" : "FAIL");
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bool verbose = argc > 1 && std::strcmp(argv[1], "-v") == 0;
+    bool ok = true;
+    std::mt19937 rng(1);
+
+    std::printf("SNR against a double DFT, dB (worst of noise / 2-tone / offset)\n");
+    std::printf("%-6s %-4s %8s %8s %8s\n", "size", "fmt", "cfft", "rfft", "hann");
+    for (unsigned n = FFT_SIZE_MIN; n <= FFT_SIZE_MAX; n *= 2) {
+        auto run = [&](auto tag) {
+            using T = decltype(tag);
+            Result worst{ 1e9, 1e9, 1e9 };
+            for (Signal s : { Signal::Noise, Signal::TwoTone, Signal::Offset }) {
+                Result r = check<T>(n, s, rng);
+                if (verbose) {
+                    std::printf("  %4u %s %-7s %8.1f %8.1f %8.1f\n", n, Fmt<T>::name,
+                                signal_name(s), r.cfft, r.rfft, r.hann);
+                }
+                worst.cfft = std::min(worst.cfft, r.cfft);
+                worst.rfft = std::min(worst.rfft, r.rfft);
+                worst.hann = std::min(worst.hann, r.hann);
+            }
+            double lim = sizeof(T) == 2 ? kMinSnrQ15 : kMinSnrQ31;
+            bool pass = worst.cfft >= lim && worst.rfft >= lim && worst.hann >= lim;
+            std::printf("%-6u %-4s %8.1f %8.1f %8.1f %s\n", n, Fmt<T>::name,
+                        worst.cfft, worst.rfft, worst.hann, pass ? "" : "FAIL");
+            ok = ok && pass;
+        };
+        run(int16_t{});
+        run(int32_t{});
+    }
+    ok = check_magnitude() && ok;
+
+    // Invalid sizes must be rejected
+    int16_t dummy[2 * 48] = {};
+    bool rejects = fft_cfft_q15(dummy, 48) == -1 && fft_rfft_q15(dummy, 32) == -1 &&
+                   fft_cfft_q15(dummy, 2048) == -1;
+    std::printf("size checks  %s\n", rejects ? "ok" : "FAIL");
+    ok = ok && rejects;
+
+    std::printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
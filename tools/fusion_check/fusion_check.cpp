@@ -0,0 +1,233 @@
+// fusion_check: the Mahony filter (mahony.c, both variants) against
+// synthetic rotations with a known true orientation.
+//
+//   fusion_check [-v]
+//
+// A true body orientation is integrated from a prescribed angular rate at
+// 10 kHz. At every IMU sample the ideal gyro and accelerometer readings are
+// derived from it, given a gyro bias, white noise and optional linear
+// acceleration, and quantized to ICM-42670 counts (4 g, 500 dps). The float
+// filter gets them scaled as imu_fusion.c does, the Q30 filter the counts.
+//
+// The error is the tilt error: the angle between the true gravity direction
+// in the body frame and the one the filter predicts (yaw is not observable,
+// so it is left out). It is reported after each case's settling time, next
+// to the error of the accelerometer alone (a tilt from one sample, as main.c
+// used before the filter). The exit code is 1 if a case exceeds its limit or the two variants
+// disagree by more than 0.5 degrees. -v adds the host ns per update (the
+// clock reads around each call included), for comparing the two variants.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "tkjhat/mahony.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kRad = kPi / 180.0;
+constexpr double kAccelLsb = 8192.0;    // LSB/g at 4 g
+constexpr double kGyroLsb = 65.5;       // LSB/dps at 500 dps
+constexpr float kKp = 1.0f, kKi = 0.02f; // IMU_FUSION_KP/KI_DEFAULT
+
+struct Vec {
+    double x, y, z;
+};
+
+struct Quat {
+    double w, x, y, z;
+};
+
+Quat mul(const Quat &a, const Quat &b) {
+    return {a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+            a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+            a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+            a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w};
+}
+
+Quat normalized(Quat q) {
+    double n = std::sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+    return {q.w / n, q.x / n, q.y / n, q.z / n};
+}
+
+// Body rotation by rate w (rad/s) for dt, exactly
+Quat step(const Quat &q, const Vec &w, double dt) {
+    double a = std::sqrt(w.x * w.x + w.y * w.y + w.z * w.z) * dt;
+    if (a == 0.0) return q;
+    double s = std::sin(a / 2) / (a / dt);
+    return normalized(mul(q, {std::cos(a / 2), w.x * s, w.y * s, w.z * s}));
+}
+
+// World vector v seen in the body frame (R^T v)
+Vec to_body(const Quat &q, const Vec &v) {
+    Quat c{q.w, -q.x, -q.y, -q.z};
+    Quat r = mul(mul(c, {0, v.x, v.y, v.z}), q);
+    return {r.x, r.y, r.z};
+}
+
+// Gravity direction in the body frame, as the filter computes it
+Vec gravity(double w, double x, double y, double z) {
+    return {2 * (x * z - w * y), 2 * (w * x + y * z), w * w - x * x - y * y + z * z};
+}
+
+double angle_deg(const Vec &a, const Vec &b) {
+    double na = std::sqrt(a.x * a.x + a.y * a.y + a.z * a.z);
+    double nb = std::sqrt(b.x * b.x + b.y * b.y + b.z * b.z);
+    double c = (a.x * b.x + a.y * b.y + a.z * b.z) / (na * nb);
+    return std::acos(std::clamp(c, -1.0, 1.0)) / kRad;
+}
+
+Quat from_euler_deg(double roll, double pitch) {
+    Quat qr{std::cos(roll * kRad / 2), std::sin(roll * kRad / 2), 0, 0};
+    Quat qp{std::cos(pitch * kRad / 2), 0, std::sin(pitch * kRad / 2), 0};
+    return mul(qp, qr);
+}
+
+int16_t counts(double v, double lsb) {
+    return int16_t(std::clamp(std::lround(v * lsb), long(INT16_MIN), long(INT16_MAX)));
+}
+
+struct Case {
+    const char *name;
+    double seconds;
+    double settle_s;        // errors are counted after this
+    double roll0, pitch0;   // true start orientation (deg)
+    double limit_deg;       // worst tilt error allowed
+    Vec (*rate_dps)(double t);
+    Vec (*lin_accel_g)(double t);   // world frame, on top of gravity
+};
+
+Vec none(double) { return {0, 0, 0}; }
+
+// 90 dps about X for 2 s, then back, repeated
+Vec roll_sweep(double t) { return {std::fmod(t, 4.0) < 2.0 ? 90.0 : -90.0, 0, 0}; }
+
+Vec wobble(double t) {
+    return {120 * std::sin(2 * kPi * 1.3 * t), 80 * std::sin(2 * kPi * 0.7 * t),
+            60 * std::sin(2 * kPi * 0.4 * t)};
+}
+
+// Board shaken back and forth at 3 Hz, 0.5 g, without rotating
+Vec shake(double t) { return {0.5 * std::sin(2 * kPi * 3 * t), 0, 0}; }
+
+const Case kCases[] = {
+    // The gyro bias is learnt by the integral term (time constant kp/ki = 50 s)
+    {"static tilt", 100, 90, 30, -20, 0.5, none, none},
+    {"roll sweep", 12, 1, 0, 0, 1.5, roll_sweep, none},
+    {"wobble", 20, 1, 0, 0, 1.5, wobble, none},
+    {"shake", 10, 5, 0, 20, 2.5, none, shake},
+};
+
+constexpr uint16_t kOdrs[] = {100, 400, 1600};
+
+struct Result {
+    double max_f32 = 0, rms_f32 = 0, max_q30 = 0, rms_q30 = 0;
+    double max_accel = 0, max_diff = 0;
+    double ns_f32 = 0, ns_q30 = 0;
+};
+
+Result run(const Case &c, uint16_t odr) {
+    std::mt19937 rng(1);
+    std::normal_distribution<double> accel_noise(0.0, 0.002);  // g
+    std::normal_distribution<double> gyro_noise(0.0, 0.05);    // dps
+    const Vec bias{0.5, -0.4, 0.3};                            // dps
+
+    const double dt = 1.0 / odr;
+    const int sub = std::max(1, 10000 / odr);
+    Quat truth = from_euler_deg(c.roll0, c.pitch0);
+
+    mahony_f32_t ff;
+    mahony_q30_t fq;
+    mahony_f32_init(&ff, kKp, kKi);
+    mahony_q30_init(&fq, kKp, kKi, odr, float(kGyroLsb));
+
+    Result r;
+    double sum_f32 = 0, sum_q30 = 0, t_f32 = 0, t_q30 = 0;
+    long n = 0;
+    const long steps = std::lround(c.seconds * odr);
+    for (long k = 0; k < steps; ++k) {
+        double t0 = k * dt;
+        Vec mean{0, 0, 0};
+        for (int s = 0; s < sub; ++s) {
+            Vec w = c.rate_dps(t0 + (s + 0.5) * dt / sub);
+            mean.x += w.x / sub;
+            mean.y += w.y / sub;
+            mean.z += w.z / sub;
+            truth = step(truth, {w.x * kRad, w.y * kRad, w.z * kRad}, dt / sub);
+        }
+        Vec lin = c.lin_accel_g(t0 + dt);
+        Vec a = to_body(truth, {lin.x, lin.y, 1.0 + lin.z});
+
+        int16_t gx = counts(mean.x + bias.x + gyro_noise(rng), kGyroLsb);
+        int16_t gy = counts(mean.y + bias.y + gyro_noise(rng), kGyroLsb);
+        int16_t gz = counts(mean.z + bias.z + gyro_noise(rng), kGyroLsb);
+        int16_t ax = counts(a.x + accel_noise(rng), kAccelLsb);
+        int16_t ay = counts(a.y + accel_noise(rng), kAccelLsb);
+        int16_t az = counts(a.z + accel_noise(rng), kAccelLsb);
+
+        // As imu_fusion.c feeds them
+        const float gs = float(kRad / kGyroLsb);
+        auto c0 = Clock::now();
+        mahony_f32_update(&ff, gx * gs, gy * gs, gz * gs, float(ax), float(ay), float(az),
+                          float(dt));
+        auto c1 = Clock::now();
+        mahony_q30_update(&fq, gx, gy, gz, ax, ay, az);
+        auto c2 = Clock::now();
+        t_f32 += std::chrono::duration<double, std::nano>(c1 - c0).count();
+        t_q30 += std::chrono::duration<double, std::nano>(c2 - c1).count();
+
+        if (t0 + dt < c.settle_s) continue;
+        Vec g = gravity(truth.w, truth.x, truth.y, truth.z);
+        Vec gf = gravity(ff.q0, ff.q1, ff.q2, ff.q3);
+        const double s30 = 1.0 / double(1 << 30);
+        Vec gq = gravity(fq.q[0] * s30, fq.q[1] * s30, fq.q[2] * s30, fq.q[3] * s30);
+        double ef = angle_deg(g, gf), eq = angle_deg(g, gq);
+        r.max_f32 = std::max(r.max_f32, ef);
+        r.max_q30 = std::max(r.max_q30, eq);
+        r.max_accel = std::max(r.max_accel, angle_deg(g, {double(ax), double(ay), double(az)}));
+        r.max_diff = std::max(r.max_diff, angle_deg(gf, gq));
+        sum_f32 += ef * ef;
+        sum_q30 += eq * eq;
+        n++;
+    }
+    r.rms_f32 = std::sqrt(sum_f32 / double(n));
+    r.rms_q30 = std::sqrt(sum_q30 / double(n));
+    r.ns_f32 = t_f32 / double(steps);
+    r.ns_q30 = t_q30 / double(steps);
+    return r;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "-v") verbose = true;
+        else { std::fprintf(stderr, "usage: %s [-v]\n", argv[0]); return 2; }
+    }
+
+    std::printf("%-12s %5s  %15s  %15s  %9s  %8s  %s\n", "case", "odr", "f32 rms/max",
+                "q30 rms/max", "accel max", "f32-q30", verbose ? "ns f32/q30" : "");
+    bool ok = true;
+    for (const Case &c : kCases) {
+        for (uint16_t odr : kOdrs) {
+            Result r = run(c, odr);
+            bool pass = r.max_f32 <= c.limit_deg && r.max_q30 <= c.limit_deg && r.max_diff <= 0.5;
+            ok = ok && pass;
+            std::printf("%-12s %5u  %6.2f / %6.2f  %6.2f / %6.2f  %9.2f  %8.3f", c.name, odr,
+                        r.rms_f32, r.max_f32, r.rms_q30, r.max_q30, r.max_accel, r.max_diff);
+            if (verbose) std::printf("  %5.1f / %5.1f", r.ns_f32, r.ns_q30);
+            std::printf("%s\n", pass ? "" : "  FAIL");
+        }
+    }
+    std::printf("(tilt error in degrees after settling)\n");
+    return ok ? 0 : 1;
+}
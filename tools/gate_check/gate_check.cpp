@@ -0,0 +1,169 @@
+// gate_check: the sound activity gate (tkjhat/mic_gate.h) on recordings
+// turned back into PDM, as mic_stream would see them on the board.
+//
+//   gate_check [-v] <file.wav ...>
+//
+// Each WAV (e.g. the mic_*.wav recordings) is brought to the microphone's
+// default 8 kHz by averaging sample pairs, with 2 s of the microphone's
+// self-noise before and after it: -90 dBFS at the PDM stream, i.e. -66
+// dBFS after the filter's gain of 16. The second-order sigma-delta
+// modulator of pdm_bench turns it into a 512 kHz (64x) bit stream, scaled
+// like a real microphone so that the gain of 16 brings it back to the
+// recorded level. The stream is cut into the driver's 32 ms buffers
+// (MEMS_BUFFER_SIZE samples) and each buffer goes through
+// mic_gate_energy() and mic_gate_update() with the default configuration.
+//
+// A buffer is loud when its source level is above -40 dBFS. Checks:
+//
+// - every loud buffer is gated open, or the gate opens within the
+//   mic_stream pre-roll (MIC_STREAM_PREROLL_DEFAULT buffers) after it, so
+//   the buffer is still filtered;
+// - every open buffer is loud, or within the hangover after a loud one:
+//   the gate does not open on the background;
+// - the gate stays closed over the leading self-noise (after the first
+//   buffer, which sets the floor) and is closed again at the end.
+//
+// Prints the duty cycle (buffers open / buffers) and the onsets per file,
+// -v the level, energy, floor and state of every buffer. The exit code is
+// 1 if any check failed.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pdm_modulator.hpp"
+#include "wav.hpp"
+
+extern "C" {
+#include "tkjhat/mic_gate.h"
+}
+
+namespace {
+
+// As sdk.h and mic_stream.h
+constexpr uint32_t kRate = 8000;            // MEMS_SAMPLING_FREQUENCY
+constexpr uint32_t kDecimation = 64;
+constexpr size_t kBufferSamples = 256;      // MEMS_BUFFER_SIZE
+constexpr size_t kPreroll = 2;              // MIC_STREAM_PREROLL_DEFAULT
+constexpr double kGain = 16.0;              // pdm_microphone.c filter Gain
+
+constexpr double kLoudDbfs = -40.0;
+constexpr double kSelfNoiseDbfs = -90.0;    // at the PDM stream
+constexpr uint32_t kPadSamples = 2 * kRate;
+
+int failures = 0;
+
+void check(bool ok, const char *what, long got, long want) {
+    if (!ok) {
+        std::printf("FAIL %s: got %ld, want %ld\n", what, got, want);
+        failures++;
+    }
+}
+
+// Source at 8 kHz, full scale 1.0, with the self-noise around it
+std::vector<double> source(const std::vector<int16_t> &pcm, uint32_t rate, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> noise(0.0, std::pow(10.0, kSelfNoiseDbfs / 20.0) * kGain);
+    std::vector<double> s;
+    for (uint32_t i = 0; i < kPadSamples; i++) s.push_back(noise(rng));
+    const size_t step = rate / kRate;
+    for (size_t i = 0; i + step <= pcm.size(); i += step) {
+        double sum = 0.0;
+        for (size_t k = 0; k < step; k++) sum += pcm[i + k];
+        s.push_back(sum / double(step) / 32768.0);
+    }
+    for (uint32_t i = 0; i < kPadSamples; i++) s.push_back(noise(rng));
+    return s;
+}
+
+double level_dbfs(const double *x, size_t n) {
+    double e = 0.0;
+    for (size_t i = 0; i < n; i++) e += x[i] * x[i];
+    return 10.0 * std::log10(e / double(n) + 1e-20);
+}
+
+void run(const std::string &path, bool verbose) {
+    uint32_t rate = 0;
+    std::vector<int16_t> pcm;
+    if (!wav::read(path, rate, pcm) || rate % kRate != 0) {
+        std::printf("FAIL %s: not a 16-bit WAV at a multiple of %u Hz\n", path.c_str(), kRate);
+        failures++;
+        return;
+    }
+    const std::vector<double> s = source(pcm, rate, 1);
+    const std::vector<uint8_t> bits = pdm::modulate(
+        s.size() * kDecimation, 1, [&](size_t i) { return s[i / kDecimation] / kGain; });
+
+    const size_t buffer_bytes = kBufferSamples * kDecimation / 8;
+    const uint32_t buffer_us = uint32_t(kBufferSamples * 1000000u / kRate);
+    const size_t n = bits.size() / buffer_bytes;
+
+    mic_gate_t g;
+    mic_gate_init(&g, nullptr);
+    std::vector<bool> open(n);
+    std::vector<double> db(n);
+    for (size_t b = 0; b < n; b++) {
+        uint32_t e = mic_gate_energy(&bits[b * buffer_bytes], buffer_bytes, kDecimation / 8);
+        open[b] = mic_gate_update(&g, e, buffer_us);
+        db[b] = level_dbfs(&s[b * kBufferSamples], kBufferSamples);
+        if (verbose) {
+            std::printf("%5zu %7.1f dBFS energy %6u floor %6u %s\n", b, db[b], g.energy, g.floor,
+                        open[b] ? "open" : "");
+        }
+    }
+
+    // Open buffers with no loud one in the hangover before them
+    const size_t hang = g.cfg.hangover_ms * 1000u / buffer_us + 1;
+    long stray = 0;
+    for (size_t b = 0; b < n; b++) {
+        bool explained = false;
+        for (size_t k = b >= hang ? b - hang : 0; k <= b; k++) {
+            explained = explained || db[k] > kLoudDbfs;
+        }
+        if (open[b] && !explained) stray++;
+    }
+
+    long loud = 0, missed = 0;
+    for (size_t b = 0; b < n; b++) {
+        if (db[b] <= kLoudDbfs) continue;
+        loud++;
+        bool kept = false;
+        for (size_t k = b; k <= b + kPreroll && k < n; k++) kept = kept || open[k];
+        if (!kept) missed++;
+    }
+    long open_lead = 0;
+    for (size_t b = 1; b < kPadSamples / kBufferSamples; b++) open_lead += open[b];
+
+    std::printf("%s: %u of %u buffers open (duty %.1f%%), %u onsets, %ld loud\n", path.c_str(),
+                g.open_buffers, g.buffers, 100.0 * g.open_buffers / g.buffers, g.onsets, loud);
+    std::string what = path + ": loud buffers outside the gate and pre-roll";
+    check(missed == 0, what.c_str(), missed, 0);
+    what = path + ": buffers open without a loud one in the hangover";
+    check(stray == 0, what.c_str(), stray, 0);
+    what = path + ": buffers open in the leading self-noise";
+    check(open_lead == 0, what.c_str(), open_lead, 0);
+    what = path + ": open at the end";
+    check(!g.open, what.c_str(), g.open, 0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bool verbose = false;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "-v") verbose = true;
+        else if (!a.empty() && a[0] != '-') files.push_back(a);
+        else { std::fprintf(stderr, "usage: %s [-v] <file.wav ...>\n", argv[0]); return 2; }
+    }
+    if (files.empty()) {
+        std::fprintf(stderr, "usage: %s [-v] <file.wav ...>\n", argv[0]);
+        return 2;
+    }
+    for (const std::string &f : files) run(f, verbose);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,158 @@
+// hdc_check: register and event sequence of the HDC2021 interrupt driver
+// (hdc2021_* in sdk.c) on host_pico against the Hdc2021 model.
+//
+//   hdc_check
+//
+// - hdc2021_configure() must stop auto mode before it changes the
+//   resolutions and restart it with MEAS_TRIG, in that order.
+// - hdc2021_enable_interrupts() must enable the requested events and the
+//   pin, active low and cleared on status read.
+// - With DRDY enabled at 5 Hz, every hdc2021_wait_sample() must return
+//   DRDY one period after the previous one, with the model's values, in
+//   one burst (two transfers) that releases the pin.
+// - A threshold crossing must show up with DRDY in the same sample.
+// - stop_hdc2021() must stop the measurements and the pin, after which a
+//   wait gives 0 at the timeout.
+//
+// Prints one line per failed check; the exit code is 1 if any failed.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include "hdc2021_model.hpp"
+#include "host_pico.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what, long got, long want) {
+    if (!ok) {
+        std::printf("FAIL %s: got %ld, want %ld\n", what, got, want);
+        failures++;
+    }
+}
+
+void check_configure(model::Hdc2021 &hdc) {
+    hdc.clear_log();
+    int rc = hdc2021_configure(HDC2021_RATE_5HZ, HDC2021_RES_14BIT, HDC2021_RES_11BIT);
+    check(rc == 0, "hdc2021_configure", rc, 0);
+
+    // CONFIG without AMM, MEASUREMENT_CONFIG, CONFIG with the rate, MEAS_TRIG
+    const auto w = hdc.writes();
+    const uint8_t meas = uint8_t(HDC2021_RES_11BIT << 4);
+    const struct { uint8_t reg, value, mask; } want[] = {
+        {HDC2021_CONFIG, 0x00, 0x70},
+        {HDC2021_MEASUREMENT_CONFIG, meas, 0xF1},
+        {HDC2021_CONFIG, uint8_t(HDC2021_RATE_5HZ << 4), 0x70},
+        {HDC2021_MEASUREMENT_CONFIG, uint8_t(meas | 0x01), 0xF1},
+    };
+    check(w.size() == 4, "writes in hdc2021_configure", long(w.size()), 4);
+    for (size_t i = 0; i < w.size() && i < 4; ++i) {
+        char what[48];
+        std::snprintf(what, sizeof(what), "configure write %zu register", i);
+        check(w[i].reg == want[i].reg, what, w[i].reg, want[i].reg);
+        std::snprintf(what, sizeof(what), "configure write %zu value", i);
+        check((w[i].value & want[i].mask) == want[i].value, what, w[i].value & want[i].mask,
+              want[i].value);
+    }
+    check(hdc2021_configure(hdc2021_rate_t(3), HDC2021_RES_14BIT, HDC2021_RES_14BIT) == -1,
+          "configure with rate 3", 0, -1);
+    check(hdc2021_configure(HDC2021_RATE_1HZ, hdc2021_resolution_t(3), HDC2021_RES_14BIT) == -1,
+          "configure with resolution 3", 0, -1);
+}
+
+void check_enable(model::Hdc2021 &hdc) {
+    check(hdc2021_enable_interrupts(0x01) == -1, "enable with a reserved bit", 0, -1);
+    int rc = hdc2021_enable_interrupts(HDC2021_EVT_DRDY | HDC2021_EVT_TEMP_HIGH);
+    check(rc == 0, "hdc2021_enable_interrupts", rc, 0);
+    check(hdc.reg(HDC2021_INT_ENABLE) == 0xC0, "INT_ENABLE", hdc.reg(HDC2021_INT_ENABLE), 0xC0);
+    check((hdc.reg(HDC2021_CONFIG) & 0x07) == 0x04, "CONFIG pin bits (enabled, low, latched)",
+          hdc.reg(HDC2021_CONFIG) & 0x07, 0x04);
+    check((hdc.reg(HDC2021_CONFIG) & 0x70) == (HDC2021_RATE_5HZ << 4), "CONFIG rate kept",
+          hdc.reg(HDC2021_CONFIG) & 0x70, HDC2021_RATE_5HZ << 4);
+    check(gpio_get(HDC2021_INTERRUPT), "pin released after enabling", 0, 1);
+}
+
+void check_samples(model::Hdc2021 &hdc) {
+    hdc2021_sample_t s;
+    uint64_t last_us = 0;
+    const int n = 20;
+    for (int i = 0; i < n; ++i) {
+        const double temp = 20.0 + 0.25 * i, rh = 35.0 + 0.5 * i;
+        hdc.set_climate(temp, rh);
+        const size_t transfers = host_i2c_transfers();
+        int rc = hdc2021_wait_sample(&s, 1000);
+        const uint64_t now = time_us_64();
+        char what[48];
+
+        std::snprintf(what, sizeof(what), "sample %d events", i);
+        check(rc == HDC2021_EVT_DRDY, what, rc, HDC2021_EVT_DRDY);
+        if (i > 0) {
+            // One 200 ms period, to the 1 ms step of the host clock
+            long gap_ms = long((now - last_us + 500) / 1000);
+            std::snprintf(what, sizeof(what), "sample %d ms since the last", i);
+            check(gap_ms >= 199 && gap_ms <= 201, what, gap_ms, 200);
+            std::snprintf(what, sizeof(what), "sample %d temperature mC", i);
+            check(std::fabs(s.temperature - temp) < 165.0 / 65536.0, what,
+                  std::lround(s.temperature * 1000), std::lround(temp * 1000));
+            std::snprintf(what, sizeof(what), "sample %d humidity m%%", i);
+            check(std::fabs(s.humidity - rh) < 100.0 / 65536.0, what,
+                  std::lround(s.humidity * 1000), std::lround(rh * 1000));
+            std::snprintf(what, sizeof(what), "sample %d I2C transfers", i);
+            check(host_i2c_transfers() - transfers == 2, what,
+                  long(host_i2c_transfers() - transfers), 2);
+        }
+        std::snprintf(what, sizeof(what), "sample %d pin released", i);
+        check(gpio_get(HDC2021_INTERRUPT), what, 0, 1);
+        last_us = now;
+    }
+    check(hdc.conversions() >= uint32_t(n), "conversions", hdc.conversions(), n);
+
+    // Above the high temperature threshold: flagged with the sample
+    hdc2021_set_high_temp_threshold(30.0f);
+    hdc.set_climate(35.0, 40.0);
+    int rc = hdc2021_wait_sample(&s, 1000);
+    check(rc == (HDC2021_EVT_DRDY | HDC2021_EVT_TEMP_HIGH), "events above the threshold", rc,
+          HDC2021_EVT_DRDY | HDC2021_EVT_TEMP_HIGH);
+    check(s.events == rc, "sample events", s.events, rc);
+}
+
+void check_stop(model::Hdc2021 &hdc) {
+    stop_hdc2021();
+    check((hdc.reg(HDC2021_CONFIG) & 0x7C) == 0, "CONFIG after stop (AMM, heater, pin)",
+          hdc.reg(HDC2021_CONFIG) & 0x7C, 0);
+    check((hdc.reg(HDC2021_MEASUREMENT_CONFIG) & 0x01) == 0, "MEAS_TRIG after stop",
+          hdc.reg(HDC2021_MEASUREMENT_CONFIG) & 0x01, 0);
+    check(hdc.reg(HDC2021_INT_ENABLE) == 0, "INT_ENABLE after stop", hdc.reg(HDC2021_INT_ENABLE),
+          0);
+
+    const uint32_t conversions = hdc.conversions();
+    hdc2021_sample_t s;
+    const uint64_t t0 = time_us_64();
+    int rc = hdc2021_wait_sample(&s, 500);
+    long waited_ms = long((time_us_64() - t0) / 1000);
+    check(rc == 0, "events after stop", rc, 0);
+    check(waited_ms == 500, "ms until timeout", waited_ms, 500);
+    check(hdc.conversions() == conversions, "conversions after stop", hdc.conversions(),
+          conversions);
+}
+
+} // namespace
+
+int main() {
+    host_pico_reset();
+    model::Hdc2021 hdc;
+    init_hdc2021_();
+    check((hdc.reg(HDC2021_CONFIG) & 0x70) == (HDC2021_RATE_1HZ << 4), "init rate",
+          hdc.reg(HDC2021_CONFIG) & 0x70, HDC2021_RATE_1HZ << 4);
+
+    check_configure(hdc);
+    check_enable(hdc);
+    check_samples(hdc);
+    check_stop(hdc);
+
+    std::printf("%s\n", failures ? "hdc_check: FAILED" : "hdc_check: ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,902 @@
+// host_pico: host model of the Pico SDK and FreeRTOS calls used by the
+// TKJHAT drivers. See host_pico.h.
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_pico.h"
+
+#include <pico/stdlib.h>
+#include <hardware/clocks.h>
+#include <hardware/dma.h>
+#include <hardware/gpio.h>
+#include <hardware/i2c.h>
+#include <hardware/irq.h>
+#include <hardware/pio.h>
+#include <hardware/pwm.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <stream_buffer.h>
+
+// A blocking call that is never satisfied gives up after this much virtual
+// time instead of hanging the test.
+#define HOST_MAX_BLOCK_US   (3600ull * 1000000ull)
+
+struct i2c_inst { int unused; };
+i2c_inst_t i2c0_inst;
+
+pio_hw_t host_pio0_hw, host_pio1_hw;
+dma_hw_t host_dma_hw;
+
+#define HOST_IRQ_COUNT      32
+#define HOST_GPIO_HANDLERS  4
+#define HOST_PIO_FIFO_MAX   8       // RX joined with TX
+
+static struct {
+    uint64_t now_us;
+    struct { host_tick_hook_t fn; void *ctx; } hooks[HOST_TICK_HOOKS];
+    unsigned hook_count;
+    bool in_hooks;
+
+    const host_i2c_device_t *i2c[128];
+    uint32_t i2c_transfers;
+    uint32_t i2c_baudrate;
+    bool i2c_bus_timing;
+    uint64_t i2c_bus_ns;        // bus time not yet added to the clock
+
+    struct {
+        bool out;               // direction
+        bool out_level;
+        gpio_function_t fn;
+        bool in_level;
+        bool pull_up;
+        uint32_t irq_enabled;   // GPIO_IRQ_* mask
+        uint32_t irq_pending;   // latched edges
+        irq_handler_t raw[HOST_GPIO_HANDLERS];
+    } gpio[NUM_BANK0_GPIOS];
+    gpio_irq_callback_t gpio_callback;
+
+    bool irq_enabled[HOST_IRQ_COUNT];
+    irq_handler_t irq_handler[HOST_IRQ_COUNT];
+
+    host_pwm_slice_t pwm[8];
+
+    struct host_sm {
+        bool enabled;
+        pio_sm_config cfg;
+        host_pio_source_t source;
+        host_pio_bit_source_t bit_source;
+        void *source_ctx;
+        uint32_t isr;           // input shift register, for bit sources
+        uint32_t fifo[HOST_PIO_FIFO_MAX];
+        unsigned fifo_head, fifo_count;
+        double next_word_ns;    // virtual time of the next autopush
+        uint32_t dropped;
+    } sm[2][NUM_PIO_STATE_MACHINES];
+
+    struct host_dma_ch {
+        bool claimed, busy;
+        dma_channel_config cfg;
+        uintptr_t read, write;  // full host addresses
+        uint32_t count, reload;
+        uint32_t transfers;
+    } dma[NUM_DMA_CHANNELS];
+    uint32_t dma_intr;          // raw completion flags
+    uint64_t dma_raised_ns[NUM_DMA_CHANNELS];
+    uint64_t dma_irq_latency_ns;
+    bool in_dma;
+
+    uint32_t notifications;
+    bool task_running;          // inside a task started by xTaskCreate()
+    uint64_t task_until_us;
+    bool task_defer;            // keep the next created task for host_task_start()
+    TaskFunction_t deferred;
+    void *deferred_arg;
+} host;
+
+static jmp_buf host_task_exit;
+
+void host_pico_reset(void) {
+    memset(&host, 0, sizeof(host));
+    memset(&host_dma_hw, 0, sizeof(host_dma_hw));
+    memset(&host_pio0_hw, 0, sizeof(host_pio0_hw));
+    memset(&host_pio1_hw, 0, sizeof(host_pio1_hw));
+    for (unsigned int i = 0; i < NUM_BANK0_GPIOS; i++) host.gpio[i].fn = GPIO_FUNC_NULL;
+}
+
+/* ---------- time ---------- */
+
+static void host_run_hooks(void) {
+    // A hook may sleep (e.g. through a driver call); don't recurse
+    if (host.in_hooks) return;
+    host.in_hooks = true;
+    for (unsigned i = 0; i < host.hook_count; ++i) {
+        host.hooks[i].fn(host.hooks[i].ctx, host.now_us);
+    }
+    host.in_hooks = false;
+}
+
+static void host_pio_dma_run(uint64_t to_us);
+
+void host_time_advance_us(uint64_t us) {
+    const uint64_t to_us = host.now_us + us;
+    host_pio_dma_run(to_us);
+    host.now_us = to_us;
+    host_run_hooks();
+}
+
+void host_add_tick_hook(host_tick_hook_t hook, void *ctx) {
+    if (host.hook_count == HOST_TICK_HOOKS) {
+        fprintf(stderr, "host_pico: too many tick hooks\n");
+        abort();
+    }
+    host.hooks[host.hook_count].fn = hook;
+    host.hooks[host.hook_count].ctx = ctx;
+    host.hook_count++;
+}
+
+// Sleep in 1 ms steps so device models see time pass at a useful rate
+static void host_sleep_us(uint64_t us) {
+    while (us > 1000) {
+        host_time_advance_us(1000);
+        us -= 1000;
+    }
+    host_time_advance_us(us);
+}
+
+void sleep_ms(uint32_t ms) { host_sleep_us((uint64_t)ms * 1000u); }
+void sleep_us(uint64_t us) { host_sleep_us(us); }
+void busy_wait_us(uint64_t delay_us) { host_sleep_us(delay_us); }
+void busy_wait_us_32(uint32_t delay_us) { host_sleep_us(delay_us); }
+uint32_t time_us_32(void) { return (uint32_t)host.now_us; }
+uint64_t time_us_64(void) { return host.now_us; }
+absolute_time_t get_absolute_time(void) { return host.now_us; }
+uint get_core_num(void) { return 0; }
+
+/* ---------- I2C ---------- */
+
+void host_i2c_attach(uint8_t addr, const host_i2c_device_t *dev) {
+    host.i2c[addr & 0x7F] = dev;
+}
+
+uint32_t host_i2c_transfers(void) {
+    return host.i2c_transfers;
+}
+
+void host_i2c_set_bus_timing(bool on) {
+    host.i2c_bus_timing = on;
+}
+
+unsigned int i2c_init(i2c_inst_t *i2c, unsigned int baudrate) {
+    (void)i2c;
+    host.i2c_baudrate = baudrate;
+    return baudrate;
+}
+
+// Address byte and @p len data bytes with their ACKs, start and stop
+static void host_i2c_bus_time(size_t len) {
+    if (!host.i2c_bus_timing || host.i2c_baudrate == 0) return;
+    host.i2c_bus_ns += ((len + 1) * 9 + 2) * 1000000000ull / host.i2c_baudrate;
+    host_time_advance_us(host.i2c_bus_ns / 1000);
+    host.i2c_bus_ns %= 1000;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    (void)i2c;
+    host.i2c_transfers++;
+    const host_i2c_device_t *dev = host.i2c[addr & 0x7F];
+    if (dev == NULL || dev->write == NULL) return PICO_ERROR_GENERIC;
+    host_i2c_bus_time(len);
+    return dev->write(dev->ctx, src, len, nostop);
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
+    (void)i2c;
+    host.i2c_transfers++;
+    const host_i2c_device_t *dev = host.i2c[addr & 0x7F];
+    if (dev == NULL || dev->read == NULL) return PICO_ERROR_GENERIC;
+    host_i2c_bus_time(len);
+    return dev->read(dev->ctx, dst, len, nostop);
+}
+
+/* ---------- IRQ ---------- */
+
+void irq_set_enabled(unsigned int num, bool enabled) {
+    if (num < HOST_IRQ_COUNT) host.irq_enabled[num] = enabled;
+}
+
+bool irq_is_enabled(unsigned int num) {
+    return num < HOST_IRQ_COUNT && host.irq_enabled[num];
+}
+
+void irq_set_exclusive_handler(unsigned int num, irq_handler_t handler) {
+    if (num < HOST_IRQ_COUNT) host.irq_handler[num] = handler;
+}
+
+/* ---------- GPIO ---------- */
+
+void gpio_init(unsigned int gpio) {
+    host.gpio[gpio].out = false;
+    host.gpio[gpio].out_level = false;
+    host.gpio[gpio].fn = GPIO_FUNC_SIO;
+}
+
+void gpio_deinit(unsigned int gpio) {
+    host.gpio[gpio].out = false;
+}
+
+void gpio_set_function(unsigned int gpio, gpio_function_t fn) { host.gpio[gpio].fn = fn; }
+
+void gpio_set_dir(unsigned int gpio, bool out) { host.gpio[gpio].out = out; }
+void gpio_put(unsigned int gpio, bool value) { host.gpio[gpio].out_level = value; }
+
+bool gpio_get(unsigned int gpio) {
+    return host.gpio[gpio].out ? host.gpio[gpio].out_level : host.gpio[gpio].in_level;
+}
+
+// An undriven input follows its pull (open-drain interrupt lines idle high)
+void gpio_pull_up(unsigned int gpio) {
+    host.gpio[gpio].pull_up = true;
+    host.gpio[gpio].in_level = true;
+}
+
+void gpio_pull_down(unsigned int gpio) {
+    host.gpio[gpio].pull_up = false;
+    host.gpio[gpio].in_level = false;
+}
+
+void gpio_disable_pulls(unsigned int gpio) { host.gpio[gpio].pull_up = false; }
+
+void gpio_set_irq_enabled(unsigned int gpio, uint32_t event_mask, bool enabled) {
+    if (enabled) {
+        host.gpio[gpio].irq_enabled |= event_mask;
+    } else {
+        host.gpio[gpio].irq_enabled &= ~event_mask;
+    }
+}
+
+void gpio_set_irq_enabled_with_callback(unsigned int gpio, uint32_t event_mask,
+                                        bool enabled, gpio_irq_callback_t callback) {
+    gpio_set_irq_enabled(gpio, event_mask, enabled);
+    host.gpio_callback = callback;
+    irq_set_enabled(IO_IRQ_BANK0, true);
+}
+
+void gpio_add_raw_irq_handler(unsigned int gpio, irq_handler_t handler) {
+    for (unsigned i = 0; i < HOST_GPIO_HANDLERS; ++i) {
+        if (host.gpio[gpio].raw[i] == NULL) {
+            host.gpio[gpio].raw[i] = handler;
+            return;
+        }
+    }
+    fprintf(stderr, "host_pico: too many handlers on GPIO %u\n", gpio);
+    abort();
+}
+
+void gpio_remove_raw_irq_handler(unsigned int gpio, irq_handler_t handler) {
+    for (unsigned i = 0; i < HOST_GPIO_HANDLERS; ++i) {
+        if (host.gpio[gpio].raw[i] == handler) host.gpio[gpio].raw[i] = NULL;
+    }
+}
+
+uint32_t gpio_get_irq_event_mask(unsigned int gpio) {
+    return host.gpio[gpio].irq_pending & host.gpio[gpio].irq_enabled;
+}
+
+void gpio_acknowledge_irq(unsigned int gpio, uint32_t event_mask) {
+    host.gpio[gpio].irq_pending &= ~event_mask;
+}
+
+void host_gpio_set_input(unsigned int gpio, bool level) {
+    bool old = host.gpio[gpio].in_level;
+    host.gpio[gpio].in_level = level;
+    if (old == level) return;
+
+    uint32_t edge = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if (!(host.gpio[gpio].irq_enabled & edge)) return;
+    host.gpio[gpio].irq_pending |= edge;
+    if (!host.irq_enabled[IO_IRQ_BANK0]) return;
+
+    // Raw handlers first, as the SDK's shared GPIO handler does
+    for (unsigned i = 0; i < HOST_GPIO_HANDLERS; ++i) {
+        if (host.gpio[gpio].raw[i] != NULL) host.gpio[gpio].raw[i]();
+    }
+    if (host.gpio_callback != NULL && (host.gpio[gpio].irq_pending & edge)) {
+        gpio_acknowledge_irq(gpio, edge);
+        host.gpio_callback(gpio, edge);
+    }
+}
+
+bool host_gpio_output(unsigned int gpio) {
+    return host.gpio[gpio].out_level;
+}
+
+/* ---------- PWM ---------- */
+
+void pwm_set_clkdiv(unsigned int slice_num, float divider) {
+    host.pwm[slice_num & 7].clkdiv = divider;
+}
+
+void pwm_set_wrap(unsigned int slice_num, uint16_t wrap) {
+    host.pwm[slice_num & 7].wrap = wrap;
+}
+
+void pwm_set_gpio_level(unsigned int gpio, uint16_t level) {
+    host.pwm[pwm_gpio_to_slice_num(gpio)].level[pwm_gpio_to_channel(gpio)] = level;
+}
+
+void pwm_set_enabled(unsigned int slice_num, bool enabled) {
+    host.pwm[slice_num & 7].enabled = enabled;
+}
+
+unsigned int host_gpio_function(unsigned int gpio) { return host.gpio[gpio].fn; }
+
+const host_pwm_slice_t *host_pwm_slice(unsigned int slice_num) {
+    return &host.pwm[slice_num & 7];
+}
+
+/* ---------- PIO ---------- */
+
+static struct host_sm *host_sm_of(PIO pio, uint sm) {
+    return &host.sm[pio_get_index(pio)][sm % NUM_PIO_STATE_MACHINES];
+}
+
+// One autopush per push threshold of input bits; the divider has 8
+// fractional bits, as in SMx_CLKDIV
+static double host_sm_word_ns(const struct host_sm *s) {
+    double div = (double)(uint32_t)(s->cfg.clkdiv * 256.0f) / 256.0;
+    double cycles = (double)s->cfg.wrap_cycles * s->cfg.push_threshold / s->cfg.wrap_in_bits;
+    return cycles * div * 1e9 / HOST_CLK_SYS_HZ;
+}
+
+static bool host_sm_runs(const struct host_sm *s) {
+    return s->enabled && (s->source != NULL || s->bit_source != NULL) && s->cfg.autopush &&
+           s->cfg.wrap_in_bits != 0;
+}
+
+// Shift bits in up to the push threshold, as the IN instructions do
+static uint32_t host_sm_shift_in(struct host_sm *s) {
+    for (uint i = 0; i < s->cfg.push_threshold; ++i) {
+        uint32_t bit = s->bit_source(s->source_ctx) ? 1u : 0u;
+        s->isr = s->cfg.in_shift_right ? (s->isr >> 1) | (bit << 31) : (s->isr << 1) | bit;
+    }
+    uint32_t word = s->isr;
+    s->isr = 0;
+    return word;
+}
+
+static void host_sm_push(struct host_sm *s, uint32_t word) {
+    unsigned depth = s->cfg.fifo_join == PIO_FIFO_JOIN_RX ? HOST_PIO_FIFO_MAX : 4;
+    if (s->fifo_count == depth) {
+        s->dropped++;           // the state machine stalls and misses the bits
+        return;
+    }
+    s->fifo[(s->fifo_head + s->fifo_count) % HOST_PIO_FIFO_MAX] = word;
+    s->fifo_count++;
+}
+
+static uint32_t host_sm_pop(struct host_sm *s) {
+    uint32_t word = s->fifo[s->fifo_head];
+    s->fifo_head = (s->fifo_head + 1) % HOST_PIO_FIFO_MAX;
+    s->fifo_count--;
+    return word;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *program) {
+    (void)pio;
+    (void)program;
+    return 0;
+}
+
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config) {
+    (void)initial_pc;
+    struct host_sm *s = host_sm_of(pio, sm);
+    s->cfg = *config;
+    s->enabled = false;
+    s->fifo_count = 0;
+    s->isr = 0;
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) {
+    struct host_sm *s = host_sm_of(pio, sm);
+    if (enabled && !s->enabled && s->cfg.wrap_in_bits != 0) {
+        s->next_word_ns = (double)host.now_us * 1000.0 + host_sm_word_ns(s);
+    }
+    s->enabled = enabled;
+}
+
+void pio_sm_clear_fifos(PIO pio, uint sm) {
+    host_sm_of(pio, sm)->fifo_count = 0;
+}
+
+void pio_sm_restart(PIO pio, uint sm) {
+    // The input shift counter starts over
+    struct host_sm *s = host_sm_of(pio, sm);
+    s->isr = 0;
+    if (s->enabled && s->cfg.wrap_in_bits != 0) {
+        s->next_word_ns = (double)host.now_us * 1000.0 + host_sm_word_ns(s);
+    }
+}
+
+int pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pins_base, uint pin_count, bool is_out) {
+    (void)pio;
+    (void)sm;
+    (void)pins_base;
+    (void)pin_count;
+    (void)is_out;
+    return PICO_OK;
+}
+
+void pio_gpio_init(PIO pio, uint pin) {
+    gpio_set_function(pin, pio == pio1 ? GPIO_FUNC_PIO1 : GPIO_FUNC_PIO0);
+}
+
+void host_pio_set_source(unsigned int pio, unsigned int sm, host_pio_source_t source, void *ctx) {
+    struct host_sm *s = &host.sm[pio & 1][sm % NUM_PIO_STATE_MACHINES];
+    s->source = source;
+    s->bit_source = NULL;
+    s->source_ctx = ctx;
+}
+
+void host_pio_set_bit_source(unsigned int pio, unsigned int sm, host_pio_bit_source_t source,
+                             void *ctx) {
+    struct host_sm *s = &host.sm[pio & 1][sm % NUM_PIO_STATE_MACHINES];
+    s->source = NULL;
+    s->bit_source = source;
+    s->source_ctx = ctx;
+}
+
+uint32_t host_pio_rx_dropped(unsigned int pio, unsigned int sm) {
+    return host.sm[pio & 1][sm % NUM_PIO_STATE_MACHINES].dropped;
+}
+
+/* ---------- DMA ---------- */
+
+// The RX FIFO a paced channel waits on, NULL if it is not a PIO RX DREQ
+static struct host_sm *host_dma_rx_sm(const struct host_dma_ch *c) {
+    uint dreq = c->cfg.dreq;
+    if (dreq >= 16 || (dreq & 4) == 0) return NULL;
+    return &host.sm[dreq >> 3][dreq & 3];
+}
+
+// A 32-bit register value back to a host address near one the channel has
+static uintptr_t host_dma_addr(uint32_t value, uintptr_t near) {
+    if (sizeof(uintptr_t) == sizeof(uint32_t)) return value;
+    uint64_t best = ((uint64_t)near & ~(uint64_t)0xffffffffu) | value;
+    if (best > (uint64_t)near + 0x80000000u) best -= 0x100000000ull;
+    else if (best + 0x80000000u < (uint64_t)near) best += 0x100000000ull;
+    return (uintptr_t)best;
+}
+
+static void host_dma_mirror(uint ch) {
+    struct host_dma_ch *c = &host.dma[ch];
+    dma_channel_hw_t *hw = &host_dma_hw.ch[ch];
+    hw->read_addr = hw->al1_read_addr = hw->al2_read_addr = hw->al3_read_addr_trig =
+        (uint32_t)c->read;
+    hw->write_addr = hw->al1_write_addr = hw->al2_write_addr_trig = hw->al3_write_addr =
+        (uint32_t)c->write;
+    hw->transfer_count = hw->al1_transfer_count_trig = hw->al2_transfer_count =
+        hw->al3_transfer_count = c->count;
+}
+
+static void host_dma_trigger(uint ch) {
+    struct host_dma_ch *c = &host.dma[ch];
+    c->count = c->reload;
+    c->busy = c->cfg.enable && c->count != 0;
+    host_dma_mirror(ch);
+}
+
+// A channel writing the DMA registers: the address and count aliases, and
+// the trigger aliases. CTRL writes are not decoded.
+static void host_dma_reg_write(size_t offset, uint32_t value) {
+    if (offset >= sizeof(host_dma_hw.ch)) {
+        if (offset == offsetof(dma_hw_t, ints0) || offset == offsetof(dma_hw_t, ints1)) {
+            host.dma_intr &= ~value;
+        }
+        return;
+    }
+    uint ch = (uint)(offset / sizeof(dma_channel_hw_t));
+    unsigned reg = (unsigned)(offset % sizeof(dma_channel_hw_t)) / 4;
+    struct host_dma_ch *c = &host.dma[ch];
+    switch (reg) {
+        case 0: case 5: case 10: case 15: c->read = host_dma_addr(value, c->read); break;
+        case 1: case 6: case 11: case 13: c->write = host_dma_addr(value, c->write); break;
+        case 2: case 7: case 9: case 14: c->reload = value; break;
+        default: break;
+    }
+    host_dma_mirror(ch);
+    if (reg == 3 || reg == 7 || reg == 11 || reg == 15) host_dma_trigger(ch);
+}
+
+static uint32_t host_dma_load(uintptr_t addr, unsigned size) {
+    for (unsigned p = 0; p < 2; ++p) {
+        pio_hw_t *hw = p ? pio1 : pio0;
+        for (unsigned sm = 0; sm < NUM_PIO_STATE_MACHINES; ++sm) {
+            if (addr == (uintptr_t)&hw->rxf[sm]) return host_sm_pop(&host.sm[p][sm]);
+        }
+    }
+    uint32_t v = 0;
+    memcpy(&v, (const void *)addr, size);
+    return v;
+}
+
+static void host_dma_store(uintptr_t addr, uint32_t value, unsigned size) {
+    uintptr_t regs = (uintptr_t)&host_dma_hw;
+    if (addr >= regs && addr < regs + sizeof(host_dma_hw)) {
+        host_dma_reg_write(addr - regs, value);
+        return;
+    }
+    memcpy((void *)addr, &value, size);
+}
+
+static uintptr_t host_dma_next(uintptr_t addr, bool incr, unsigned size, uint ring_bits) {
+    if (!incr) return addr;
+    if (ring_bits == 0) return addr + size;
+    uintptr_t mask = ((uintptr_t)1 << ring_bits) - 1;
+    return (addr & ~mask) | ((addr + size) & mask);
+}
+
+static void host_dma_transfer(uint ch, uint64_t t_ns) {
+    struct host_dma_ch *c = &host.dma[ch];
+    unsigned size = 1u << c->cfg.size;
+    uint32_t v = host_dma_load(c->read, size);
+    if (c->cfg.bswap && size == 4) v = __builtin_bswap32(v);
+    if (c->cfg.bswap && size == 2) v = __builtin_bswap16((uint16_t)v);
+    uintptr_t to = c->write;
+    c->read = host_dma_next(c->read, c->cfg.read_increment, size,
+                            c->cfg.ring_write ? 0 : c->cfg.ring_size_bits);
+    c->write = host_dma_next(c->write, c->cfg.write_increment, size,
+                             c->cfg.ring_write ? c->cfg.ring_size_bits : 0);
+    c->transfers++;
+    bool done = --c->count == 0;
+    if (done) c->busy = false;
+    host_dma_mirror(ch);
+    host_dma_store(to, v, size);
+    if (done) {
+        if (!(host.dma_intr & (1u << ch))) host.dma_raised_ns[ch] = t_ns;
+        host.dma_intr |= 1u << ch;
+        if (c->cfg.chain_to != ch) host_dma_trigger(c->cfg.chain_to);
+    }
+}
+
+// Move what can move now: unpaced channels to the end, paced ones while
+// their FIFO has words
+static void host_dma_service(uint64_t t_ns) {
+    bool moved = true;
+    while (moved) {
+        moved = false;
+        for (uint ch = 0; ch < NUM_DMA_CHANNELS; ++ch) {
+            struct host_dma_ch *c = &host.dma[ch];
+            if (!c->busy) continue;
+            if (c->cfg.dreq == DREQ_FORCE) {
+                while (c->busy) host_dma_transfer(ch, t_ns);
+                moved = true;
+            } else {
+                struct host_sm *s = host_dma_rx_sm(c);
+                if (s != NULL && s->fifo_count != 0) {
+                    host_dma_transfer(ch, t_ns);
+                    moved = true;
+                }
+            }
+        }
+    }
+}
+
+// The ints registers are write-1-to-clear and read back 0
+static void host_dma_apply_clears(void) {
+    host.dma_intr &= ~(host_dma_hw.ints0 | host_dma_hw.ints1);
+    host_dma_hw.ints0 = 0;
+    host_dma_hw.ints1 = 0;
+}
+
+// Run the handler of each DMA IRQ line that has been asserted for the
+// configured latency at @p t_ns
+static void host_dma_irq_poll(uint64_t t_ns) {
+    host_dma_apply_clears();
+    for (unsigned line = 0; line < 2; ++line) {
+        unsigned num = line ? DMA_IRQ_1 : DMA_IRQ_0;
+        uint32_t ints = host.dma_intr & (line ? host_dma_hw.inte1 : host_dma_hw.inte0);
+        if (ints == 0 || !host.irq_enabled[num] || host.irq_handler[num] == NULL) continue;
+        uint64_t since = UINT64_MAX;
+        for (uint ch = 0; ch < NUM_DMA_CHANNELS; ++ch) {
+            if ((ints & (1u << ch)) && host.dma_raised_ns[ch] < since) since = host.dma_raised_ns[ch];
+        }
+        if (t_ns < since + host.dma_irq_latency_ns) continue;
+        host.irq_handler[num]();
+        host_dma_apply_clears();
+    }
+}
+
+// Step the state machines and the DMA word by word up to @p to_us. The
+// clock shows the time of each word while its interrupts run.
+static void host_pio_dma_run(uint64_t to_us) {
+    if (host.in_dma) return;    // an interrupt handler that sleeps
+    host.in_dma = true;
+    const double end_ns = (double)to_us * 1000.0;
+    for (;;) {
+        struct host_sm *next = NULL;
+        for (unsigned p = 0; p < 2; ++p) {
+            for (unsigned sm = 0; sm < NUM_PIO_STATE_MACHINES; ++sm) {
+                struct host_sm *s = &host.sm[p][sm];
+                if (host_sm_runs(s) && s->next_word_ns <= end_ns &&
+                    (next == NULL || s->next_word_ns < next->next_word_ns)) {
+                    next = s;
+                }
+            }
+        }
+        if (next == NULL) break;
+        const uint64_t t_ns = (uint64_t)next->next_word_ns;
+        if (t_ns / 1000 > host.now_us) host.now_us = t_ns / 1000;
+        host_dma_irq_poll(t_ns);
+        host_sm_push(next, next->bit_source != NULL ? host_sm_shift_in(next)
+                                                    : next->source(next->source_ctx));
+        next->next_word_ns += host_sm_word_ns(next);
+        host_dma_service(t_ns);
+        host_dma_irq_poll(t_ns);
+    }
+    host_dma_irq_poll(to_us * 1000);
+    host.in_dma = false;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    dma_channel_config c = {DMA_SIZE_32, true, false, false, 0, DREQ_FORCE, channel, false, true};
+    return c;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config,
+                           volatile void *write_addr, const volatile void *read_addr,
+                           uint transfer_count, bool trigger) {
+    struct host_dma_ch *c = &host.dma[channel];
+    c->cfg = *config;
+    c->read = (uintptr_t)read_addr;
+    c->write = (uintptr_t)write_addr;
+    c->reload = transfer_count;
+    host_dma_mirror(channel);
+    if (trigger) dma_channel_start(channel);
+}
+
+int dma_claim_unused_channel(bool required) {
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ++ch) {
+        if (!host.dma[ch].claimed) {
+            host.dma[ch].claimed = true;
+            return (int)ch;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "host_pico: no DMA channel left\n");
+        abort();
+    }
+    return -1;
+}
+
+void dma_channel_unclaim(uint channel) {
+    host.dma[channel].claimed = false;
+}
+
+void dma_channel_start(uint channel) {
+    host_dma_trigger(channel);
+    host_dma_service(host.now_us * 1000);
+}
+
+void dma_channel_abort(uint channel) {
+    host.dma[channel].busy = false;
+    host.dma[channel].count = 0;
+    host_dma_mirror(channel);
+}
+
+bool dma_channel_is_busy(uint channel) {
+    return host.dma[channel].busy;
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled) {
+    if (enabled) host_dma_hw.inte0 |= 1u << channel;
+    else host_dma_hw.inte0 &= ~(1u << channel);
+}
+
+void dma_channel_set_irq1_enabled(uint channel, bool enabled) {
+    if (enabled) host_dma_hw.inte1 |= 1u << channel;
+    else host_dma_hw.inte1 &= ~(1u << channel);
+}
+
+uint32_t host_dma_transfers(unsigned int channel) {
+    return host.dma[channel % NUM_DMA_CHANNELS].transfers;
+}
+
+void host_dma_set_irq_latency_us(uint32_t us) {
+    host.dma_irq_latency_ns = (uint64_t)us * 1000u;
+}
+
+/* ---------- FreeRTOS ---------- */
+
+static struct tskTaskControlBlock { int unused; } host_task, host_created_task;
+
+void host_task_run_until(uint64_t us) {
+    host.task_until_us = us;
+}
+
+// A created task gives the thread back once it blocks past its time
+static void host_task_block_point(void) {
+    if (host.task_running && !host.in_hooks && host.now_us >= host.task_until_us) {
+        longjmp(host_task_exit, 1);
+    }
+}
+
+static void host_task_run(TaskFunction_t fn, void *arg) {
+    host.task_running = true;
+    if (setjmp(host_task_exit) == 0) {
+        fn(arg);
+    }
+    host.task_running = false;
+    host.task_until_us = 0;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char *pcName,
+                       configSTACK_DEPTH_TYPE uxStackDepth, void *pvParameters,
+                       UBaseType_t uxPriority, TaskHandle_t *pxCreatedTask) {
+    (void)pcName;
+    (void)uxStackDepth;
+    (void)uxPriority;
+    if (host.task_defer && host.deferred == NULL && !host.task_running) {
+        host.task_defer = false;
+        host.deferred = pxTaskCode;
+        host.deferred_arg = pvParameters;
+        if (pxCreatedTask != NULL) *pxCreatedTask = &host_created_task;
+        return pdPASS;
+    }
+    if (host.task_until_us == 0 || host.task_running) return pdFAIL;
+    if (pxCreatedTask != NULL) *pxCreatedTask = &host_created_task;
+    host_task_run(pxTaskCode, pvParameters);
+    return pdPASS;
+}
+
+void host_task_defer(void) {
+    host.task_defer = true;
+}
+
+void host_task_start(uint64_t us) {
+    TaskFunction_t fn = host.deferred;
+    if (fn == NULL || host.task_running) return;
+    host.deferred = NULL;
+    host.task_until_us = us;
+    host_task_run(fn, host.deferred_arg);
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete) {
+    if (xTaskToDelete == NULL && host.task_running) longjmp(host_task_exit, 1);
+}
+
+void vTaskCoreAffinitySet(TaskHandle_t xTask, UBaseType_t uxCoreAffinityMask) {
+    (void)xTask;
+    (void)uxCoreAffinityMask;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask) {
+    (void)xTask;
+    return 0;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return &host_task;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(host.now_us / (1000000u / configTICK_RATE_HZ));
+}
+
+TickType_t xTaskGetTickCountFromISR(void) {
+    return xTaskGetTickCount();
+}
+
+// Blocked tasks wake on a tick interrupt, at the start of the tick
+static void host_sleep_until_tick(TickType_t tick) {
+    host_task_block_point();
+    uint64_t at = (uint64_t)tick * (1000000u / configTICK_RATE_HZ);
+    if (at > host.now_us) host_sleep_us(at - host.now_us);
+}
+
+void vTaskDelay(TickType_t xTicksToDelay) {
+    host_sleep_until_tick(xTaskGetTickCount() + xTicksToDelay);
+}
+
+BaseType_t xTaskDelayUntil(TickType_t *pxPreviousWakeTime, TickType_t xTimeIncrement) {
+    TickType_t wake = *pxPreviousWakeTime + xTimeIncrement;
+    TickType_t now = xTaskGetTickCount();
+    *pxPreviousWakeTime = wake;
+    if ((int32_t)(wake - now) <= 0) return pdFALSE;
+    host_sleep_until_tick(wake);
+    return pdTRUE;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken) {
+    (void)xTaskToNotify;
+    host.notifications++;
+    if (pxHigherPriorityTaskWoken != NULL) *pxHigherPriorityTaskWoken = pdTRUE;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify) {
+    (void)xTaskToNotify;
+    host.notifications++;
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait) {
+    uint64_t waited = 0;
+    while (host.notifications == 0) {
+        if (xTicksToWait != portMAX_DELAY &&
+            waited >= (uint64_t)xTicksToWait * (1000000u / configTICK_RATE_HZ)) {
+            return 0;
+        }
+        if (waited >= HOST_MAX_BLOCK_US) return 0;
+        host_task_block_point();
+        host_time_advance_us(1000);
+        waited += 1000;
+    }
+    uint32_t count = host.notifications;
+    host.notifications = xClearCountOnExit ? 0 : count - 1;
+    return count;
+}
+
+uint32_t host_task_notifications(void) {
+    return host.notifications;
+}
+
+// One FIFO of bytes; the only task cannot fill it while it waits
+struct StreamBufferDef_t {
+    uint8_t *data;
+    size_t size, head, count;
+};
+
+StreamBufferHandle_t xStreamBufferCreate(size_t xBufferSizeBytes, size_t xTriggerLevelBytes) {
+    (void)xTriggerLevelBytes;
+    StreamBufferHandle_t sb = calloc(1, sizeof(*sb));
+    if (sb == NULL) return NULL;
+    sb->data = malloc(xBufferSizeBytes);
+    sb->size = xBufferSizeBytes;
+    if (sb->data == NULL) {
+        free(sb);
+        return NULL;
+    }
+    return sb;
+}
+
+void vStreamBufferDelete(StreamBufferHandle_t xStreamBuffer) {
+    if (xStreamBuffer == NULL) return;
+    free(xStreamBuffer->data);
+    free(xStreamBuffer);
+}
+
+size_t xStreamBufferSend(StreamBufferHandle_t xStreamBuffer, const void *pvTxData,
+                         size_t xDataLengthBytes, TickType_t xTicksToWait) {
+    (void)xTicksToWait;
+    StreamBufferHandle_t sb = xStreamBuffer;
+    size_t n = sb->size - sb->count;
+    if (n > xDataLengthBytes) n = xDataLengthBytes;
+    for (size_t i = 0; i < n; i++) {
+        sb->data[(sb->head + sb->count + i) % sb->size] = ((const uint8_t *)pvTxData)[i];
+    }
+    sb->count += n;
+    return n;
+}
+
+size_t xStreamBufferReceive(StreamBufferHandle_t xStreamBuffer, void *pvRxData,
+                            size_t xBufferLengthBytes, TickType_t xTicksToWait) {
+    StreamBufferHandle_t sb = xStreamBuffer;
+    if (sb->count == 0) {
+        // Nothing can arrive: wait out the timeout, as a reader would
+        if (xTicksToWait != portMAX_DELAY) vTaskDelay(xTicksToWait);
+        return 0;
+    }
+    size_t n = sb->count < xBufferLengthBytes ? sb->count : xBufferLengthBytes;
+    for (size_t i = 0; i < n; i++) {
+        ((uint8_t *)pvRxData)[i] = sb->data[(sb->head + i) % sb->size];
+    }
+    sb->head = (sb->head + n) % sb->size;
+    sb->count -= n;
+    return n;
+}
+
+size_t xStreamBufferBytesAvailable(StreamBufferHandle_t xStreamBuffer) {
+    return xStreamBuffer->count;
+}
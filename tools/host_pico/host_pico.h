@@ -0,0 +1,127 @@
+// host_pico: a host model of the parts of the Pico SDK and FreeRTOS that
+// the TKJHAT driver code uses, so drivers can run unchanged on the PC
+// against simulated sensors.
+//
+// - Time is virtual. It only moves when the code under test sleeps, busy
+//   waits or blocks on a task notification, or when the test advances it.
+// - I2C transfers are routed by address to device models.
+// - GPIO inputs are driven by the test; edges raise the GPIO interrupt
+//   and run the registered handlers immediately.
+// - PIO state machines are modelled by their timing: one with a word
+//   source pushes to its RX FIFO at the rate its clock divider gives, and
+//   the DMA channels paced by it move the words as they arrive. DMA
+//   completion interrupts run their handler at the completing word.
+// - There is one task, the calling thread. Notifications from interrupt
+//   handlers are counted for it. A task created with xTaskCreate() runs
+//   inline on that thread for a stretch of virtual time set by
+//   host_task_run_until(), then is left where it was.
+
+#ifndef HOST_PICO_H
+#define HOST_PICO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A device on the I2C bus. Both callbacks return the number of bytes
+// transferred, or a negative value to not acknowledge.
+typedef struct {
+    int (*write)(void *ctx, const uint8_t *src, size_t len, bool nostop);
+    int (*read)(void *ctx, uint8_t *dst, size_t len, bool nostop);
+    void *ctx;
+} host_i2c_device_t;
+
+// Attach a device at @p addr (7-bit); NULL detaches it. @p dev must stay
+// valid while attached.
+void host_i2c_attach(uint8_t addr, const host_i2c_device_t *dev);
+
+// Number of I2C transfers (write or read calls) so far, for bus load.
+uint32_t host_i2c_transfers(void);
+
+// Let every transfer take its time on the bus (address and data bytes at
+// 9 bits each, plus start and stop, at the i2c_init() baud rate) instead
+// of none. Off after reset.
+void host_i2c_set_bus_timing(bool on);
+
+// Advance the virtual clock by @p us, running the tick hooks once at the
+// end. Blocking calls advance it in steps of at most 1 ms.
+void host_time_advance_us(uint64_t us);
+
+// Called whenever the virtual clock has moved, with the new time. Device
+// models use it to complete measurements and drive interrupt pins. Up to
+// HOST_TICK_HOOKS hooks, run in the order they were added.
+#define HOST_TICK_HOOKS 8
+typedef void (*host_tick_hook_t)(void *ctx, uint64_t now_us);
+void host_add_tick_hook(host_tick_hook_t hook, void *ctx);
+
+// Drive a GPIO input. A level change raises the matching edge interrupt
+// if it is enabled.
+void host_gpio_set_input(unsigned int gpio, bool level);
+
+// Level last written to a GPIO output.
+bool host_gpio_output(unsigned int gpio);
+
+// Function last selected for a GPIO (gpio_function_t: GPIO_FUNC_SIO after
+// gpio_init(), GPIO_FUNC_PWM, ...).
+unsigned int host_gpio_function(unsigned int gpio);
+
+// Programmed state of a PWM slice.
+typedef struct {
+    bool enabled;
+    float clkdiv;
+    uint16_t wrap;
+    uint16_t level[2];      // per channel (A, B)
+} host_pwm_slice_t;
+const host_pwm_slice_t *host_pwm_slice(unsigned int slice_num);
+
+// Words a PIO state machine (@p pio 0 or 1) autopushes: @p source is called
+// for each push and returns the shift register (with a left shift, the
+// first bit in bit 31). A state machine without a source pushes nothing.
+typedef uint32_t (*host_pio_source_t)(void *ctx);
+void host_pio_set_source(unsigned int pio, unsigned int sm, host_pio_source_t source, void *ctx);
+
+// Instead, the input pin level at each IN: the model shifts the bits into
+// the ISR in the configured direction and pushes it at the threshold.
+typedef bool (*host_pio_bit_source_t)(void *ctx);
+void host_pio_set_bit_source(unsigned int pio, unsigned int sm, host_pio_bit_source_t source,
+                             void *ctx);
+
+// Words the state machine could not push because its RX FIFO was full.
+uint32_t host_pio_rx_dropped(unsigned int pio, unsigned int sm);
+
+// Transfers (bus reads and writes) a DMA channel has made since reset.
+uint32_t host_dma_transfers(unsigned int channel);
+
+// Delay from a DMA completion to its interrupt handler running, as when
+// another interrupt or a critical section is in the way. 0 after reset.
+void host_dma_set_irq_latency_us(uint32_t us);
+
+// Run the next task created with xTaskCreate() inline, until it blocks at
+// or after virtual time @p us (or deletes itself); xTaskCreate() then
+// returns. Without this, xTaskCreate() fails as there is no scheduler.
+// The stack high-water mark is not modelled and reads 0.
+void host_task_run_until(uint64_t us);
+
+// For drivers that create their task before starting what feeds it: the
+// next xTaskCreate() only keeps the task (and returns pdPASS), and
+// host_task_start() runs it later, inline until it blocks at or after
+// virtual time @p us, as above.
+void host_task_defer(void);
+void host_task_start(uint64_t us);
+
+// Notifications given to the task and not taken yet.
+uint32_t host_task_notifications(void);
+
+// Back to power-on state: time 0, no devices, no handlers, no pending
+// notifications.
+void host_pico_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
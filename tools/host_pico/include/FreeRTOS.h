@@ -0,0 +1,35 @@
+// Host stand-in for <FreeRTOS.h>. There is no scheduler: the calling
+// thread is the only task, and blocking calls advance the virtual clock
+// (see host_pico.h) until they are satisfied or time out.
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t configSTACK_DEPTH_TYPE;
+
+#define pdFALSE         ((BaseType_t)0)
+#define pdTRUE          ((BaseType_t)1)
+#define pdPASS          pdTRUE
+#define pdFAIL          pdFALSE
+#define portMAX_DELAY   ((TickType_t)0xffffffffUL)
+
+#define configTICK_RATE_HZ          ((TickType_t)1000)
+#define configNUMBER_OF_CORES       2
+#define configUSE_CORE_AFFINITY     1
+#define configMAX_PRIORITIES        32
+#define tskIDLE_PRIORITY            ((UBaseType_t)0U)
+#define portTICK_PERIOD_MS          ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(xTimeInMs) \
+    ((TickType_t)(((TickType_t)(xTimeInMs) * configTICK_RATE_HZ) / (TickType_t)1000U))
+
+#define portYIELD_FROM_ISR(x)       ((void)(x))
+#define taskENTER_CRITICAL()        ((void)0)
+#define taskEXIT_CRITICAL()         ((void)0)
+
+#endif
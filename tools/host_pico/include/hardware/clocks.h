@@ -0,0 +1,28 @@
+// Host stand-in for <hardware/clocks.h>: the system clock at the SDK's
+// default 125 MHz, which sets the PIO timing (see host_pico.h).
+
+#ifndef HOST_HARDWARE_CLOCKS_H
+#define HOST_HARDWARE_CLOCKS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HOST_CLK_SYS_HZ     125000000u
+
+enum clock_index {
+    clk_sys = 5,
+};
+
+static inline uint32_t clock_get_hz(enum clock_index clk_index) {
+    (void)clk_index;
+    return HOST_CLK_SYS_HZ;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
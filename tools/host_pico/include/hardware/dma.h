@@ -0,0 +1,129 @@
+// Host stand-in for <hardware/dma.h>. The channels are modelled in
+// host_pico.c: a channel paced by a PIO RX DREQ moves one word each time
+// the state machine pushes one (host_pio_set_source()), an unpaced one runs
+// to the end at once. Read/write increment, address rings on either side,
+// byte swap, chaining, the aliased trigger registers and the completion
+// interrupts behave as on the RP2040. The registers show the low 32 bits
+// of the host addresses; writes to them take effect when a channel makes
+// them (a control channel), CPU code goes through the functions below.
+
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NUM_DMA_CHANNELS    12
+
+#define DREQ_PIO0_RX0       4
+#define DREQ_PIO1_RX0       12
+#define DREQ_FORCE          0x3f
+
+typedef struct {
+    volatile uint32_t read_addr;
+    volatile uint32_t write_addr;
+    volatile uint32_t transfer_count;
+    volatile uint32_t ctrl_trig;
+    volatile uint32_t al1_ctrl;
+    volatile uint32_t al1_read_addr;
+    volatile uint32_t al1_write_addr;
+    volatile uint32_t al1_transfer_count_trig;
+    volatile uint32_t al2_ctrl;
+    volatile uint32_t al2_transfer_count;
+    volatile uint32_t al2_read_addr;
+    volatile uint32_t al2_write_addr_trig;
+    volatile uint32_t al3_ctrl;
+    volatile uint32_t al3_write_addr;
+    volatile uint32_t al3_transfer_count;
+    volatile uint32_t al3_read_addr_trig;
+} dma_channel_hw_t;
+
+// ints0/ints1 are write-1-to-clear. The model applies what was written
+// and they read back 0.
+typedef struct {
+    dma_channel_hw_t ch[NUM_DMA_CHANNELS];
+    volatile uint32_t intr;
+    volatile uint32_t inte0;
+    volatile uint32_t intf0;
+    volatile uint32_t ints0;
+    volatile uint32_t inte1;
+    volatile uint32_t intf1;
+    volatile uint32_t ints1;
+} dma_hw_t;
+
+extern dma_hw_t host_dma_hw;
+#define dma_hw (&host_dma_hw)
+
+enum dma_channel_transfer_size {
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2,
+};
+
+// The SDK packs these into CTRL; the model keeps them apart
+typedef struct {
+    enum dma_channel_transfer_size size;
+    bool read_increment;
+    bool write_increment;
+    bool ring_write;
+    uint ring_size_bits;        // 0: no ring
+    uint dreq;
+    uint chain_to;              // itself: no chaining
+    bool bswap;
+    bool enable;
+} dma_channel_config;
+
+static inline void channel_config_set_read_increment(dma_channel_config *c, bool incr) {
+    c->read_increment = incr;
+}
+
+static inline void channel_config_set_write_increment(dma_channel_config *c, bool incr) {
+    c->write_increment = incr;
+}
+
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq) {
+    c->dreq = dreq;
+}
+
+static inline void channel_config_set_chain_to(dma_channel_config *c, uint chain_to) {
+    c->chain_to = chain_to;
+}
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c,
+                                                         enum dma_channel_transfer_size size) {
+    c->size = size;
+}
+
+static inline void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits) {
+    c->ring_write = write;
+    c->ring_size_bits = size_bits;
+}
+
+static inline void channel_config_set_bswap(dma_channel_config *c, bool bswap) {
+    c->bswap = bswap;
+}
+
+static inline void channel_config_set_enable(dma_channel_config *c, bool enable) {
+    c->enable = enable;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel);
+void dma_channel_configure(uint channel, const dma_channel_config *config,
+                           volatile void *write_addr, const volatile void *read_addr,
+                           uint transfer_count, bool trigger);
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(uint channel);
+void dma_channel_start(uint channel);
+void dma_channel_abort(uint channel);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_set_irq0_enabled(uint channel, bool enabled);
+void dma_channel_set_irq1_enabled(uint channel, bool enabled);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
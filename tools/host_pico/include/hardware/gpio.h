@@ -0,0 +1,63 @@
+// Host stand-in for <hardware/gpio.h>. Outputs are recorded, inputs are
+// driven by the test (host_gpio_set_input()) and raise edge interrupts.
+
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hardware/irq.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NUM_BANK0_GPIOS 30
+
+#define GPIO_OUT 1
+#define GPIO_IN  0
+
+typedef enum gpio_function {
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_PWM = 4,
+    GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_PIO0 = 6,
+    GPIO_FUNC_PIO1 = 7,
+    GPIO_FUNC_NULL = 0x1f,
+} gpio_function_t;
+
+enum gpio_irq_level {
+    GPIO_IRQ_LEVEL_LOW = 0x1u,
+    GPIO_IRQ_LEVEL_HIGH = 0x2u,
+    GPIO_IRQ_EDGE_FALL = 0x4u,
+    GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+
+typedef void (*gpio_irq_callback_t)(unsigned int gpio, uint32_t event_mask);
+
+void gpio_init(unsigned int gpio);
+void gpio_deinit(unsigned int gpio);
+void gpio_set_function(unsigned int gpio, gpio_function_t fn);
+void gpio_set_dir(unsigned int gpio, bool out);
+void gpio_put(unsigned int gpio, bool value);
+bool gpio_get(unsigned int gpio);
+void gpio_pull_up(unsigned int gpio);
+void gpio_pull_down(unsigned int gpio);
+void gpio_disable_pulls(unsigned int gpio);
+
+void gpio_set_irq_enabled(unsigned int gpio, uint32_t event_mask, bool enabled);
+void gpio_set_irq_enabled_with_callback(unsigned int gpio, uint32_t event_mask,
+                                        bool enabled, gpio_irq_callback_t callback);
+void gpio_add_raw_irq_handler(unsigned int gpio, irq_handler_t handler);
+void gpio_remove_raw_irq_handler(unsigned int gpio, irq_handler_t handler);
+uint32_t gpio_get_irq_event_mask(unsigned int gpio);
+void gpio_acknowledge_irq(unsigned int gpio, uint32_t event_mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
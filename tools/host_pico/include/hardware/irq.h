@@ -0,0 +1,28 @@
+// Host stand-in for <hardware/irq.h>. Interrupts are raised by the models
+// in host_pico.c (GPIO edges, DMA completion) and run synchronously.
+
+#ifndef HOST_HARDWARE_IRQ_H
+#define HOST_HARDWARE_IRQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DMA_IRQ_0       11
+#define DMA_IRQ_1       12
+#define IO_IRQ_BANK0    13
+
+typedef void (*irq_handler_t)(void);
+
+void irq_set_enabled(unsigned int num, bool enabled);
+bool irq_is_enabled(unsigned int num);
+void irq_set_exclusive_handler(unsigned int num, irq_handler_t handler);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,100 @@
+// Host stand-in for <hardware/pio.h>. A state machine is modelled by its
+// timing only: once enabled, it autopushes a word from the test's source
+// (host_pio_set_source()) into its RX FIFO every push threshold of input
+// bits, at the rate its clock divider and program give. The program's
+// rate is carried in the config by the host .pio.h stand-ins.
+
+#ifndef HOST_HARDWARE_PIO_H
+#define HOST_HARDWARE_PIO_H
+
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NUM_PIO_STATE_MACHINES  4
+
+typedef struct pio_hw {
+    volatile uint32_t rxf[NUM_PIO_STATE_MACHINES];
+} pio_hw_t;
+typedef pio_hw_t *PIO;
+
+extern pio_hw_t host_pio0_hw, host_pio1_hw;
+#define pio0 (&host_pio0_hw)
+#define pio1 (&host_pio1_hw)
+
+typedef struct pio_program {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+enum pio_fifo_join {
+    PIO_FIFO_JOIN_NONE = 0,
+    PIO_FIFO_JOIN_TX = 1,
+    PIO_FIFO_JOIN_RX = 2,
+};
+
+typedef struct {
+    float clkdiv;
+    uint in_base;
+    uint sideset_base;
+    bool in_shift_right;
+    bool autopush;
+    uint push_threshold;
+    enum pio_fifo_join fifo_join;
+    // Host only: the program loop, set by its get_default_config()
+    uint wrap_cycles;
+    uint wrap_in_bits;
+} pio_sm_config;
+
+static inline pio_sm_config pio_get_default_sm_config(void) {
+    pio_sm_config c = {1.0f, 0, 0, true, false, 32, PIO_FIFO_JOIN_NONE, 1, 0};
+    return c;
+}
+
+static inline void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base) {
+    c->sideset_base = sideset_base;
+}
+
+static inline void sm_config_set_in_pins(pio_sm_config *c, uint in_base) {
+    c->in_base = in_base;
+}
+
+static inline void sm_config_set_in_shift(pio_sm_config *c, bool shift_right, bool autopush,
+                                          uint push_threshold) {
+    c->in_shift_right = shift_right;
+    c->autopush = autopush;
+    c->push_threshold = push_threshold ? push_threshold : 32;
+}
+
+static inline void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join) {
+    c->fifo_join = join;
+}
+
+static inline void sm_config_set_clkdiv(pio_sm_config *c, float div) {
+    c->clkdiv = div;
+}
+
+static inline uint pio_get_index(PIO pio) {
+    return pio == pio1 ? 1u : 0u;
+}
+
+static inline uint pio_get_dreq(PIO pio, uint sm, bool is_tx) {
+    return (pio == pio1 ? 8u : 0u) + (is_tx ? 0u : 4u) + sm;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *program);
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_sm_clear_fifos(PIO pio, uint sm);
+void pio_sm_restart(PIO pio, uint sm);
+int pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pins_base, uint pin_count, bool is_out);
+void pio_gpio_init(PIO pio, uint pin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,31 @@
+// Host stand-in for <hardware/pwm.h>. Slice settings are recorded so a test
+// can read back the programmed frequency (host_pwm_slice()).
+
+#ifndef HOST_HARDWARE_PWM_H
+#define HOST_HARDWARE_PWM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline unsigned int pwm_gpio_to_slice_num(unsigned int gpio) {
+    return (gpio >> 1u) & 7u;
+}
+
+static inline unsigned int pwm_gpio_to_channel(unsigned int gpio) {
+    return gpio & 1u;
+}
+
+void pwm_set_clkdiv(unsigned int slice_num, float divider);
+void pwm_set_wrap(unsigned int slice_num, uint16_t wrap);
+void pwm_set_gpio_level(unsigned int gpio, uint16_t level);
+void pwm_set_enabled(unsigned int slice_num, bool enabled);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
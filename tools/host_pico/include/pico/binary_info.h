@@ -0,0 +1,9 @@
+// Host stand-in for <pico/binary_info.h>: binary info is dropped.
+
+#ifndef HOST_PICO_BINARY_INFO_H
+#define HOST_PICO_BINARY_INFO_H
+
+#define bi_decl(...)
+#define bi_decl_if_func_used(...)
+
+#endif
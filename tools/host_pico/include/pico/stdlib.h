@@ -0,0 +1,49 @@
+// Host stand-in for <pico/stdlib.h>: only what the TKJHAT sources use.
+// Time is virtual (see host_pico.h); sleeping advances it.
+
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum pico_error_codes {
+    PICO_OK = 0,
+    PICO_ERROR_NONE = 0,
+    PICO_ERROR_TIMEOUT = -1,
+    PICO_ERROR_GENERIC = -2,
+};
+
+// Section placement has no meaning on the host
+#define __not_in_flash(group)
+#define __not_in_flash_func(func_name) func_name
+#define __time_critical_func(func_name) func_name
+#define __in_flash(group)
+
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+void busy_wait_us(uint64_t delay_us);
+void busy_wait_us_32(uint32_t delay_us);
+uint32_t time_us_32(void);
+uint64_t time_us_64(void);
+absolute_time_t get_absolute_time(void);
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000u);
+}
+
+static inline void tight_loop_contents(void) {}
+
+uint get_core_num(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+
+#endif
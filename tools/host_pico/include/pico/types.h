@@ -0,0 +1,14 @@
+// Host stand-in for <pico/types.h>.
+
+#ifndef HOST_PICO_TYPES_H
+#define HOST_PICO_TYPES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+typedef uint64_t absolute_time_t;
+
+#endif
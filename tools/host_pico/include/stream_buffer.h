@@ -0,0 +1,28 @@
+// Host stand-in for <stream_buffer.h>: a byte FIFO. Sends never block.
+// The only task cannot fill the buffer while it waits on it, so a receive
+// from an empty buffer sleeps out its timeout and returns 0.
+
+#ifndef HOST_STREAM_BUFFER_H
+#define HOST_STREAM_BUFFER_H
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct StreamBufferDef_t *StreamBufferHandle_t;
+
+StreamBufferHandle_t xStreamBufferCreate(size_t xBufferSizeBytes, size_t xTriggerLevelBytes);
+void vStreamBufferDelete(StreamBufferHandle_t xStreamBuffer);
+size_t xStreamBufferSend(StreamBufferHandle_t xStreamBuffer, const void *pvTxData,
+                         size_t xDataLengthBytes, TickType_t xTicksToWait);
+size_t xStreamBufferReceive(StreamBufferHandle_t xStreamBuffer, void *pvRxData,
+                            size_t xBufferLengthBytes, TickType_t xTicksToWait);
+size_t xStreamBufferBytesAvailable(StreamBufferHandle_t xStreamBuffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
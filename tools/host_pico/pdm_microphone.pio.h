@@ -0,0 +1,83 @@
+// Host stand-in for the pioasm output of pdm_microphone.pio. The
+// instructions are the assembled program; what the host PIO model runs is
+// the loop timing in the default config (4 cycles per wrap, one input bit
+// per wrap for mono, two for stereo). pdm_microphone_data_init() is the
+// c-sdk block of the .pio file.
+
+#ifndef HOST_PDM_MICROPHONE_PIO_H
+#define HOST_PDM_MICROPHONE_PIO_H
+
+#include "hardware/pio.h"
+
+#define pdm_microphone_data_wrap_target 0
+#define pdm_microphone_data_wrap 3
+
+static const uint16_t pdm_microphone_data_program_instructions[] = {
+    0xa042, //  0: nop                    side 0
+    0x4001, //  1: in     pins, 1         side 0
+    0xb042, //  2: nop                    side 1
+    0xb042, //  3: nop                    side 1
+};
+
+static const struct pio_program pdm_microphone_data_program = {
+    .instructions = pdm_microphone_data_program_instructions,
+    .length = 4,
+    .origin = -1,
+};
+
+static inline pio_sm_config pdm_microphone_data_program_get_default_config(uint offset) {
+    (void)offset;
+    pio_sm_config c = pio_get_default_sm_config();
+    c.wrap_cycles = 4;
+    c.wrap_in_bits = 1;
+    return c;
+}
+
+#define pdm_microphone_stereo_data_wrap_target 0
+#define pdm_microphone_stereo_data_wrap 3
+
+static const uint16_t pdm_microphone_stereo_data_program_instructions[] = {
+    0xa042, //  0: nop                    side 0
+    0x4001, //  1: in     pins, 1         side 0
+    0xb042, //  2: nop                    side 1
+    0x5001, //  3: in     pins, 1         side 1
+};
+
+static const struct pio_program pdm_microphone_stereo_data_program = {
+    .instructions = pdm_microphone_stereo_data_program_instructions,
+    .length = 4,
+    .origin = -1,
+};
+
+static inline pio_sm_config pdm_microphone_stereo_data_program_get_default_config(uint offset) {
+    (void)offset;
+    pio_sm_config c = pio_get_default_sm_config();
+    c.wrap_cycles = 4;
+    c.wrap_in_bits = 2;
+    return c;
+}
+
+// offset is where pdm_microphone_data_program, or with stereo set
+// pdm_microphone_stereo_data_program, was loaded
+static inline void pdm_microphone_data_init(PIO pio, uint sm, uint offset, float clk_div, uint data_pin, uint clk_pin, bool stereo) {
+    pio_sm_set_consecutive_pindirs(pio, sm, data_pin, 1, false);
+    pio_sm_set_consecutive_pindirs(pio, sm, clk_pin, 1, true);
+
+    pio_sm_config c = stereo ? pdm_microphone_stereo_data_program_get_default_config(offset)
+                             : pdm_microphone_data_program_get_default_config(offset);
+
+    sm_config_set_sideset_pins(&c, clk_pin);
+    sm_config_set_in_pins(&c, data_pin);
+
+    pio_gpio_init(pio, clk_pin);
+    pio_gpio_init(pio, data_pin);
+
+    sm_config_set_in_shift(&c, false, true, 32);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);
+
+    sm_config_set_clkdiv(&c, clk_div);
+
+    pio_sm_init(pio, sm, offset, &c);
+}
+
+#endif
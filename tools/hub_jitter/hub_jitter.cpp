@@ -0,0 +1,223 @@
+// hub_jitter: sampling jitter of one task per sensor against the sensor
+// hub (sensor_hub.c), on host_pico with every I2C transfer taking its bus
+// time at 400 kHz.
+//
+//   hub_jitter [-l] [-s seconds]
+//
+// Both sample the three HAT sensors at the hub's default rates (IMU
+// 100 Hz, light 10 Hz, temperature/humidity 1 Hz) on one core:
+//
+// - per-task: one loop per sensor that reads and then calls
+//   vTaskDelay(period), as the tasks in hat_example and the old main.c
+//   sensor_task did. The loops run the way FreeRTOS runs equal-priority
+//   tasks on one core: the ones due at a tick read in turn, and each
+//   sleeps its period from the tick its read ended in.
+// - hub: sensor_hub_start() with the default configuration, run as a task
+//   by host_pico. The samples are timestamped from its on_sample callback.
+//
+// -l adds a higher-priority load that takes the core for 1.5 ms every
+// 50 ms (a display refresh, USB printing), modelled as a tick hook that
+// moves the clock on. This is where a relative delay turns every late
+// wakeup into drift.
+//
+// For every sensor it prints the achieved rate, the worst lateness
+// against the ideal grid (t0 + k * period) and the worst deviation of one
+// interval from the period. The hub must stay on its grid within each
+// channel's deadline; the exit code is 1 if it does not. The stacks are
+// printed as configured: their high-water marks need the board (the
+// ".stats" command of main.c prints them).
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "hdc2021_model.hpp"
+#include "host_pico.h"
+#include "icm42670_model.hpp"
+#include "veml6030_model.hpp"
+
+extern "C" {
+#include "FreeRTOS.h"
+#include "task.h"
+#include "tkjhat/imu_fusion.h"
+#include "tkjhat/sensor_hub.h"
+}
+
+namespace {
+
+const char *const names[SENSOR_HUB_COUNT] = {"IMU", "light", "temp/hum"};
+
+struct Series {
+    uint32_t period_ms = 0;
+    std::vector<uint64_t> ts;   // read start times
+};
+
+struct Timing {
+    double rate_hz;
+    double late_ms_max;         // against t0 + k * period
+    double interval_dev_ms_max; // |interval - period|
+};
+
+Timing timing(const Series &s) {
+    Timing t{};
+    if (s.ts.size() < 2) return t;
+    const uint64_t p = uint64_t(s.period_ms) * 1000;
+    for (size_t k = 1; k < s.ts.size(); ++k) {
+        double late = double(int64_t(s.ts[k] - s.ts[0]) - int64_t(k * p)) / 1000.0;
+        double dev = double(int64_t(s.ts[k] - s.ts[k - 1]) - int64_t(p)) / 1000.0;
+        t.late_ms_max = std::max(t.late_ms_max, late);
+        t.interval_dev_ms_max = std::max(t.interval_dev_ms_max, std::abs(dev));
+    }
+    t.rate_hz = double(s.ts.size() - 1) * 1e6 / double(s.ts.back() - s.ts.front());
+    return t;
+}
+
+// Higher-priority work: takes the core for busy_us every every_us
+struct Load {
+    uint64_t next_us, every_us, busy_us;
+};
+
+void run_per_task(Series (&out)[SENSOR_HUB_COUNT], const sensor_hub_config_t &cfg,
+                  uint64_t duration_us) {
+    const std::function<void()> read[SENSOR_HUB_COUNT] = {
+        [] {
+            float ax, ay, az, gx, gy, gz, t;
+            ICM42670_read_sensor_data(&ax, &ay, &az, &gx, &gy, &gz, &t);
+        },
+        [] { veml6030_read_light(); },
+        [] {
+            hdc2021_read_temperature();
+            hdc2021_read_humidity();
+        },
+    };
+    TickType_t wake[SENSOR_HUB_COUNT];
+    vTaskDelay(1);
+    const uint64_t end = time_us_64() + duration_us;
+    for (int i = 0; i < SENSOR_HUB_COUNT; ++i) {
+        out[i].period_ms = cfg.channel[i].period_ms;
+        wake[i] = xTaskGetTickCount();
+    }
+    while (time_us_64() < end) {
+        for (int i = 0; i < SENSOR_HUB_COUNT; ++i) {
+            if (int32_t(xTaskGetTickCount() - wake[i]) < 0) continue;
+            out[i].ts.push_back(time_us_64());
+            read[i]();
+            wake[i] = xTaskGetTickCount() + pdMS_TO_TICKS(cfg.channel[i].period_ms);
+        }
+        TickType_t next = *std::min_element(wake, wake + SENSOR_HUB_COUNT);
+        if (int32_t(next - xTaskGetTickCount()) > 0) vTaskDelay(next - xTaskGetTickCount());
+    }
+}
+
+Series *hub_series;
+
+void hub_sample(sensor_hub_sensor_t sensor, void *) {
+    uint64_t ts = 0;
+    if (sensor == SENSOR_HUB_IMU) {
+        sensor_hub_imu_t s;
+        sensor_hub_get_imu(&s);
+        ts = s.timestamp_us;
+    } else if (sensor == SENSOR_HUB_LIGHT) {
+        sensor_hub_light_t s;
+        sensor_hub_get_light(&s);
+        ts = s.timestamp_us;
+    } else {
+        sensor_hub_env_t s;
+        sensor_hub_get_env(&s);
+        ts = s.timestamp_us;
+    }
+    hub_series[sensor].ts.push_back(ts);
+}
+
+void print_row(const char *how, const char *sensor, uint32_t period_ms, const Timing &t) {
+    std::printf("%-9s %-9s %7.2f %9.2f %10.3f %10.3f\n", how, sensor, 1000.0 / period_ms,
+                t.rate_hz, t.late_ms_max, t.interval_dev_ms_max);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bool loaded = false;
+    double seconds = 10.0;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "-l") loaded = true;
+        else if (a == "-s" && i + 1 < argc) seconds = std::atof(argv[++i]);
+        else { std::fprintf(stderr, "usage: %s [-l] [-s seconds]\n", argv[0]); return 2; }
+    }
+    const uint64_t duration_us = uint64_t(seconds * 1e6);
+
+    host_pico_reset();
+    model::Icm42670 imu;
+    model::Veml6030 veml;
+    model::Hdc2021 hdc;
+    veml.set_lux(300.0);
+    init_hat_sdk();
+    init_ICM42670();
+    ICM42670_start_with_default_values();
+    init_veml6030();
+    init_hdc2021_();
+    host_i2c_set_bus_timing(true);
+
+    Load load{0, 50000, 1500};
+    if (loaded) {
+        load.next_us = time_us_64() + 3000;
+        host_add_tick_hook([](void *ctx, uint64_t now) {
+            auto *l = static_cast<Load *>(ctx);
+            if (now < l->next_us) return;
+            l->next_us += l->every_us;
+            host_time_advance_us(l->busy_us);   // hooks do not re-enter
+        }, &load);
+    }
+
+    sensor_hub_config_t cfg;
+    sensor_hub_default_config(&cfg);
+
+    Series per_task[SENSOR_HUB_COUNT];
+    run_per_task(per_task, cfg, duration_us);
+
+    Series hub[SENSOR_HUB_COUNT];
+    for (int i = 0; i < SENSOR_HUB_COUNT; ++i) hub[i].period_ms = cfg.channel[i].period_ms;
+    hub_series = hub;
+    cfg.on_sample = hub_sample;
+    vTaskDelay(1);
+    host_task_run_until(time_us_64() + duration_us);
+    if (sensor_hub_start(&cfg) != 0) {
+        std::printf("hub_jitter: sensor_hub_start failed\n");
+        return 1;
+    }
+    sensor_hub_stats_t st;
+    sensor_hub_get_stats(&st);
+
+    std::printf("%.0f s, %s, I2C at 400 kHz\n", seconds,
+                loaded ? "1.5 ms of higher-priority work every 50 ms" : "no other load");
+    std::printf("%-9s %-9s %7s %9s %10s %10s\n", "", "sensor", "want Hz", "got Hz",
+                "drift ms", "jitter ms");
+    int failures = 0;
+    for (int i = 0; i < SENSOR_HUB_COUNT; ++i) {
+        print_row("per-task", names[i], cfg.channel[i].period_ms, timing(per_task[i]));
+    }
+    for (int i = 0; i < SENSOR_HUB_COUNT; ++i) {
+        Timing t = timing(hub[i]);
+        print_row("hub", names[i], cfg.channel[i].period_ms, t);
+        const double deadline_ms = cfg.channel[i].deadline_us / 1000.0;
+        if (st.channel[i].deadline_misses || st.channel[i].errors || st.channel[i].skipped ||
+            t.late_ms_max > deadline_ms) {
+            std::printf("FAIL %s: %u deadline misses, %u errors, %u skipped, drift %.3f ms\n",
+                        names[i], st.channel[i].deadline_misses, st.channel[i].errors,
+                        st.channel[i].skipped, t.late_ms_max);
+            failures++;
+        }
+    }
+    std::printf("hub reads: IMU %u us, light %u us, temp/hum %u us (longest)\n",
+                st.channel[SENSOR_HUB_IMU].read_us_max, st.channel[SENSOR_HUB_LIGHT].read_us_max,
+                st.channel[SENSOR_HUB_ENV].read_us_max);
+    std::printf("stacks: per-task 3 x 2048 words (hat_example), main.c before: 2048 + "
+                "imu_fusion %u words; hub %u words\n",
+                unsigned(IMU_FUSION_STACK_SIZE), unsigned(SENSOR_HUB_STACK_SIZE));
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,167 @@
+// imu_bench: throughput and accuracy of the ICM-42670 batch converters
+// (ICM42670_convert_batch_q16/_float in sdk.c) on the PC.
+//
+//   imu_bench [-n repeats] [-s samples]
+//
+// The SDK's IMU driver runs on host_pico against a simulated sensor, so the
+// scale factors come from ICM42670_startAccel/startGyro exactly as on the
+// board. For every full-scale range pair, random raw samples in
+// structure-of-arrays buffers are converted three ways:
+//
+// - div:   per value float division by aRes/gRes, as the old
+//          ICM42670_read_sensor_data() did;
+// - float: ICM42670_convert_batch_float(), multiply by the reciprocal;
+// - q16:   ICM42670_convert_batch_q16(), 32-bit integer multiply and shift.
+//
+// Times are ns of host CPU per 7-channel sample, the best of -n runs. The
+// Q16.16 and float results are compared with the exact value in double;
+// the exit code is 1 if an error exceeds what sdk.h promises (scale factor
+// within 2^-15, plus half an output LSB of rounding).
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "host_pico.h"
+#include "icm42670_model.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Range {
+    uint16_t accel_g;
+    uint16_t gyro_dps;
+};
+
+constexpr Range kRanges[] = {{2, 250}, {4, 500}, {8, 1000}, {16, 2000}};
+
+// One SoA batch, every channel filled
+struct Batch {
+    explicit Batch(size_t n) : raw(7, std::vector<int16_t>(n)), q16(7, std::vector<int32_t>(n)),
+                               f(7, std::vector<float>(n)) {}
+
+    icm_raw_soa in() {
+        return {raw[0].data(), raw[1].data(), raw[2].data(), raw[3].data(),
+                raw[4].data(), raw[5].data(), raw[6].data()};
+    }
+    icm_q16_soa out_q16() {
+        return {q16[0].data(), q16[1].data(), q16[2].data(), q16[3].data(),
+                q16[4].data(), q16[5].data(), q16[6].data()};
+    }
+    icm_float_soa out_float() {
+        return {f[0].data(), f[1].data(), f[2].data(), f[3].data(),
+                f[4].data(), f[5].data(), f[6].data()};
+    }
+
+    std::vector<std::vector<int16_t>> raw;  // ax ay az gx gy gz t
+    std::vector<std::vector<int32_t>> q16;
+    std::vector<std::vector<float>> f;
+};
+
+// What ICM42670_read_sensor_data() did per sample before the batch API
+void convert_div(const icm42670_config_t *cfg, Batch &b, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        for (int c = 0; c < 3; ++c) b.f[c][i] = float(b.raw[c][i]) / cfg->aRes;
+        for (int c = 3; c < 6; ++c) b.f[c][i] = float(b.raw[c][i]) / cfg->gRes;
+        b.f[6][i] = float(b.raw[6][i]) / 128.0f + 25.0f;
+    }
+}
+
+// Best time of `repeats` runs, ns per sample
+template <typename F>
+double time_ns(F &&fn, size_t n, int repeats) {
+    double best = 1e30;
+    for (int r = 0; r < repeats; ++r) {
+        // Enough passes for a few ms per run
+        const int passes = int(std::max<size_t>(1, 2000000 / n));
+        auto t0 = Clock::now();
+        for (int p = 0; p < passes; ++p) fn();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        best = std::min(best, ns / (double(passes) * double(n)));
+    }
+    return best;
+}
+
+double exact(const icm42670_config_t *cfg, int c, int16_t raw) {
+    if (c < 3) return double(raw) / double(cfg->aRes);
+    if (c < 6) return double(raw) / double(cfg->gRes);
+    return double(raw) / 128.0 + 25.0;
+}
+
+void usage(const char *argv0) {
+    std::fprintf(stderr, "usage: %s [-n repeats] [-s samples]\n", argv0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int repeats = 5;
+    size_t n = 1024;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "-n" && i + 1 < argc) repeats = std::max(1, std::atoi(argv[++i]));
+        else if (a == "-s" && i + 1 < argc) n = size_t(std::max(1, std::atoi(argv[++i])));
+        else { usage(argv[0]); return 2; }
+    }
+
+    host_pico_reset();
+    model::Icm42670 imu;
+
+    Batch b(n);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dist(INT16_MIN, INT16_MAX);
+    for (auto &ch : b.raw) {
+        for (auto &v : ch) v = int16_t(dist(rng));
+    }
+    // Full-scale values are where the scale error is largest
+    for (auto &ch : b.raw) {
+        ch[0] = INT16_MIN;
+        ch[1] = INT16_MAX;
+    }
+
+    std::printf("%zu samples of 7 channels per batch, best of %d runs\n", n, repeats);
+    std::printf("%-12s %8s %8s %8s   %12s %12s\n", "range", "div", "float", "q16",
+                "q16 err/lim", "float err");
+
+    bool ok = true;
+    for (const Range &r : kRanges) {
+        if (ICM42670_startAccel(100, r.accel_g) != 0 || ICM42670_startGyro(100, r.gyro_dps) != 0) {
+            std::fprintf(stderr, "cannot configure %u g / %u dps\n", r.accel_g, r.gyro_dps);
+            return 1;
+        }
+        const icm42670_config_t *cfg = ICM42670_get_config();
+        icm_raw_soa in = b.in();
+        icm_q16_soa q = b.out_q16();
+        icm_float_soa f = b.out_float();
+
+        double t_div = time_ns([&] { convert_div(cfg, b, n); }, n, repeats);
+        double t_float = time_ns([&] { ICM42670_convert_batch_float(cfg, &in, &f, n); }, n, repeats);
+        double t_q16 = time_ns([&] { ICM42670_convert_batch_q16(cfg, &in, &q, n); }, n, repeats);
+
+        // Worst error relative to the documented bound, and float error
+        double q_ratio = 0, f_err = 0;
+        for (int c = 0; c < 7; ++c) {
+            for (size_t i = 0; i < n; ++i) {
+                double x = exact(cfg, c, b.raw[c][i]);
+                double lim = std::fabs(x) * std::ldexp(1.0, -15) + std::ldexp(1.0, -17);
+                q_ratio = std::max(q_ratio, std::fabs(double(b.q16[c][i]) / 65536.0 - x) / lim);
+                f_err = std::max(f_err, std::fabs(double(b.f[c][i]) - x) / std::max(std::fabs(x), 1e-9));
+            }
+        }
+        if (q_ratio > 1.0 || f_err > 1e-6) ok = false;
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "%ug/%udps", r.accel_g, r.gyro_dps);
+        std::printf("%-12s %8.2f %8.2f %8.2f   %12.3f %12.1e%s\n", name, t_div, t_float, t_q16,
+                    q_ratio, f_err, q_ratio > 1.0 || f_err > 1e-6 ? "  FAIL" : "");
+    }
+    std::printf("(ns per sample; q16 err/lim <= 1 passes)\n");
+    return ok ? 0 : 1;
+}
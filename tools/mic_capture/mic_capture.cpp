@@ -0,0 +1,268 @@
+// mic_capture: record the framed audio stream (tkjhat/audio_stream.h) from
+// a serial port straight into a WAV file.
+//
+//   mic_capture [-t seconds] [-p prealloc_s] [-q] <device> <out.wav>
+//
+// Frames are checked as they arrive: sequence gaps are counted and filled
+// with silence so the WAV timing stays right. Samples go into a memory
+// mapped, pre-sized file and the header is patched when the capture ends
+// (Ctrl+C, -t, or the device closing). A level meter runs on stderr.
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "tkjhat/audio_stream.h"
+#include "wav_mmap.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<bool> g_stop{false};
+
+void on_signal(int) { g_stop = true; }
+
+// Raw 8-bit, no echo, no line editing; a no-op for plain files
+int open_serial(const char *path) {
+    int fd = ::open(path, O_RDONLY | O_NOCTTY);
+    if (fd < 0 || !::isatty(fd)) return fd;
+    termios t;
+    if (::tcgetattr(fd, &t) == 0) {
+        ::cfmakeraw(&t);
+        t.c_cc[VMIN] = 1;
+        t.c_cc[VTIME] = 0;
+        ::tcsetattr(fd, TCSANOW, &t);
+        ::tcflush(fd, TCIFLUSH);
+    }
+    return fd;
+}
+
+struct Stats {
+    size_t frames = 0;
+    size_t lost_frames = 0;
+    size_t skipped_bytes = 0;
+    size_t bytes = 0;
+    size_t rate_changes = 0;
+};
+
+// RMS and peak over the samples since the last redraw
+class LevelMeter {
+public:
+    void add(const int16_t *pcm, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            int32_t v = pcm[i];
+            sum_sq_ += double(v * v);
+            int32_t a = v < 0 ? -v : v;
+            if (a > peak_) peak_ = a;
+        }
+        count_ += n;
+    }
+
+    void draw(const Stats &st, size_t samples, uint32_t rate) {
+        double rms = count_ ? std::sqrt(sum_sq_ / double(count_)) : 0.0;
+        double rms_db = db(rms);
+        double peak_db = db(peak_);
+        int bar = int((rms_db + 60.0) / 60.0 * kBarWidth);
+        if (bar < 0) bar = 0;
+        if (bar > kBarWidth) bar = kBarWidth;
+        char meter[kBarWidth + 1];
+        std::memset(meter, '#', size_t(bar));
+        std::memset(meter + bar, ' ', size_t(kBarWidth - bar));
+        meter[kBarWidth] = 0;
+        std::fprintf(stderr, "\r[%s] %6.1f dBFS rms %6.1f peak  %7.1f s  %zu frames  %zu lost ",
+                     meter, rms_db, peak_db, rate ? double(samples) / rate : 0.0,
+                     st.frames, st.lost_frames);
+        sum_sq_ = 0;
+        peak_ = 0;
+        count_ = 0;
+    }
+
+private:
+    static constexpr int kBarWidth = 30;
+    static double db(double v) { return v > 0 ? 20.0 * std::log10(v / 32768.0) : -99.0; }
+
+    double sum_sq_ = 0;
+    int32_t peak_ = 0;
+    size_t count_ = 0;
+};
+
+void usage(const char *argv0) {
+    std::fprintf(stderr,
+                 "usage: %s [-t seconds] [-p prealloc_s] [-q] <device> <out.wav>\n"
+                 "  -t  stop after this much audio (default: until Ctrl+C or EOF)\n"
+                 "  -p  grow the WAV file in steps of this many seconds (default 60)\n"
+                 "  -q  no level meter\n", argv0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    double max_seconds = 0;
+    double prealloc_s = 60;
+    bool quiet = false;
+    int opt;
+    while ((opt = ::getopt(argc, argv, "t:p:q")) != -1) {
+        switch (opt) {
+        case 't': max_seconds = std::atof(optarg); break;
+        case 'p': prealloc_s = std::atof(optarg); break;
+        case 'q': quiet = true; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (argc - optind != 2) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char *dev = argv[optind];
+    const std::string out_path = argv[optind + 1];
+
+    int fd = open_serial(dev);
+    if (fd < 0) {
+        std::fprintf(stderr, "cannot open %s: %s\n", dev, std::strerror(errno));
+        return 1;
+    }
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    // Bytes are appended at the end and frames consumed from the front; the
+    // unparsed rest is moved down when there is no room for another frame
+    std::vector<uint8_t> buf(64 * 1024);
+    size_t head = 0, tail = 0;
+
+    WavMmap wav;
+    bool wav_open = false;
+    uint32_t rate = 0;
+    bool have_seq = false;
+    uint16_t next_seq = 0;
+    uint16_t last_samples = 0;
+    int16_t pcm[AUDIO_STREAM_MAX_SAMPLES];
+    size_t max_samples = 0;
+
+    Stats st;
+    LevelMeter meter;
+    auto t_start = Clock::now();
+    auto t_draw = t_start;
+    int rc = 0;
+
+    while (!g_stop) {
+        pollfd p = { fd, POLLIN, 0 };
+        int pr = ::poll(&p, 1, 100);
+        if (pr < 0 && errno != EINTR) break;
+        if (pr > 0) {
+            if (buf.size() - tail < AUDIO_STREAM_MAX_FRAME) {
+                std::memmove(buf.data(), buf.data() + head, tail - head);
+                tail -= head;
+                head = 0;
+            }
+            ssize_t n = ::read(fd, buf.data() + tail, buf.size() - tail);
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) continue;
+                break;                  // EOF, or EIO when the port goes away
+            }
+            tail += size_t(n);
+            st.bytes += size_t(n);
+        }
+
+        while (head < tail) {
+            audio_frame_info_t info;
+            int len = audio_stream_parse(&buf[head], tail - head, &info);
+            if (len == 0) break;
+            if (len < 0) {
+                head++;
+                st.skipped_bytes++;
+                continue;
+            }
+
+            if (!wav_open) {
+                rate = info.sample_rate;
+                size_t grow = size_t(prealloc_s * rate) * sizeof(int16_t);
+                if (!wav.open(out_path, rate, grow)) {
+                    std::fprintf(stderr, "cannot create %s: %s\n", out_path.c_str(), std::strerror(errno));
+                    rc = 1;
+                    g_stop = true;
+                    break;
+                }
+                wav_open = true;
+                if (max_seconds > 0) max_samples = size_t(max_seconds * rate);
+            } else if (info.sample_rate != rate) {
+                st.rate_changes++;      // keep the first rate; a WAV has only one
+            }
+
+            if (have_seq && info.seq != next_seq) {
+                uint16_t gap = uint16_t(info.seq - next_seq);
+                st.lost_frames += gap;
+                wav.silence(size_t(gap) * last_samples);
+            }
+            have_seq = true;
+            next_seq = uint16_t(info.seq + 1);
+            last_samples = info.samples;
+
+            const uint8_t *payload = &buf[head + AUDIO_STREAM_HEADER_SIZE];
+            if (info.codec == AUDIO_CODEC_IMA_ADPCM) {
+                ima_adpcm_state_t state = info.state;
+                ima_adpcm_decode(&state, payload, info.samples, pcm);
+            } else {
+                for (size_t i = 0; i < info.samples; i++) {
+                    pcm[i] = int16_t(payload[2 * i] | payload[2 * i + 1] << 8);
+                }
+            }
+            if (!wav.write(pcm, info.samples)) {
+                std::fprintf(stderr, "\nwrite to %s failed: %s\n", out_path.c_str(), std::strerror(errno));
+                rc = 1;
+                g_stop = true;
+                break;
+            }
+            meter.add(pcm, info.samples);
+            st.frames++;
+            head += size_t(len);
+
+            if (max_samples && wav.samples() >= max_samples) {
+                g_stop = true;
+                break;
+            }
+        }
+        if (head == tail) head = tail = 0;
+
+        auto now = Clock::now();
+        if (!quiet && now - t_draw >= std::chrono::milliseconds(100)) {
+            meter.draw(st, wav.samples(), rate);
+            t_draw = now;
+        }
+    }
+    ::close(fd);
+
+    double wall = std::chrono::duration<double>(Clock::now() - t_start).count();
+    if (!quiet) std::fputc('\n', stderr);
+    if (!wav_open) {
+        std::fprintf(stderr, "no audio frames received (%zu bytes)\n", st.bytes);
+        return 1;
+    }
+    size_t samples = wav.samples();
+    if (!wav.close()) {
+        std::fprintf(stderr, "closing %s failed: %s\n", out_path.c_str(), std::strerror(errno));
+        rc = 1;
+    }
+    std::printf("%zu frames, %zu samples @ %u Hz (%.2f s audio in %.2f s), "
+                "%zu lost frames, %zu bytes skipped, %.0f B/s -> %s\n",
+                st.frames, samples, rate, double(samples) / rate, wall,
+                st.lost_frames, st.skipped_bytes, st.bytes / wall, out_path.c_str());
+    if (st.rate_changes) {
+        std::printf("warning: %zu frames had a different sample rate than %u Hz\n",
+                    st.rate_changes, rate);
+    }
+    return rc;
+}
@@ -0,0 +1,169 @@
+// pty_stream: stand-in for the board when testing mic_capture. Creates a
+// pseudo terminal and sends a synthetic tone on it in the same frames the
+// firmware sends on CDC1.
+//
+//   pty_stream [-r rate] [-c pcm16|adpcm] [-t seconds] [-f hz] [-d n] [-x speed] [-w ms]
+//
+// The slave path is printed on stdout; point mic_capture at it. -d drops
+// every n-th frame (its sequence number is still used) to exercise gap
+// detection, -x sends faster than real time to measure headroom.
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tkjhat/audio_stream.h"
+
+namespace {
+
+// Same block size as the firmware microphone buffer
+constexpr size_t kBlock = 256;
+
+struct Sink {
+    int fd;
+    unsigned drop_every;
+    size_t frames = 0;
+    size_t dropped = 0;
+    bool failed = false;
+};
+
+int send_frame(const void *data, size_t len, void *ctx) {
+    auto *s = static_cast<Sink *>(ctx);
+    s->frames++;
+    if (s->drop_every && s->frames % s->drop_every == 0) {
+        s->dropped++;
+        return int(len);
+    }
+    auto *p = static_cast<const uint8_t *>(data);
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = ::write(s->fd, p + done, len - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            s->failed = true;
+            return int(done);
+        }
+        done += size_t(n);
+    }
+    return int(len);
+}
+
+void add_ns(timespec &t, long ns) {
+    t.tv_nsec += ns;
+    while (t.tv_nsec >= 1000000000L) {
+        t.tv_nsec -= 1000000000L;
+        t.tv_sec++;
+    }
+}
+
+void usage(const char *argv0) {
+    std::fprintf(stderr,
+                 "usage: %s [-r rate] [-c pcm16|adpcm] [-t seconds] [-f hz] [-d n] [-x speed] [-w ms]\n"
+                 "  -r  sample rate (default 48000)\n"
+                 "  -c  payload codec (default pcm16)\n"
+                 "  -t  seconds of audio to send (default 10)\n"
+                 "  -f  tone frequency (default 1000)\n"
+                 "  -d  drop every n-th frame (default 0, none)\n"
+                 "  -x  send this many times faster than real time (default 1)\n"
+                 "  -w  wait before sending so the reader can open the port (default 500)\n",
+                 argv0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    unsigned rate = 48000;
+    audio_codec_t codec = AUDIO_CODEC_PCM16;
+    double seconds = 10;
+    double freq = 1000;
+    unsigned drop_every = 0;
+    double speed = 1;
+    unsigned wait_ms = 500;
+    int opt;
+    while ((opt = ::getopt(argc, argv, "r:c:t:f:d:x:w:")) != -1) {
+        switch (opt) {
+        case 'r': rate = unsigned(std::atoi(optarg)); break;
+        case 'c':
+            if (std::strcmp(optarg, "adpcm") == 0) codec = AUDIO_CODEC_IMA_ADPCM;
+            else if (std::strcmp(optarg, "pcm16") == 0) codec = AUDIO_CODEC_PCM16;
+            else { usage(argv[0]); return 2; }
+            break;
+        case 't': seconds = std::atof(optarg); break;
+        case 'f': freq = std::atof(optarg); break;
+        case 'd': drop_every = unsigned(std::atoi(optarg)); break;
+        case 'x': speed = std::atof(optarg); break;
+        case 'w': wait_ms = unsigned(std::atoi(optarg)); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (rate == 0 || rate > 65535 || speed <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    int master = ::posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || ::grantpt(master) != 0 || ::unlockpt(master) != 0) {
+        std::perror("posix_openpt");
+        return 1;
+    }
+    // Raw mode on the master side applies to the line, so the binary frames
+    // pass through untouched whoever opens the slave
+    termios t;
+    if (::tcgetattr(master, &t) == 0) {
+        ::cfmakeraw(&t);
+        ::tcsetattr(master, TCSANOW, &t);
+    }
+    // Keep a slave fd open ourselves: without it the master write fails
+    // with EIO before the reader has opened the port
+    const char *slave_name = ::ptsname(master);
+    int slave = ::open(slave_name, O_RDWR | O_NOCTTY);
+    std::printf("%s\n", slave_name);
+    std::fflush(stdout);
+    ::usleep(wait_ms * 1000u);
+
+    Sink sink{ master, drop_every };
+    static audio_stream_t as;
+    audio_stream_init(&as, codec, uint16_t(rate), send_frame, &sink);
+
+    const size_t total = size_t(seconds * rate);
+    const long block_ns = long(1e9 * kBlock / rate / speed);
+    const double w = 2.0 * M_PI * freq / rate;
+    int16_t pcm[kBlock];
+    timespec next;
+    ::clock_gettime(CLOCK_MONOTONIC, &next);
+    timespec t0 = next;
+
+    for (size_t done = 0; done < total && !sink.failed; done += kBlock) {
+        size_t n = total - done < kBlock ? total - done : kBlock;
+        for (size_t i = 0; i < n; i++) {
+            // Tone with a slow 0.5 Hz swell so the level meter has something to show
+            double tt = double(done + i);
+            double env = 0.55 + 0.45 * std::sin(2.0 * M_PI * 0.5 * tt / rate);
+            pcm[i] = int16_t(std::lround(20000.0 * env * std::sin(w * tt)));
+        }
+        audio_stream_write(&as, pcm, n);
+        add_ns(next, block_ns);
+        ::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+    }
+
+    timespec t1;
+    ::clock_gettime(CLOCK_MONOTONIC, &t1);
+    double wall = double(t1.tv_sec - t0.tv_sec) + double(t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    std::fprintf(stderr, "sent %zu frames (%zu dropped on purpose), %u bytes in %.2f s\n",
+                 sink.frames, sink.dropped, unsigned(as.bytes_out), wall);
+
+    // Let the reader drain the pty before the line goes away
+    ::tcdrain(master);
+    ::usleep(200000);
+    if (slave >= 0) ::close(slave);
+    ::close(master);
+    return sink.failed ? 1 : 0;
+}
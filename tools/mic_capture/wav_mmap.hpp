@@ -0,0 +1,95 @@
+// WAV file written through a memory mapping.
+//
+// The file is pre-sized in large steps and samples are copied straight into
+// the mapping, so writing costs a memcpy and no system call per block. The
+// RIFF and data sizes in the header are patched and the file is cut to its
+// real length on close().
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "wav.hpp"
+
+class WavMmap {
+public:
+    ~WavMmap() { close(); }
+
+    // grow_bytes: how much the file is extended each time it fills up
+    bool open(const std::string &path, uint32_t sample_rate, size_t grow_bytes) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) return false;
+        rate_ = sample_rate;
+        grow_ = grow_bytes < 4096 ? 4096 : grow_bytes;
+        used_ = kHeader;
+        return remap(kHeader + grow_);
+    }
+
+    bool write(const int16_t *pcm, size_t samples) {
+        size_t bytes = samples * sizeof(int16_t);
+        if (used_ + bytes > size_ && !remap(used_ + bytes + grow_)) return false;
+        std::memcpy(map_ + used_, pcm, bytes);      // host is little-endian like WAV
+        used_ += bytes;
+        return true;
+    }
+
+    bool silence(size_t samples) {
+        size_t bytes = samples * sizeof(int16_t);
+        if (used_ + bytes > size_ && !remap(used_ + bytes + grow_)) return false;
+        std::memset(map_ + used_, 0, bytes);
+        used_ += bytes;
+        return true;
+    }
+
+    size_t samples() const { return (used_ - kHeader) / sizeof(int16_t); }
+
+    // Patch the header, drop the unused tail and close
+    bool close() {
+        if (fd_ < 0) return true;
+        bool ok = true;
+        if (map_) {
+            patch_header();
+            ok = ::msync(map_, size_, MS_SYNC) == 0;
+            ::munmap(map_, size_);
+            map_ = nullptr;
+        }
+        ok = ::ftruncate(fd_, off_t(used_)) == 0 && ok;
+        ok = ::close(fd_) == 0 && ok;
+        fd_ = -1;
+        return ok;
+    }
+
+private:
+    static constexpr size_t kHeader = wav::kHeaderBytes;
+
+    bool remap(size_t new_size) {
+        if (map_) {
+            patch_header();
+            ::munmap(map_, size_);
+            map_ = nullptr;
+        }
+        if (::ftruncate(fd_, off_t(new_size)) != 0) return false;
+        void *m = ::mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (m == MAP_FAILED) return false;
+        map_ = static_cast<uint8_t *>(m);
+        size_ = new_size;
+        patch_header();
+        return true;
+    }
+
+    // Valid header for what has been written so far (readable after a crash)
+    void patch_header() { wav::header(map_, rate_, uint32_t(used_ - kHeader)); }
+
+    int fd_ = -1;
+    uint8_t *map_ = nullptr;
+    size_t size_ = 0;
+    size_t used_ = 0;
+    size_t grow_ = 0;
+    uint32_t rate_ = 0;
+};
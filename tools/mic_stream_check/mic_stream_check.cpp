@@ -0,0 +1,215 @@
+// mic_stream_check: the gated DSP task of mic_stream.c (look-ahead,
+// pre-roll, discarding silent buffers) on the host_pico PIO/DMA model.
+//
+//   mic_stream_check [-v]
+//
+// The microphone pin plays modulated PDM at 8 kHz x 64 (32 ms raw
+// buffers): microphone self-noise (-90 dBFS at the stream) with two
+// bursts of a -6 dBFS 1 kHz tone, 10 buffers each, the first after 40
+// quiet buffers and the second 40 buffers later. The gate's default
+// threshold (8x the floor, which cannot fall below 1/16 count^2) wants a
+// tone that loud; -10 dBFS stays closed. init_pdm_microphone()
+// and mic_stream_start() run with the gate on and the default pre-roll;
+// the DSP task then runs for the whole input.
+//
+// The test replays the gate on the same raw buffers to know which ones
+// the task must stream: every buffer the gate is open after, plus the
+// pre-roll buffers before each onset. Checks:
+//
+// - the stream holds exactly those buffers, in order: the output of each
+//   is loud where the input was, and each onset comes after its pre-roll
+//   quiet buffers. The level is taken over the second half of a buffer,
+//   past the tail of a burst, and loud means above -20 dBFS: the first
+//   buffer the filter ever sees still carries its DC settling at -32;
+// - two onsets, no samples dropped;
+// - every captured buffer is filtered, gated, or still in the ring, and
+//   duty_permille is buffers / (buffers + gated_buffers).
+//
+// -v prints the class of every streamed buffer. Exit code 1 if any check
+// failed.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "host_pico.h"
+#include "pdm_modulator.hpp"
+
+extern "C" {
+#include "pico/stdlib.h"
+#include "tkjhat/mic_stream.h"
+#include "tkjhat/pdm_microphone.h"
+}
+
+namespace {
+
+constexpr uint32_t kRate = MEMS_SAMPLING_FREQUENCY;
+constexpr uint32_t kDecimation = 64;
+constexpr size_t kBufferSamples = MEMS_BUFFER_SIZE;
+constexpr size_t kBufferBytes = kBufferSamples * kDecimation / 8;
+constexpr double kGain = 16.0;              // pdm_microphone.c filter Gain
+
+constexpr size_t kQuiet = 40, kBurst = 10;
+constexpr size_t kBuffers = 3 * kQuiet + 2 * kBurst;
+constexpr double kToneDbfs = -6.0, kSelfNoiseDbfs = -90.0, kLoudDbfs = -20.0;
+
+int failures = 0;
+
+void check(bool ok, const char *what, long got, long want) {
+    if (!ok) {
+        std::printf("FAIL %s: got %ld, want %ld\n", what, got, want);
+        failures++;
+    }
+}
+
+bool loud_input(size_t b) {
+    return (b >= kQuiet && b < kQuiet + kBurst) ||
+           (b >= 2 * kQuiet + kBurst && b < 2 * kQuiet + 2 * kBurst);
+}
+
+// Modulated input, with one spare buffer so the pin never wraps around
+std::vector<uint8_t> input() {
+    std::mt19937 rng(1);
+    std::normal_distribution<double> noise(0.0, std::pow(10.0, kSelfNoiseDbfs / 20.0));
+    const double amp = std::pow(10.0, kToneDbfs / 20.0) * std::sqrt(2.0) / kGain;
+    const size_t samples = (kBuffers + 1) * kBufferSamples;
+    std::vector<double> s(samples);
+    for (size_t i = 0; i < samples; i++) {
+        s[i] = noise(rng);
+        if (loud_input(i / kBufferSamples)) s[i] += amp * std::sin(2 * M_PI * 1000.0 * i / kRate);
+    }
+    return pdm::modulate(samples * kDecimation, 1, [&](size_t i) { return s[i / kDecimation]; });
+}
+
+struct Pin {
+    const std::vector<uint8_t> *data;
+    size_t next = 0;
+};
+
+bool next_bit(void *ctx) {
+    auto *p = static_cast<Pin *>(ctx);
+    const size_t i = p->next++ % (p->data->size() * 8);
+    return ((*p->data)[i / 8] >> (7 - i % 8)) & 1;
+}
+
+// Buffers the task must stream: as mic_stream_task, the gate sees every
+// buffer once in order; an onset brings the pre-roll buffers before it
+std::vector<size_t> expected(const std::vector<uint8_t> &bits, const mic_stream_config_t &cfg,
+                             uint32_t buffer_us) {
+    mic_gate_t g;
+    mic_gate_init(&g, &cfg.gate_cfg);
+    std::vector<size_t> out;
+    for (size_t b = 0; b < kBuffers; b++) {
+        const bool was_open = g.open;
+        mic_gate_update(&g, mic_gate_energy(&bits[b * kBufferBytes], kBufferBytes, kDecimation / 8),
+                        buffer_us);
+        if (!g.open) continue;
+        if (!was_open) {
+            for (size_t k = cfg.preroll; k > 0; k--) {
+                if (b >= k && (out.empty() || out.back() < b - k)) out.push_back(b - k);
+            }
+        }
+        out.push_back(b);
+    }
+    return out;
+}
+
+double level_dbfs(const int16_t *x, size_t n) {
+    double e = 0.0;
+    for (size_t i = 0; i < n; i++) e += double(x[i]) * x[i];
+    return 10.0 * std::log10(e / double(n) / (32768.0 * 32768.0) + 1e-20);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "-v") verbose = true;
+        else { std::fprintf(stderr, "usage: %s [-v]\n", argv[0]); return 2; }
+    }
+
+    const std::vector<uint8_t> bits = input();
+    host_pico_reset();
+    Pin pin{&bits};
+    host_pio_set_bit_source(0, 0, next_bit, &pin);
+
+    int rc = init_pdm_microphone();
+    check(rc == 0, "init_pdm_microphone", rc, 0);
+    mic_stream_config_t cfg;
+    mic_stream_default_config(&cfg);
+    cfg.gate = true;
+    cfg.frames = uint16_t(kBuffers);        // read after the run: nothing may drop
+
+    // The task is created before sampling starts; run it once it has
+    host_task_defer();
+    rc = mic_stream_start(&cfg);
+    check(rc == 0, "mic_stream_start", rc, 0);
+    pdm_microphone_stats mic;
+    pdm_microphone_get_stats(&mic);
+    host_task_start(time_us_64() + uint64_t(kBuffers) * mic.buffer_us);
+
+    mic_stream_stats_t st;
+    mic_stream_get_stats(&st);
+    pdm_microphone_get_stats(&mic);
+    uint32_t oldest;
+    const uint32_t end = pdm_microphone_raw_window(&oldest);
+
+    std::vector<int16_t> pcm;
+    int16_t buf[kBufferSamples];
+    for (size_t n; (n = mic_stream_read(buf, kBufferSamples, 0)) > 0;) {
+        pcm.insert(pcm.end(), buf, buf + n);
+    }
+
+    const std::vector<size_t> want = expected(bits, cfg, mic.buffer_us);
+    const size_t streamed = pcm.size() / kBufferSamples;
+    check(pcm.size() % kBufferSamples == 0, "samples in whole buffers",
+          long(pcm.size() % kBufferSamples), 0);
+    check(streamed == want.size(), "buffers streamed", long(streamed), long(want.size()));
+    check(st.buffers == streamed, "stats buffers", st.buffers, long(streamed));
+    check(st.onsets == 2, "onsets", st.onsets, 2);
+    check(st.dropped_samples == 0, "dropped samples", st.dropped_samples, 0);
+
+    // Each streamed buffer loud exactly where its input was
+    long mismatched = 0, preroll_quiet = 0, loud_out = 0;
+    for (size_t i = 0; i < streamed && i < want.size(); i++) {
+        const double db = level_dbfs(&pcm[i * kBufferSamples + kBufferSamples / 2],
+                                     kBufferSamples / 2);
+        const bool loud = db > kLoudDbfs;
+        loud_out += loud;
+        if (loud != loud_input(want[i])) mismatched++;
+        // The pre-roll: the buffers right before each burst, streamed quiet
+        const bool preroll = (want[i] + cfg.preroll >= kQuiet && want[i] < kQuiet) ||
+                             (want[i] + cfg.preroll >= 2 * kQuiet + kBurst &&
+                              want[i] < 2 * kQuiet + kBurst);
+        if (preroll && !loud) preroll_quiet++;
+        if (verbose) {
+            std::printf("%3zu  input buffer %3zu %s  %7.1f dBFS\n", i, want[i],
+                        loud_input(want[i]) ? "tone " : "quiet", db);
+        }
+    }
+    check(mismatched == 0, "streamed buffers loud where the input was not (or not where it was)",
+          mismatched, 0);
+    check(loud_out == long(2 * kBurst), "loud buffers streamed", loud_out, long(2 * kBurst));
+    check(preroll_quiet == long(2 * cfg.preroll), "quiet pre-roll buffers streamed",
+          preroll_quiet, long(2 * cfg.preroll));
+
+    // Accounting against the capture
+    const long in_ring = long(end - oldest);
+    check(long(st.buffers + st.gated_buffers) + in_ring == long(mic.buffers_captured),
+          "filtered + gated + in the ring", long(st.buffers + st.gated_buffers) + in_ring,
+          long(mic.buffers_captured));
+    const uint32_t total = st.buffers + st.gated_buffers;
+    const long duty = total ? long(uint64_t(st.buffers) * 1000 / total) : 0;
+    check(st.duty_permille == uint32_t(duty), "duty_permille", st.duty_permille, duty);
+    check(mic.overruns == 0, "raw overruns", mic.overruns, 0);
+
+    std::printf("%u captured, %u streamed (%u onsets, pre-roll %u), %u gated, %ld in the ring, "
+                "duty %u per mille\n", mic.buffers_captured, st.buffers, st.onsets,
+                unsigned(cfg.preroll), st.gated_buffers, in_ring, st.duty_permille);
+    std::printf("%s\n", failures ? "mic_stream_check: FAILED" : "mic_stream_check: ok");
+    return failures ? 1 : 0;
+}
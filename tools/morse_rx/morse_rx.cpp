@@ -0,0 +1,300 @@
+// morse_rx: run the microphone Morse receiver (tkjhat/tone_morse.h) on the
+// PC, on a recording or on a synthesized buzzer signal.
+//
+//   morse_rx [options] <in.wav>
+//       Decode a 16-bit WAV file (e.g. captured with mic_capture).
+//   morse_rx --synth "TEXT" [options] [-o out.wav]
+//       Synthesize TEXT as buzzer Morse with noise, decode it and compare.
+//   morse_rx --sweep
+//       Character accuracy over a grid of speeds, noise levels and detuning.
+//
+// Options: --wpm N (synth speed, 15), --tone HZ (1000), --detune HZ (0),
+//          --snr DB (20), --rate HZ (8000), --unit-ms N (receiver start, 100),
+//          --no-track, --seed N (noise)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "tkjhat/tone_morse.h"
+#include "wav.hpp"
+
+namespace {
+
+// Same table as the firmware application (main.c)
+struct MorseEntry {
+    char symbol;
+    const char *code;
+};
+
+const MorseEntry morse_table[] = {
+    {'A', ".-"}, {'B', "-..."}, {'C', "-.-."}, {'D', "-.."}, {'E', "."},
+    {'F', "..-."}, {'G', "--."}, {'H', "...."}, {'I', ".."}, {'J', ".---"},
+    {'K', "-.-"}, {'L', ".-.."}, {'M', "--"}, {'N', "-."}, {'O', "---"},
+    {'P', ".--."}, {'Q', "--.-"}, {'R', ".-."}, {'S', "..."}, {'T', "-"},
+    {'U', "..-"}, {'V', "...-"}, {'W', ".--"}, {'X', "-..-"}, {'Y', "-.--"},
+    {'Z', "--.."},
+    {'0', "-----"}, {'1', ".----"}, {'2', "..---"}, {'3', "...--"}, {'4', "....-"},
+    {'5', "....."}, {'6', "-...."}, {'7', "--..."}, {'8', "---.."}, {'9', "----."},
+    {',', "--..--"}, {'?', "..--.."}, {'!', "-.-.--"}, {'\'', ".----."},
+    {'/', "-..-."}, {'(', "-.--."}, {')', "-.--.-"}, {'&', ".-..."}, {':', "---..."},
+    {';', "-.-.-."}, {'=', "-...-"}, {'+', ".-.-."}, {'_', "..--.-"},
+    {'"', ".-..-."}, {'$', "...-..-"}, {'@', ".--.-."}
+};
+
+char from_morse(const char *code) {
+    for (const auto &e : morse_table) {
+        if (std::strcmp(e.code, code) == 0) return e.symbol;
+    }
+    return '?';
+}
+
+const char *to_morse(char c) {
+    c = char(std::toupper((unsigned char)c));
+    for (const auto &e : morse_table) {
+        if (e.symbol == c) return e.code;
+    }
+    return "";
+}
+
+struct Options {
+    double wpm = 15;
+    double tone = 1000;
+    double detune = 0;
+    double snr_db = 20;
+    uint32_t rate = 8000;
+    uint32_t unit_ms = 100;
+    bool track = true;
+    unsigned seed = 1;
+};
+
+// Buzzer-like square wave keyed with Morse timing, plus white noise
+std::vector<int16_t> synthesize(const std::string &text, const Options &o, std::mt19937 &rng) {
+    const double unit_s = 1.2 / o.wpm;
+    const double amp = 6000.0;
+    // A square wave of amplitude a has power a^2
+    const double noise_rms = amp / std::pow(10.0, o.snr_db / 20.0);
+    std::normal_distribution<double> noise(0.0, noise_rms);
+    const double hz = o.tone + o.detune;
+
+    std::vector<int16_t> pcm;
+    double phase = 0;
+    auto emit = [&](double seconds, bool on) {
+        size_t n = size_t(seconds * o.rate + 0.5);
+        for (size_t i = 0; i < n; i++) {
+            double v = noise(rng);
+            if (on) v += phase < 0.5 ? amp : -amp;
+            phase += hz / o.rate;
+            if (phase >= 1.0) phase -= 1.0;
+            pcm.push_back(int16_t(std::clamp(v, -32768.0, 32767.0)));
+        }
+    };
+
+    emit(0.5, false);
+    bool first_letter = true;
+    for (char c : text) {
+        if (c == ' ') {
+            emit(6 * unit_s, false);    // word gap 7 = 1 (after the mark) + 6
+            first_letter = true;
+            continue;
+        }
+        const char *code = to_morse(c);
+        if (!*code) continue;
+        if (!first_letter) emit(2 * unit_s, false);     // letter gap 3 = 1 + 2
+        first_letter = false;
+        for (const char *p = code; *p; p++) {
+            emit((*p == '-' ? 3 : 1) * unit_s, true);
+            emit(unit_s, false);
+        }
+    }
+    emit(1.0, false);
+    return pcm;
+}
+
+struct Decoded {
+    std::string text;
+    tone_morse_status_t status;
+    double ns_per_sample;
+};
+
+void on_event(const tone_morse_event_t *ev, void *ctx) {
+    auto *text = static_cast<std::string *>(ctx);
+    if (ev->symbol == TONE_MORSE_LETTER_GAP && ev->letter) text->push_back(ev->letter);
+    if (ev->symbol == TONE_MORSE_WORD_GAP) text->push_back(' ');
+}
+
+bool decode(const std::vector<int16_t> &pcm, uint32_t rate, const Options &o, Decoded &out) {
+    tone_morse_config_t cfg;
+    tone_morse_default_config(&cfg);
+    cfg.sample_rate = rate;
+    cfg.tone_hz = float(o.tone);
+    cfg.track = o.track;
+    cfg.unit_us = o.unit_ms * 1000;
+    cfg.decode = from_morse;
+    cfg.on_event = on_event;
+    cfg.ctx = &out.text;
+
+    tone_morse_t rx;
+    if (tone_morse_init(&rx, &cfg) != 0) {
+        std::fprintf(stderr, "invalid receiver settings for %u Hz\n", rate);
+        return false;
+    }
+    // Same chunk size as the microphone buffer
+    const size_t chunk = 256;
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < pcm.size(); i += chunk) {
+        tone_morse_process(&rx, &pcm[i], std::min(chunk, pcm.size() - i));
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    out.ns_per_sample = std::chrono::duration<double, std::nano>(t1 - t0).count() / double(pcm.size());
+    while (!out.text.empty() && out.text.back() == ' ') out.text.pop_back();
+    tone_morse_get_status(&rx, &out.status);
+    return true;
+}
+
+std::string normalize(const std::string &s) {
+    std::string out;
+    for (char c : s) {
+        if (c == ' ' && (out.empty() || out.back() == ' ')) continue;
+        out.push_back(char(std::toupper((unsigned char)c)));
+    }
+    while (!out.empty() && out.back() == ' ') out.pop_back();
+    return out;
+}
+
+size_t edit_distance(const std::string &a, const std::string &b) {
+    std::vector<size_t> d(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); j++) d[j] = j;
+    for (size_t i = 1; i <= a.size(); i++) {
+        size_t prev = d[0];
+        d[0] = i;
+        for (size_t j = 1; j <= b.size(); j++) {
+            size_t cur = d[j];
+            d[j] = std::min({ d[j] + 1, d[j - 1] + 1, prev + (a[i - 1] == b[j - 1] ? 0 : 1) });
+            prev = cur;
+        }
+    }
+    return d[b.size()];
+}
+
+double accuracy(const std::string &want, const std::string &got) {
+    std::string w = normalize(want), g = normalize(got);
+    if (w.empty()) return 1.0;
+    double e = double(edit_distance(w, g));
+    return std::max(0.0, 1.0 - e / double(w.size()));
+}
+
+void print_result(const Decoded &d) {
+    std::printf("decoded   \"%s\"\n", d.text.c_str());
+    std::printf("speed     %.1f WPM (unit %u ms)\n", d.status.wpm, unsigned(d.status.unit_us / 1000));
+    std::printf("tone      %.1f Hz, level %u, floor %u, peak %u\n", d.status.tone_hz,
+                unsigned(d.status.level), unsigned(d.status.noise_floor), unsigned(d.status.peak));
+    std::printf("cost      %.1f ns/sample (host)\n", d.ns_per_sample);
+}
+
+int sweep(const Options &base) {
+    const std::string text = "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 0123456789";
+    std::mt19937 rng(base.seed);
+    double total = 0;
+    int runs = 0;
+    std::printf("character accuracy, %%; columns: SNR dB\n");
+    for (double detune : { 0.0, 40.0, -80.0 }) {
+        std::printf("\ndetune %+.0f Hz%s\n  WPM", detune, base.track ? "" : " (no tracking)");
+        const double snrs[] = { 20, 10, 6, 3, 0 };
+        for (double snr : snrs) std::printf(" %6.0f", snr);
+        std::printf("\n");
+        for (double wpm : { 5.0, 10.0, 15.0, 20.0, 25.0, 30.0 }) {
+            std::printf("  %3.0f", wpm);
+            for (double snr : snrs) {
+                Options o = base;
+                o.wpm = wpm;
+                o.snr_db = snr;
+                o.detune = detune;
+                Decoded d;
+                auto pcm = synthesize(text, o, rng);
+                decode(pcm, o.rate, o, d);
+                double a = accuracy(text, d.text);
+                total += a;
+                runs++;
+                std::printf(" %6.1f", 100 * a);
+            }
+            std::printf("\n");
+        }
+    }
+    std::printf("\nmean %.1f %%\n", 100 * total / runs);
+    return 0;
+}
+
+void usage(const char *argv0) {
+    std::fprintf(stderr,
+                 "usage: %s [options] <in.wav>\n"
+                 "       %s --synth \"TEXT\" [options] [-o out.wav]\n"
+                 "       %s --sweep [options]\n"
+                 "options: --wpm N --tone HZ --detune HZ --snr DB --rate HZ --unit-ms N --no-track --seed N\n",
+                 argv0, argv0, argv0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options o;
+    std::string synth_text, in_path, out_path;
+    bool synth = false, do_sweep = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (a == "--synth") { synth = true; synth_text = next(); }
+        else if (a == "--sweep") do_sweep = true;
+        else if (a == "--wpm") o.wpm = std::atof(next());
+        else if (a == "--tone") o.tone = std::atof(next());
+        else if (a == "--detune") o.detune = std::atof(next());
+        else if (a == "--snr") o.snr_db = std::atof(next());
+        else if (a == "--rate") o.rate = uint32_t(std::atoi(next()));
+        else if (a == "--unit-ms") o.unit_ms = uint32_t(std::atoi(next()));
+        else if (a == "--no-track") o.track = false;
+        else if (a == "--seed") o.seed = unsigned(std::atoi(next()));
+        else if (a == "-o") out_path = next();
+        else if (!a.empty() && a[0] == '-') { usage(argv[0]); return 2; }
+        else in_path = a;
+    }
+
+    if (do_sweep) return sweep(o);
+
+    std::vector<int16_t> pcm;
+    uint32_t rate = o.rate;
+    if (synth) {
+        std::mt19937 rng(o.seed);
+        pcm = synthesize(synth_text, o, rng);
+        if (!out_path.empty() && !wav::write(out_path, rate, pcm)) {
+            std::fprintf(stderr, "cannot write %s\n", out_path.c_str());
+            return 1;
+        }
+    } else if (in_path.empty() || !wav::read(in_path, rate, pcm)) {
+        if (!in_path.empty()) std::fprintf(stderr, "cannot read 16-bit PCM WAV %s\n", in_path.c_str());
+        else usage(argv[0]);
+        return in_path.empty() ? 2 : 1;
+    }
+
+    Decoded d;
+    if (!decode(pcm, rate, o, d)) return 1;
+    print_result(d);
+    if (synth) {
+        double a = accuracy(synth_text, d.text);
+        std::printf("accuracy  %.1f %%\n", 100 * a);
+        return normalize(synth_text) == normalize(d.text) ? 0 : 1;
+    }
+    return 0;
+}
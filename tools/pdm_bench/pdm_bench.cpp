@@ -0,0 +1,508 @@
+// pdm_bench: accuracy and cost of the PDM to PCM filter (OpenPDM2PCM) on
+// the PC, without a board.
+//
+//   pdm_bench [-t seconds] [-n repeats] [-j results.jsonl] [-q] [file.wav ...]
+//
+// A second-order sigma-delta modulator turns a stepped sine sweep (at every
+// rate and decimation the driver supports) and any given WAV files (e.g. the
+// mic_*.wav recordings, at their own rate) into PDM bit streams, scaled like
+// a real microphone so that the filter's gain of 16 brings them back to the
+// source level. Each stream is filtered with Open_PDM_Filter_64/128 and the
+// output compared with the source:
+//
+// - sines: a least-squares fit of the tone gives SNR, THD (harmonics 2-5)
+//   and SINAD;
+// - WAV files: SNR after a least-squares FIR fit from source to output, so
+//   the filter's delay and frequency response are not counted as error.
+//   They are scaled to a -6 dBFS peak first, and the filter's DC removal
+//   is applied to the source it is compared with.
+//
+// Every configuration is also run as bit-interleaved stereo
+// (Open_PDM_Filter_Stereo_64/128), which must match the mono output exactly.
+// Times are ns of host CPU per output sample (per channel), the best of
+// -n runs. The coefficient tables (flash on the board) and per-channel
+// state are listed as the filter's memory footprint.
+//
+// Whether the filter uses its lookup table is fixed when OpenPDMFilter.c is
+// compiled, so this program is built twice: pdm_bench (LUT) and
+// pdm_bench_nolut. -j appends one JSON object per result line, tagged with
+// the variant, for tracking regressions:
+//
+//   ./pdm_bench -j bench.jsonl mic.wav && ./pdm_bench_nolut -j bench.jsonl mic.wav
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "OpenPDMFilter.h"
+#include "pdm_modulator.hpp"
+#include "wav.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+#ifdef USE_LUT
+constexpr const char *kVariant = "lut";
+#else
+constexpr const char *kVariant = "nolut";
+#endif
+
+// As pdm_microphone.c
+constexpr uint16_t kVolume = 64;
+constexpr uint8_t kGain = 16;
+
+// Output settles within this (10 Hz high-pass)
+constexpr double kSettleS = 0.1;
+constexpr uint16_t kHighPassHz = 10;
+
+// Modulator input: a tone, or recorded PCM at the output rate; both in
+// modulator units (see pdm_level())
+struct Source {
+    std::string name;
+    double hz = 0;              // tone frequency; 0 for recorded input
+    double amplitude = 0;
+    size_t samples = 0;         // at the output rate
+    std::vector<double> pcm;    // recorded input
+};
+
+// Windowed-sinc interpolation to the PDM rate. Linear interpolation would
+// leave images just above the output Nyquist frequency, which the decimator
+// folds back as error that a real microphone never sees.
+class Upsampler {
+public:
+    static constexpr int kHalf = 16;        // input samples each side
+    static constexpr double kCutoff = 0.45; // of the input rate
+
+    explicit Upsampler(uint32_t decimation) : d_(decimation), h_(size_t(decimation) * 2 * kHalf) {
+        for (uint32_t k = 0; k < d_; k++) {
+            for (int j = -kHalf + 1; j <= kHalf; j++) {
+                const double tau = double(k) / d_ - j;
+                const double x = 2.0 * kCutoff * tau;
+                const double sinc = x == 0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+                const double window = 0.5 + 0.5 * std::cos(M_PI * tau / kHalf);
+                h_[k * 2 * kHalf + size_t(j + kHalf - 1)] = 2.0 * kCutoff * sinc * window;
+            }
+        }
+    }
+
+    // Value at input position i + phase / decimation
+    double at(const std::vector<double> &x, size_t i, uint32_t phase) const {
+        const double *h = &h_[phase * 2 * kHalf];
+        double y = 0;
+        for (int j = -kHalf + 1; j <= kHalf; j++) {
+            const ptrdiff_t n = ptrdiff_t(i) + j;
+            if (n >= 0 && size_t(n) < x.size()) y += x[size_t(n)] * h[j + kHalf - 1];
+        }
+        return y;
+    }
+
+private:
+    uint32_t d_;
+    std::vector<double> h_;
+};
+
+std::vector<uint8_t> modulate(const Source &src, uint32_t rate, uint32_t decimation, uint32_t seed) {
+    Upsampler up(decimation);
+    const double w = 2.0 * M_PI * src.hz / (double(rate) * decimation);
+    return pdm::modulate(src.samples * decimation, seed, [&](size_t bit) {
+        return src.hz > 0 ? src.amplitude * std::sin(w * double(bit))
+                          : up.at(src.pcm, bit / decimation, uint32_t(bit % decimation));
+    });
+}
+
+// What the filter should give for recorded input: the source with the
+// upsampler's band limit and the filter's DC removal. That is a first-order
+// high-pass with its coefficient rounded to 1/256 as in Open_PDM_Filter_Init,
+// a corner of 20-30 Hz whose phase shift a short FIR fit cannot absorb.
+std::vector<double> reference(const Source &src, uint32_t rate, uint32_t decimation) {
+    Upsampler up(decimation);
+    const double alpha = std::floor(rate * 256.0 / (2 * 3.14159 * kHighPassHz + rate)) / 256.0;
+    std::vector<double> ref(src.pcm.size());
+    double x1 = 0, y = 0;
+    for (size_t i = 0; i < ref.size(); i++) {
+        const double x = up.at(src.pcm, i, 0);
+        y = alpha * (y + x - x1);
+        x1 = x;
+        ref[i] = y;
+    }
+    return ref;
+}
+
+// Bit-interleave two streams: first channel in bits 7, 5, 3, 1
+std::vector<uint8_t> interleave(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b) {
+    std::vector<uint8_t> out(2 * a.size(), 0);
+    for (size_t i = 0; i < a.size() * 8; i++) {
+        const size_t o = 2 * i;
+        if (a[i / 8] & (0x80 >> (i % 8))) out[o / 8] |= uint8_t(0x80 >> (o % 8));
+        if (b[i / 8] & (0x80 >> (i % 8))) out[(o + 1) / 8] |= uint8_t(0x80 >> ((o + 1) % 8));
+    }
+    return out;
+}
+
+void init_filter(TPDMFilter_InitStruct &f, uint32_t rate, uint32_t decimation, uint8_t channels) {
+    f = TPDMFilter_InitStruct{};
+    f.Fs = uint16_t(rate);
+    f.LP_HZ = float(rate / 2);
+    f.HP_HZ = kHighPassHz;
+    f.In_MicChannels = channels;
+    f.Out_MicChannels = channels;
+    f.Decimation = uint8_t(decimation);
+    f.MaxVolume = 64;
+    f.Gain = kGain;
+    Open_PDM_Filter_Init(&f);
+}
+
+// Filter a whole stream in 1 ms blocks, best time of repeats in seconds
+double run(const std::vector<uint8_t> &pdm, uint32_t rate, uint32_t decimation, unsigned channels,
+           int repeats, std::vector<int16_t> &pcm) {
+    const size_t block = rate / 1000;
+    const size_t in_step = channels * block * decimation / 8;
+    const size_t blocks = pdm.size() / in_step;
+    pcm.assign(channels * blocks * block, 0);
+    uint8_t *in = const_cast<uint8_t *>(pdm.data());
+    double best = 1e30;
+    for (int r = 0; r < repeats; r++) {
+        TPDMFilter_InitStruct left, right;
+        init_filter(left, rate, decimation, uint8_t(channels));
+        init_filter(right, rate, decimation, uint8_t(channels));
+        auto t0 = Clock::now();
+        for (size_t b = 0; b < blocks; b++) {
+            auto *out = reinterpret_cast<uint16_t *>(&pcm[channels * b * block]);
+            uint8_t *src = in + b * in_step;
+            if (channels == 2) {
+                if (decimation == 128) Open_PDM_Filter_Stereo_128(src, out, kVolume, &left, &right);
+                else Open_PDM_Filter_Stereo_64(src, out, kVolume, &left, &right);
+            } else if (decimation == 128) {
+                Open_PDM_Filter_128(src, out, kVolume, &left);
+            } else {
+                Open_PDM_Filter_64(src, out, kVolume, &left);
+            }
+        }
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - t0).count());
+    }
+    return best;
+}
+
+double db(double ratio) { return ratio > 0 ? 10.0 * std::log10(ratio) : -999.0; }
+
+// Least-squares amplitude^2 of the tone at hz in y (cos/sin pair), and
+// removes it from y
+double remove_tone(std::vector<double> &y, double hz, uint32_t rate) {
+    const double w = 2.0 * M_PI * hz / rate;
+    double cc = 0, ss = 0, cs = 0, yc = 0, ys = 0;
+    for (size_t n = 0; n < y.size(); n++) {
+        const double c = std::cos(w * n), s = std::sin(w * n);
+        cc += c * c; ss += s * s; cs += c * s;
+        yc += y[n] * c; ys += y[n] * s;
+    }
+    const double det = cc * ss - cs * cs;
+    if (std::fabs(det) < 1e-9) return 0;
+    const double a = (yc * ss - ys * cs) / det;
+    const double b = (ys * cc - yc * cs) / det;
+    for (size_t n = 0; n < y.size(); n++) y[n] -= a * std::cos(w * n) + b * std::sin(w * n);
+    return 0.5 * (a * a + b * b);
+}
+
+struct Quality {
+    double snr_db = NAN, thd_db = NAN, sinad_db = NAN;
+};
+
+Quality analyse_tone(const std::vector<int16_t> &pcm, size_t stride, size_t channel,
+                     double hz, uint32_t rate) {
+    std::vector<double> y;
+    for (size_t i = size_t(kSettleS * rate) * stride + channel; i < pcm.size(); i += stride) {
+        y.push_back(pcm[i]);
+    }
+    double mean = 0;
+    for (double v : y) mean += v;
+    mean /= double(y.size());
+    for (double &v : y) v -= mean;
+
+    const double fund = remove_tone(y, hz, rate);
+    double noise_dist = 0;
+    for (double v : y) noise_dist += v * v;
+    noise_dist /= double(y.size());
+    double harm = 0;
+    int harmonics = 0;
+    for (int k = 2; k <= 5 && k * hz < rate / 2.0; k++, harmonics++) harm += remove_tone(y, k * hz, rate);
+    const double noise = std::max(noise_dist - harm, 1e-12);
+
+    Quality q;
+    q.sinad_db = db(fund / noise_dist);
+    q.snr_db = db(fund / noise);
+    q.thd_db = harmonics ? db(harm / fund) : NAN;
+    return q;
+}
+
+// SNR of out against src. A least-squares FIR (kTaps taps plus DC) maps src
+// onto out first, so the filter's delay, droop and high-pass count as part
+// of the signal; what is left is noise and distortion.
+constexpr size_t kTaps = 16;
+
+double compare(const std::vector<int16_t> &out, const std::vector<double> &src, uint32_t rate) {
+    constexpr size_t m = kTaps + 1;
+    const size_t skip = std::max(size_t(kSettleS * rate), kTaps);
+    const size_t n = std::min(out.size(), src.size());
+    if (n <= skip + m) return NAN;
+
+    // Normal equations A h = b over rows [src[i], src[i-1], ..., 1]
+    std::vector<double> A(m * m, 0.0), b(m, 0.0), row(m);
+    for (size_t i = skip; i < n; i++) {
+        for (size_t k = 0; k < kTaps; k++) row[k] = src[i - k];
+        row[kTaps] = 1.0 / (32768.0 * kGain);
+        for (size_t r = 0; r < m; r++) {
+            b[r] += row[r] * out[i];
+            for (size_t c = 0; c < m; c++) A[r * m + c] += row[r] * row[c];
+        }
+    }
+    // A pure tone leaves the taps underdetermined: a little ridge keeps
+    // the system solvable without changing the fit noticeably
+    double trace = 0;
+    for (size_t r = 0; r < m; r++) trace += A[r * m + r];
+    for (size_t r = 0; r < m; r++) A[r * m + r] += 1e-9 * trace / m;
+
+    // Gaussian elimination with partial pivoting
+    std::vector<double> h(m);
+    for (size_t c = 0; c < m; c++) {
+        size_t p = c;
+        for (size_t r = c + 1; r < m; r++) {
+            if (std::fabs(A[r * m + c]) > std::fabs(A[p * m + c])) p = r;
+        }
+        if (std::fabs(A[p * m + c]) < 1e-30) return NAN;
+        for (size_t k = 0; k < m; k++) std::swap(A[c * m + k], A[p * m + k]);
+        std::swap(b[c], b[p]);
+        for (size_t r = c + 1; r < m; r++) {
+            const double f = A[r * m + c] / A[c * m + c];
+            for (size_t k = c; k < m; k++) A[r * m + k] -= f * A[c * m + k];
+            b[r] -= f * b[c];
+        }
+    }
+    for (size_t c = m; c-- > 0;) {
+        double v = b[c];
+        for (size_t k = c + 1; k < m; k++) v -= A[c * m + k] * h[k];
+        h[c] = v / A[c * m + c];
+    }
+
+    double sig = 0, err = 0;
+    for (size_t i = skip; i < n; i++) {
+        double y = h[kTaps] / (32768.0 * kGain);
+        for (size_t k = 0; k < kTaps; k++) y += h[k] * src[i - k];
+        const double e = out[i] - y;
+        sig += y * y;
+        err += e * e;
+    }
+    return db(sig / std::max(err, 1e-12));
+}
+
+struct Result {
+    std::string input;
+    uint32_t rate = 0, decimation = 0;
+    unsigned channels = 1;
+    double ns_per_sample = 0;
+    Quality q;
+    bool match = true;
+};
+
+std::string json_number(double v) {
+    if (!std::isfinite(v)) return "null";
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.2f", v);
+    return buf;
+}
+
+void print_row(const Result &r) {
+    auto cell = [](double v) { return std::isfinite(v) ? json_number(v) : std::string("-"); };
+    std::printf("%-34s %6u %4u %3u %10.1f %8s %8s %8s  %s\n", r.input.c_str(), unsigned(r.rate),
+                unsigned(r.decimation), r.channels, r.ns_per_sample, cell(r.q.snr_db).c_str(),
+                cell(r.q.thd_db).c_str(), cell(r.q.sinad_db).c_str(), r.match ? "" : "MISMATCH");
+}
+
+void write_json(std::FILE *f, const Result &r) {
+    const size_t raw_per_ms = r.channels * (r.rate / 1000) * r.decimation / 8;
+    std::fprintf(f,
+                 "{\"variant\":\"%s\",\"input\":\"%s\",\"rate\":%u,\"decimation\":%u,\"channels\":%u,"
+                 "\"ns_per_sample\":%s,\"snr_db\":%s,\"thd_db\":%s,\"sinad_db\":%s,"
+                 "\"table_bytes\":%zu,\"state_bytes\":%zu,\"raw_bytes_per_ms\":%zu,\"match\":%s}\n",
+                 kVariant, r.input.c_str(), unsigned(r.rate), unsigned(r.decimation), r.channels,
+                 json_number(r.ns_per_sample).c_str(), json_number(r.q.snr_db).c_str(),
+                 json_number(r.q.thd_db).c_str(), json_number(r.q.sinad_db).c_str(),
+                 Open_PDM_Filter_Table_Bytes(uint8_t(r.decimation)), r.channels * sizeof(TPDMFilter_InitStruct),
+                 raw_per_ms,
+                 r.match ? "true" : "false");
+}
+
+bool same(const std::vector<int16_t> &stereo, const std::vector<int16_t> &a, const std::vector<int16_t> &b) {
+    if (stereo.size() != 2 * a.size() || a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (stereo[2 * i] != a[i] || stereo[2 * i + 1] != b[i]) return false;
+    }
+    return true;
+}
+
+// Mono run of both sources, then the stereo pair; appends three results
+// (two if a and b are the same)
+void bench(const Source &a, const Source &b, uint32_t rate, uint32_t decimation, int repeats,
+           std::vector<Result> &out) {
+    auto pdm_a = modulate(a, rate, decimation, 1);
+    auto pdm_b = &a == &b ? pdm_a : modulate(b, rate, decimation, 2);
+    std::vector<int16_t> pcm_a, pcm_b, pcm_ab;
+    const double t_a = run(pdm_a, rate, decimation, 1, repeats, pcm_a);
+    const double t_b = run(pdm_b, rate, decimation, 1, repeats, pcm_b);
+    const double t_ab = run(interleave(pdm_a, pdm_b), rate, decimation, 2, repeats, pcm_ab);
+
+    auto quality = [&](const std::vector<int16_t> &pcm, size_t stride, const Source &src) {
+        if (src.hz > 0) return analyse_tone(pcm, stride, 0, src.hz, rate);
+        std::vector<int16_t> mono;
+        for (size_t i = 0; i < pcm.size(); i += stride) mono.push_back(pcm[i]);
+        Quality q;
+        q.snr_db = compare(mono, reference(src, rate, decimation), rate);
+        return q;
+    };
+
+    Result r;
+    r.rate = rate;
+    r.decimation = decimation;
+    r.input = a.name;
+    r.ns_per_sample = 1e9 * t_a / double(pcm_a.size());
+    r.q = quality(pcm_a, 1, a);
+    out.push_back(r);
+    if (&a != &b) {
+        r.input = b.name;
+        r.ns_per_sample = 1e9 * t_b / double(pcm_b.size());
+        r.q = quality(pcm_b, 1, b);
+        out.push_back(r);
+    }
+    r.input = a.name + (&a != &b ? " + " + b.name : " x2");
+    r.channels = 2;
+    r.ns_per_sample = 1e9 * t_ab / double(pcm_ab.size());
+    r.q = quality(pcm_ab, 2, a);
+    r.match = same(pcm_ab, pcm_a, pcm_b);
+    out.push_back(r);
+}
+
+// Modulator input for PCM x: the filter gain of 16 brings it back to x
+double pdm_level(double pcm) { return pcm / (32768.0 * kGain); }
+
+Source tone(double hz, double dbfs, uint32_t rate, double seconds) {
+    Source s;
+    char name[32];
+    std::snprintf(name, sizeof(name), "sine %.0f Hz", hz);
+    s.name = name;
+    s.hz = hz;
+    s.amplitude = pdm_level(32768.0 * std::pow(10.0, dbfs / 20.0));
+    s.samples = size_t(seconds * rate);
+    return s;
+}
+
+void usage(const char *argv0) {
+    std::fprintf(stderr,
+                 "usage: %s [-t seconds] [-n repeats] [-j results.jsonl] [-q] [file.wav ...]\n"
+                 "  -t  seconds per sine (default 1)\n"
+                 "  -n  timing repeats, best is kept (default 3)\n"
+                 "  -j  append JSON lines to this file (- for stdout)\n"
+                 "  -q  no table\n", argv0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    double seconds = 1;
+    int repeats = 3;
+    std::string json_path;
+    bool quiet = false;
+    int opt;
+    while ((opt = ::getopt(argc, argv, "t:n:j:q")) != -1) {
+        switch (opt) {
+        case 't': seconds = std::atof(optarg); break;
+        case 'n': repeats = std::atoi(optarg); break;
+        case 'j': json_path = optarg; break;
+        case 'q': quiet = true; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (seconds <= kSettleS || repeats < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    struct Config {
+        uint32_t rate, decimation;
+    };
+    // Everything init_pdm_microphone_ex() accepts
+    const Config configs[] = { { 8000, 64 }, { 8000, 128 }, { 16000, 64 }, { 16000, 128 },
+                               { 32000, 64 }, { 48000, 64 } };
+
+    std::vector<Result> results;
+    for (const Config &c : configs) {
+        // Stepped sweep, -6 dBFS, up to 0.4 x the rate
+        std::vector<double> sweep;
+        for (double hz = 100; hz <= 0.4 * c.rate; hz *= 2) sweep.push_back(hz);
+        for (size_t i = 0; i < sweep.size(); i += 2) {
+            const double hb = i + 1 < sweep.size() ? sweep[i + 1] : sweep[i];
+            const Source a = tone(sweep[i], -6, c.rate, seconds);
+            const Source b = tone(hb, -6, c.rate, seconds);
+            if (hb == sweep[i]) bench(a, a, c.rate, c.decimation, repeats, results);
+            else bench(a, b, c.rate, c.decimation, repeats, results);
+        }
+    }
+
+    for (int i = optind; i < argc; i++) {
+        uint32_t rate = 0;
+        std::vector<int16_t> pcm;
+        if (!wav::read(argv[i], rate, pcm)) {
+            std::fprintf(stderr, "cannot read 16-bit PCM WAV %s\n", argv[i]);
+            return 1;
+        }
+        if (rate == 0 || rate % 1000 || rate * 64 > 3250000u) {
+            std::fprintf(stderr, "%s: %u Hz is not a microphone rate\n", argv[i], unsigned(rate));
+            return 1;
+        }
+        Source src;
+        src.name = argv[i];
+        src.name = src.name.substr(src.name.find_last_of('/') + 1);
+        src.samples = pcm.size();
+        src.pcm.resize(pcm.size());
+        // Peak at -6 dBFS, so the measurement is of the filter and not of
+        // the output saturating on a recording that was already near full scale
+        int32_t peak = 1;
+        for (int16_t v : pcm) peak = std::max(peak, std::abs(int32_t(v)));
+        const double scale = 16384.0 / peak;
+        for (size_t n = 0; n < pcm.size(); n++) src.pcm[n] = pdm_level(pcm[n] * scale);
+        for (uint32_t d : { 64u, 128u }) {
+            if (rate * d <= 3250000u) bench(src, src, rate, d, 1, results);
+        }
+    }
+
+    bool ok = true;
+    for (const Result &r : results) ok = ok && r.match;
+
+    if (!quiet) {
+        std::printf("variant %s: %zu / %zu bytes of tables at 64x / 128x (%zu copied to RAM), "
+                    "%zu bytes of state per channel\n\n", kVariant, Open_PDM_Filter_Table_Bytes(64),
+                    Open_PDM_Filter_Table_Bytes(128), Open_PDM_Filter_Ram_Bytes(),
+                    sizeof(TPDMFilter_InitStruct));
+        std::printf("%-34s %6s %4s %3s %10s %8s %8s %8s\n", "input", "rate", "dec", "ch", "ns/sample",
+                    "SNR dB", "THD dB", "SINAD dB");
+        for (const Result &r : results) print_row(r);
+    }
+
+    if (!json_path.empty()) {
+        std::FILE *f = json_path == "-" ? stdout : std::fopen(json_path.c_str(), "a");
+        if (!f) {
+            std::fprintf(stderr, "cannot open %s\n", json_path.c_str());
+            return 1;
+        }
+        for (const Result &r : results) write_json(f, r);
+        if (f != stdout) std::fclose(f);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+// pdm_exact: the current OpenPDMFilter (32-bit, single pass) against the
+// one the repository started from (reference.h), sample for sample, and
+// what each costs per output sample on the PC.
+//
+//   pdm_exact [-n repeats]
+//
+// Every rate and decimation the driver supports, on four inputs: a
+// sigma-delta modulated 1 kHz sine at -6 dBFS and at full scale, random
+// bits, and a square wave of all-ones and all-zeros bytes (full-scale
+// steps, which drive the output into saturation). Each is filtered with
+// Gain 1, 4 and 16 and volumes 0 to 65535, mono (the reference packed
+// stereo by byte, so stereo is checked against mono by pdm_bench). The
+// output must be identical.
+//
+// Times are ns of host CPU per output sample, the best of -n runs, for
+// the sine at Gain 16 and volume 64 (pdm_microphone.c). Built twice like
+// pdm_bench: pdm_exact (LUT) and pdm_exact_nolut; the reference always
+// has its LUT. The heap copy of the 128x LUT must not exist before the
+// first 128x filter (none at all without the LUT). Exit code 1 if any
+// sample differs or the copy is not as expected.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "OpenPDMFilter.h"
+#include "pdm_modulator.hpp"
+#include "reference.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+#ifdef USE_LUT
+constexpr const char *kVariant = "lut";
+#else
+constexpr const char *kVariant = "nolut";
+#endif
+
+constexpr double kSeconds = 0.5;
+constexpr float kHighPassHz = 10;
+constexpr uint8_t kMaxVolume = 64;
+
+struct Input {
+    const char *name;
+    std::vector<uint8_t> pdm;
+};
+
+std::vector<Input> inputs(uint32_t rate, uint32_t decimation) {
+    const size_t bits = size_t(kSeconds * rate) * decimation;
+    const double w = 2.0 * M_PI * 1000.0 / (double(rate) * decimation);
+    std::vector<Input> in;
+    in.push_back({"sine -6 dBFS", pdm::modulate(bits, 1, [&](size_t i) {
+                      return 0.5 * std::sin(w * double(i));
+                  })});
+    in.push_back({"sine 0 dBFS", pdm::modulate(bits, 2, [&](size_t i) {
+                      return std::sin(w * double(i));
+                  })});
+    std::mt19937 rng(3);
+    std::vector<uint8_t> random(bits / 8);
+    for (auto &b : random) b = uint8_t(rng());
+    in.push_back({"random", random});
+    std::vector<uint8_t> square(bits / 8);
+    const size_t period = size_t(rate) * decimation / 8 / 50;     // 50 Hz
+    for (size_t i = 0; i < square.size(); i++) square[i] = (i % period) < period / 2 ? 0xFF : 0x00;
+    in.push_back({"square", square});
+    return in;
+}
+
+void current_init(TPDMFilter_InitStruct &f, uint32_t rate, uint32_t decimation, uint8_t gain) {
+    f = TPDMFilter_InitStruct{};
+    f.Fs = uint16_t(rate);
+    f.LP_HZ = float(rate / 2);
+    f.HP_HZ = kHighPassHz;
+    f.In_MicChannels = 1;
+    f.Out_MicChannels = 1;
+    f.Decimation = uint8_t(decimation);
+    f.MaxVolume = kMaxVolume;
+    f.Gain = gain;
+    Open_PDM_Filter_Init(&f);
+}
+
+// Filter the whole input in 1 ms blocks; seconds taken
+template <typename Block>
+double run(const std::vector<uint8_t> &pdm, uint32_t rate, uint32_t decimation,
+           std::vector<uint16_t> &out, Block block) {
+    const size_t n = rate / 1000, step = n * decimation / 8, blocks = pdm.size() / step;
+    out.assign(blocks * n, 0);
+    auto t0 = Clock::now();
+    for (size_t b = 0; b < blocks; b++) block(&pdm[b * step], &out[b * n]);
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+double run_reference(const std::vector<uint8_t> &pdm, uint32_t rate, uint32_t decimation,
+                     uint8_t gain, uint16_t volume, std::vector<uint16_t> &out) {
+    pdm_reference_init(uint16_t(rate), uint8_t(decimation), kHighPassHz, kMaxVolume, gain);
+    return run(pdm, rate, decimation, out, [&](const uint8_t *in, uint16_t *o) {
+        pdm_reference_filter(in, o, volume);
+    });
+}
+
+double run_current(const std::vector<uint8_t> &pdm, uint32_t rate, uint32_t decimation,
+                   uint8_t gain, uint16_t volume, std::vector<uint16_t> &out) {
+    TPDMFilter_InitStruct f;
+    current_init(f, rate, decimation, gain);
+    return run(pdm, rate, decimation, out, [&](const uint8_t *in, uint16_t *o) {
+        auto *data = const_cast<uint8_t *>(in);
+        if (decimation == 128) Open_PDM_Filter_128(data, o, volume, &f);
+        else Open_PDM_Filter_64(data, o, volume, &f);
+    });
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int repeats = 3;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "-n" && i + 1 < argc) repeats = std::max(1, std::atoi(argv[++i]));
+        else { std::fprintf(stderr, "usage: %s [-n repeats]\n", argv[0]); return 2; }
+    }
+
+    const struct { uint32_t decimation, rate; } configs[] = {
+        {64, 8000}, {64, 16000}, {64, 32000}, {64, 48000},
+        {128, 8000}, {128, 16000}, {128, 24000},
+    };
+    const uint8_t gains[] = {1, 4, 16};
+    const uint16_t volumes[] = {0, 1, 64, 1000, 25210, 65535};
+
+    std::printf("variant %s, %.1f s per input, volumes 0..65535, gain 1/4/16\n", kVariant,
+                kSeconds);
+    std::printf("%4s %6s %12s %12s %12s %10s\n", "dec", "rate", "samples", "differing",
+                "ref ns/smp", "ns/smp");
+    uint64_t total_diff = 0;
+    long ram_fail = 0;
+    bool started_128 = false;
+    for (const auto &c : configs) {
+        uint64_t samples = 0, diff = 0;
+        std::vector<uint16_t> want, got;
+        for (const Input &in : inputs(c.rate, c.decimation)) {
+            for (uint8_t gain : gains) {
+                for (uint16_t volume : volumes) {
+                    run_reference(in.pdm, c.rate, c.decimation, gain, volume, want);
+                    run_current(in.pdm, c.rate, c.decimation, gain, volume, got);
+                    samples += want.size();
+                    for (size_t i = 0; i < want.size(); i++) {
+                        if (got[i] == want[i]) continue;
+                        if (diff++ == 0) {
+                            std::printf("FAIL %ux %u Hz %s gain %u volume %u: sample %zu is %d, "
+                                        "want %d\n", c.decimation, c.rate, in.name, gain, volume,
+                                        i, int16_t(got[i]), int16_t(want[i]));
+                        }
+                    }
+                }
+            }
+        }
+
+        const std::vector<uint8_t> sine = inputs(c.rate, c.decimation)[0].pdm;
+        double ref_s = 1e30, cur_s = 1e30;
+        for (int r = 0; r < repeats; r++) {
+            ref_s = std::min(ref_s, run_reference(sine, c.rate, c.decimation, 16, 64, want));
+            cur_s = std::min(cur_s, run_current(sine, c.rate, c.decimation, 16, 64, got));
+        }
+        std::printf("%4u %6u %12llu %12llu %12.1f %10.1f\n", c.decimation, c.rate,
+                    (unsigned long long)samples, (unsigned long long)diff,
+                    ref_s * 1e9 / double(want.size()), cur_s * 1e9 / double(got.size()));
+        total_diff += diff;
+
+        // 64x keeps every table in flash; the first 128x filter copies its LUT
+        started_128 = started_128 || c.decimation == 128;
+#ifdef USE_LUT
+        const size_t want_ram =
+            started_128 ? sizeof(TPDMFilter_Tables) + sizeof(int32_t) * 16 * 256 * SINCN : 0;
+#else
+        const size_t want_ram = 0;
+#endif
+        if (Open_PDM_Filter_Ram_Bytes() != want_ram) {
+            std::printf("FAIL %ux %u Hz: %zu bytes of tables in RAM, want %zu\n", c.decimation,
+                        c.rate, Open_PDM_Filter_Ram_Bytes(), want_ram);
+            ram_fail++;
+        }
+    }
+    std::printf("tables in RAM after the 128x runs: %zu bytes\n", Open_PDM_Filter_Ram_Bytes());
+    const bool failed = total_diff || ram_fail;
+    std::printf("%s\n", failed ? "pdm_exact: FAILED" : "pdm_exact: ok");
+    return failed ? 1 : 0;
+}
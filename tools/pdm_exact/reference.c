@@ -0,0 +1,50 @@
+// reference/OpenPDMFilter.c under its own names, so it links next to the
+// current filter. See reference.h.
+
+#define div_const               ref_div_const
+#define sub_const               ref_sub_const
+#define sinc                    ref_sinc
+#define sinc1                   ref_sinc1
+#define sinc2                   ref_sinc2
+#define coef                    ref_coef
+#define lut                     ref_lut
+#define filter_table            ref_filter_table
+#define filter_table_mono_64    ref_filter_table_mono_64
+#define filter_table_stereo_64  ref_filter_table_stereo_64
+#define filter_table_mono_128   ref_filter_table_mono_128
+#define filter_table_stereo_128 ref_filter_table_stereo_128
+#define filter_tables_64        ref_filter_tables_64
+#define filter_tables_128       ref_filter_tables_128
+#define convolve                ref_convolve
+#define Open_PDM_Filter_Init    ref_Open_PDM_Filter_Init
+#define Open_PDM_Filter_64      ref_Open_PDM_Filter_64
+#define Open_PDM_Filter_128     ref_Open_PDM_Filter_128
+
+#include "reference/OpenPDMFilter.c"
+
+#include "reference.h"
+
+static TPDMFilter_InitStruct ref_filter;
+
+void pdm_reference_init(uint16_t fs, uint8_t decimation, float hp_hz, uint8_t max_volume,
+                        uint8_t gain) {
+    TPDMFilter_InitStruct f = {0};
+    f.Fs = fs;
+    f.LP_HZ = fs / 2;
+    f.HP_HZ = hp_hz;
+    f.In_MicChannels = 1;
+    f.Out_MicChannels = 1;
+    f.Decimation = decimation;
+    f.MaxVolume = max_volume;
+    f.Gain = gain;
+    ref_filter = f;
+    Open_PDM_Filter_Init(&ref_filter);
+}
+
+void pdm_reference_filter(const uint8_t *data, uint16_t *out, uint16_t volume) {
+    if (ref_filter.Decimation == 128) {
+        Open_PDM_Filter_128((uint8_t *)data, out, volume, &ref_filter);
+    } else {
+        Open_PDM_Filter_64((uint8_t *)data, out, volume, &ref_filter);
+    }
+}
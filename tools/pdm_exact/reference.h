@@ -0,0 +1,24 @@
+// OpenPDMFilter as the repository first had it (reference/, unchanged:
+// 64-bit state, three passes over the input, LUT built at init), for
+// comparing the current filter against. Its tables are globals, so there
+// is one instance.
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Set up for mono input as pdm_microphone.c does: LP at fs / 2, HP at
+// hp_hz, MaxVolume and Gain as given
+void pdm_reference_init(uint16_t fs, uint8_t decimation, float hp_hz, uint8_t max_volume,
+                        uint8_t gain);
+
+// 1 ms of output (fs / 1000 samples) from fs / 1000 * decimation / 8 bytes
+void pdm_reference_filter(const uint8_t *data, uint16_t *out, uint16_t volume);
+
+#ifdef __cplusplus
+}
+#endif
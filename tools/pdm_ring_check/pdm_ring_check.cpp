@@ -0,0 +1,204 @@
+// pdm_ring_check: the PDM capture ring of pdm_microphone.c (a data DMA
+// channel chained to a control channel that reloads its write address, the
+// IRQ only counting buffers) on the host_pico PIO/DMA model, with a
+// consumer that is late on purpose.
+//
+//   pdm_ring_check
+//
+// The state machine pushes a counter, so every word says where it came
+// from: the raw buffers must hold consecutive counters in arrival byte
+// order (most significant byte first, from the DMA byte swap). For ring
+// depths of 2, 4 and 8 buffers at 8 kHz, 64x (32 ms per buffer):
+//
+// - consumer late by up to count-1 buffer times: no word missing, no
+//   overrun;
+// - the same with the IRQ 1.5 buffer times late (0.5 with 2 buffers) and
+//   the consumer late by up to the rest: no word missing, the late IRQs
+//   counted;
+// - consumer late by more than the ring: the words it missed must be the
+//   overruns counted, in whole buffers, and what it reads still whole.
+//
+// The PIO FIFO must never overflow: the ring does not need the CPU. Last,
+// pdm_microphone_read() must filter one buffer into a full block and count
+// an underrun when there is nothing left. Exit code 1 if any check failed.
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+#include "host_pico.h"
+
+extern "C" {
+#include "pico/stdlib.h"
+#include "tkjhat/pdm_microphone.h"
+#include "tkjhat/pins.h"
+}
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what, long got, long want) {
+    if (!ok) {
+        std::printf("FAIL %s: got %ld, want %ld\n", what, got, want);
+        failures++;
+    }
+}
+
+const uint sample_rate = 8000, buffer_samples = 256;
+const uint64_t buffer_us = uint64_t(buffer_samples) * 1000000 / sample_rate;
+
+uint32_t counter_word(void *ctx) {
+    return (*static_cast<uint32_t *>(ctx))++;
+}
+
+struct Reader {
+    uint32_t expect = 0;        // next counter
+    uint64_t words = 0;
+    uint64_t missing = 0;       // skipped at a buffer start
+    uint64_t corrupt = 0;       // out of sequence anywhere else
+};
+
+// Read and check every buffer the driver offers, then release them
+void drain(Reader &r, size_t words_per_buffer) {
+    uint32_t oldest;
+    const uint32_t end = pdm_microphone_raw_window(&oldest);
+    for (uint32_t seq = oldest; seq != end; ++seq) {
+        const uint8_t *b = pdm_microphone_raw_buffer(seq);
+        if (b == nullptr) {
+            r.corrupt++;
+            break;
+        }
+        for (size_t i = 0; i < words_per_buffer; ++i, b += 4) {
+            const uint32_t w = uint32_t(b[0]) << 24 | uint32_t(b[1]) << 16 |
+                               uint32_t(b[2]) << 8 | b[3];
+            if (w != r.expect) {
+                if (i == 0 && w - r.expect < 0x80000000u) r.missing += w - r.expect;
+                else r.corrupt++;
+                r.expect = w;
+            }
+            r.expect++;
+            r.words++;
+        }
+    }
+    pdm_microphone_discard(end);
+}
+
+pdm_microphone_config mic_config(uint raw_buffer_count) {
+    pdm_microphone_config c{};
+    c.gpio_data = PDM_DATA;
+    c.gpio_clk = PDM_CLK;
+    c.pio = pio0;
+    c.pio_sm = 0;
+    c.sample_rate = sample_rate;
+    c.sample_buffer_size = buffer_samples;
+    c.raw_buffer_count = raw_buffer_count;
+    c.decimation = 64;
+    return c;
+}
+
+struct Phase {
+    const char *name;
+    double late_min, late_max;  // consumer, in buffer times
+    double irq_late;            // in buffer times
+};
+
+void run(uint count, const Phase &ph, double seconds) {
+    host_pico_reset();
+    uint32_t counter = 0;
+    host_pio_set_source(0, 0, counter_word, &counter);
+    host_dma_set_irq_latency_us(uint32_t(ph.irq_late * buffer_us));
+
+    const pdm_microphone_config cfg = mic_config(count);
+    if (pdm_microphone_init(&cfg) != 0 || pdm_microphone_start() != 0) {
+        std::printf("FAIL %u buffers, %s: microphone did not start\n", count, ph.name);
+        failures++;
+        return;
+    }
+    const size_t words_per_buffer = pdm_microphone_raw_buffer_size() / 4;
+
+    std::mt19937 rng(count * 7919u + 1);
+    std::uniform_real_distribution<double> late(ph.late_min, ph.late_max);
+    Reader r;
+    const uint64_t end = time_us_64() + uint64_t(seconds * 1e6);
+    while (time_us_64() < end) {
+        sleep_us(uint64_t(late(rng) * double(buffer_us)));
+        drain(r, words_per_buffer);
+    }
+    pdm_microphone_stats st;
+    pdm_microphone_get_stats(&st);
+    const uint32_t dropped = host_pio_rx_dropped(0, 0);
+    pdm_microphone_stop();
+    pdm_microphone_deinit();
+
+    const bool overload = ph.late_min > count;
+    std::printf("%7u  %-22s %8llu %8llu %8u %8u %8u\n", count, ph.name,
+                (unsigned long long)(r.words / words_per_buffer),
+                (unsigned long long)(r.missing / words_per_buffer), st.overruns, st.late_irqs,
+                dropped);
+
+    char what[96];
+    std::snprintf(what, sizeof(what), "%u buffers, %s: words out of sequence", count, ph.name);
+    check(r.corrupt == 0, what, long(r.corrupt), 0);
+    std::snprintf(what, sizeof(what), "%u buffers, %s: FIFO overflows", count, ph.name);
+    check(dropped == 0, what, long(dropped), 0);
+    if (!overload) {
+        std::snprintf(what, sizeof(what), "%u buffers, %s: words missing", count, ph.name);
+        check(r.missing == 0, what, long(r.missing), 0);
+        std::snprintf(what, sizeof(what), "%u buffers, %s: overruns", count, ph.name);
+        check(st.overruns == 0, what, long(st.overruns), 0);
+    } else {
+        std::snprintf(what, sizeof(what), "%u buffers, %s: words missing", count, ph.name);
+        check(r.missing == uint64_t(st.overruns) * words_per_buffer, what, long(r.missing),
+              long(uint64_t(st.overruns) * words_per_buffer));
+        std::snprintf(what, sizeof(what), "%u buffers, %s: overruns", count, ph.name);
+        check(st.overruns > 0, what, long(st.overruns), 1);
+    }
+    if (ph.irq_late > 1.0) {
+        std::snprintf(what, sizeof(what), "%u buffers, %s: late IRQs", count, ph.name);
+        check(st.late_irqs > 0, what, long(st.late_irqs), 1);
+    }
+}
+
+void check_read() {
+    host_pico_reset();
+    uint32_t counter = 0;
+    host_pio_set_source(0, 0, counter_word, &counter);
+    const pdm_microphone_config cfg = mic_config(0);
+    pdm_microphone_init(&cfg);
+    pdm_microphone_start();
+    sleep_us(buffer_us + buffer_us / 2);
+
+    int16_t pcm[buffer_samples];
+    int n = pdm_microphone_read(pcm, buffer_samples);
+    check(n == int(buffer_samples), "pdm_microphone_read samples", n, buffer_samples);
+    n = pdm_microphone_read(pcm, buffer_samples);
+    check(n == 0, "pdm_microphone_read with nothing captured", n, 0);
+    pdm_microphone_stats st;
+    pdm_microphone_get_stats(&st);
+    check(st.underruns == 1, "underruns", long(st.underruns), 1);
+    check(st.buffers_read == 1, "buffers read", long(st.buffers_read), 1);
+    pdm_microphone_stop();
+    pdm_microphone_deinit();
+}
+
+} // namespace
+
+int main() {
+    std::printf("%7s  %-22s %8s %8s %8s %8s %8s\n", "buffers", "consumer", "read", "missed",
+                "overruns", "late IRQ", "FIFO ovf");
+    for (uint count : {2u, 4u, 8u}) {
+        const double slack = count - 1;
+        const double irq_late = count > 2 ? 1.5 : 0.5;
+        const Phase phases[] = {
+            {"late <= count-1", 0.0, 0.95 * slack, 0.0},
+            {"IRQ late, consumer too", 0.0, 0.95 * (slack - irq_late), irq_late},
+            {"late > count", count + 0.5, count + 1.5, 0.0},
+        };
+        for (const Phase &ph : phases) run(count, ph, 10.0);
+    }
+    check_read();
+
+    std::printf("%s\n", failures ? "pdm_ring_check: FAILED" : "pdm_ring_check: ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,208 @@
+// pdm_stream_check: the byte stream of the PDM capture with 32-bit
+// autopush and word-wide DMA against the byte-wide capture it replaced,
+// on the host_pico PIO/DMA model.
+//
+//   pdm_stream_check
+//
+// The same 2^20 random input bits are captured two ways at 48 kHz x 64:
+//
+// - byte-wide, as before: the state machine pushes every 8 bits (its
+//   explicit push is modelled as an 8-bit autopush, shifting left) and a
+//   DMA_SIZE_8 channel stores the low byte of each FIFO word;
+// - word-wide, as now: pdm_microphone_data_init() with its 32-bit
+//   autopush and a DMA_SIZE_32 channel with bswap.
+//
+// Both must store the bits in input order, first bit in bit 7 of the
+// first byte, which is what the filter's byte LUT reads. Then
+// pdm_microphone.c itself, mono and stereo, must leave a modulated sine
+// in its raw buffers the same way.
+//
+// It also prints the DMA transfers and RX FIFO reads each way takes per
+// second and their share of the 125 MHz system clock: the DMA moves one
+// transfer per cycle at most, each a bus read and a bus write. Exit code
+// 1 if any check failed.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "host_pico.h"
+#include "pdm_modulator.hpp"
+
+extern "C" {
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "pdm_microphone.pio.h"
+#include "pico/stdlib.h"
+#include "tkjhat/pdm_microphone.h"
+#include "tkjhat/pins.h"
+}
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what, long got, long want) {
+    if (!ok) {
+        std::printf("FAIL %s: got %ld, want %ld\n", what, got, want);
+        failures++;
+    }
+}
+
+// Input pin: packed bits, first in bit 7
+struct Bits {
+    const std::vector<uint8_t> *data;
+    size_t next = 0;
+};
+
+bool next_bit(void *ctx) {
+    auto *b = static_cast<Bits *>(ctx);
+    const size_t i = b->next++ % (b->data->size() * 8);
+    return ((*b->data)[i / 8] >> (7 - i % 8)) & 1;
+}
+
+// Index of the first differing byte, or -1
+long first_difference(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (i >= a.size() || i >= b.size() || a[i] != b[i]) return long(i);
+    }
+    return -1;
+}
+
+// The capture stops the state machine when it is complete, so nothing
+// after it counts as a FIFO overflow
+uint capture_channel;
+
+void capture_done() {
+    dma_hw->ints0 = 1u << capture_channel;
+    pio_sm_set_enabled(pio0, 0, false);
+}
+
+struct Capture {
+    std::vector<uint8_t> bytes;
+    uint32_t transfers;
+    uint32_t dropped;
+};
+
+Capture capture(const std::vector<uint8_t> &in, uint32_t rate, uint32_t decimation, bool words) {
+    host_pico_reset();
+    Bits src{&in};
+    host_pio_set_bit_source(0, 0, next_bit, &src);
+
+    const float clk_div = float(clock_get_hz(clk_sys) / (rate * decimation * 4.0));
+    if (words) {
+        pdm_microphone_data_init(pio0, 0, 0, clk_div, PDM_DATA, PDM_CLK, false);
+    } else {
+        pio_sm_config c = pdm_microphone_data_program_get_default_config(0);
+        sm_config_set_in_shift(&c, false, true, 8);
+        sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);
+        sm_config_set_clkdiv(&c, clk_div);
+        pio_sm_init(pio0, 0, 0, &c);
+    }
+
+    Capture cap;
+    cap.bytes.assign(in.size(), 0);
+    const uint ch = uint(dma_claim_unused_channel(true));
+    dma_channel_config d = dma_channel_get_default_config(ch);
+    channel_config_set_transfer_data_size(&d, words ? DMA_SIZE_32 : DMA_SIZE_8);
+    channel_config_set_bswap(&d, words);
+    channel_config_set_read_increment(&d, false);
+    channel_config_set_write_increment(&d, true);
+    channel_config_set_dreq(&d, pio_get_dreq(pio0, 0, false));
+    capture_channel = ch;
+    irq_set_exclusive_handler(DMA_IRQ_0, capture_done);
+    dma_channel_set_irq0_enabled(ch, true);
+    irq_set_enabled(DMA_IRQ_0, true);
+    dma_channel_configure(ch, &d, cap.bytes.data(), &pio0->rxf[0],
+                          uint(words ? in.size() / 4 : in.size()), true);
+    pio_sm_set_enabled(pio0, 0, true);
+
+    const uint64_t end = time_us_64() + 10000000;
+    while (dma_channel_is_busy(ch) && time_us_64() < end) sleep_ms(1);
+    cap.transfers = host_dma_transfers(ch);
+    cap.dropped = host_pio_rx_dropped(0, 0);
+    return cap;
+}
+
+// pdm_microphone.c on a modulated sine: its raw buffers, concatenated
+std::vector<uint8_t> driver_capture(const std::vector<uint8_t> &in, uint channels) {
+    host_pico_reset();
+    Bits src{&in};
+    host_pio_set_bit_source(0, 0, next_bit, &src);
+    pdm_microphone_config c{};
+    c.gpio_data = PDM_DATA;
+    c.gpio_clk = PDM_CLK;
+    c.pio = pio0;
+    c.sample_rate = 8000;
+    c.sample_buffer_size = 256;
+    c.decimation = 64;
+    c.channels = channels;
+    std::vector<uint8_t> out;
+    if (pdm_microphone_init(&c) != 0 || pdm_microphone_start() != 0) return out;
+    while (out.size() < in.size()) {
+        sleep_ms(10);
+        uint32_t oldest;
+        const uint32_t end = pdm_microphone_raw_window(&oldest);
+        for (uint32_t seq = oldest; seq != end; ++seq) {
+            const uint8_t *b = pdm_microphone_raw_buffer(seq);
+            out.insert(out.end(), b, b + pdm_microphone_raw_buffer_size());
+        }
+        pdm_microphone_discard(end);
+    }
+    pdm_microphone_stats st;
+    pdm_microphone_get_stats(&st);
+    check(st.overruns == 0, "driver overruns", long(st.overruns), 0);
+    pdm_microphone_stop();
+    pdm_microphone_deinit();
+    return out;
+}
+
+} // namespace
+
+int main() {
+    const uint32_t rate = 48000, decimation = 64;
+    std::mt19937 rng(39);
+    std::vector<uint8_t> bits(1u << 17);
+    for (auto &b : bits) b = uint8_t(rng());
+
+    const Capture bytes = capture(bits, rate, decimation, false);
+    const Capture words = capture(bits, rate, decimation, true);
+    check(first_difference(bytes.bytes, bits, bits.size()) == -1,
+          "byte-wide capture, first differing byte", first_difference(bytes.bytes, bits, bits.size()), -1);
+    check(first_difference(words.bytes, bits, bits.size()) == -1,
+          "word-wide capture, first differing byte", first_difference(words.bytes, bits, bits.size()), -1);
+    check(bytes.dropped == 0, "byte-wide FIFO overflows", long(bytes.dropped), 0);
+    check(words.dropped == 0, "word-wide FIFO overflows", long(words.dropped), 0);
+
+    const double bytes_per_s = double(rate) * decimation / 8;
+    const double seconds = double(bits.size()) / bytes_per_s;
+    std::printf("%zu input bits at %u Hz x %u (%.0f bytes/s)\n", bits.size() * 8, rate, decimation,
+                bytes_per_s);
+    std::printf("%-10s %10s %14s %12s %8s\n", "capture", "transfers", "transfers/s", "FIFO reads/s",
+                "DMA %");
+    for (const auto *c : {&bytes, &words}) {
+        const double per_s = c->transfers / seconds;
+        std::printf("%-10s %10u %14.0f %12.0f %8.3f\n", c == &bytes ? "byte-wide" : "word-wide",
+                    c->transfers, per_s, per_s, 100.0 * per_s / clock_get_hz(clk_sys));
+    }
+
+    // The driver, mono and stereo, on a 1 kHz sine at -6 dBFS
+    const double w = 2.0 * M_PI * 1000.0 / (8000.0 * 64);
+    const std::vector<uint8_t> sine = pdm::modulate(size_t(8000) * 64 / 2, 1, [&](size_t i) {
+        return 0.5 * std::sin(w * double(i));
+    });
+    for (uint channels : {1u, 2u}) {
+        const std::vector<uint8_t> got = driver_capture(sine, channels);
+        const long diff = first_difference(got, sine, sine.size());
+        std::printf("pdm_microphone.c, %s: %zu bytes, %s\n", channels == 1 ? "mono" : "stereo",
+                    got.size(), diff == -1 ? "same as the input" : "DIFFERENT");
+        check(diff == -1, channels == 1 ? "driver mono, first differing byte"
+                                        : "driver stereo, first differing byte", diff, -1);
+    }
+
+    std::printf("%s\n", failures ? "pdm_stream_check: FAILED" : "pdm_stream_check: ok");
+    return failures ? 1 : 0;
+}
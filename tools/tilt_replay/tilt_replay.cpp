@@ -0,0 +1,383 @@
+// tilt_replay: the tilt Morse pipeline of main.c (Mahony fusion, then the
+// tilt_morse classifier) replayed on IMU traces, with decoding accuracy
+// and host CPU per sample.
+//
+//   tilt_replay [-v] trace.csv...
+//   tilt_replay --synth TEXT [-r odr] [-u unit_ms] [-k shake_g] [-s seed] > trace.csv
+//
+// A trace is a CSV of raw ICM-42670 counts, one sample per line:
+//
+//   # text: PARIS SOS        what was keyed (for the accuracy)
+//   # odr: 100               sample rate in Hz
+//   # gyro_lsb_per_dps: 65.5
+//   # unit_ms: 200           Morse unit the sender used
+//   t_us,ax,ay,az,gx,gy,gz
+//   0,12,-3,8190,1,0,-2
+//
+// Each trace is run through two pitch sources: the fixed-point Mahony
+// filter as imu_fusion.c runs it, and the accelerometer alone. Symbols are
+// collected the way print_task() does (a letter gap is one space, a word
+// gap two) and decoded with the Morse table of main.c. Accuracy is
+// 1 - edit distance / length, on the letters and on the Morse string. The
+// exit code is 1 if the fusion pitch does not decode a trace exactly.
+//
+// --synth writes a trace of someone keying TEXT by tilting the board:
+// smooth tilts to 30-40 degrees either way, timing jitter, hand tremor,
+// sensor noise and gyro bias, and with -k the board shaken back and forth
+// at 4 Hz (e.g. while walking). tools/tilt_replay/traces/ holds one trace
+// of each.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tkjhat/mahony.h"
+#include "tkjhat/tilt_morse.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kAccelLsb = 8192.0;   // 4 g, ICM42670_start_with_default_values()
+
+// Same table as main.c
+struct MorseEntry {
+    char symbol;
+    const char *code;
+};
+
+const MorseEntry kMorse[] = {
+    {'A', ".-"}, {'B', "-..."}, {'C', "-.-."}, {'D', "-.."}, {'E', "."},
+    {'F', "..-."}, {'G', "--."}, {'H', "...."}, {'I', ".."}, {'J', ".---"},
+    {'K', "-.-"}, {'L', ".-.."}, {'M', "--"}, {'N', "-."}, {'O', "---"},
+    {'P', ".--."}, {'Q', "--.-"}, {'R', ".-."}, {'S', "..."}, {'T', "-"},
+    {'U', "..-"}, {'V', "...-"}, {'W', ".--"}, {'X', "-..-"}, {'Y', "-.--"},
+    {'Z', "--.."},
+    {'0', "-----"}, {'1', ".----"}, {'2', "..---"}, {'3', "...--"}, {'4', "....-"},
+    {'5', "....."}, {'6', "-...."}, {'7', "--..."}, {'8', "---.."}, {'9', "----."},
+};
+
+const char *to_morse(char c) {
+    for (const MorseEntry &e : kMorse) {
+        if (e.symbol == c) return e.code;
+    }
+    return "";
+}
+
+char from_morse(const std::string &code) {
+    for (const MorseEntry &e : kMorse) {
+        if (code == e.code) return e.symbol;
+    }
+    return '?';
+}
+
+// Morse string in main.c's format: letters separated by one space, words by two
+std::string encode(const std::string &text) {
+    std::string out;
+    for (char c : text) {
+        if (c == ' ') {
+            if (!out.empty() && out.back() == ' ') out += ' ';
+            continue;
+        }
+        out += to_morse(char(std::toupper(static_cast<unsigned char>(c))));
+        out += ' ';
+    }
+    while (!out.empty() && out.back() == ' ') out.pop_back();
+    return out;
+}
+
+std::string decode(const std::string &morse) {
+    std::string out, tok;
+    size_t spaces = 0;
+    for (size_t i = 0; i <= morse.size(); ++i) {
+        char c = i < morse.size() ? morse[i] : ' ';
+        if (c != ' ') {
+            if (spaces >= 2 && !out.empty()) out += ' ';
+            spaces = 0;
+            tok += c;
+            continue;
+        }
+        if (!tok.empty()) out += from_morse(tok);
+        tok.clear();
+        spaces++;
+    }
+    return out;
+}
+
+size_t edit_distance(const std::string &a, const std::string &b) {
+    std::vector<size_t> row(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); ++j) row[j] = j;
+    for (size_t i = 1; i <= a.size(); ++i) {
+        size_t diag = row[0];
+        row[0] = i;
+        for (size_t j = 1; j <= b.size(); ++j) {
+            size_t up = row[j];
+            row[j] = std::min({row[j] + 1, row[j - 1] + 1, diag + (a[i - 1] != b[j - 1])});
+            diag = up;
+        }
+    }
+    return row[b.size()];
+}
+
+double accuracy(const std::string &got, const std::string &want) {
+    if (want.empty()) return got.empty() ? 1.0 : 0.0;
+    return std::max(0.0, 1.0 - double(edit_distance(got, want)) / double(want.size()));
+}
+
+struct Sample {
+    uint32_t t_us;
+    int16_t ax, ay, az, gx, gy, gz;
+};
+
+struct Trace {
+    std::string text;
+    unsigned odr = 100;
+    float gyro_lsb = 65.5f;
+    unsigned unit_ms = 200;
+    std::vector<Sample> samples;
+};
+
+bool load(const char *path, Trace &tr) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        if (line[0] == '#') {
+            std::string key, value;
+            std::istringstream ls(line.substr(1));
+            ls >> key;
+            std::getline(ls >> std::ws, value);
+            if (key == "text:") tr.text = value;
+            else if (key == "odr:") tr.odr = unsigned(std::atoi(value.c_str()));
+            else if (key == "gyro_lsb_per_dps:") tr.gyro_lsb = std::strtof(value.c_str(), nullptr);
+            else if (key == "unit_ms:") tr.unit_ms = unsigned(std::atoi(value.c_str()));
+            continue;
+        }
+        if (!std::isdigit(static_cast<unsigned char>(line[0]))) continue; // column names
+        Sample s;
+        long v[7];
+        if (std::sscanf(line.c_str(), "%ld,%ld,%ld,%ld,%ld,%ld,%ld", &v[0], &v[1], &v[2], &v[3],
+                        &v[4], &v[5], &v[6]) != 7) {
+            return false;
+        }
+        s.t_us = uint32_t(v[0]);
+        s.ax = int16_t(v[1]); s.ay = int16_t(v[2]); s.az = int16_t(v[3]);
+        s.gx = int16_t(v[4]); s.gy = int16_t(v[5]); s.gz = int16_t(v[6]);
+        tr.samples.push_back(s);
+    }
+    return tr.odr > 0 && tr.odr <= 1600 && !tr.samples.empty();
+}
+
+struct Run {
+    std::string morse;
+    double ns_pitch = 0;    // pitch source, per sample
+    double ns_classify = 0; // tilt_morse_update(), per sample
+};
+
+// As main.c's imu_sample()
+float fused_pitch(mahony_q30_t &f, const Sample &s) {
+    mahony_q30_update(&f, s.gx, s.gy, s.gz, s.ax, s.ay, s.az);
+    const float k = 1.0f / float(1 << 30);
+    float w = f.q[0] * k, x = f.q[1] * k, y = f.q[2] * k, z = f.q[3] * k;
+    float sp = std::clamp(2.0f * (w * y - z * x), -1.0f, 1.0f);
+    return std::asin(sp) * float(180.0 / kPi);
+}
+
+float accel_pitch(const Sample &s) {
+    float ax = s.ax, ay = s.ay, az = s.az;
+    return std::atan2(ax, std::sqrt(ay * ay + az * az)) * float(180.0 / kPi);
+}
+
+Run replay(const Trace &tr, bool fused) {
+    const size_t n = tr.samples.size();
+    std::vector<float> pitch(n);
+    Run r;
+
+    // Best of a few passes for the timing; the result is the same each time
+    double best_pitch = 1e30, best_classify = 1e30;
+    for (int pass = 0; pass < 5; ++pass) {
+        mahony_q30_t f;
+        mahony_q30_init(&f, 1.0f, 0.02f, uint16_t(tr.odr), tr.gyro_lsb);
+        auto t0 = Clock::now();
+        if (fused) {
+            for (size_t i = 0; i < n; ++i) pitch[i] = fused_pitch(f, tr.samples[i]);
+        } else {
+            for (size_t i = 0; i < n; ++i) pitch[i] = accel_pitch(tr.samples[i]);
+        }
+        auto t1 = Clock::now();
+
+        tilt_morse_t tm;
+        tilt_morse_config_t cfg;
+        tilt_morse_default_config(&cfg);
+        cfg.unit_us = tr.unit_ms * 1000u;
+        tilt_morse_init(&tm, &cfg);
+        std::string morse;
+        for (size_t i = 0; i < n; ++i) {
+            tilt_morse_event_t ev;
+            if (!tilt_morse_update(&tm, pitch[i], tr.samples[i].t_us, &ev)) continue;
+            if (ev.symbol == TILT_MORSE_WORD_GAP) morse += ' ';   // second space
+            else morse += ev.symbol;
+        }
+        auto t2 = Clock::now();
+
+        best_pitch = std::min(best_pitch, std::chrono::duration<double, std::nano>(t1 - t0).count());
+        best_classify = std::min(best_classify, std::chrono::duration<double, std::nano>(t2 - t1).count());
+        while (!morse.empty() && morse.back() == ' ') morse.pop_back();
+        r.morse = morse;
+    }
+    r.ns_pitch = best_pitch / double(n);
+    r.ns_classify = best_classify / double(n);
+    return r;
+}
+
+int16_t counts(double v, double lsb) {
+    return int16_t(std::clamp(std::lround(v * lsb), long(INT16_MIN), long(INT16_MAX)));
+}
+
+// Someone keying `text` by tilting the board about its Y axis
+int synth(const std::string &text, unsigned odr, unsigned unit_ms, double shake_g, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> jitter(0.85, 1.15);
+    std::uniform_real_distribution<double> depth(30.0, 40.0);
+    std::normal_distribution<double> accel_noise(0.0, 0.002);  // g
+    std::normal_distribution<double> gyro_noise(0.0, 0.05);    // dps
+    const double gyro_lsb = 65.5;
+    const double bias_dps[3] = {0.4, -0.3, 0.2};
+
+    // Target tilt as (start s, length s, degrees) segments
+    struct Mark {
+        double t, len, deg;
+    };
+    std::vector<Mark> marks;
+    const double unit = unit_ms / 1000.0;
+    double t = 1.0;
+    std::string morse = encode(text);
+    for (size_t i = 0; i < morse.size(); ++i) {
+        char c = morse[i];
+        if (c == ' ') {
+            // One unit already follows every mark
+            bool word = i + 1 < morse.size() && morse[i + 1] == ' ';
+            t += (word ? 6 : 2) * unit * jitter(rng);
+            if (word) ++i;
+            continue;
+        }
+        double len = (c == '.' ? 1 : 3) * unit * jitter(rng);
+        double deg = depth(rng) * (rng() & 1 ? 1 : -1);
+        marks.push_back({t, len, deg});
+        t += len + unit * jitter(rng);
+    }
+    const double total = t + 8 * unit + 1.0;  // room for the final word gap
+
+    // Tilt angle at time x: raised-cosine ramps of 80 ms centred on the
+    // mark edges, plus a 0.8 degree tremor at 7 Hz
+    const double ramp = 0.08;
+    auto angle = [&](double x) {
+        double a = 0.8 * std::sin(2 * kPi * 7 * x);
+        for (const Mark &m : marks) {
+            double up = x - (m.t - ramp / 2), down = (m.t + m.len + ramp / 2) - x;
+            double e = std::min({up, down, ramp}) / ramp;
+            if (e <= 0) continue;
+            a += m.deg * 0.5 * (1 - std::cos(kPi * e));
+        }
+        return a;
+    };
+
+    std::printf("# text: %s\n# odr: %u\n# gyro_lsb_per_dps: %.1f\n# unit_ms: %u\n", text.c_str(),
+                odr, gyro_lsb, unit_ms);
+    std::printf("# synthetic: tilt_replay --synth \"%s\" -r %u -u %u -k %.2f -s %u\n",
+                text.c_str(), odr, unit_ms, shake_g, seed);
+    std::printf("t_us,ax,ay,az,gx,gy,gz\n");
+    const double dt = 1.0 / odr;
+    for (long k = 0; k * dt < total; ++k) {
+        double x = k * dt;
+        double th = angle(x) * kPi / 180.0;
+        double rate = (angle(x + dt / 2) - angle(x - dt / 2)) / dt;  // dps about Y
+        // Rotation about body Y by th: gravity (world Z) in the body frame is
+        // (-sin, 0, cos) and the shaking direction (world X) is (cos, 0, sin)
+        double lin = shake_g * std::sin(2 * kPi * 4 * x);
+        std::printf("%lu,%d,%d,%d,%d,%d,%d\n", (unsigned long)std::lround(x * 1e6),
+                    counts(-std::sin(th) + lin * std::cos(th) + accel_noise(rng), kAccelLsb),
+                    counts(accel_noise(rng), kAccelLsb),
+                    counts(std::cos(th) + lin * std::sin(th) + accel_noise(rng), kAccelLsb),
+                    counts(bias_dps[0] + gyro_noise(rng), gyro_lsb),
+                    counts(rate + bias_dps[1] + gyro_noise(rng), gyro_lsb),
+                    counts(bias_dps[2] + gyro_noise(rng), gyro_lsb));
+    }
+    return 0;
+}
+
+void usage(const char *argv0) {
+    std::fprintf(stderr,
+                 "usage: %s [-v] trace.csv...\n"
+                 "       %s --synth TEXT [-r odr] [-u unit_ms] [-k shake_g] [-s seed] > trace.csv\n",
+                 argv0, argv0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bool verbose = false;
+    std::string synth_text;
+    bool do_synth = false;
+    unsigned odr = 100, unit_ms = 200, seed = 1;
+    double shake_g = 0.0;
+    std::vector<const char *> paths;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "-v") verbose = true;
+        else if (a == "--synth" && i + 1 < argc) { do_synth = true; synth_text = argv[++i]; }
+        else if (a == "-r" && i + 1 < argc) odr = unsigned(std::atoi(argv[++i]));
+        else if (a == "-u" && i + 1 < argc) unit_ms = unsigned(std::atoi(argv[++i]));
+        else if (a == "-k" && i + 1 < argc) shake_g = std::atof(argv[++i]);
+        else if (a == "-s" && i + 1 < argc) seed = unsigned(std::atoi(argv[++i]));
+        else if (!a.empty() && a[0] != '-') paths.push_back(argv[i]);
+        else { usage(argv[0]); return 2; }
+    }
+    if (do_synth) {
+        if (odr == 0 || odr > 1600 || unit_ms == 0) { usage(argv[0]); return 2; }
+        return synth(synth_text, odr, unit_ms, shake_g, seed);
+    }
+    if (paths.empty()) { usage(argv[0]); return 2; }
+
+    bool ok = true;
+    std::printf("%-28s %-6s %8s %8s %10s %10s\n", "trace", "pitch", "letters", "morse",
+                "ns pitch", "ns class.");
+    for (const char *path : paths) {
+        Trace tr;
+        if (!load(path, tr)) {
+            std::fprintf(stderr, "%s: cannot read trace\n", path);
+            return 1;
+        }
+        const std::string want_morse = encode(tr.text);
+        std::string want_text;
+        for (char c : tr.text) want_text += char(std::toupper(static_cast<unsigned char>(c)));
+
+        const char *name = std::strrchr(path, '/') ? std::strrchr(path, '/') + 1 : path;
+        for (bool fused : {true, false}) {
+            Run r = replay(tr, fused);
+            std::string text = decode(r.morse);
+            double acc_text = accuracy(text, want_text);
+            double acc_morse = accuracy(r.morse, want_morse);
+            if (fused && text != want_text) ok = false;
+            std::printf("%-28s %-6s %7.1f%% %7.1f%% %10.1f %10.1f%s\n", name,
+                        fused ? "fusion" : "accel", 100 * acc_text, 100 * acc_morse, r.ns_pitch,
+                        r.ns_classify, fused && text != want_text ? "  FAIL" : "");
+            if (verbose) {
+                std::printf("  decoded \"%s\"\n  morse   \"%s\"\n", text.c_str(), r.morse.c_str());
+            }
+        }
+    }
+    std::printf("(host ns per sample; the board runs the same code at SENSOR_PERIOD_MS)\n");
+    return ok ? 0 : 1;
+}
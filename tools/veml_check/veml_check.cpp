@@ -0,0 +1,144 @@
+// veml_check: VEML6030 auto-range and lux correction (veml6030_read() in
+// sdk.c) on host_pico against the Veml6030 model, from 0 to 120 klx.
+//
+//   veml_check [-v]
+//
+// The light is stepped in 1/8 decades from 0.05 lx up to 120 klx and back
+// down. At every level the driver is read every 50 ms, as an application
+// polling it would, until a fresh reading of a result measured at the new
+// level leaves the range where it is. Then:
+//
+// - the counts must be within the 100..10000 window the ladder aims for,
+//   unless the ladder is at one of its ends;
+// - the fixed-point non-linearity correction must match the polynomial in
+//   double precision to 1e-5 (plus 1 mlx);
+// - the reported lux must match the true lux within half a count, carried
+//   through the correction, plus 0.1%.
+//
+// The ladder must settle within 5 s (from one end to the other takes
+// about 3 s). Prints one line per decade (-v: per
+// level) and exits with 1 if any check failed.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "host_pico.h"
+#include "veml6030_model.hpp"
+
+namespace {
+
+const char *gain_name(veml6030_gain_t g) {
+    switch (g) {
+        case VEML6030_GAIN_1:   return "x1";
+        case VEML6030_GAIN_2:   return "x2";
+        case VEML6030_GAIN_1_8: return "x1/8";
+        default:                return "x1/4";
+    }
+}
+
+// Least and most sensitive ladder steps (sdk.c veml_ladder)
+bool at_ladder_end(const veml6030_reading_t &r) {
+    return (r.gain == VEML6030_GAIN_1_8 && r.it_ms == 25) ||
+           (r.gain == VEML6030_GAIN_2 && r.it_ms == 800);
+}
+
+// Driver's polynomial in double, from the counts it read
+double expected_mlx(const veml6030_reading_t &r) {
+    double lin = r.als * (r.resolution_1e4 * 1e-4);
+    return (lin > 1000.0 ? model::Veml6030::correction(lin) : lin) * 1000.0;
+}
+
+struct Level {
+    double lux;
+    veml6030_reading_t r;
+    double settle_ms;
+    bool counts_ok, fixed_ok, lux_ok, settled;
+};
+
+Level measure(model::Veml6030 &veml, double lux) {
+    Level l{};
+    l.lux = lux;
+    veml.set_lux(lux);
+    const uint64_t t0 = time_us_64();
+
+    while (time_us_64() - t0 < 5000000) {
+        sleep_ms(50);
+        const uint16_t cfg = veml.reg(VEML6030_CONFIG_REG);
+        veml6030_reading_t r;
+        if (veml6030_read(&r, false) != 0) break;
+        // Settled: a result of the new level, and the driver kept the range
+        if (r.fresh && veml.result_us() > t0 && veml.reg(VEML6030_CONFIG_REG) == cfg) {
+            l.r = r;
+            l.settled = true;
+            break;
+        }
+    }
+    l.settle_ms = double(time_us_64() - t0) / 1000.0;
+    if (!l.settled) return l;
+
+    const veml6030_reading_t &r = l.r;
+    l.counts_ok = (r.als >= 100 && r.als <= 10000) || at_ladder_end(r);
+
+    double want = expected_mlx(r);
+    l.fixed_ok = std::fabs(r.lux_mlx - want) <= 1.0 + 1e-5 * want;
+
+    // Half a count either way, through the correction
+    double res = r.resolution_1e4 * 1e-4;
+    double lin = model::Veml6030::uncorrected(lux);
+    auto corr = [](double x) { return x > 1000.0 ? model::Veml6030::correction(x) : x; };
+    double half = 0.5 * (corr(lin + 0.5 * res) - corr(std::max(0.0, lin - 0.5 * res)));
+    double tol = (half + 1e-3 * lux) * 1000.0 + 1.0;
+    l.lux_ok = std::fabs(r.lux_mlx - lux * 1000.0) <= tol;
+    return l;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "-v") verbose = true;
+        else { std::fprintf(stderr, "usage: %s [-v]\n", argv[0]); return 2; }
+    }
+
+    host_pico_reset();
+    model::Veml6030 veml;
+    init_veml6030();
+
+    std::vector<double> levels{0.0};
+    for (int k = 0; 0.05 * std::pow(10.0, k / 8.0) < 120000.0; ++k) {
+        levels.push_back(0.05 * std::pow(10.0, k / 8.0));
+    }
+    levels.push_back(120000.0);
+    for (size_t i = levels.size() - 1; i-- > 0;) levels.push_back(levels[i]);
+
+    std::printf("%12s %6s %5s %6s %14s %8s %8s\n", "true lx", "gain", "IT ms", "counts",
+                "reported lx", "err %", "settle");
+    int failures = 0;
+    double last_decade = -1e9;
+    for (size_t i = 0; i < levels.size(); ++i) {
+        Level l = measure(veml, levels[i]);
+        bool ok = l.settled && l.counts_ok && l.fixed_ok && l.lux_ok;
+        if (!ok) failures++;
+
+        // One line per decade unless -v, and every failure
+        double decade = l.lux > 0 ? std::floor(std::log10(l.lux)) : -9;
+        bool show = verbose || !ok || decade != last_decade || i + 1 == levels.size();
+        last_decade = decade;
+        if (!show) continue;
+        double got = l.r.lux_mlx / 1000.0;
+        double err = l.lux > 0 ? 100.0 * (got - l.lux) / l.lux : 0.0;
+        std::printf("%12.3f %6s %5u %6u %14.3f %8.3f %6.0fms%s%s%s%s\n", l.lux,
+                    gain_name(l.r.gain), l.r.it_ms, l.r.als, got, err, l.settle_ms,
+                    l.settled ? "" : "  FAIL: not settled", l.settled && !l.counts_ok ? "  FAIL: counts" : "",
+                    l.settled && !l.fixed_ok ? "  FAIL: correction" : "",
+                    l.settled && !l.lux_ok ? "  FAIL: lux" : "");
+    }
+    std::printf("%zu levels, %d failed\n", levels.size(), failures);
+    return failures ? 1 : 0;
+}